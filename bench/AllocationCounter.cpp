@@ -0,0 +1,90 @@
+
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+namespace {
+
+std::atomic<v_int64> g_allocations(0);
+std::atomic<v_int64> g_liveBytes(0);
+std::atomic<v_int64> g_peakLiveBytes(0);
+
+void* countedAlloc(std::size_t size) {
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr != nullptr) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    v_int64 usable = (v_int64) malloc_usable_size(ptr);
+    v_int64 live = g_liveBytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+    v_int64 peak = g_peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+  }
+  return ptr;
+}
+
+void countedFree(void* ptr) {
+  if (ptr != nullptr) {
+    g_liveBytes.fetch_sub((v_int64) malloc_usable_size(ptr), std::memory_order_relaxed);
+    std::free(ptr);
+  }
+}
+
+}
+
+v_int64 AllocationCounter::getAllocations() {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+v_int64 AllocationCounter::getLiveBytes() {
+  return g_liveBytes.load(std::memory_order_relaxed);
+}
+
+v_int64 AllocationCounter::getPeakLiveBytes() {
+  return g_peakLiveBytes.load(std::memory_order_relaxed);
+}
+
+void AllocationCounter::resetPeakLiveBytes() {
+  g_peakLiveBytes.store(g_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+  void* ptr = countedAlloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  void* ptr = countedAlloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  countedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  countedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  countedFree(ptr);
+}
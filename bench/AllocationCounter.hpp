@@ -0,0 +1,50 @@
+
+#ifndef AllocationCounter_hpp
+#define AllocationCounter_hpp
+
+#include "oatpp/core/Types.hpp"
+
+/**
+ *  Counts heap allocations of the benchmark process.
+ *  The global operator new/delete of the bench executable are replaced in AllocationCounter.cpp.
+ */
+class AllocationCounter {
+public:
+
+  /**
+   * Numbers collected between two points of time.
+   */
+  struct Sample {
+    v_int64 allocations;
+    v_int64 liveBytes;
+  };
+
+public:
+
+  /**
+   * Total number of allocations made so far (all threads).
+   */
+  static v_int64 getAllocations();
+
+  /**
+   * Bytes currently allocated and not yet freed (all threads).
+   */
+  static v_int64 getLiveBytes();
+
+  /**
+   * Most bytes allocated at the same time since the last resetPeakLiveBytes().
+   */
+  static v_int64 getPeakLiveBytes();
+
+  /**
+   * Start measuring the peak from the bytes currently allocated.
+   */
+  static void resetPeakLiveBytes();
+
+  static Sample sample() {
+    return {getAllocations(), getLiveBytes()};
+  }
+
+};
+
+#endif /* AllocationCounter_hpp */
@@ -0,0 +1,88 @@
+
+#include "DatabaseBench.hpp"
+#include "DatabaseContentionBench.hpp"
+#include "DeviceLayoutBench.hpp"
+#include "DescriptionBench.hpp"
+#include "ConnectionHandlerBench.hpp"
+#include "StateParserBench.hpp"
+#include "ResponseWriterBench.hpp"
+#include "DriverPipelineBench.hpp"
+#include "TransitionBench.hpp"
+#include "StorageBench.hpp"
+#include "MetricsBench.hpp"
+#include "LightsStreamBench.hpp"
+#include "BridgeHostingBench.hpp"
+#include "ShardingBench.hpp"
+#include "ColorBench.hpp"
+#include "HubProcess.hpp"
+#include "BenchReport.hpp"
+
+#include "oatpp/core/base/CommandLineArguments.hpp"
+#include "oatpp/core/base/Environment.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+void runBenchmarks() {
+
+  OATPP_RUN_TEST(DatabaseBench);
+  OATPP_RUN_TEST(DatabaseContentionBench);
+  OATPP_RUN_TEST(DeviceLayoutBench);
+  OATPP_RUN_TEST(DescriptionBench);
+  OATPP_RUN_TEST(ConnectionHandlerBench);
+  OATPP_RUN_TEST(StateParserBench);
+  OATPP_RUN_TEST(ResponseWriterBench);
+  OATPP_RUN_TEST(DriverPipelineBench);
+  OATPP_RUN_TEST(TransitionBench);
+  OATPP_RUN_TEST(StorageBench);
+  OATPP_RUN_TEST(MetricsBench);
+  OATPP_RUN_TEST(LightsStreamBench);
+  OATPP_RUN_TEST(BridgeHostingBench);
+  OATPP_RUN_TEST(ShardingBench);
+  OATPP_RUN_TEST(ColorBench);
+
+}
+
+}
+
+/**
+ *  main
+ *  --json <path>  also write the results as JSON, to diff them between releases
+ *  --bridge-process <port> --bridge-count <n> --shards <n> [--pin-shards]  run a hub instead, started by the benchmark itself (see HubProcess)
+ */
+int main(int argc, const char * argv[]) {
+
+  oatpp::base::Environment::init();
+
+  oatpp::base::CommandLineArguments args(argc, argv);
+
+  const char* bridgePort = args.getNamedArgumentValue("--bridge-process", nullptr);
+  if (bridgePort != nullptr) {
+    HubProcess::Config hub;
+    hub.port = (v_uint16) std::atoi(bridgePort);
+    hub.bridges = (v_uint32) std::atoi(args.getNamedArgumentValue("--bridge-count", "1"));
+    hub.shards = (v_uint32) std::atoi(args.getNamedArgumentValue("--shards", "1"));
+    hub.pinShards = args.hasArgument("--pin-shards");
+    HubProcess::serve(hub);
+    return 0;
+  }
+
+  runBenchmarks();
+
+  const char* jsonPath = args.getNamedArgumentValue("--json", nullptr);
+  if (jsonPath != nullptr && !BenchReport::writeToFile(jsonPath)) {
+    OATPP_LOGE("Bench", "Can't write results to '%s'", jsonPath);
+  }
+
+  /* Print how much objects were created during app running, and what have left-probably leaked */
+  /* Disable object counting for release builds using '-D OATPP_DISABLE_ENV_OBJECT_COUNTERS' flag for better performance */
+  std::cout << "\nEnvironment:\n";
+  std::cout << "objectsCount = " << oatpp::base::Environment::getObjectsCount() << "\n";
+  std::cout << "objectsCreated = " << oatpp::base::Environment::getObjectsCreated() << "\n\n";
+
+  oatpp::base::Environment::destroy();
+
+  return 0;
+}
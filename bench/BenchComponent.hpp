@@ -0,0 +1,52 @@
+
+#ifndef BenchComponent_hpp
+#define BenchComponent_hpp
+
+#include "db/Database.hpp"
+#include "DeviceDescriptorComponent.hpp"
+#include "connection/ConnectionMetrics.hpp"
+#include "events/ChangeStream.hpp"
+#include "metrics/Metrics.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/macro/component.hpp"
+
+/**
+ *  Components the controllers need when their endpoints are called directly from a benchmark.
+ *  Mirrors AppComponent without any server parts.
+ */
+class BenchComponent {
+public:
+
+  DeviceDescriptorComponent deviceComponent;
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, apiObjectMapper)([] {
+    auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    objectMapper->getDeserializer()->getConfig()->allowUnknownFields = true;
+    objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+    return objectMapper;
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Database>, database)([] {
+    OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper);
+    return std::make_shared<Database>(objectMapper);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<ConnectionMetrics>, connectionMetrics)([] {
+    return std::make_shared<ConnectionMetrics>();
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Metrics>, metrics)([] {
+    return Metrics::createShared();
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<ChangeStream>, changeStream)([] {
+    OATPP_COMPONENT(std::shared_ptr<Database>, database);
+    auto stream = ChangeStream::createShared(ChangeStream::Config());
+    database->addChangeListener(stream);
+    return stream;
+  }());
+
+};
+
+#endif /* BenchComponent_hpp */
@@ -0,0 +1,66 @@
+
+#include "BenchReport.hpp"
+#include "BenchReportDto.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::mutex g_mutex;
+std::vector<BenchReport::Result> g_results;
+
+}
+
+void BenchReport::add(const Result& result) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_results.push_back(result);
+}
+
+bool BenchReport::writeToFile(const std::string& path) {
+
+  auto report = BenchReportDto::createShared();
+  report->cores = (v_int32) std::thread::hardware_concurrency();
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (const Result& result : g_results) {
+      auto dto = BenchResultDto::createShared();
+      dto->bench = result.bench.c_str();
+      dto->op = result.op.c_str();
+      if (result.devices > 0) {
+        dto->devices = result.devices;
+      }
+      dto->threads = result.threads;
+      dto->ops = result.ops;
+      dto->nsPerOp = result.nsPerOp;
+      dto->allocsPerOp = result.allocsPerOp;
+      if (result.mbPerSecond > 0) {
+        dto->mbPerSecond = result.mbPerSecond;
+      }
+      if (result.peakMb > 0) {
+        dto->peakMb = result.peakMb;
+      }
+      if (result.cpuNsPerOp > 0) {
+        dto->cpuNsPerOp = result.cpuNsPerOp;
+      }
+      report->results->push_back(dto);
+    }
+  }
+
+  auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+  objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+  objectMapper->getSerializer()->getConfig()->useBeautifier = true;
+  oatpp::String json = objectMapper->writeToString(report);
+
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool success = std::fwrite(json->data(), 1, json->size(), file) == json->size();
+  return std::fclose(file) == 0 && success;
+
+}
@@ -0,0 +1,45 @@
+#ifndef BenchReport_hpp
+#define BenchReport_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <string>
+
+/**
+ *  Results of all benchmarks of a run, written as JSON by `example-iot-hue-ssdp-bench --json <path>`
+ *  so runs of two releases can be diffed. Benchmarks add a result next to the line they log.
+ */
+class BenchReport {
+public:
+
+  struct Result {
+    std::string bench; ///< the benchmark's TAG
+    std::string op; ///< what was measured
+    v_int32 devices = 0; ///< devices in the Database, `0` if not applicable
+    v_int32 threads = 1;
+    v_int64 ops = 0; ///< operations timed
+    v_float64 nsPerOp = 0;
+    v_float64 allocsPerOp = 0;
+    v_float64 mbPerSecond = 0; ///< bytes produced or consumed per second, `0` if not applicable
+    v_float64 peakMb = 0; ///< memory taken on top of what was in use before the op, `0` if not measured
+    v_float64 cpuNsPerOp = 0; ///< CPU time the server took per op, `0` if not measured
+  };
+
+public:
+
+  /**
+   * Add a result. Thread safe.
+   * @param result
+   */
+  static void add(const Result& result);
+
+  /**
+   * Write all results added so far as JSON.
+   * @param path
+   * @return - `false` if the file can't be written
+   */
+  static bool writeToFile(const std::string& path);
+
+};
+
+#endif /* BenchReport_hpp */
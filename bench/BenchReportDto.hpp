@@ -0,0 +1,41 @@
+#ifndef BenchReportDto_hpp
+#define BenchReportDto_hpp
+
+#include "oatpp/core/macro/codegen.hpp"
+#include "oatpp/core/Types.hpp"
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+/*
+ * JSON written by `example-iot-hue-ssdp-bench --json <path>`, see BenchReport
+ */
+
+class BenchResultDto : public oatpp::DTO {
+
+  DTO_INIT(BenchResultDto, DTO);
+
+  DTO_FIELD(String, bench);
+  DTO_FIELD(String, op);
+  DTO_FIELD(Int32, devices);
+  DTO_FIELD(Int32, threads);
+  DTO_FIELD(Int64, ops);
+  DTO_FIELD(Float64, nsPerOp, "ns_per_op");
+  DTO_FIELD(Float64, allocsPerOp, "allocs_per_op");
+  DTO_FIELD(Float64, mbPerSecond, "mb_per_s");
+  DTO_FIELD(Float64, peakMb, "peak_mb");
+  DTO_FIELD(Float64, cpuNsPerOp, "cpu_ns_per_op");
+
+};
+
+class BenchReportDto : public oatpp::DTO {
+
+  DTO_INIT(BenchReportDto, DTO);
+
+  DTO_FIELD(Int32, cores);
+  DTO_FIELD(List<Object<BenchResultDto>>, results) = {};
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#endif /* BenchReportDto_hpp */
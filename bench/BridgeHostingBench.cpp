@@ -0,0 +1,177 @@
+
+#include "BridgeHostingBench.hpp"
+
+#include "BenchReport.hpp"
+#include "HubProcess.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+const char* const TAG = "BENCH[BridgeHostingBench]";
+
+const v_uint32 BRIDGES = 50;
+const v_int32 ROUNDS = 20; ///< requests per bridge
+const v_int32 IDLE_SECONDS = 2;
+
+struct ProcessSample {
+  v_int64 pssBytes = 0; ///< shared pages are split between the processes sharing them
+  v_int64 rssBytes = 0;
+  v_int64 threads = 0;
+  v_int64 cpuTicks = 0; ///< user + system
+};
+
+/**
+ *  A `<field>: <value>` line of a /proc file, `-1` if there is none.
+ */
+v_int64 readProcField(const std::string& path, const char* field) {
+  FILE* file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  char line[256];
+  size_t length = std::strlen(field);
+  v_int64 value = -1;
+  while (std::fgets(line, sizeof(line), file) != nullptr) {
+    if (std::strncmp(line, field, length) == 0 && line[length] == ':') {
+      value = std::strtoll(line + length + 1, nullptr, 10);
+      break;
+    }
+  }
+  std::fclose(file);
+  return value;
+}
+
+/**
+ *  utime + stime of /proc/<pid>/stat in clock ticks, `-1` if it can't be read.
+ */
+v_int64 readCpuTicks(pid_t pid) {
+  FILE* file = std::fopen(("/proc/" + std::to_string(pid) + "/stat").c_str(), "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  char line[1024];
+  bool read = std::fgets(line, sizeof(line), file) != nullptr;
+  std::fclose(file);
+  if (!read) {
+    return -1;
+  }
+  // the command may contain spaces - the fields are counted from its closing parenthesis, utime and stime are 14 and 15
+  const char* fields = std::strrchr(line, ')');
+  if (fields == nullptr) {
+    return -1;
+  }
+  unsigned long long utime = 0;
+  unsigned long long stime = 0;
+  if (std::sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+    return -1;
+  }
+  return (v_int64) (utime + stime);
+}
+
+ProcessSample sample(const std::vector<pid_t>& pids) {
+  ProcessSample result;
+  for (pid_t pid : pids) {
+    std::string proc = "/proc/" + std::to_string(pid);
+    v_int64 pss = readProcField(proc + "/smaps_rollup", "Pss");
+    result.pssBytes += pss > 0 ? pss * 1024 : 0;
+    v_int64 rss = readProcField(proc + "/status", "VmRSS");
+    result.rssBytes += rss > 0 ? rss * 1024 : 0;
+    v_int64 threads = readProcField(proc + "/status", "Threads");
+    result.threads += threads > 0 ? threads : 0;
+    v_int64 ticks = readCpuTicks(pid);
+    result.cpuTicks += ticks > 0 ? ticks : 0;
+  }
+  return result;
+}
+
+void runLayout(const char* name, v_uint32 processes, v_uint16 firstPort) {
+
+  const v_uint32 bridgesPerProcess = BRIDGES / processes;
+  const v_float64 mb = 1024 * 1024;
+  const v_float64 nsPerTick = 1e9 / ::sysconf(_SC_CLK_TCK);
+
+  std::vector<pid_t> pids;
+  for (v_uint32 i = 0; i < processes; i++) {
+    HubProcess::Config hub;
+    hub.port = (v_uint16) (firstPort + i * bridgesPerProcess);
+    hub.bridges = bridgesPerProcess;
+    pid_t pid = HubProcess::spawn(hub);
+    if (pid > 0) {
+      pids.push_back(pid);
+    }
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  bool ready = pids.size() == processes;
+  for (v_uint32 i = 0; i < BRIDGES && ready; i++) {
+    ready = HubProcess::waitForPort((v_uint16) (firstPort + i), deadline);
+  }
+
+  if (ready) {
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500)); // let the start-up settle
+    ProcessSample idleStart = sample(pids);
+    std::this_thread::sleep_for(std::chrono::seconds(IDLE_SECONDS));
+    ProcessSample idleEnd = sample(pids);
+
+    const std::string request = "GET /api/bench/lights HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    v_int32 failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (v_int32 round = 0; round < ROUNDS; round++) {
+      for (v_uint32 i = 0; i < BRIDGES; i++) {
+        failed += HubProcess::get((v_uint16) (firstPort + i), request) ? 0 : 1;
+      }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    ProcessSample loadEnd = sample(pids);
+
+    const v_int64 requests = (v_int64) ROUNDS * BRIDGES;
+    v_float64 idleCpu = (idleEnd.cpuTicks - idleStart.cpuTicks) * nsPerTick / (IDLE_SECONDS * 1e9) * 100;
+    v_float64 cpuPerRequest = (loadEnd.cpuTicks - idleEnd.cpuTicks) * nsPerTick / requests;
+
+    OATPP_LOGD(TAG, "%-22s PSS=%8.2f MB  RSS=%8.2f MB  threads=%4lld  idle CPU=%5.2f%%  CPU/request=%7.1f us  wall/request=%7.1f us  failed=%d",
+               name, idleEnd.pssBytes / mb, idleEnd.rssBytes / mb, (long long) idleEnd.threads, idleCpu,
+               cpuPerRequest / 1e3, (v_float64) elapsed / requests / 1e3, failed);
+
+    BenchReport::Result result;
+    result.bench = TAG;
+    result.devices = 2 * BRIDGES; // the demo devices of every bridge
+    result.threads = (v_int32) idleEnd.threads;
+
+    result.op = std::string(name) + " idle";
+    result.ops = IDLE_SECONDS;
+    result.nsPerOp = 1e9;
+    result.peakMb = idleEnd.pssBytes / mb;
+    result.cpuNsPerOp = (idleEnd.cpuTicks - idleStart.cpuTicks) * nsPerTick / IDLE_SECONDS;
+    BenchReport::add(result);
+
+    result.op = std::string(name) + " GET lights";
+    result.ops = requests;
+    result.nsPerOp = (v_float64) elapsed / requests;
+    result.peakMb = loadEnd.pssBytes / mb;
+    result.cpuNsPerOp = cpuPerRequest;
+    BenchReport::add(result);
+
+  } else {
+    OATPP_LOGE(TAG, "%-22s hub processes did not come up", name);
+  }
+
+  HubProcess::kill(pids);
+
+}
+
+}
+
+void BridgeHostingBench::onRun() {
+  runLayout("1 process x 50 bridges", 1, 8400);
+  runLayout("50 processes x 1 bridge", BRIDGES, 8500);
+}
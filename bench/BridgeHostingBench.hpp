@@ -0,0 +1,23 @@
+#ifndef BridgeHostingBench_hpp
+#define BridgeHostingBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  50 bridges hosted by one process (`--bridges 50`) against 50 processes hosting one bridge each.
+ *  The hub processes are started from the bench executable itself (see HubProcess) and measured from the outside:
+ *  proportional set size and threads of all processes when idle, CPU time they take while idle
+ *  and per request while every bridge is sent the same requests.
+ */
+class BridgeHostingBench : public oatpp::test::UnitTest {
+public:
+
+  BridgeHostingBench()
+    : UnitTest("BENCH[BridgeHostingBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* BridgeHostingBench_hpp */
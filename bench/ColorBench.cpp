@@ -0,0 +1,130 @@
+
+#include "ColorBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchReport.hpp"
+
+#include "color/ColorModel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace {
+
+const char* const TAG = "BENCH[ColorBench]";
+
+/**
+ * Lights in every colormode, spread over the color wheel, the ct range and the xy plane.
+ */
+std::vector<HueDevice> makeLights(v_int32 lightsCount) {
+  std::vector<HueDevice> hueDevices(lightsCount);
+  for (v_int32 i = 0; i < lightsCount; i++) {
+    HueDevice& hueDevice = hueDevices[i];
+    hueDevice.id = i;
+    switch (i % 3) {
+      case 0:
+        hueDevice.mode = HueColorMode::HS;
+        hueDevice.hue = (v_uint16) (i * 97);
+        hueDevice.sat = (v_uint8) (i % 255);
+        break;
+      case 1:
+        hueDevice.mode = HueColorMode::CT;
+        hueDevice.ct = (v_uint16) (ColorModel::MIN_CT + i % (ColorModel::MAX_CT - ColorModel::MIN_CT + 1));
+        break;
+      default:
+        ColorModel::setXy(hueDevice, (i % 71) / 71.0f, (i % 53) / 53.0f);
+    }
+  }
+  return hueDevices;
+}
+
+/**
+ * Run `pass` over all lights until about 4M lights are converted.
+ */
+void measure(const char* name, v_int32 lightsCount, const std::function<void()>& pass) {
+
+  const v_int32 passes = std::max(20, 4000000 / lightsCount);
+
+  auto before = AllocationCounter::sample();
+  auto start = std::chrono::steady_clock::now();
+
+  for (v_int32 i = 0; i < passes; i++) {
+    pass();
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto after = AllocationCounter::sample();
+
+  v_float64 ops = (v_float64) passes * lightsCount;
+  v_float64 nsPerLight = (v_float64) elapsed / ops;
+  v_float64 allocsPerLight = (v_float64) (after.allocations - before.allocations) / ops;
+  OATPP_LOGD(TAG, "%-16s lights=%6d: %7.2f ns/light %6.3f allocs/light", name, lightsCount, nsPerLight, allocsPerLight);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = name;
+  result.devices = lightsCount;
+  result.ops = (v_int64) ops;
+  result.nsPerOp = nsPerLight;
+  result.allocsPerOp = allocsPerLight;
+  BenchReport::add(result);
+
+}
+
+void runConversions(v_int32 lightsCount) {
+
+  std::vector<HueDevice> hueDevices = makeLights(lightsCount);
+  std::vector<ColorModel::Color> colors(lightsCount);
+
+  // what the read paths did before batches - a light at a time
+  measure("convert light", lightsCount, [&hueDevices, &colors] {
+    for (size_t i = 0; i < hueDevices.size(); i++) {
+      colors[i] = ColorModel::convert(hueDevices[i]);
+    }
+  });
+
+  measure("convert batch", lightsCount, [&hueDevices, &colors] {
+    ColorModel::convert(hueDevices.data(), colors.data(), hueDevices.size());
+  });
+
+  // the kernels alone, without gathering and scattering the records
+  std::vector<float> hue(lightsCount), sat(lightsCount), ct(lightsCount), x(lightsCount), y(lightsCount);
+  for (v_int32 i = 0; i < lightsCount; i++) {
+    hue[i] = (float) ((i * 97) % 65536);
+    sat[i] = (float) (i % 255);
+    ct[i] = (float) (ColorModel::MIN_CT + i % (ColorModel::MAX_CT - ColorModel::MIN_CT + 1));
+  }
+
+  measure("hueSatToXy", lightsCount, [&] {
+    ColorModel::hueSatToXy(hue.data(), sat.data(), x.data(), y.data(), x.size());
+  });
+
+  measure("clampToGamut", lightsCount, [&] {
+    ColorModel::clampToGamut(ColorModel::GAMUT_B, x.data(), y.data(), x.size());
+  });
+
+  measure("xyToHueSat", lightsCount, [&] {
+    ColorModel::xyToHueSat(x.data(), y.data(), hue.data(), sat.data(), x.size());
+  });
+
+  measure("ctToXy", lightsCount, [&] {
+    ColorModel::ctToXy(ct.data(), x.data(), y.data(), x.size());
+  });
+
+  measure("xyToCt", lightsCount, [&] {
+    ColorModel::xyToCt(x.data(), y.data(), ct.data(), x.size());
+  });
+
+}
+
+}
+
+void ColorBench::onRun() {
+
+  for (v_int32 lights = 10; lights <= 100000; lights *= 10) {
+    runConversions(lights);
+  }
+
+}
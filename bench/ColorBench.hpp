@@ -0,0 +1,21 @@
+#ifndef ColorBench_hpp
+#define ColorBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Throughput of the ColorModel conversions - a light at a time, as a batch of lights,
+ *  and the bare kernels - versus the number of lights converted.
+ */
+class ColorBench : public oatpp::test::UnitTest {
+public:
+
+  ColorBench()
+    : UnitTest("BENCH[ColorBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ColorBench_hpp */
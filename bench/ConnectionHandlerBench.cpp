@@ -0,0 +1,100 @@
+
+#include "ConnectionHandlerBench.hpp"
+
+#include "BenchComponent.hpp"
+#include "LatencyClient.hpp"
+
+#include "controller/HueDeviceController.hpp"
+#include "controller/HueDeviceAsyncController.hpp"
+#include "connection/ConnectionPolicyInterceptor.hpp"
+#include "connection/TrackedConnectionHandler.hpp"
+
+#include "oatpp/web/server/AsyncHttpConnectionHandler.hpp"
+#include "oatpp/web/server/HttpConnectionHandler.hpp"
+#include "oatpp/web/server/HttpRouter.hpp"
+#include "oatpp/network/tcp/server/ConnectionProvider.hpp"
+#include "oatpp/network/Server.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <thread>
+
+namespace {
+
+const char* const TAG = "BENCH[ConnectionHandlerBench]";
+
+const v_int32 CONNECTIONS = 1000;
+const v_int32 REQUESTS = 20000;
+
+void runMode(bool async, v_uint16 port, const char* path) {
+
+  OATPP_COMPONENT(std::shared_ptr<ConnectionMetrics>, metrics);
+  auto interceptor = ConnectionPolicyInterceptor::createShared(ConnectionPolicy(), metrics); // Connection: close
+
+  auto router = oatpp::web::server::HttpRouter::createShared();
+  std::shared_ptr<oatpp::async::Executor> executor;
+  std::shared_ptr<oatpp::network::ConnectionHandler> handler;
+
+  if (async) {
+    executor = std::make_shared<oatpp::async::Executor>(4, 1, 1);
+    router->addController(HueDeviceAsyncController::createShared());
+    auto asyncHandler = oatpp::web::server::AsyncHttpConnectionHandler::createShared(router, executor);
+    asyncHandler->addResponseInterceptor(interceptor);
+    handler = asyncHandler;
+  } else {
+    router->addController(HueDeviceController::createShared());
+    auto syncHandler = oatpp::web::server::HttpConnectionHandler::createShared(router);
+    syncHandler->addResponseInterceptor(interceptor);
+    handler = syncHandler;
+  }
+  handler = TrackedConnectionHandler::createShared(handler, metrics);
+
+  auto provider = oatpp::network::tcp::server::ConnectionProvider::createShared({"127.0.0.1", port, oatpp::network::Address::IP_4});
+  oatpp::network::Server server(provider, handler);
+  std::thread serverThread([&server] {
+    server.run();
+  });
+
+  std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+  auto result = LatencyClient::run("127.0.0.1", port, request, CONNECTIONS, REQUESTS);
+
+  server.stop();
+  provider->stop();
+  handler->stop();
+  serverThread.join();
+
+  if (executor) {
+    executor->waitTasksFinished();
+    executor->stop();
+    executor->join();
+  }
+
+  OATPP_LOGD(TAG, "%-6s %-22s %8.0f req/s  p50=%7.2f ms  p99=%7.2f ms  max=%7.2f ms  failed=%lld",
+             async ? "async" : "sync", path,
+             result.succeeded / (result.elapsedNs / 1e9),
+             result.percentile(0.5) / 1e6,
+             result.percentile(0.99) / 1e6,
+             result.percentile(1.0) / 1e6,
+             (long long) result.failed);
+
+}
+
+}
+
+void ConnectionHandlerBench::onRun() {
+
+  LatencyClient::raiseFileLimit();
+
+  BenchComponent component;
+
+  OATPP_COMPONENT(std::shared_ptr<Database>, database);
+  for (v_int32 i = 0; i < 20; i++) {
+    database->registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+
+  v_uint16 port = 8301;
+  for (const char* path : {"/description.xml", "/api/bench/lights", "/api/bench/lights/1"}) {
+    runMode(false, port++, path);
+    runMode(true, port++, path);
+  }
+
+}
@@ -0,0 +1,21 @@
+#ifndef ConnectionHandlerBench_hpp
+#define ConnectionHandlerBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Latency of the Hue API served over loopback at 1k concurrent connections,
+ *  thread-per-connection HttpConnectionHandler versus AsyncHttpConnectionHandler with coroutine endpoints.
+ */
+class ConnectionHandlerBench : public oatpp::test::UnitTest {
+public:
+
+  ConnectionHandlerBench()
+    : UnitTest("BENCH[ConnectionHandlerBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ConnectionHandlerBench_hpp */
@@ -0,0 +1,186 @@
+
+#include "DatabaseBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchReport.hpp"
+
+#include "db/Database.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const TAG = "BENCH[DatabaseBench]";
+
+/**
+ * Run `op(thread, i)` `opsPerThread` times on each of `threadsCount` threads.
+ * ns/op is the wall time divided by the operations of all threads.
+ * @param op - returns the bytes it produced, `0` if throughput doesn't apply
+ */
+template<class Op>
+void measure(const char* name, v_int32 devicesCount, v_int32 threadsCount, v_int64 opsPerThread, const Op& op) {
+
+  std::atomic<bool> go(false);
+  std::atomic<v_int64> bytes(0);
+  std::vector<std::thread> threads;
+  for(v_int32 t = 0; t < threadsCount; t++) {
+    threads.push_back(std::thread([&, t] {
+      v_int64 produced = 0;
+      while(!go.load()) {}
+      for(v_int64 i = 0; i < opsPerThread; i++) {
+        produced += op(t, i);
+      }
+      bytes += produced;
+    }));
+  }
+
+  auto before = AllocationCounter::sample();
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  for(auto& t : threads) {
+    t.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto after = AllocationCounter::sample();
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = name;
+  result.devices = devicesCount;
+  result.threads = threadsCount;
+  result.ops = opsPerThread * threadsCount;
+  result.nsPerOp = (v_float64) elapsed / result.ops;
+  result.allocsPerOp = (v_float64) (after.allocations - before.allocations) / result.ops;
+  result.mbPerSecond = bytes.load() / (elapsed / 1e9) / (1024 * 1024);
+  BenchReport::add(result);
+
+  OATPP_LOGD(TAG, "%-26s devices=%6d threads=%2d: %12.1f ns/op %8.1f allocs/op %8.1f MB/s",
+             name, devicesCount, threadsCount, result.nsPerOp, result.allocsPerOp, result.mbPerSecond);
+
+}
+
+oatpp::String makeName(v_int64 i) {
+  return "Light-" + oatpp::utils::conversion::int64ToStr(i);
+}
+
+void runDatabase(v_int32 devicesCount, v_int32 threadsCount) {
+
+  // registration into an empty Database, the threads split the devices between them
+  {
+    Database db;
+    measure("registerHueDevice", devicesCount, threadsCount, std::max(1, devicesCount / threadsCount), [&](v_int32 t, v_int64 i) {
+      db.registerHueDevice(makeName(t * devicesCount + i));
+      return 0;
+    });
+  }
+
+  {
+    Database db;
+    auto dto = HueDeviceDto::createShared();
+    dto->state->on = true;
+    dto->state->bri = 100;
+    measure("createHueDevice", devicesCount, threadsCount, std::max(1, devicesCount / threadsCount), [&](v_int32 t, v_int64 i) {
+      auto copy = HueDeviceDto::createShared(); // serializeFromDto
+      copy->name = makeName(t * devicesCount + i);
+      copy->state = dto->state;
+      db.createHueDevice(copy);
+      return 0;
+    });
+  }
+
+  Database db;
+  for(v_int32 i = 0; i < devicesCount; i++) {
+    db.registerHueDevice(makeName(i));
+  }
+  // the first generation of slot `i` has the HueDeviceId `i`
+  auto id = [devicesCount](v_int32 t, v_int64 i) {
+    return (v_int32) ((i * 7919 + t * 104729) % devicesCount);
+  };
+
+  const v_int64 ops = 20000;
+  const v_int64 listOps = std::max<v_int64>(2, 200000 / devicesCount); // a list holds all devices
+
+  measure("updateHueDeviceState(dto)", devicesCount, threadsCount, ops / threadsCount, [&](v_int32 t, v_int64 i) {
+    auto state = HueDeviceStateDto::createShared();
+    state->bri = (v_uint8) (i % 254);
+    db.updateHueDeviceState(id(t, i), state);
+    return 0;
+  });
+
+  measure("updateHueDeviceState", devicesCount, threadsCount, ops / threadsCount, [&](v_int32 t, v_int64 i) {
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_BRI;
+    update.bri = (v_uint8) (i % 254);
+    HueDevice updated;
+    db.updateHueDeviceState(id(t, i), update, updated);
+    return 0;
+  });
+
+  measure("getHueDeviceById", devicesCount, threadsCount, ops / threadsCount, [&](v_int32 t, v_int64 i) {
+    db.getHueDeviceById(id(t, i)); // deserializeToDto
+    return 0;
+  });
+
+  measure("getHueDeviceJsonById", devicesCount, threadsCount, ops / threadsCount, [&](v_int32 t, v_int64 i) {
+    return (v_int64) db.getHueDeviceJsonById(id(t, i))->size();
+  });
+
+  measure("getHueDevices", devicesCount, threadsCount, std::max<v_int64>(1, listOps / threadsCount), [&](v_int32, v_int64) {
+    db.getHueDevices();
+    return 0;
+  });
+
+  measure("getHueDevicesJson", devicesCount, threadsCount, std::max<v_int64>(1, listOps / threadsCount), [&](v_int32, v_int64) {
+    return (v_int64) db.getHueDevicesJson()->size();
+  });
+
+}
+
+void runSerialization() {
+
+  auto objectMapper = Database::createDefaultObjectMapper();
+  auto dto = HueDeviceDto::createShared();
+  dto->name = "Oat";
+  dto->uniqueid = "f807566a0001";
+  dto->state->on = true;
+  dto->state->bri = 254;
+  dto->state->hue = 10000;
+  dto->state->sat = 200;
+  dto->state->ct = 366;
+  dto->state->colormode = "ct";
+  oatpp::String json = objectMapper->writeToString(dto);
+
+  const v_int64 ops = 100000;
+
+  measure("HueDeviceDto writeToString", 0, 1, ops, [&](v_int32, v_int64) {
+    return (v_int64) objectMapper->writeToString(dto)->size();
+  });
+
+  measure("HueDeviceDto readFromString", 0, 1, ops, [&](v_int32, v_int64) {
+    objectMapper->readFromString<oatpp::Object<HueDeviceDto>>(json);
+    return (v_int64) json->size();
+  });
+
+}
+
+}
+
+void DatabaseBench::onRun() {
+
+  const v_int32 cores = std::max<v_int32>(2, (v_int32) std::thread::hardware_concurrency());
+
+  for(v_int32 devices : {10, 1000, 100000}) {
+    for(v_int32 threads : {1, cores}) {
+      runDatabase(devices, threads);
+    }
+  }
+
+  runSerialization();
+
+}
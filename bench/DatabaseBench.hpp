@@ -0,0 +1,21 @@
+#ifndef DatabaseBench_hpp
+#define DatabaseBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  ns/op and allocations/op of the Database's API across device and thread counts,
+ *  plus the JSON serialization throughput of HueDeviceDto.
+ */
+class DatabaseBench : public oatpp::test::UnitTest {
+public:
+
+  DatabaseBench()
+    : UnitTest("BENCH[DatabaseBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* DatabaseBench_hpp */
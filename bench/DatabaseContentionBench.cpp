@@ -0,0 +1,81 @@
+
+#include "DatabaseContentionBench.hpp"
+
+#include "legacy/SpinLockDatabase.hpp"
+#include "db/Database.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const TAG = "BENCH[DatabaseContentionBench]";
+
+template<class Db>
+void runContention(const char* storeName, v_int32 devicesCount, v_int32 readersCount, v_int32 writersCount, v_int32 iterations) {
+
+  Db db;
+  for(v_int32 i = 0; i < devicesCount; i++) {
+    db.registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+
+  for(v_int32 r = 0; r < readersCount; r++) {
+    threads.push_back(std::thread([&db, &go, devicesCount, iterations] {
+      while(!go.load()) {}
+      for(v_int32 i = 0; i < iterations; i++) {
+        db.getHueDevices();
+        db.getHueDeviceById(i % devicesCount);
+      }
+    }));
+  }
+
+  for(v_int32 w = 0; w < writersCount; w++) {
+    threads.push_back(std::thread([&db, &go, devicesCount, iterations] {
+      auto state = HueDeviceStateDto::createShared();
+      while(!go.load()) {}
+      for(v_int32 i = 0; i < iterations; i++) {
+        state->bri = (v_uint8) (i % 254);
+        db.updateHueDeviceState(i % devicesCount, state);
+      }
+    }));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  for(auto& t : threads) {
+    t.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  v_float64 seconds = elapsed / 1000000.0;
+
+  OATPP_LOGD(TAG, "%-9s devices=%5d readers=%2d writers=%2d: %10.0f reads/s %10.0f writes/s (%lld us)",
+             storeName, devicesCount, readersCount, writersCount,
+             (readersCount * iterations) / seconds,
+             (writersCount * iterations) / seconds,
+             (long long) elapsed);
+
+}
+
+}
+
+void DatabaseContentionBench::onRun() {
+
+  const v_int32 iterations = 2000;
+  const v_int32 cores = std::max<v_int32>(2, (v_int32) std::thread::hardware_concurrency());
+
+  for(v_int32 devices : {2, 100}) {
+    for(v_int32 readers : {1, cores - 1, cores * 2}) {
+      runContention<legacy::SpinLockDatabase>("spinlock", devices, readers, 1, iterations);
+      runContention<Database>("snapshot", devices, readers, 1, iterations);
+    }
+  }
+
+}
@@ -0,0 +1,22 @@
+
+#ifndef DatabaseContentionBench_hpp
+#define DatabaseContentionBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Readers polling the device list while writers push state updates.
+ *  Compares the copy-on-write snapshot Database with the original SpinLock store.
+ */
+class DatabaseContentionBench : public oatpp::test::UnitTest {
+public:
+
+  DatabaseContentionBench()
+    : UnitTest("BENCH[DatabaseContentionBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* DatabaseContentionBench_hpp */
@@ -0,0 +1,73 @@
+
+#include "DescriptionBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchReport.hpp"
+#include "BenchComponent.hpp"
+#include "legacy/DescriptionRenderer.hpp"
+
+#include "controller/HueDeviceController.hpp"
+
+#include <chrono>
+
+namespace {
+
+const char* const TAG = "BENCH[DescriptionBench]";
+
+template<class Handler>
+void runHandler(const char* name, const Handler& handler, v_int32 requests) {
+
+  auto before = AllocationCounter::sample();
+  auto start = std::chrono::steady_clock::now();
+
+  for(v_int32 i = 0; i < requests; i++) {
+    auto response = handler();
+    (void) response;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto after = AllocationCounter::sample();
+
+  OATPP_LOGD(TAG, "%-28s %12.0f requests/s %6.1f allocations/request",
+             name,
+             requests / (elapsed / 1e9),
+             (v_float64) (after.allocations - before.allocations) / requests);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = name;
+  result.ops = requests;
+  result.nsPerOp = (v_float64) elapsed / requests;
+  result.allocsPerOp = (v_float64) (after.allocations - before.allocations) / requests;
+  BenchReport::add(result);
+
+}
+
+}
+
+void DescriptionBench::onRun() {
+
+  const v_int32 requests = 200000;
+
+  BenchComponent component;
+
+  OATPP_COMPONENT(std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>, desc);
+  auto hueController = HueDeviceController::createShared();
+
+  runHandler("description.xml rendered", [&desc] {
+    return legacy::DescriptionRenderer::description(*desc);
+  }, requests);
+
+  runHandler("description.xml pre-rendered", [&hueController] {
+    return hueController->description();
+  }, requests);
+
+  runHandler("M-SEARCH rendered", [&desc] {
+    return legacy::DescriptionRenderer::search(*desc);
+  }, requests);
+
+  runHandler("M-SEARCH pre-rendered", [&desc] {
+    return desc->getRendered()->searchResponses.back(); // the datagram SsdpServer sends for the device type
+  }, requests);
+
+}
@@ -0,0 +1,22 @@
+
+#ifndef DescriptionBench_hpp
+#define DescriptionBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Requests/sec and allocations/request of the `description` and `M-SEARCH` handlers,
+ *  rendering per request (original) versus serving the pre-rendered DeviceDescriptor buffers.
+ */
+class DescriptionBench : public oatpp::test::UnitTest {
+public:
+
+  DescriptionBench()
+    : UnitTest("BENCH[DescriptionBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* DescriptionBench_hpp */
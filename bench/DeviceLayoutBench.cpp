@@ -0,0 +1,72 @@
+
+#include "DeviceLayoutBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "legacy/SpinLockDatabase.hpp"
+#include "db/Database.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <chrono>
+
+namespace {
+
+const char* const TAG = "BENCH[DeviceLayoutBench]";
+
+struct BrightnessSum {
+
+  v_int64* sum;
+
+  void operator()(const HueDevice& hueDevice) const {
+    *sum += hueDevice.bri;
+  }
+
+  void operator()(const legacy::SpinLockDatabase::HueDevice& hueDevice) const {
+    *sum += *hueDevice.bri;
+  }
+
+};
+
+template<class Db>
+void runLayout(const char* storeName, v_int32 devicesCount, v_int32 rounds) {
+
+  auto before = AllocationCounter::sample();
+
+  Db db;
+  for(v_int32 i = 0; i < devicesCount; i++) {
+    db.registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+
+  auto after = AllocationCounter::sample();
+
+  v_int64 sum = 0;
+  BrightnessSum visitor {&sum};
+  auto start = std::chrono::steady_clock::now();
+  for(v_int32 i = 0; i < rounds; i++) {
+    db.forEachHueDevice(visitor);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  OATPP_LOGD(TAG, "%-9s devices=%6d: %7.1f bytes/device %7.1f allocations/device, full iteration %10.1f us (%.2f ns/device) [checksum %lld]",
+             storeName, devicesCount,
+             (v_float64) (after.liveBytes - before.liveBytes) / devicesCount,
+             (v_float64) (after.allocations - before.allocations) / devicesCount,
+             (v_float64) elapsed / rounds / 1000.0,
+             (v_float64) elapsed / rounds / devicesCount,
+             (long long) sum);
+
+}
+
+}
+
+void DeviceLayoutBench::onRun() {
+
+  OATPP_LOGD(TAG, "sizeof(HueDevice): legacy=%d, packed=%d",
+             (v_int32) sizeof(legacy::SpinLockDatabase::HueDevice), (v_int32) sizeof(HueDevice));
+
+  for(v_int32 devices : {10000, 100000}) {
+    runLayout<legacy::SpinLockDatabase>("boxed", devices, 50);
+    runLayout<Database>("packed", devices, 50);
+  }
+
+}
@@ -0,0 +1,22 @@
+
+#ifndef DeviceLayoutBench_hpp
+#define DeviceLayoutBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Memory per device and full-table iteration time of the packed HueDevice pages
+ *  compared to the original boxed records in an unordered_map.
+ */
+class DeviceLayoutBench : public oatpp::test::UnitTest {
+public:
+
+  DeviceLayoutBench()
+    : UnitTest("BENCH[DeviceLayoutBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* DeviceLayoutBench_hpp */
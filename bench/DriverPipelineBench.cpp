@@ -0,0 +1,113 @@
+
+#include "DriverPipelineBench.hpp"
+
+#include "driver/DriverPipeline.hpp"
+#include "driver/FileLightDriver.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const TAG = "BENCH[DriverPipelineBench]";
+
+const v_int32 DEVICES_COUNT = 16;
+const v_int32 WRITERS_COUNT = 4;
+const v_int32 LATENCY_MS = 2; ///< simulated bus time per frame
+
+/**
+ * @param pipelined - feed the driver through a DriverPipeline instead of calling it after every update
+ */
+void runWriters(const char* name, bool pipelined, v_int32 iterations) {
+
+  auto db = std::make_shared<Database>();
+  for(v_int32 i = 0; i < DEVICES_COUNT; i++) {
+    db->registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+
+  auto driver = FileLightDriver::createShared("/dev/null", LATENCY_MS);
+  std::mutex driverMutex; // the inline driver is shared by all writers, like a bus
+
+  std::shared_ptr<DriverPipeline> pipeline;
+  if (pipelined) {
+    pipeline = DriverPipeline::createShared(db, driver, DriverPipeline::Config());
+    db->addChangeListener(pipeline);
+  }
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for(v_int32 w = 0; w < WRITERS_COUNT; w++) {
+    threads.push_back(std::thread([&, w] {
+      HueStateUpdate update;
+      update.fields = HueStateUpdate::FIELD_BRI;
+      HueDevice updated;
+      LightDriver::Frame frame;
+      while(!go.load()) {}
+      for(v_int32 i = 0; i < iterations; i++) {
+        update.bri = (v_uint8) (i % 254);
+        db->updateHueDeviceState((i + w) % DEVICES_COUNT, update, updated);
+        if (!pipelined) {
+          // the old way - the handler drives the light before it answers
+          std::lock_guard<std::mutex> lock(driverMutex);
+          frame.sequence++;
+          frame.lights.assign(1, updated);
+          driver->writeFrame(frame);
+        }
+      }
+    }));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  for(auto& t : threads) {
+    t.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  v_float64 seconds = elapsed / 1000000.0;
+
+  pipeline.reset(); // writes the last frame
+
+  OATPP_LOGD(TAG, "%-8s writers=%d: %10.0f updates/s (%lld us)",
+             name, WRITERS_COUNT, (WRITERS_COUNT * iterations) / seconds, (long long) elapsed);
+
+}
+
+}
+
+void DriverPipelineBench::onRun() {
+
+  runWriters("inline", false, 100);
+  runWriters("pipeline", true, 100);
+
+  // coalescing under a sustained load
+  auto db = std::make_shared<Database>();
+  for(v_int32 i = 0; i < DEVICES_COUNT; i++) {
+    db->registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+  auto pipeline = DriverPipeline::createShared(db, FileLightDriver::createShared("/dev/null", LATENCY_MS), DriverPipeline::Config());
+  db->addChangeListener(pipeline);
+
+  HueStateUpdate update;
+  update.fields = HueStateUpdate::FIELD_BRI;
+  HueDevice updated;
+  auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  v_int64 updates = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    update.bri = (v_uint8) (updates % 254);
+    db->updateHueDeviceState((v_int32) (updates % DEVICES_COUNT), update, updated);
+    updates++;
+  }
+
+  auto stats = pipeline->getStats();
+  OATPP_LOGD(TAG, "%lld updates in 1s: %lld queued, %lld dropped, %lld frames, %lld lights written, coalescing %.1f:1, %lld resyncs",
+             (long long) updates, (long long) stats.commandsQueued, (long long) stats.commandsDropped,
+             (long long) stats.framesWritten, (long long) stats.lightsWritten,
+             stats.lightsWritten > 0 ? (v_float64) stats.commandsQueued / stats.lightsWritten : 0.0,
+             (long long) stats.resyncs);
+
+}
@@ -0,0 +1,21 @@
+#ifndef DriverPipelineBench_hpp
+#define DriverPipelineBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  State updates per second with a slow LightDriver called inline by the writers
+ *  versus fed through the DriverPipeline, plus the pipeline's coalescing ratio.
+ */
+class DriverPipelineBench : public oatpp::test::UnitTest {
+public:
+
+  DriverPipelineBench()
+    : UnitTest("BENCH[DriverPipelineBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* DriverPipelineBench_hpp */
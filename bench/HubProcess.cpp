@@ -0,0 +1,105 @@
+#include "HubProcess.hpp"
+
+#include "bridge/BridgeHost.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+pid_t HubProcess::spawn(const Config& config) {
+  std::string portArg = std::to_string(config.port);
+  std::string countArg = std::to_string(config.bridges);
+  std::string shardsArg = std::to_string(config.shards);
+  pid_t pid = ::fork();
+  if (pid == 0) {
+    int devNull = ::open("/dev/null", O_WRONLY);
+    if (devNull >= 0) {
+      ::dup2(devNull, STDOUT_FILENO);
+      ::dup2(devNull, STDERR_FILENO);
+    }
+    const char* argv[] = {"example-iot-hue-ssdp-bench", "--bridge-process", portArg.c_str(), "--bridge-count", countArg.c_str(),
+                          "--shards", shardsArg.c_str(), config.pinShards ? "--pin-shards" : nullptr, nullptr};
+    ::execv("/proc/self/exe", (char* const*) argv);
+    ::_exit(127);
+  }
+  return pid;
+}
+
+void HubProcess::serve(const Config& hub) {
+
+  AppConfig config;
+  config.port = hub.port;
+  config.bridges = hub.bridges;
+  config.shards = hub.shards;
+  config.pinShards = hub.pinShards;
+  config.ssdp.host = "127.0.0.1";
+  config.ssdp.port = hub.port; // every process has an SSDP socket of its own, like separately started hubs
+  config.ssdp.multicastGroup = "";
+  config.ssdp.notifyHost = ""; // no announcements from the bench
+
+  auto components = std::make_shared<AppComponent>(config);
+  for (auto& bridge : *components->bridges.getObject()) {
+    bridge->getDatabase()->registerHueDevice("Oat");
+    bridge->getDatabase()->registerHueDevice("Grain");
+  }
+
+  BridgeHost host(components);
+  host.start();
+
+  auto ssdp = components->ssdpServer.getObject();
+  ssdp->run(); // until the process is killed
+
+}
+
+bool HubProcess::get(v_uint16 port, const std::string& request) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, (sockaddr*) &address, sizeof(address)) != 0 ||
+      ::send(fd, request.data(), request.size(), 0) != (ssize_t) request.size()) {
+    ::close(fd);
+    return false;
+  }
+  char buffer[16 * 1024];
+  v_int64 bytes = 0;
+  ssize_t size;
+  while ((size = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    bytes += size;
+  }
+  ::close(fd);
+  return size == 0 && bytes > 0;
+}
+
+bool HubProcess::waitForPort(v_uint16 port, std::chrono::steady_clock::time_point deadline) {
+  const std::string request = "GET /description.xml HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (get(port, request)) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return false;
+}
+
+void HubProcess::kill(const std::vector<pid_t>& pids) {
+  for (pid_t pid : pids) {
+    if (pid <= 0) {
+      continue; // not started - kill(-1) would kill every process of the user
+    }
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef HubProcess_hpp
+#define HubProcess_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ *  Hubs run by benchmarks in processes of their own, started from the bench executable itself:
+ *  `example-iot-hue-ssdp-bench --bridge-process <port> --bridge-count <n> --shards <n> [--pin-shards]`.
+ *  Every process is a fresh image, nothing is shared with the benchmark but the pages of the executable
+ *  and its libraries, as with separately started hubs.
+ */
+class HubProcess {
+public:
+
+  struct Config {
+    v_uint16 port = 8000; ///< of the first bridge, the SSDP port has the same number
+    v_uint32 bridges = 1;
+    v_uint32 shards = 1;
+    bool pinShards = false;
+  };
+
+public:
+
+  /**
+   * Start a hub process, its output goes to /dev/null.
+   * @param config
+   * @return - pid, `-1` if it couldn't be forked
+   */
+  static pid_t spawn(const Config& config);
+
+  /**
+   * Run a hub with the demo devices on every bridge until the process is killed.
+   * Called by the bench executable in the processes started with spawn().
+   * @param config
+   */
+  static void serve(const Config& config);
+
+  /**
+   * Send one request and read the response until the server closes the connection.
+   * @param port
+   * @param request - with `Connection: close`
+   * @return - `true` if a response was read
+   */
+  static bool get(v_uint16 port, const std::string& request);
+
+  /**
+   * Wait until the port serves `GET /description.xml`.
+   * @param port
+   * @param deadline
+   * @return - `false` if it didn't before the deadline
+   */
+  static bool waitForPort(v_uint16 port, std::chrono::steady_clock::time_point deadline);
+
+  /**
+   * Kill the processes and wait for them to exit. Pids of processes that couldn't be started are skipped.
+   * @param pids
+   */
+  static void kill(const std::vector<pid_t>& pids);
+
+};
+
+#endif /* HubProcess_hpp */
@@ -0,0 +1,168 @@
+
+#include "LatencyClient.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Connection {
+  int fd;
+  Clock::time_point start;
+  size_t sent;
+  bool reading;
+  char status[13]; // "HTTP/1.1 200"
+  size_t statusSize;
+};
+
+int openConnection(const sockaddr_in& address) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  if (::connect(fd, (const sockaddr*) &address, sizeof(address)) != 0 && errno != EINPROGRESS) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}
+
+v_int64 LatencyClient::Result::percentile(v_float64 p) const {
+  if (latenciesNs.empty()) {
+    return 0;
+  }
+  size_t index = (size_t) (p * (latenciesNs.size() - 1) + 0.5);
+  return latenciesNs[index];
+}
+
+void LatencyClient::raiseFileLimit() {
+  rlimit limit;
+  if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+
+LatencyClient::Result LatencyClient::run(const char* ip, v_uint16 port, const std::string& request, v_int32 concurrency, v_int32 requests) {
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  ::inet_pton(AF_INET, ip, &address.sin_addr);
+
+  Result result;
+  result.latenciesNs.reserve((size_t) requests);
+
+  std::vector<Connection> connections;
+  std::vector<pollfd> pollFds;
+  connections.reserve((size_t) concurrency);
+  pollFds.reserve((size_t) concurrency);
+
+  char buffer[16 * 1024];
+  v_int32 started = 0;
+  auto begin = Clock::now();
+
+  while (started < requests || !connections.empty()) {
+
+    while (started < requests && (v_int32) connections.size() < concurrency) {
+      started++;
+      Connection connection;
+      connection.start = Clock::now();
+      connection.fd = openConnection(address);
+      connection.sent = 0;
+      connection.reading = false;
+      connection.statusSize = 0;
+      if (connection.fd < 0) {
+        result.failed++;
+        continue;
+      }
+      connections.push_back(connection);
+    }
+
+    pollFds.resize(connections.size());
+    for (size_t i = 0; i < connections.size(); i++) {
+      pollFds[i].fd = connections[i].fd;
+      pollFds[i].events = connections[i].reading ? POLLIN : POLLOUT;
+      pollFds[i].revents = 0;
+    }
+
+    if (::poll(pollFds.data(), (nfds_t) pollFds.size(), 1000) < 0 && errno != EINTR) {
+      break;
+    }
+
+    for (size_t i = connections.size(); i-- > 0;) {
+
+      if (pollFds[i].revents == 0) {
+        continue;
+      }
+
+      Connection& connection = connections[i];
+      bool done = false;
+      bool failed = false;
+
+      if (!connection.reading) {
+        auto res = ::send(connection.fd, request.data() + connection.sent, request.size() - connection.sent, MSG_NOSIGNAL);
+        if (res > 0) {
+          connection.sent += (size_t) res;
+          connection.reading = connection.sent == request.size();
+        } else if (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+          done = failed = true;
+        }
+      } else {
+        while (true) {
+          auto res = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+          if (res > 0) {
+            size_t n = std::min((size_t) res, sizeof(connection.status) - 1 - connection.statusSize);
+            std::memcpy(connection.status + connection.statusSize, buffer, n);
+            connection.statusSize += n;
+          } else if (res == 0) {
+            connection.status[connection.statusSize] = 0;
+            done = true;
+            failed = std::strncmp(connection.status, "HTTP/1.1 2", 10) != 0;
+            break;
+          } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+              done = failed = true;
+            }
+            break;
+          }
+        }
+      }
+
+      if (done) {
+        if (failed) {
+          result.failed++;
+        } else {
+          result.succeeded++;
+          result.latenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - connection.start).count());
+        }
+        ::close(connection.fd);
+        connections[i] = connections.back();
+        connections.pop_back();
+      }
+
+    }
+
+  }
+
+  result.elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+  std::sort(result.latenciesNs.begin(), result.latenciesNs.end());
+  return result;
+
+}
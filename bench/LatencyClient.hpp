@@ -0,0 +1,51 @@
+#ifndef LatencyClient_hpp
+#define LatencyClient_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ *  Minimal HTTP load client for the benchmarks.
+ *  Keeps `concurrency` connections in flight from a single poll() loop, every connection sends one raw request
+ *  and reads the response until the server closes the connection (the hub answers with `Connection: close`).
+ *  Latency is measured from connect() to the end of the response, so it includes connection setup on the server.
+ */
+class LatencyClient {
+public:
+
+  struct Result {
+    v_int64 succeeded = 0;
+    v_int64 failed = 0;
+    v_int64 elapsedNs = 0;
+    std::vector<v_int64> latenciesNs; ///< sorted ascending
+
+    /**
+     * @param p - percentile in [0, 1]
+     * @return - latency in nanoseconds, 0 if nothing succeeded
+     */
+    v_int64 percentile(v_float64 p) const;
+  };
+
+public:
+
+  /**
+   * Run the load.
+   * @param ip - IPv4 address of the server
+   * @param port - port of the server
+   * @param request - raw HTTP request sent on every connection
+   * @param concurrency - number of connections kept open at the same time
+   * @param requests - total number of requests
+   * @return - Result
+   */
+  static Result run(const char* ip, v_uint16 port, const std::string& request, v_int32 concurrency, v_int32 requests);
+
+  /**
+   * Raise the soft open-files limit to the hard limit, the client and the server need two descriptors per connection.
+   */
+  static void raiseFileLimit();
+
+};
+
+#endif /* LatencyClient_hpp */
@@ -0,0 +1,229 @@
+
+#include "LightsStreamBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchComponent.hpp"
+#include "BenchReport.hpp"
+
+#include "controller/HueDeviceController.hpp"
+
+#include "oatpp/web/server/HttpConnectionHandler.hpp"
+#include "oatpp/web/server/HttpRouter.hpp"
+#include "oatpp/network/tcp/server/ConnectionProvider.hpp"
+#include "oatpp/network/Server.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const TAG = "BENCH[LightsStreamBench]";
+
+const v_int32 DEVICES = 50000;
+const v_int32 REQUESTS = 20;
+
+/**
+ *  The lights object rendered into one buffer - `GET /api/{username}/lights` before it was streamed.
+ */
+class BufferedLightsHandler : public oatpp::web::server::HttpRequestHandler {
+private:
+  std::shared_ptr<Database> m_database;
+public:
+
+  BufferedLightsHandler(const std::shared_ptr<Database>& database)
+    : m_database(database)
+  {}
+
+  std::shared_ptr<OutgoingResponse> handle(const std::shared_ptr<IncomingRequest>& request) override {
+    (void) request;
+    auto body = oatpp::web::protocol::http::outgoing::BufferBody::createShared(m_database->getHueDevicesJson(), "application/json");
+    return OutgoingResponse::createShared(oatpp::web::protocol::http::Status::CODE_200, body);
+  }
+
+};
+
+/**
+ *  A `VmRSS`/`VmHWM` line of /proc/self/status in bytes, `-1` if there is none.
+ */
+v_int64 readProcStatus(const char* field) {
+  FILE* file = std::fopen("/proc/self/status", "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  char line[256];
+  size_t length = std::strlen(field);
+  v_int64 kb = -1;
+  while (std::fgets(line, sizeof(line), file) != nullptr) {
+    if (std::strncmp(line, field, length) == 0 && line[length] == ':') {
+      kb = std::strtoll(line + length + 1, nullptr, 10);
+      break;
+    }
+  }
+  std::fclose(file);
+  return kb < 0 ? -1 : kb * 1024;
+}
+
+/**
+ *  Set VmHWM back to the current RSS, Linux only.
+ */
+bool resetPeakRss() {
+  FILE* file = std::fopen("/proc/self/clear_refs", "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written = std::fputs("5", file) >= 0;
+  return std::fclose(file) == 0 && written;
+}
+
+struct Sample {
+  v_int64 ttfbNs = 0;
+  v_int64 totalNs = 0;
+  v_int64 bytes = 0;
+};
+
+/**
+ *  Send one request and read the response until the server closes the connection.
+ */
+bool get(v_uint16 port, const std::string& request, Sample& sample) {
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  auto start = std::chrono::steady_clock::now();
+  if (connect(fd, (sockaddr*) &address, sizeof(address)) != 0 ||
+      send(fd, request.data(), request.size(), 0) != (ssize_t) request.size()) {
+    close(fd);
+    return false;
+  }
+
+  char buffer[64 * 1024];
+  sample.bytes = 0;
+  ssize_t size;
+  while ((size = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    if (sample.bytes == 0) {
+      sample.ttfbNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    sample.bytes += size;
+  }
+  sample.totalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  close(fd);
+
+  return size == 0 && sample.bytes > 0;
+
+}
+
+v_int64 median(std::vector<v_int64> values) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+void runMode(const char* name, const std::shared_ptr<oatpp::web::server::HttpRouter>& router, v_uint16 port, const char* path) {
+
+  auto handler = oatpp::web::server::HttpConnectionHandler::createShared(router);
+  auto provider = oatpp::network::tcp::server::ConnectionProvider::createShared({"127.0.0.1", port, oatpp::network::Address::IP_4});
+  oatpp::network::Server server(provider, handler);
+  std::thread serverThread([&server] {
+    server.run();
+  });
+
+  std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+
+  Sample sample;
+  get(port, request, sample); // warm up
+
+  std::vector<v_int64> ttfbs;
+  std::vector<v_int64> totals;
+  v_int64 bytes = 0;
+  v_int64 peakHeap = 0;
+  v_int64 peakRss = -1;
+  v_int32 failed = 0;
+
+  for (v_int32 i = 0; i < REQUESTS; i++) {
+    v_int64 liveBefore = AllocationCounter::getLiveBytes();
+    AllocationCounter::resetPeakLiveBytes();
+    v_int64 rssBefore = resetPeakRss() ? readProcStatus("VmRSS") : -1;
+    if (!get(port, request, sample)) {
+      failed++;
+      continue;
+    }
+    peakHeap = std::max(peakHeap, AllocationCounter::getPeakLiveBytes() - liveBefore);
+    if (rssBefore >= 0) {
+      peakRss = std::max(peakRss, readProcStatus("VmHWM") - rssBefore);
+    }
+    ttfbs.push_back(sample.ttfbNs);
+    totals.push_back(sample.totalNs);
+    bytes = sample.bytes;
+  }
+
+  server.stop();
+  provider->stop();
+  handler->stop();
+  serverThread.join();
+
+  v_int64 ttfb = median(ttfbs);
+  v_int64 total = median(totals);
+  const v_float64 mb = 1024 * 1024;
+
+  OATPP_LOGD(TAG, "%-9s %-40s %8.2f MB  ttfb=%7.2f ms  total=%7.2f ms  peak heap=+%6.2f MB  peak RSS=%s%6.2f MB  failed=%d",
+             name, path, bytes / mb, ttfb / 1e6, total / 1e6, peakHeap / mb,
+             peakRss >= 0 ? "+" : "n/a ", peakRss >= 0 ? peakRss / mb : 0.0, failed);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.devices = DEVICES;
+  result.ops = (v_int64) ttfbs.size();
+  result.peakMb = peakHeap / mb;
+
+  result.op = std::string(name) + " time to first byte";
+  result.nsPerOp = (v_float64) ttfb;
+  BenchReport::add(result);
+
+  result.op = std::string(name) + " full response";
+  result.nsPerOp = (v_float64) total;
+  result.mbPerSecond = total > 0 ? bytes / mb / (total / 1e9) : 0;
+  BenchReport::add(result);
+
+}
+
+}
+
+void LightsStreamBench::onRun() {
+
+  BenchComponent component;
+
+  OATPP_COMPONENT(std::shared_ptr<Database>, database);
+  for (v_int32 i = 0; i < DEVICES; i++) {
+    database->registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+
+  auto bufferedRouter = oatpp::web::server::HttpRouter::createShared();
+  bufferedRouter->route("GET", "/api/{username}/lights", std::make_shared<BufferedLightsHandler>(database));
+  runMode("buffered", bufferedRouter, 8341, "/api/bench/lights");
+
+  auto router = oatpp::web::server::HttpRouter::createShared();
+  router->addController(HueDeviceController::createShared());
+  runMode("streamed", router, 8342, "/api/bench/lights");
+  runMode("page", router, 8343, "/api/bench/lights?offset=25000&limit=100");
+
+}
@@ -0,0 +1,22 @@
+#ifndef LightsStreamBench_hpp
+#define LightsStreamBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  `GET /api/{username}/lights` of a hub with 50k lights over a local connection:
+ *  the lights object rendered into one buffer against the object streamed by LightsJsonReader, and one page of it.
+ *  Measures the time to the first byte, to the last byte, and the peak heap and RSS taken while the response was sent.
+ */
+class LightsStreamBench : public oatpp::test::UnitTest {
+public:
+
+  LightsStreamBench()
+    : UnitTest("BENCH[LightsStreamBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* LightsStreamBench_hpp */
@@ -0,0 +1,75 @@
+#include "MetricsBench.hpp"
+
+#include "BenchReport.hpp"
+
+#include "metrics/Metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const TAG = "BENCH[MetricsBench]";
+
+const v_int32 ITERATIONS = 2000000;
+
+template<class Record>
+void runThreads(const char* name, v_int32 threadsCount, const Record& record) {
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (v_int32 t = 0; t < threadsCount; t++) {
+    threads.push_back(std::thread([&go, &record, t] {
+      while (!go.load()) {}
+      for (v_int32 i = 0; i < ITERATIONS; i++) {
+        record((v_uint64) (1000 + ((i + t) & 0xFFFF)));
+      }
+    }));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  // wall time per record of one thread - stays flat if the threads don't contend
+  v_float64 nsPerOp = (v_float64) elapsed / ITERATIONS;
+  OATPP_LOGD(TAG, "%-24s threads=%2d: %8.2f ns/op", name, threadsCount, nsPerOp);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = name;
+  result.threads = threadsCount;
+  result.ops = (v_int64) ITERATIONS * threadsCount;
+  result.nsPerOp = nsPerOp;
+  BenchReport::add(result);
+
+}
+
+}
+
+void MetricsBench::onRun() {
+
+  v_int32 maxThreads = std::max(2, (v_int32) std::thread::hardware_concurrency());
+
+  for (v_int32 threads = 1; threads <= maxThreads; threads *= 2) {
+
+    Metrics metrics;
+    v_int32 series = metrics.addSeries("bench", "Bench", "");
+    runThreads("Metrics::record", threads, [&metrics, series](v_uint64 value) {
+      metrics.record(series, value);
+    });
+
+    std::atomic<v_uint64> counter(0);
+    runThreads("shared atomic increment", threads, [&counter](v_uint64 value) {
+      counter.fetch_add(value, std::memory_order_relaxed);
+    });
+
+  }
+
+}
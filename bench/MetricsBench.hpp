@@ -0,0 +1,21 @@
+#ifndef MetricsBench_hpp
+#define MetricsBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Cost of Metrics::record() from 1 to N threads, next to a shared atomic counter
+ *  incremented by all threads - what recording into one histogram for everybody would cost at least.
+ */
+class MetricsBench : public oatpp::test::UnitTest {
+public:
+
+  MetricsBench()
+    : UnitTest("BENCH[MetricsBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* MetricsBench_hpp */
@@ -0,0 +1,102 @@
+
+#include "ResponseWriterBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchReport.hpp"
+#include "legacy/StateResponseRenderer.hpp"
+
+#include "response/HueResponseWriter.hpp"
+#include "db/Database.hpp"
+
+#include "oatpp/web/protocol/http/outgoing/ResponseFactory.hpp"
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <chrono>
+
+namespace {
+
+const char* const TAG = "BENCH[ResponseWriterBench]";
+
+template<class Handler>
+void runHandler(const char* name, const Handler& handler, v_int32 requests) {
+
+  auto before = AllocationCounter::sample();
+  auto start = std::chrono::steady_clock::now();
+
+  for(v_int32 i = 0; i < requests; i++) {
+    auto response = handler(i);
+    (void) response;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto after = AllocationCounter::sample();
+
+  OATPP_LOGD(TAG, "%-28s %12.0f requests/s %6.1f allocations/request",
+             name,
+             requests / (elapsed / 1e9),
+             (v_float64) (after.allocations - before.allocations) / requests);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = name;
+  result.ops = requests;
+  result.nsPerOp = (v_float64) elapsed / requests;
+  result.allocsPerOp = (v_float64) (after.allocations - before.allocations) / requests;
+  BenchReport::add(result);
+
+}
+
+}
+
+void ResponseWriterBench::onRun() {
+
+  typedef oatpp::web::protocol::http::Status Status;
+  typedef oatpp::web::protocol::http::outgoing::ResponseFactory ResponseFactory;
+
+  const v_int32 requests = 200000;
+  const v_int32 devicesCount = 16;
+
+  auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+  objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+
+  Database db(objectMapper);
+  for(v_int32 i = 0; i < devicesCount; i++) {
+    db.registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+
+  // the body `{"on":true,"bri":254}` - as a DTO for the old path and as parsed by HueStateParser for the new one
+  auto stateDto = HueDeviceStateDto::createShared();
+  stateDto->on = true;
+  stateDto->bri = 254;
+  auto state = HueStateUpdate::fromDto(stateDto);
+
+  runHandler("PUT state, DTO response", [&db, &stateDto, &objectMapper](v_int32 i) {
+    v_int32 id = i % devicesCount;
+    auto updated = db.updateHueDeviceState(id, stateDto);
+    return legacy::StateResponseRenderer::updateState(id + 1, stateDto, updated, objectMapper);
+  }, requests);
+
+  runHandler("PUT state, writer", [&db, &state](v_int32 i) {
+    v_int32 id = i % devicesCount;
+    HueDevice updated;
+    db.updateHueDeviceState(id, state, updated);
+    HueResponseWriter writer;
+    writer.addStateSuccess("/lights/", id + 1, "/state/", state, updated);
+    return ResponseFactory::createResponse(Status::CODE_200, writer.toString());
+  }, requests);
+
+  auto updatedDto = db.getHueDeviceById(0);
+  runHandler("response only, DTO", [&stateDto, &updatedDto, &objectMapper](v_int32 i) {
+    return legacy::StateResponseRenderer::updateState(i % devicesCount + 1, stateDto, updatedDto, objectMapper);
+  }, requests);
+
+  HueDevice updated;
+  state.applyTo(updated);
+  runHandler("response only, writer", [&state, &updated](v_int32 i) {
+    HueResponseWriter writer;
+    writer.addStateSuccess("/lights/", i % devicesCount + 1, "/state/", state, updated);
+    return ResponseFactory::createResponse(Status::CODE_200, writer.toString());
+  }, requests);
+
+}
@@ -0,0 +1,21 @@
+#ifndef ResponseWriterBench_hpp
+#define ResponseWriterBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Allocations per `PUT .../lights/{hueId}/state` - state change plus response,
+ *  GenericResponseDto through the ObjectMapper versus HueResponseWriter.
+ */
+class ResponseWriterBench : public oatpp::test::UnitTest {
+public:
+
+  ResponseWriterBench()
+    : UnitTest("BENCH[ResponseWriterBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ResponseWriterBench_hpp */
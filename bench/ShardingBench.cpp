@@ -0,0 +1,89 @@
+#include "ShardingBench.hpp"
+
+#include "BenchReport.hpp"
+#include "HubProcess.hpp"
+#include "LoadGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const TAG = "BENCH[ShardingBench]";
+
+const v_uint16 PORT = 8600;
+const v_int32 CLIENTS = 64;
+const v_int32 DURATION_SECONDS = 5;
+
+void runShards(v_uint32 shards, bool pin) {
+
+  HubProcess::Config hub;
+  hub.port = PORT;
+  hub.shards = shards;
+  hub.pinShards = pin;
+  pid_t pid = HubProcess::spawn(hub);
+
+  std::string name = std::to_string(shards) + (shards == 1 ? " shard" : " shards") + (pin ? " pinned" : "");
+  if (pid <= 0 || !HubProcess::waitForPort(PORT, std::chrono::steady_clock::now() + std::chrono::seconds(30))) {
+    OATPP_LOGE(TAG, "%-18s hub process did not come up", name.c_str());
+    HubProcess::kill({pid});
+    return;
+  }
+
+  LoadGenerator::Config config;
+  config.port = PORT;
+  config.ssdpPort = PORT;
+  config.clients = CLIENTS;
+  config.durationSeconds = DURATION_SECONDS;
+  config.lightsWeight = 100; // polls only - a connection per request
+  config.stateWeight = 0;
+  config.discoveryWeight = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  auto stats = LoadGenerator(config).run();
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  HubProcess::kill({pid});
+
+  auto& lights = stats[LoadGenerator::LIGHTS];
+  v_int64 connections = 0;
+  for (v_int32 i = LoadGenerator::DESCRIPTION; i < LoadGenerator::ENDPOINTS_COUNT; i++) {
+    connections += (v_int64) stats[i].latenciesNs.size(); // UDP searches aside, every request had a connection of its own
+  }
+  v_float64 perSecond = connections * 1e9 / elapsed;
+
+  OATPP_LOGD(TAG, "%-18s connections/s=%9.0f  p50=%7.2f ms  p99=%7.2f ms  errors=%lld",
+             name.c_str(), perSecond, lights.percentile(0.5) / 1e6, lights.percentile(0.99) / 1e6, (long long) lights.getErrors());
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.devices = 2;
+  result.threads = CLIENTS;
+
+  result.op = name + " connections";
+  result.ops = connections;
+  result.nsPerOp = connections > 0 ? (v_float64) elapsed / connections : 0;
+  BenchReport::add(result);
+
+  result.op = name + " GET lights p99";
+  result.ops = (v_int64) lights.latenciesNs.size();
+  result.nsPerOp = (v_float64) lights.percentile(0.99);
+  BenchReport::add(result);
+
+}
+
+}
+
+void ShardingBench::onRun() {
+
+  v_uint32 cores = std::max(1u, std::thread::hardware_concurrency());
+  for (v_uint32 shards = 1; shards < cores; shards *= 2) {
+    runShards(shards, false);
+  }
+  runShards(cores, false);
+  runShards(cores, true);
+
+}
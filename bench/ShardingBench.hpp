@@ -0,0 +1,24 @@
+#ifndef ShardingBench_hpp
+#define ShardingBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Connections per second and p99 latency of one bridge served by 1, 2, 4... up to one `--shards` per core,
+ *  and by one shard per core pinned to the CPUs (`--pin-shards`).
+ *  The hub runs in a process of its own (see HubProcess), the LoadGenerator of `example-iot-hue-ssdp-loadgen`
+ *  polls its lights with a new connection per request. Both run on the same host - with few cores the load generator
+ *  takes a share of them.
+ */
+class ShardingBench : public oatpp::test::UnitTest {
+public:
+
+  ShardingBench()
+    : UnitTest("BENCH[ShardingBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ShardingBench_hpp */
@@ -0,0 +1,85 @@
+
+#include "StateParserBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchReport.hpp"
+
+#include "parser/HueStateParser.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const char* const TAG = "BENCH[StateParserBench]";
+
+template<class Parse>
+void runParser(const char* name, const char* body, const Parse& parse, v_int32 iterations) {
+
+  v_buff_size size = (v_buff_size) std::strlen(body);
+  v_int64 checksum = 0;
+
+  auto before = AllocationCounter::sample();
+  auto start = std::chrono::steady_clock::now();
+
+  for(v_int32 i = 0; i < iterations; i++) {
+    HueStateUpdate update;
+    parse(body, size, update);
+    checksum += update.fields + update.bri;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto after = AllocationCounter::sample();
+
+  OATPP_LOGD(TAG, "%-12s %-48s %8.1f ns/op %8.1f MB/s %6.1f allocs/op (checksum %lld)",
+             name, body,
+             (v_float64) elapsed / iterations,
+             (v_float64) size * iterations / (elapsed / 1e9) / (1024 * 1024),
+             (v_float64) (after.allocations - before.allocations) / iterations,
+             (long long) checksum);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = std::string(name) + " " + body;
+  result.ops = iterations;
+  result.nsPerOp = (v_float64) elapsed / iterations;
+  result.allocsPerOp = (v_float64) (after.allocations - before.allocations) / iterations;
+  result.mbPerSecond = (v_float64) size * iterations / (elapsed / 1e9) / (1024 * 1024);
+  BenchReport::add(result);
+
+}
+
+}
+
+void StateParserBench::onRun() {
+
+  const v_int32 iterations = 200000;
+
+  auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+  objectMapper->getDeserializer()->getConfig()->allowUnknownFields = true;
+
+  const char* bodies[] = {
+    "{\"on\":true}",
+    "{\"bri\":128}",
+    "{\"on\":true,\"bri\":254,\"hue\":10000,\"sat\":200}",
+    "{\"ct\":366,\"colormode\":\"ct\",\"transitiontime\":4}",
+    "{\"on\":true,\"xy\":[0.4573,0.41]}"
+  };
+
+  for(const char* body : bodies) {
+
+    // what BODY_DTO does: read the body into a String and deserialize a HueDeviceStateDto
+    runParser("ObjectMapper", body, [&objectMapper](const char* data, v_buff_size size, HueStateUpdate& update) {
+      auto dto = objectMapper->readFromString<oatpp::Object<HueDeviceStateDto>>(oatpp::String(data, size));
+      update = HueStateUpdate::fromDto(dto);
+    }, iterations);
+
+    runParser("parser", body, [](const char* data, v_buff_size size, HueStateUpdate& update) {
+      HueStateParser::parse(data, size, update);
+    }, iterations);
+
+  }
+
+}
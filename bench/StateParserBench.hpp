@@ -0,0 +1,20 @@
+#ifndef StateParserBench_hpp
+#define StateParserBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Parse throughput of light state bodies, HueStateParser versus HueDeviceStateDto through the ObjectMapper.
+ */
+class StateParserBench : public oatpp::test::UnitTest {
+public:
+
+  StateParserBench()
+    : UnitTest("BENCH[StateParserBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* StateParserBench_hpp */
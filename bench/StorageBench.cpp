@@ -0,0 +1,178 @@
+
+#include "StorageBench.hpp"
+
+#include "BenchReport.hpp"
+
+#include "db/Storage.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const TAG = "BENCH[StorageBench]";
+
+v_int64 getDirectorySize(const std::string& directory, bool remove) {
+  v_int64 size = 0;
+  DIR* dir = opendir(directory.c_str());
+  while (struct dirent* entry = readdir(dir)) {
+    std::string path = directory + "/" + entry->d_name;
+    struct stat info;
+    if (entry->d_name[0] != '.' && stat(path.c_str(), &info) == 0) {
+      size += info.st_size;
+      if (remove) {
+        unlink(path.c_str());
+      }
+    }
+  }
+  closedir(dir);
+  return size;
+}
+
+void runStartup(const std::string& directory, v_int32 devicesCount) {
+
+  Storage::Config config;
+  config.directory = directory;
+  config.sync = false;
+  config.compactBytes = 1LL << 40; // compacted explicitly below
+
+  {
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+    for(v_int32 i = 0; i < devicesCount; i++) {
+      db->registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+    }
+  }
+
+  v_int64 journalSize = getDirectorySize(directory, false);
+  {
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+    OATPP_LOGD(TAG, "startup devices=%d from journal:  %6lld ms (%lld KB)",
+               devicesCount, (long long) storage->getStats().loadMicros / 1000, (long long) journalSize / 1024);
+    storage->compact();
+  }
+
+  v_int64 snapshotSize = getDirectorySize(directory, false);
+  {
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+    OATPP_LOGD(TAG, "startup devices=%d from snapshot: %6lld ms (%lld KB)",
+               devicesCount, (long long) storage->getStats().loadMicros / 1000, (long long) snapshotSize / 1024);
+  }
+
+  getDirectorySize(directory, true);
+
+}
+
+/**
+ * @param directory - empty - no Storage
+ */
+void runLatency(const char* name, const std::string& directory, bool sync, v_int32 writersCount, v_int32 iterations) {
+
+  const v_int32 devicesCount = 16;
+
+  auto db = std::make_shared<Database>();
+  std::shared_ptr<Storage> storage;
+  if (!directory.empty()) {
+    Storage::Config config;
+    config.directory = directory;
+    config.sync = sync;
+    storage = Storage::createShared(db, config);
+  }
+  for(v_int32 i = 0; i < devicesCount; i++) {
+    db->registerHueDevice("Light-" + oatpp::utils::conversion::int32ToStr(i));
+  }
+  auto before = storage ? storage->getStats().journal : Journal::Stats();
+
+  std::atomic<bool> go(false);
+  std::vector<std::vector<v_int64>> latencies(writersCount);
+  std::vector<std::thread> threads;
+  for(v_int32 w = 0; w < writersCount; w++) {
+    threads.push_back(std::thread([&, w] {
+      HueStateUpdate update;
+      update.fields = HueStateUpdate::FIELD_BRI;
+      HueDevice updated;
+      latencies[w].reserve(iterations);
+      while(!go.load()) {}
+      for(v_int32 i = 0; i < iterations; i++) {
+        update.bri = (v_uint8) (i % 254);
+        auto start = std::chrono::steady_clock::now();
+        db->updateHueDeviceState((i + w) % devicesCount, update, updated);
+        latencies[w].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      }
+    }));
+  }
+  go = true;
+  for(auto& t : threads) {
+    t.join();
+  }
+
+  std::vector<v_int64> all;
+  for(auto& l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  v_int64 total = 0;
+  for(v_int64 l : all) {
+    total += l;
+  }
+
+  v_int64 commits = 0;
+  v_int64 syncs = 0;
+  if (storage) {
+    auto after = storage->getStats().journal;
+    commits = after.commits - before.commits;
+    syncs = after.syncs - before.syncs;
+  }
+
+  OATPP_LOGD(TAG, "%-8s writers=%2d: avg %8.1f us p50 %8.1f us p99 %8.1f us, %lld commits / %lld fsyncs",
+             name, writersCount, total / 1000.0 / all.size(),
+             all[all.size() / 2] / 1000.0, all[all.size() * 99 / 100] / 1000.0,
+             (long long) commits, (long long) syncs);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = std::string("updateHueDeviceState ") + name;
+  result.devices = devicesCount;
+  result.threads = writersCount;
+  result.ops = (v_int64) all.size();
+  result.nsPerOp = (v_float64) total / all.size(); // latency, not wall time per operation
+  BenchReport::add(result);
+
+  storage.reset();
+  if (!directory.empty()) {
+    getDirectorySize(directory, true);
+  }
+
+}
+
+}
+
+void StorageBench::onRun() {
+
+  char directory[] = "/tmp/hue-storage-bench-XXXXXX";
+  OATPP_ASSERT(mkdtemp(directory) != nullptr);
+
+  runStartup(directory, 100000);
+
+  const v_int32 iterations = 500;
+  for(v_int32 writers : {1, 8}) {
+    runLatency("memory", "", false, writers, iterations);
+    runLatency("no-sync", directory, false, writers, iterations);
+    runLatency("fsync", directory, true, writers, iterations);
+  }
+
+  rmdir(directory);
+
+}
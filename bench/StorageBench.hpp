@@ -0,0 +1,21 @@
+#ifndef StorageBench_hpp
+#define StorageBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Startup time of a Storage holding 100k devices - replaying the journal versus mapping a snapshot,
+ *  and the latency of state updates in memory, journaled without fsync and journaled with group-committed fsyncs.
+ */
+class StorageBench : public oatpp::test::UnitTest {
+public:
+
+  StorageBench()
+    : UnitTest("BENCH[StorageBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* StorageBench_hpp */
@@ -0,0 +1,99 @@
+#include "TransitionBench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "BenchReport.hpp"
+
+#include "transition/TransitionEngine.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+const char* const TAG = "BENCH[TransitionBench]";
+
+const v_int32 TICK_MS = 20;
+
+class CountingListener : public Database::ChangeListener {
+public:
+  v_int64 steps = 0;
+public:
+
+  void onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) override {
+    steps += (v_int64) hueDevices.size();
+  }
+
+};
+
+void runTicks(v_int32 lightsCount, bool forward) {
+
+  TransitionEngine::Config config;
+  config.tickMs = 3600 * 1000; // ticked by the benchmark
+  auto engine = TransitionEngine::createShared(config);
+  auto listener = std::make_shared<CountingListener>();
+  if (forward) {
+    engine->addListener(listener, true);
+  }
+
+  // fades long enough not to finish during the run, spread over the color wheel
+  auto now = TransitionEngine::Clock::now();
+  for (v_int32 i = 0; i < lightsCount; i++) {
+    HueDevice previous;
+    previous.id = i;
+    previous.version = 1;
+    previous.flags |= HueDevice::FLAG_IN_USE;
+    previous.setOn(true);
+    previous.bri = (v_uint8) (i % 254);
+    previous.mode = HueColorMode::HS;
+    previous.hue = (v_uint16) (i * 97);
+    HueDevice updated = previous;
+    updated.version = 2;
+    updated.bri = (v_uint8) (254 - i % 254);
+    updated.hue = (v_uint16) (i * 97 + 30000);
+    updated.sat = 254;
+    engine->start(previous, updated, 3600 * 1000, now);
+  }
+
+  const v_int32 ticks = std::max(200, 4000000 / lightsCount);
+
+  auto before = AllocationCounter::sample();
+  auto start = std::chrono::steady_clock::now();
+
+  for (v_int32 i = 0; i < ticks; i++) {
+    now += std::chrono::milliseconds(TICK_MS);
+    engine->tick(now);
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto after = AllocationCounter::sample();
+
+  const char* name = forward ? "tick, steps to listener" : "tick";
+  v_float64 nsPerTick = (v_float64) elapsed / ticks;
+  OATPP_LOGD(TAG, "%-24s lights=%6d: %10.2f us/tick %7.2f ns/light %6.1f allocs/tick (%lld steps)",
+             name, lightsCount, nsPerTick / 1000, nsPerTick / lightsCount,
+             (v_float64) (after.allocations - before.allocations) / ticks, (long long) listener->steps);
+
+  BenchReport::Result result;
+  result.bench = TAG;
+  result.op = name;
+  result.devices = lightsCount;
+  result.ops = ticks;
+  result.nsPerOp = nsPerTick;
+  result.allocsPerOp = (v_float64) (after.allocations - before.allocations) / ticks;
+  BenchReport::add(result);
+
+}
+
+}
+
+void TransitionBench::onRun() {
+
+  for (v_int32 lights = 10; lights <= 100000; lights *= 10) {
+    runTicks(lights, false);
+  }
+
+  for (v_int32 lights = 10; lights <= 100000; lights *= 10) {
+    runTicks(lights, true);
+  }
+
+}
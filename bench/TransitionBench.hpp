@@ -0,0 +1,21 @@
+#ifndef TransitionBench_hpp
+#define TransitionBench_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ *  Cost of one TransitionEngine tick versus the number of lights fading at the same time,
+ *  with and without the steps passed on to a listener (the DriverPipeline in the app).
+ */
+class TransitionBench : public oatpp::test::UnitTest {
+public:
+
+  TransitionBench()
+    : UnitTest("BENCH[TransitionBench]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* TransitionBench_hpp */
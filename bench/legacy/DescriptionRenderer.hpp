@@ -0,0 +1,76 @@
+
+#ifndef legacy_DescriptionRenderer_hpp
+#define legacy_DescriptionRenderer_hpp
+
+#include "DeviceDescriptorComponent.hpp"
+
+#include "oatpp/web/protocol/http/outgoing/ResponseFactory.hpp"
+#include "oatpp/core/data/stream/BufferStream.hpp"
+
+namespace legacy {
+
+/**
+ *  The original `description` endpoint and `M-SEARCH` responder, rendering everything per request.
+ *  Kept here only as the baseline for DescriptionBench.
+ */
+class DescriptionRenderer {
+private:
+  typedef oatpp::web::protocol::http::Status Status;
+  typedef oatpp::web::protocol::http::outgoing::ResponseFactory ResponseFactory;
+  typedef oatpp::web::protocol::http::outgoing::Response OutgoingResponse;
+public:
+
+  static std::shared_ptr<OutgoingResponse> description(const DeviceDescriptorComponent::DeviceDescriptor& desc) {
+    oatpp::data::stream::BufferOutputStream ss;
+    ss <<
+      "<?xml version=\"1.0\"?>\n"
+      "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">\n"
+      "  <specVersion>\n"
+      "    <major>1</major>\n"
+      "    <minor>0</minor>\n"
+      "  </specVersion>\n"
+      "  <URLBase>http://" << desc.ipPort << "/</URLBase>\n"
+      "  <device>\n"
+      "    <deviceType>urn:schemas-upnp-org:device:Basic:1</deviceType>\n"
+      "    <friendlyName>Philips hue (" << desc.ipPort << ")</friendlyName>\n"
+      "    <manufacturer>Royal Philips Electronics</manufacturer>\n"
+      "    <manufacturerURL>http://www.philips.com</manufacturerURL>\n"
+      "    <modelDescription>Philips hue Personal Wireless Lighting</modelDescription>\n"
+      "    <modelName>Philips hue bridge 2012</modelName>\n"
+      "    <modelNumber>" << desc.sn << "</modelNumber>\n"
+      "    <modelURL>http://www.meethue.com</modelURL>\n"
+      "    <serialNumber>" << desc.mac << "</serialNumber>\n"
+      "    <UDN>uuid:" + desc.uuid + "</UDN>\n"
+      "    <presentationURL>index.html</presentationURL>\n"
+      "    <serviceList>\n"
+      "      <service>\n"
+      "        <serviceType>(null)</serviceType>\n"
+      "        <serviceId>(null)</serviceId>\n"
+      "        <controlURL>(null)</controlURL>\n"
+      "        <eventSubURL>(null)</eventSubURL>\n"
+      "        <SCPDURL>(null)</SCPDURL>\n"
+      "      </service>\n"
+      "    </serviceList>\n"
+      "  </device>\n"
+      "</root>";
+    auto rsp = ResponseFactory::createResponse(Status::CODE_200, ss.toString());
+    rsp->putHeader("Connection", "close");
+    return rsp;
+  }
+
+  static std::shared_ptr<OutgoingResponse> search(const DeviceDescriptorComponent::DeviceDescriptor& desc) {
+    auto rsp = ResponseFactory::createResponse(Status::CODE_200, oatpp::String(""));
+    rsp->putHeader("CACHE-CONTROL", "max-age=100");
+    rsp->putHeader("EXT", "");
+    rsp->putHeader("LOCATION", "http://" + desc.ipPort + "/description.xml");
+    rsp->putHeader("SERVER", "FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0");
+    rsp->putHeader("ST", "urn:schemas-upnp-org:device:basic:1");
+    rsp->putHeader("USN", "uuid:" + desc.uuid + "::upnp:rootdevice");
+    return rsp;
+  }
+
+};
+
+}
+
+#endif /* legacy_DescriptionRenderer_hpp */
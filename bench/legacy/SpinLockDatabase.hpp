@@ -0,0 +1,133 @@
+
+#ifndef legacy_SpinLockDatabase_hpp
+#define legacy_SpinLockDatabase_hpp
+
+#include "dto/HueDeviceDto.hpp"
+
+#include "oatpp/core/concurrency/SpinLock.hpp"
+#include <unordered_map>
+#include <mutex>
+
+namespace legacy {
+
+/**
+ *  The original Database implementation (one SpinLock around an unordered_map of boxed records).
+ *  Kept here only as the baseline the benchmarks compare the current Database against.
+ */
+class SpinLockDatabase {
+public:
+
+  /**
+   *  The original boxed HueDevice record.
+   */
+  class HueDevice {
+  public:
+    v_int32 id;
+    oatpp::String name;
+    oatpp::String mode;
+    oatpp::Boolean on = false;
+    oatpp::UInt8 bri = (v_uint8)0;
+    oatpp::UInt8 sat = (v_uint8)0;
+    oatpp::UInt16 hue = (v_uint16)0;
+    oatpp::UInt16 ct = (v_uint16)500;
+  };
+
+private:
+  oatpp::concurrency::SpinLock m_lock;
+  v_int32 m_idCounter;
+  std::unordered_map<v_int32, HueDevice> m_HueDevicesById;
+private:
+
+  static oatpp::Object<HueDeviceDto> deserializeToDto(const HueDevice& hueDevice) {
+    auto dto = HueDeviceDto::createShared();
+    size_t namehash = std::hash<std::string>{}(*hueDevice.name);
+    char idstr[32] = {0};
+    if (sizeof(size_t) == 8) {
+      namehash = namehash % 4294967291;
+    }
+    snprintf(idstr, 32, "%08zx%04d", namehash, hueDevice.id + 1);
+    dto->uniqueid = idstr;
+    dto->name = hueDevice.name;
+    dto->state->bri = hueDevice.bri;
+    dto->state->on = hueDevice.on;
+    dto->state->ct = hueDevice.ct;
+    dto->state->hue = hueDevice.hue;
+    dto->state->sat = hueDevice.sat;
+    dto->state->colormode = hueDevice.mode;
+    return dto;
+  }
+
+public:
+
+  SpinLockDatabase()
+    : m_idCounter(0)
+  {}
+
+  v_int32 registerHueDevice(const oatpp::String &name, const oatpp::Boolean &on = false, const oatpp::Int32 &bri = 254) {
+    std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+    HueDevice hueDevice;
+    hueDevice.name = name;
+    hueDevice.on = on;
+    hueDevice.bri = bri;
+    hueDevice.id = m_idCounter++;
+    m_HueDevicesById[hueDevice.id] = hueDevice;
+    return hueDevice.id;
+  }
+
+  oatpp::Object<HueDeviceDto> updateHueDeviceState(v_int32 id, const oatpp::Object<HueDeviceStateDto>& hueDeviceStateDto) {
+    std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+    auto it = m_HueDevicesById.find(id);
+    if(it == m_HueDevicesById.end()){
+      return nullptr;
+    }
+    if (hueDeviceStateDto->bri != nullptr) {
+      it->second.bri = hueDeviceStateDto->bri;
+    }
+    if (hueDeviceStateDto->on != nullptr) {
+      it->second.on = hueDeviceStateDto->on;
+    }
+    if (hueDeviceStateDto->hue != nullptr) {
+      it->second.hue = hueDeviceStateDto->hue;
+      it->second.mode = "hue";
+    }
+    if (hueDeviceStateDto->sat != nullptr) {
+      it->second.sat = hueDeviceStateDto->sat;
+    }
+    if (hueDeviceStateDto->ct != nullptr) {
+      it->second.ct = hueDeviceStateDto->ct;
+      it->second.mode = "ct";
+    }
+    return deserializeToDto(it->second);
+  }
+
+  oatpp::Object<HueDeviceDto> getHueDeviceById(v_int32 id) {
+    std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+    auto it = m_HueDevicesById.find(id);
+    if(it == m_HueDevicesById.end()){
+      return nullptr;
+    }
+    return deserializeToDto(it->second);
+  }
+
+  oatpp::PairList<oatpp::UInt32, oatpp::Object<HueDeviceDto>> getHueDevices() {
+    std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+    oatpp::PairList<oatpp::UInt32, oatpp::Object<HueDeviceDto>> result({});
+    for(auto it = m_HueDevicesById.begin(); it != m_HueDevicesById.end(); it++) {
+      result->emplace_back(it->first, deserializeToDto(it->second));
+    }
+    return result;
+  }
+
+  template<class Callback>
+  void forEachHueDevice(const Callback& callback) {
+    std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+    for(auto it = m_HueDevicesById.begin(); it != m_HueDevicesById.end(); it++) {
+      callback(it->second);
+    }
+  }
+
+};
+
+}
+
+#endif /* legacy_SpinLockDatabase_hpp */
@@ -0,0 +1,90 @@
+#ifndef legacy_StateResponseRenderer_hpp
+#define legacy_StateResponseRenderer_hpp
+
+#include "dto/GenericResponseDto.hpp"
+#include "dto/HueDeviceDto.hpp"
+
+#include "oatpp/web/protocol/http/outgoing/ResponseFactory.hpp"
+
+#include <cstring>
+
+namespace legacy {
+
+/**
+ *  The original tail of `updateState`, building a GenericResponseDto and serializing it with the ObjectMapper.
+ *  Kept here only as the baseline for ResponseWriterBench.
+ */
+class StateResponseRenderer {
+private:
+  typedef oatpp::web::protocol::http::Status Status;
+  typedef oatpp::web::protocol::http::outgoing::ResponseFactory ResponseFactory;
+  typedef oatpp::web::protocol::http::outgoing::Response OutgoingResponse;
+public:
+
+  static std::shared_ptr<OutgoingResponse> updateState(v_int32 hueId,
+                                                       const oatpp::Object<HueDeviceStateDto>& state,
+                                                       const oatpp::Object<HueDeviceDto>& updated,
+                                                       const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper)
+  {
+    char num[32];
+    auto responseDto = GenericResponseDto::createShared();
+    responseDto->push_back(oatpp::Object<ResponseTypeDto>::createShared());
+
+    if (state->on != nullptr) {
+      memset(num, 0, 32);
+      snprintf(num, 32, "/lights/%d/state/on", hueId);
+      if (responseDto->back()->success.get() == nullptr) {
+        responseDto->back()->success = {{oatpp::String(num), updated->state->on}};
+      } else {
+        responseDto->back()->success->push_back({oatpp::String(num), updated->state->on});
+      }
+    }
+
+    if (state->bri != nullptr) {
+      memset(num, 0, 32);
+      snprintf(num, 32, "/lights/%d/state/bri", hueId);
+      if (responseDto->back()->success.get() == nullptr) {
+        responseDto->back()->success = {{oatpp::String(num), updated->state->bri}};
+      } else {
+        responseDto->back()->success->push_back({oatpp::String(num), updated->state->bri});
+      }
+    }
+
+    if (state->hue != nullptr) {
+      memset(num, 0, 32);
+      snprintf(num, 32, "/lights/%d/state/hue", hueId);
+      if (responseDto->back()->success.get() == nullptr) {
+        responseDto->back()->success = {{oatpp::String(num), updated->state->hue}};
+      } else {
+        responseDto->back()->success->push_back({oatpp::String(num), updated->state->hue});
+      }
+    }
+
+    if (state->sat != nullptr) {
+      memset(num, 0, 32);
+      snprintf(num, 32, "/lights/%d/state/sat", hueId);
+      if (responseDto->back()->success.get() == nullptr) {
+        responseDto->back()->success = {{oatpp::String(num), updated->state->sat}};
+      } else {
+        responseDto->back()->success->push_back({oatpp::String(num), updated->state->sat});
+      }
+    }
+
+    if (state->ct != nullptr) {
+      memset(num, 0, 32);
+      snprintf(num, 32, "/lights/%d/state/ct", hueId);
+      if (responseDto->back()->success.get() == nullptr) {
+        responseDto->back()->success = {{oatpp::String(num), updated->state->ct}};
+      } else {
+        responseDto->back()->success->push_back({oatpp::String(num), updated->state->ct});
+      }
+    }
+
+    return ResponseFactory::createResponse(Status::CODE_200, responseDto, objectMapper);
+  }
+
+};
+
+}
+
+#endif /* legacy_StateResponseRenderer_hpp */
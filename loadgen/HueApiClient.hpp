@@ -0,0 +1,34 @@
+#ifndef HueApiClient_hpp
+#define HueApiClient_hpp
+
+#include "dto/UserRegisterDto.hpp"
+
+#include "oatpp/web/client/ApiClient.hpp"
+#include "oatpp/core/macro/codegen.hpp"
+
+#include OATPP_CODEGEN_BEGIN(ApiClient)
+
+/**
+ *  The calls a Hue client (i.E. Alexa) makes on the hub, in the order it makes them:
+ *  fetch the description found by SSDP, register, list the lights, then set light states.
+ */
+class HueApiClient : public oatpp::web::client::ApiClient {
+
+  API_CLIENT_INIT(HueApiClient)
+
+  API_CALL("GET", "/description.xml", getDescription)
+
+  API_CALL("POST", "/api", appRegister, BODY_DTO(Object<UserRegisterDto>, userRegister))
+
+  API_CALL("GET", "/api/{username}/lights", getLights, PATH(String, username))
+
+  API_CALL("PUT", "/api/{username}/lights/{hueId}/state", updateState,
+           PATH(String, username),
+           PATH(Int32, hueId),
+           BODY_STRING(String, state))
+
+};
+
+#include OATPP_CODEGEN_END(ApiClient)
+
+#endif /* HueApiClient_hpp */
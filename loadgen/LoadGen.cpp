@@ -0,0 +1,33 @@
+
+#include "LoadGenerator.hpp"
+
+#include "oatpp/core/base/Environment.hpp"
+
+#include <iostream>
+
+/**
+ *  main
+ *  Emulates Hue clients against a hub running on this machine, see LoadGenerator::Config for the options.
+ */
+int main(int argc, const char * argv[]) {
+
+  oatpp::base::Environment::init();
+
+  v_int64 succeeded = 0;
+  {
+    LoadGenerator generator(LoadGenerator::Config::fromArgs(oatpp::base::CommandLineArguments(argc, argv)));
+    for (const auto& stats : generator.run()) {
+      succeeded += (v_int64) stats.latenciesNs.size();
+    }
+  }
+
+  /* Print how much objects were created during app running, and what have left-probably leaked */
+  /* Disable object counting for release builds using '-D OATPP_DISABLE_ENV_OBJECT_COUNTERS' flag for better performance */
+  std::cout << "\nEnvironment:\n";
+  std::cout << "objectsCount = " << oatpp::base::Environment::getObjectsCount() << "\n";
+  std::cout << "objectsCreated = " << oatpp::base::Environment::getObjectsCreated() << "\n\n";
+
+  oatpp::base::Environment::destroy();
+
+  return succeeded > 0 ? 0 : 1; // nothing got through - the hub is not running
+}
@@ -0,0 +1,363 @@
+#include "LoadGenerator.hpp"
+
+#include "HueApiClient.hpp"
+#include "SsdpSearchClient.hpp"
+
+#include "dto/HueDeviceDto.hpp"
+
+#include "oatpp/web/client/HttpRequestExecutor.hpp"
+#include "oatpp/network/tcp/client/ConnectionProvider.hpp"
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace {
+
+const char* const TAG = "LoadGen";
+const char* const HOST = "127.0.0.1"; // never leaves the machine
+
+typedef std::chrono::steady_clock Clock;
+
+v_int32 getInt(const oatpp::base::CommandLineArguments& args, const char* name, v_int32 defaultValue) {
+  const char* value = args.getNamedArgumentValue(name, nullptr);
+  if (value == nullptr) {
+    return defaultValue;
+  }
+  bool success;
+  v_int32 result = oatpp::utils::conversion::strToInt32(oatpp::String(value), success);
+  if (!success || result < 0) {
+    OATPP_LOGE(TAG, "Invalid value '%s' for '%s', using %d", value, name, defaultValue);
+    return defaultValue;
+  }
+  return result;
+}
+
+}
+
+/**
+ *  One emulated Hue client. Used by its own thread only.
+ */
+class LoadGenerator::Client {
+private:
+  typedef oatpp::web::client::RequestExecutor::ConnectionHandle ConnectionHandle;
+  typedef oatpp::web::protocol::http::incoming::Response Response;
+private:
+  const Config& m_config;
+  std::shared_ptr<oatpp::web::client::RequestExecutor> m_executor;
+  std::shared_ptr<HueApiClient> m_api;
+  std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper;
+  SsdpSearchClient m_ssdp;
+  oatpp::String m_username;
+  std::vector<v_int32> m_lights; ///< Hue light numbers from the last `GET /api/{username}/lights`
+  size_t m_nextLight;
+  bool m_on;
+  std::mt19937 m_random;
+  bool m_paced;
+  Clock::duration m_interval;
+  Clock::time_point m_due; ///< when the next request is to be sent if paced
+  std::vector<Stats> m_stats;
+private:
+
+  /**
+   * Wait until the next request is due.
+   * @return - time the request latency is measured from
+   */
+  Clock::time_point beginRequest() {
+    if (!m_paced) {
+      return Clock::now();
+    }
+    auto due = m_due;
+    m_due += m_interval;
+    std::this_thread::sleep_until(due);
+    return due;
+  }
+
+  void recordLatency(v_int32 endpoint, Clock::time_point start) {
+    m_stats[endpoint].latenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+  }
+
+  /**
+   * Execute one HTTP call on its own connection, like the hub's clients do with `Connection: close`.
+   * @param endpoint
+   * @param call - `(connection) -> response`
+   * @param body - out, may be `nullptr`
+   * @return - `true` if the hub answered with 2xx
+   */
+  template<class Call>
+  bool execute(v_int32 endpoint, const Call& call, oatpp::String* body) {
+
+    auto start = beginRequest();
+    Stats& stats = m_stats[endpoint];
+
+    std::shared_ptr<ConnectionHandle> connection;
+    try {
+      connection = m_executor->getConnection();
+    } catch (const std::exception&) {
+      connection = nullptr;
+    }
+    if (!connection) {
+      stats.refused++;
+      return false;
+    }
+
+    try {
+      std::shared_ptr<Response> response = call(connection);
+      auto data = response->readBodyToString();
+      if (response->getStatusCode() / 100 != 2) {
+        stats.status++;
+        return false;
+      }
+      recordLatency(endpoint, start);
+      if (body != nullptr) {
+        *body = data;
+      }
+      return true;
+    } catch (const std::exception&) {
+      stats.failed++;
+      return false;
+    }
+
+  }
+
+  void search() {
+    auto start = beginRequest();
+    Stats& stats = m_stats[SEARCH];
+    switch (m_ssdp.search(m_config.searchTimeoutMs)) {
+      case SsdpSearchClient::Result::OK: recordLatency(SEARCH, start); break;
+      case SsdpSearchClient::Result::REFUSED: stats.refused++; break;
+      case SsdpSearchClient::Result::TIMEOUT: stats.timeouts++; break;
+      case SsdpSearchClient::Result::FAILED: stats.failed++; break;
+    }
+  }
+
+  void discover() {
+
+    search();
+
+    execute(DESCRIPTION, [this](const std::shared_ptr<ConnectionHandle>& connection) {
+      return m_api->getDescription(connection);
+    }, nullptr);
+
+    auto userRegister = UserRegisterDto::createShared();
+    userRegister->username = m_username;
+    userRegister->devicetype = "loadgen#hub";
+    execute(REGISTER, [this, &userRegister](const std::shared_ptr<ConnectionHandle>& connection) {
+      return m_api->appRegister(userRegister, connection);
+    }, nullptr);
+
+    oatpp::String lightsJson;
+    if (!pollLights(&lightsJson)) {
+      return;
+    }
+    try {
+      auto lights = m_objectMapper->readFromString<oatpp::Fields<oatpp::Object<HueDeviceDto>>>(lightsJson);
+      m_lights.clear();
+      for (const auto& pair : *lights) {
+        bool success;
+        v_int32 hueId = oatpp::utils::conversion::strToInt32(pair.first, success);
+        if (success) {
+          m_lights.push_back(hueId);
+        }
+      }
+    } catch (const std::exception&) {
+      m_stats[LIGHTS].failed++; // answered with 200, but not with lights
+    }
+
+  }
+
+  bool pollLights(oatpp::String* body) {
+    return execute(LIGHTS, [this](const std::shared_ptr<ConnectionHandle>& connection) {
+      return m_api->getLights(m_username, connection);
+    }, body);
+  }
+
+  void burst() {
+    if (m_lights.empty()) {
+      pollLights(nullptr); // nothing to switch - the hub has no lights, or they couldn't be listed
+      return;
+    }
+    m_on = !m_on;
+    oatpp::String state = m_on ? "{\"on\":true,\"bri\":254}" : "{\"on\":false}";
+    for (v_int32 i = 0; i < m_config.burst; i++) {
+      v_int32 hueId = m_lights[m_nextLight++ % m_lights.size()];
+      execute(STATE, [this, hueId, &state](const std::shared_ptr<ConnectionHandle>& connection) {
+        return m_api->updateState(m_username, hueId, state, connection);
+      }, nullptr);
+    }
+  }
+
+public:
+
+  Client(const Config& config,
+         v_int32 index,
+         const std::shared_ptr<oatpp::web::client::RequestExecutor>& executor,
+         const std::shared_ptr<HueApiClient>& api,
+         const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper)
+    : m_config(config)
+    , m_executor(executor)
+    , m_api(api)
+    , m_objectMapper(objectMapper)
+    , m_ssdp(HOST, config.ssdpPort)
+    , m_username("loadgen" + oatpp::utils::conversion::int32ToStr(index))
+    , m_nextLight(0)
+    , m_on(false)
+    , m_random((std::mt19937::result_type) index)
+    , m_paced(config.rate > 0)
+    , m_interval(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(m_paced ? (v_int64) 1000000000 * config.clients / config.rate : 0)))
+    , m_stats(ENDPOINTS_COUNT)
+  {}
+
+  void run(Clock::time_point begin, Clock::time_point end) {
+
+    // spread the clients over one interval instead of sending their first requests at once
+    m_due = begin + m_interval * (v_int32) (m_random() % 1000) / 1000;
+
+    discover();
+
+    v_int32 total = m_config.lightsWeight + m_config.stateWeight + m_config.discoveryWeight;
+    std::uniform_int_distribution<v_int32> pick(0, total - 1);
+    while (Clock::now() < end) {
+      v_int32 step = pick(m_random);
+      if (step < m_config.lightsWeight) {
+        pollLights(nullptr);
+      } else if (step < m_config.lightsWeight + m_config.stateWeight) {
+        burst();
+      } else {
+        discover();
+      }
+    }
+
+  }
+
+  std::vector<Stats>& getStats() {
+    return m_stats;
+  }
+
+};
+
+LoadGenerator::Config LoadGenerator::Config::fromArgs(const oatpp::base::CommandLineArguments& args) {
+
+  Config config;
+  config.port = (v_uint16) getInt(args, "--port", config.port);
+  config.ssdpPort = (v_uint16) getInt(args, "--ssdp-port", config.ssdpPort);
+  config.clients = std::max(1, getInt(args, "--clients", config.clients));
+  config.durationSeconds = std::max(1, getInt(args, "--duration", config.durationSeconds));
+  config.rate = getInt(args, "--rate", config.rate);
+  config.burst = std::max(1, getInt(args, "--burst", config.burst));
+  config.searchTimeoutMs = std::max(1, getInt(args, "--search-timeout", config.searchTimeoutMs));
+
+  const char* mix = args.getNamedArgumentValue("--mix", nullptr);
+  if (mix != nullptr) {
+    v_int32 lights, state, discovery;
+    if (std::sscanf(mix, "%d,%d,%d", &lights, &state, &discovery) == 3 &&
+        lights >= 0 && state >= 0 && discovery >= 0 && lights + state + discovery > 0) {
+      config.lightsWeight = lights;
+      config.stateWeight = state;
+      config.discoveryWeight = discovery;
+    } else {
+      OATPP_LOGE(TAG, "Invalid value '%s' for '--mix', using %d,%d,%d", mix,
+                 config.lightsWeight, config.stateWeight, config.discoveryWeight);
+    }
+  }
+
+  return config;
+
+}
+
+v_int64 LoadGenerator::Stats::percentile(v_float64 p) const {
+  if (latenciesNs.empty()) {
+    return 0;
+  }
+  size_t index = (size_t) (p * (latenciesNs.size() - 1) + 0.5);
+  return latenciesNs[index];
+}
+
+const char* LoadGenerator::getEndpointName(v_int32 endpoint) {
+  switch (endpoint) {
+    case SEARCH: return "M-SEARCH *";
+    case DESCRIPTION: return "GET description.xml";
+    case REGISTER: return "POST /api";
+    case LIGHTS: return "GET lights";
+    case STATE: return "PUT lights/state";
+    default: return "?";
+  }
+}
+
+LoadGenerator::LoadGenerator(const Config& config)
+  : m_config(config)
+{}
+
+std::vector<LoadGenerator::Stats> LoadGenerator::run() {
+
+  auto connectionProvider = oatpp::network::tcp::client::ConnectionProvider::createShared({HOST, m_config.port, oatpp::network::Address::IP_4});
+  auto executor = oatpp::web::client::HttpRequestExecutor::createShared(connectionProvider);
+  auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+  objectMapper->getDeserializer()->getConfig()->allowUnknownFields = true;
+  auto api = HueApiClient::createShared(executor, objectMapper);
+
+  OATPP_LOGD(TAG, "%d clients against %s:%d (SSDP %d) for %ds, rate %s, mix lights/state/discovery %d/%d/%d, burst %d",
+             m_config.clients, HOST, (v_int32) m_config.port, (v_int32) m_config.ssdpPort, m_config.durationSeconds,
+             m_config.rate > 0 ? oatpp::utils::conversion::int32ToStr(m_config.rate)->c_str() : "unlimited",
+             m_config.lightsWeight, m_config.stateWeight, m_config.discoveryWeight, m_config.burst);
+
+  std::vector<std::unique_ptr<Client>> clients;
+  for (v_int32 i = 0; i < m_config.clients; i++) {
+    clients.emplace_back(new Client(m_config, i, executor, api, objectMapper));
+  }
+
+  auto begin = Clock::now();
+  auto end = begin + std::chrono::seconds(m_config.durationSeconds);
+  std::vector<std::thread> threads;
+  for (auto& client : clients) {
+    Client* c = client.get();
+    threads.emplace_back([c, begin, end] {
+      c->run(begin, end);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  v_float64 elapsedSeconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count() / 1e9;
+
+  std::vector<Stats> result(ENDPOINTS_COUNT);
+  for (auto& client : clients) {
+    auto& stats = client->getStats();
+    for (v_int32 i = 0; i < ENDPOINTS_COUNT; i++) {
+      result[i].refused += stats[i].refused;
+      result[i].failed += stats[i].failed;
+      result[i].status += stats[i].status;
+      result[i].timeouts += stats[i].timeouts;
+      result[i].latenciesNs.insert(result[i].latenciesNs.end(), stats[i].latenciesNs.begin(), stats[i].latenciesNs.end());
+    }
+  }
+
+  OATPP_LOGD(TAG, "%-20s %9s %9s %9s %9s %9s %9s   %s", "endpoint", "ok", "req/s", "p50 ms", "p99 ms", "p999 ms", "max ms",
+             "refused/failed/status/timeout");
+  v_int64 succeeded = 0;
+  v_int64 errors = 0;
+  for (v_int32 i = 0; i < ENDPOINTS_COUNT; i++) {
+    Stats& stats = result[i];
+    std::sort(stats.latenciesNs.begin(), stats.latenciesNs.end());
+    OATPP_LOGD(TAG, "%-20s %9lld %9.0f %9.2f %9.2f %9.2f %9.2f   %lld/%lld/%lld/%lld",
+               getEndpointName(i),
+               (long long) stats.latenciesNs.size(),
+               stats.latenciesNs.size() / elapsedSeconds,
+               stats.percentile(0.5) / 1e6,
+               stats.percentile(0.99) / 1e6,
+               stats.percentile(0.999) / 1e6,
+               stats.percentile(1.0) / 1e6,
+               (long long) stats.refused, (long long) stats.failed, (long long) stats.status, (long long) stats.timeouts);
+    succeeded += (v_int64) stats.latenciesNs.size();
+    errors += stats.getErrors();
+  }
+  OATPP_LOGD(TAG, "%-20s %9lld %9.0f   errors=%lld", "total", (long long) succeeded, succeeded / elapsedSeconds, (long long) errors);
+
+  return result;
+
+}
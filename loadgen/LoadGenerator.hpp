@@ -0,0 +1,102 @@
+#ifndef LoadGenerator_hpp
+#define LoadGenerator_hpp
+
+#include "oatpp/core/base/CommandLineArguments.hpp"
+#include "oatpp/core/Types.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ *  Emulates Hue clients (i.E. Alexa) talking to a hub on localhost, to find out how many of them one hub process can serve.
+ *
+ *  Every client runs on its own thread and starts the way a voice assistant does:
+ *  `M-SEARCH *` to the SSDP port, `GET /description.xml`, `POST /api` to register and `GET /api/{username}/lights`.
+ *  Then it picks one of these steps by Config weights until the run is over:
+ *
+ *  - `GET /api/{username}/lights` - polling the lights
+ *  - a burst of `PUT /api/{username}/lights/{hueId}/state` on successive lights - "Alexa, turn on the living room"
+ *  - the discovery sequence again
+ *
+ *  With a rate set, requests are sent on a fixed schedule and latency is measured from the time a request was due,
+ *  so a stalled hub shows up in the percentiles instead of just lowering the request rate.
+ */
+class LoadGenerator {
+public:
+
+  enum Endpoint : v_int32 {
+    SEARCH = 0,
+    DESCRIPTION,
+    REGISTER,
+    LIGHTS,
+    STATE,
+    ENDPOINTS_COUNT
+  };
+
+  /**
+   *  Options of the load generator, read from the command line.
+   *
+   *  --port <port>          HTTP port of the hub (default 80)
+   *  --ssdp-port <port>     SSDP port of the hub (default 1900)
+   *  --clients <n>          concurrent clients (default 16)
+   *  --duration <s>         length of the run (default 10)
+   *  --rate <n>             requests per second of all clients together, 0 - as fast as the hub answers (default 0)
+   *  --mix <l,s,d>          weights of lights polls, state bursts and rediscoveries (default 70,25,5)
+   *  --burst <n>            state PUTs per burst (default 3)
+   *  --search-timeout <ms>  time to wait for the answer to a M-SEARCH (default 1000)
+   */
+  struct Config {
+    v_uint16 port = 80;
+    v_uint16 ssdpPort = 1900;
+    v_int32 clients = 16;
+    v_int32 durationSeconds = 10;
+    v_int32 rate = 0;
+    v_int32 lightsWeight = 70;
+    v_int32 stateWeight = 25;
+    v_int32 discoveryWeight = 5;
+    v_int32 burst = 3;
+    v_int32 searchTimeoutMs = 1000;
+
+    static Config fromArgs(const oatpp::base::CommandLineArguments& args);
+  };
+
+  /**
+   *  Results of one endpoint.
+   */
+  struct Stats {
+    v_int64 refused = 0; ///< connection refused - or the SSDP port unreachable
+    v_int64 failed = 0; ///< the connection broke or the response couldn't be read
+    v_int64 status = 0; ///< answered with a status other than 2xx
+    v_int64 timeouts = 0; ///< M-SEARCH without an answer
+    std::vector<v_int64> latenciesNs; ///< of successful requests, sorted ascending once the run is over
+
+    v_int64 getErrors() const {
+      return refused + failed + status + timeouts;
+    }
+
+    /**
+     * @param p - percentile in [0, 1]
+     * @return - latency in nanoseconds, 0 if nothing succeeded
+     */
+    v_int64 percentile(v_float64 p) const;
+  };
+
+private:
+  class Client;
+private:
+  const Config m_config;
+public:
+
+  LoadGenerator(const Config& config);
+
+  /**
+   * Run all clients for Config::durationSeconds and log the results per endpoint.
+   * @return - results indexed by Endpoint
+   */
+  std::vector<Stats> run();
+
+  static const char* getEndpointName(v_int32 endpoint);
+
+};
+
+#endif /* LoadGenerator_hpp */
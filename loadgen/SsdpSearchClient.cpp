@@ -0,0 +1,94 @@
+#include "SsdpSearchClient.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// unicast search without MX - answered right away and every time, so the latency is the hub's own
+const char* const SEARCH =
+  "M-SEARCH * HTTP/1.1\r\n"
+  "HOST: 127.0.0.1:1900\r\n"
+  "MAN: \"ssdp:discover\"\r\n"
+  "ST: urn:schemas-upnp-org:device:basic:1\r\n"
+  "\r\n";
+
+}
+
+SsdpSearchClient::SsdpSearchClient(const char* ip, v_uint16 port)
+  : m_fd(::socket(AF_INET, SOCK_DGRAM, 0))
+{
+  if (m_fd < 0) {
+    return;
+  }
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  ::inet_pton(AF_INET, ip, &address.sin_addr);
+  ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+  if (::connect(m_fd, (const sockaddr*) &address, sizeof(address)) != 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+}
+
+SsdpSearchClient::~SsdpSearchClient() {
+  if (m_fd >= 0) {
+    ::close(m_fd);
+  }
+}
+
+SsdpSearchClient::Result SsdpSearchClient::search(v_int32 timeoutMs) {
+
+  if (m_fd < 0) {
+    return Result::FAILED;
+  }
+
+  char buffer[2048];
+
+  // answers to searches that timed out earlier must not be taken for the answer to this one
+  while (::recv(m_fd, buffer, sizeof(buffer), 0) > 0) {}
+
+  if (::send(m_fd, SEARCH, std::strlen(SEARCH), 0) < 0) {
+    return errno == ECONNREFUSED ? Result::REFUSED : Result::FAILED;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true) {
+
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (left <= 0) {
+      return Result::TIMEOUT;
+    }
+
+    pollfd pollFd;
+    pollFd.fd = m_fd;
+    pollFd.events = POLLIN;
+    pollFd.revents = 0;
+    if (::poll(&pollFd, 1, (int) left) < 0 && errno != EINTR) {
+      return Result::FAILED;
+    }
+
+    auto res = ::recv(m_fd, buffer, sizeof(buffer), 0);
+    if (res > 0) {
+      return res >= 12 && std::strncmp(buffer, "HTTP/1.1 200", 12) == 0 ? Result::OK : Result::FAILED;
+    }
+    if (res < 0 && errno == ECONNREFUSED) {
+      return Result::REFUSED;
+    }
+    if (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      return Result::FAILED;
+    }
+
+  }
+
+}
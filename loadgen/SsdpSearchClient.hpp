@@ -0,0 +1,46 @@
+#ifndef SsdpSearchClient_hpp
+#define SsdpSearchClient_hpp
+
+#include "oatpp/core/Types.hpp"
+
+/**
+ *  Sends `M-SEARCH *` packets to the hub's SSDP port and waits for the answer, like a Hue client discovering bridges.
+ *  The packet goes to the unicast address of the hub instead of the multicast group, so the load stays on localhost.
+ *  The socket is connected, so a closed SSDP port is reported as refused (ICMP port unreachable) instead of a timeout.
+ */
+class SsdpSearchClient {
+public:
+
+  enum class Result : v_int32 {
+    OK = 0,
+    REFUSED = 1,
+    TIMEOUT = 2,
+    FAILED = 3 ///< socket error or an answer that is not `HTTP/1.1 200`
+  };
+
+private:
+  int m_fd;
+public:
+
+  /**
+   * Constructor.
+   * @param ip - IPv4 address of the hub
+   * @param port - SSDP port of the hub
+   */
+  SsdpSearchClient(const char* ip, v_uint16 port);
+
+  ~SsdpSearchClient();
+
+  SsdpSearchClient(const SsdpSearchClient&) = delete;
+  SsdpSearchClient& operator=(const SsdpSearchClient&) = delete;
+
+  /**
+   * Send one search and wait for its answer.
+   * @param timeoutMs - time to wait for the answer
+   * @return - Result
+   */
+  Result search(v_int32 timeoutMs);
+
+};
+
+#endif /* SsdpSearchClient_hpp */
@@ -1,80 +1,78 @@
 
-#include "controller/SsdpController.hpp"
-#include "controller/HueDeviceController.hpp"
 #include "AppComponent.hpp"
+#include "bridge/BridgeHost.hpp"
 
-#include "oatpp-swagger/Controller.hpp"
-
-#include "oatpp/network/Server.hpp"
+#include <signal.h>
 
 #include <iostream>
 #include <thread>
 
+/**
+ *  SIGINT and SIGTERM are taken by run() with sigwait().
+ *  Blocked before any thread is started, so that every thread inherits the mask and none of them is interrupted.
+ */
+static sigset_t getShutdownSignals() {
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  return signals;
+}
+
 /**
  *  run() method.
  *  1) set Environment components.
- *  2) add ApiController's endpoints to router
- *  3) run server
+ *  2) create a router and Hue controller per bridge
+ *  3) run the servers of all bridges and the SSDP server
+ *  4) on SIGINT or SIGTERM stop them - SSDP says byebye for the bridges, and the components are destroyed in order
  */
 
-void run() {
+void run(const AppConfig& config) {
   
-  std::shared_ptr<AppComponent> components = std::make_shared<AppComponent>(); // Create scope Environment components
+  std::shared_ptr<AppComponent> components = std::make_shared<AppComponent>(config); // Create scope Environment components
 
-  /* Get Database instance to add devices to it */
-  auto db = components->database.getObject();
+  /* Add the demo devices to every bridge on its first start only - with `--data-dir` they are restored with their names and states later on */
+  for (auto& bridge : *components->bridges.getObject()) {
 
-  /* Add a device called 'Oat' */
-  db->registerHueDevice("Oat");
+    auto db = bridge->getDatabase();
+    if (db->getHueDevicesCount() == 0) {
 
-  /* Add another device called 'Grain' */
-  db->registerHueDevice("Grain");
+      /* Add a device called 'Oat' */
+      db->registerHueDevice("Oat");
 
+      /* Add another device called 'Grain' */
+      db->registerHueDevice("Grain");
 
-  /* get the router for HTTP calls */
-  auto router = components->httpRouter.getObject();
+    }
 
-  /* create the Swagger endpoint documentation engine*/
-  oatpp::web::server::api::Endpoints docEndpoints;
+  }
 
-  /* create the Hue HTTP REST controller */
-  docEndpoints.append(router->addController(HueDeviceController::createShared())->getEndpoints());
+  /* create a router and a Hue HTTP REST controller per bridge, sharing one swagger UI controller */
+  BridgeHost host(components);
 
-  /* create swagger UI controller */
-  router->addController(oatpp::swagger::Controller::createShared(docEndpoints));
-
-  /* create the SSDP-Router and SSDP-Controller and add its endpoints to the SSDP-Router */
-  auto ssdpRouter = components->ssdpRouter.getObject();
-
-  ssdpRouter->addController(SsdpController::createShared());
-
-  OATPP_LOGD("SSDPRouter", "Mappings:");
-  ssdpRouter->logRouterMappings();
   OATPP_LOGD("HTTPRouter", "Mappings:");
-  router->logRouterMappings();
-
+  host.getRouter()->logRouterMappings();
 
-  /* create http and ssdp server in separate thread to have them run in parallel */
-  std::thread http([components](){
-    oatpp::network::Server server(components->serverConnectionProvider.getObject(),
-                                  components->serverConnectionHandler.getObject());
-
-    OATPP_LOGD("Server", "Running HTTP on port %s...", components->serverConnectionProvider.getObject()->getProperty("port").toString()->c_str());
-
-    server.run();
-  });
+  /* create http and ssdp servers in separate threads to have them run in parallel */
+  host.start();
 
   std::thread ssdp([components](){
-    oatpp::network::Server server(components->ssdpConnectionProvider.getObject(),
-      components->ssdpStreamHandler.getObject());
+    auto server = components->ssdpServer.getObject();
+    OATPP_LOGD("Server", "Running SSDP on port %d for %d bridges...",
+               (v_int32) server->getPort(), (v_int32) components->bridges.getObject()->size());
+    server->run();
+  });
 
-    OATPP_LOGD("Server", "Running SSDP on port %s...", components->ssdpConnectionProvider.getObject()->getProperty("port").toString()->c_str());
+  /* wait for SIGINT or SIGTERM */
+  sigset_t signals = getShutdownSignals();
+  int signal = 0;
+  while (sigwait(&signals, &signal) != 0) {}
+  OATPP_LOGI("Server", "Received signal %d, stopping...", signal);
 
-    server.run();
-  });
+  components->ssdpServer.getObject()->stop();
+  host.stop();
 
-  if (http.joinable())
-    http.join();
+  host.join();
 
   if (ssdp.joinable())
     ssdp.join();
@@ -88,7 +86,15 @@ int main(int argc, const char * argv[]) {
 
   oatpp::base::Environment::init();
 
-  run();
+  sigset_t signals = getShutdownSignals();
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  AppConfig config = AppConfig::fromArgs(oatpp::base::CommandLineArguments(argc, argv));
+
+  /* format and write log messages on a background thread, see AsyncLogger */
+  oatpp::base::Environment::setLogger(AsyncLogger::createShared(config.log));
+
+  run(config);
   
   /* Print how much objects were created during app running, and what have left-probably leaked */
   /* Disable object counting for release builds using '-D OATPP_DISABLE_ENV_OBJECT_COUNTERS' flag for better performance */
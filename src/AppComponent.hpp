@@ -2,17 +2,28 @@
 #ifndef AppComponent_hpp
 #define AppComponent_hpp
 
+#include "AppConfig.hpp"
+#include "bridge/Bridge.hpp"
 #include "db/Database.hpp"
 
 #include "SwaggerComponent.hpp"
 #include "DeviceDescriptorComponent.hpp"
 
+#include "connection/ConnectionPolicyInterceptor.hpp"
+#include "connection/ReusePortConnectionProvider.hpp"
+#include "connection/TrackedConnectionHandler.hpp"
+#include "driver/FileLightDriver.hpp"
+#include "logging/AsyncLogger.hpp"
+#include "metrics/Metrics.hpp"
+#include "ssdp/SsdpServer.hpp"
+#include "transition/TransitionEngine.hpp"
+
+#include "oatpp/web/server/AsyncHttpConnectionHandler.hpp"
 #include "oatpp/web/server/HttpConnectionHandler.hpp"
 #include "oatpp/web/server/HttpRouter.hpp"
 #include "oatpp/network/tcp/server/ConnectionProvider.hpp"
-
-#include "oatpp-ssdp/SimpleSsdpUdpStreamProvider.hpp"
-#include "oatpp-ssdp/SsdpStreamHandler.hpp"
+#include "oatpp/network/monitor/ConnectionMonitor.hpp"
+#include "oatpp/network/monitor/ConnectionInactivityChecker.hpp"
 
 #include "oatpp/parser/json/mapping/Serializer.hpp"
 #include "oatpp/parser/json/mapping/Deserializer.hpp"
@@ -24,57 +35,60 @@
  *  Order of components initialization is from top to bottom
  */
 class AppComponent {
+private:
+  const AppConfig m_config; // initialized first, the components below read it
 public:
 
+  AppComponent(const AppConfig& config = AppConfig())
+    : m_config(config)
+  {}
+
+  const AppConfig& getConfig() const {
+    return m_config;
+  }
+
+  /**
+   *  Descriptor of the first bridge, the others are derived from it
+   */
   DeviceDescriptorComponent deviceComponent;
 
   /**
    *  Swagger component
    */
   SwaggerComponent swaggerComponent;
-  
-  /**
-   *  Create ConnectionProvider component which listens on the port
-   */
-  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::network::ServerConnectionProvider>, serverConnectionProvider)("httpConnectionProvider", [] {
-    return oatpp::network::tcp::server::ConnectionProvider::createShared({"0.0.0.0", 80, oatpp::network::Address::IP_4});
-  }());
 
-  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::ssdp::SimpleSsdpUdpStreamProvider>, ssdpConnectionProvider)("ssdpConnectionProvider", [] {
-    return oatpp::ssdp::SimpleSsdpUdpStreamProvider::createShared();
-  }());
-  
   /**
-   *  Create Router components
+   *  Counters of opened connections and served requests
    */
-  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::web::server::HttpRouter>, httpRouter)("httpRouter", [] {
-    return oatpp::web::server::HttpRouter::createShared();
+  OATPP_CREATE_COMPONENT(std::shared_ptr<ConnectionMetrics>, connectionMetrics)([] {
+    return std::make_shared<ConnectionMetrics>();
   }());
 
   /**
-   * We can reuse the HttpRouter for SSDP since both SSDP and HTTP use the same Header structure
-   */
-  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::web::server::HttpRouter>, ssdpRouter)("ssdpRouter", [] {
-    return oatpp::web::server::HttpRouter::createShared();
-  }());
-  
-  /**
-   *  Create ConnectionHandler component which uses Router component to route requests
+   *  Latency histograms of the endpoints and the Database write lock, served on `GET /metrics`
    */
-  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, serverConnectionHandler)("httpConnectionHandler", [] {
-    OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::HttpRouter>, router, "httpRouter"); // get Router component
-    return oatpp::web::server::HttpConnectionHandler::createShared(router);
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Metrics>, metrics)([] {
+    OATPP_COMPONENT(std::shared_ptr<ConnectionMetrics>, connectionMetrics);
+    auto metrics = Metrics::createShared();
+    metrics->addGauge("hue_http_connections_active", "HTTP connections currently open", [connectionMetrics] {
+      return connectionMetrics->connectionsOpened.load() - connectionMetrics->connectionsClosed.load();
+    });
+    metrics->addGauge("hue_log_dropped_records", "Log records dropped because the logging thread's ring was full", [] {
+      return AsyncLogger::getDroppedCount();
+    });
+    return metrics;
   }());
 
   /**
-   *  Create SsdpStreamHandler component which uses Router component to route requests.
-   *  It looks like a normal ConnectionHandler but is specialized on SsdpStreams and returns something conceptually very different
+   *  Executor running the coroutines of all bridges in async mode - `nullptr` with a thread per connection.
    */
-  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::ssdp::SsdpStreamHandler>, ssdpStreamHandler)("ssdpStreamHandler", [] {
-    OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::HttpRouter>, router, "ssdpRouter"); // get Router component
-    return oatpp::ssdp::SsdpStreamHandler::createShared(router);
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor)([this] {
+    if (!m_config.async) {
+      return std::shared_ptr<oatpp::async::Executor>();
+    }
+    return std::make_shared<oatpp::async::Executor>(m_config.dataWorkers, m_config.ioWorkers, m_config.timerWorkers);
   }());
-  
+
   /**
    *  Create ObjectMapper component to serialize/deserialize DTOs in Contoller's API
    */
@@ -89,9 +103,210 @@ public:
    *  Create Demo-Database component which stores information about users
    */
   OATPP_CREATE_COMPONENT(std::shared_ptr<Database>, database)([] {
-    return std::make_shared<Database>();
+    OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper); // renders the per-device JSON cache
+    OATPP_COMPONENT(std::shared_ptr<Metrics>, metrics);
+    auto database = std::make_shared<Database>(objectMapper);
+    database->setMetrics(metrics);
+    return database;
+  }());
+
+  /**
+   *  Fades the lights of the first bridge to states with a `transitiontime`.
+   *  `nullptr` with `--transition-tick 0` - states are applied at once then.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<TransitionEngine>, transitionEngine)([this] {
+    OATPP_COMPONENT(std::shared_ptr<Database>, database);
+    OATPP_COMPONENT(std::shared_ptr<Metrics>, metrics);
+    auto engine = attachTransitionEngine(database);
+    if (engine) {
+      std::weak_ptr<TransitionEngine> weakEngine = engine;
+      metrics->addGauge("hue_lights_fading", "Lights of the first bridge fading to a new state", [weakEngine] {
+        auto current = weakEngine.lock();
+        return current ? current->getStats().fading : 0;
+      });
+    }
+    return engine;
+  }());
+
+  /**
+   *  Restores the Database from `--data-dir` and journals every write to it.
+   *  `nullptr` unless a data directory is configured - devices are kept in memory only then.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Storage>, storage)([this] {
+    if (m_config.storage.directory.empty()) {
+      return std::shared_ptr<Storage>();
+    }
+    OATPP_COMPONENT(std::shared_ptr<Database>, database);
+    auto storage = Storage::createShared(database, m_config.storage);
+    auto stats = storage->getStats();
+    OATPP_LOGD("Storage", "Restored %d devices from '%s' in %lldms (%lld journal records)",
+               (v_int32) database->getHueDevicesCount(), m_config.storage.directory.c_str(),
+               (long long) stats.loadMicros / 1000, (long long) stats.journalRecords);
+    return storage;
+  }());
+
+  /**
+   *  Stream of committed light changes, served as server-sent events
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<ChangeStream>, changeStream)([this] {
+    OATPP_COMPONENT(std::shared_ptr<Database>, database);
+    OATPP_COMPONENT(std::shared_ptr<TransitionEngine>, transitionEngine);
+    return createChangeStream(database, transitionEngine);
   }());
 
+  /**
+   *  Moves committed light states to the LightDriver off the HTTP threads.
+   *  `nullptr` unless a driver is configured - replace FileLightDriver with the driver of your hardware.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<DriverPipeline>, driverPipeline)([this] {
+    if (m_config.driverOutput.empty()) {
+      return std::shared_ptr<DriverPipeline>();
+    }
+    OATPP_COMPONENT(std::shared_ptr<Database>, database);
+    OATPP_COMPONENT(std::shared_ptr<TransitionEngine>, transitionEngine);
+    auto driver = FileLightDriver::createShared(m_config.driverOutput, m_config.driverLatencyMs);
+    auto pipeline = DriverPipeline::createShared(database, driver, m_config.driver);
+    if (transitionEngine) {
+      transitionEngine->addListener(pipeline, true); // the driver is sent the steps of fading lights
+    } else {
+      database->addChangeListener(pipeline);
+    }
+    return pipeline;
+  }());
+
+  /**
+   *  All bridges hosted by this process. The first one is made of the components above,
+   *  the others get a Database, a ChangeStream and a Storage directory of their own.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Bridge::List>, bridges)([this] {
+    OATPP_COMPONENT(std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>, descriptor);
+    OATPP_COMPONENT(std::shared_ptr<Database>, database);
+    OATPP_COMPONENT(std::shared_ptr<ChangeStream>, changeStream);
+    OATPP_COMPONENT(std::shared_ptr<Storage>, storage);
+    OATPP_COMPONENT(std::shared_ptr<DriverPipeline>, driverPipeline);
+    auto bridges = std::make_shared<Bridge::List>();
+    bridges->push_back(Bridge::createShared(0, m_config.port, descriptor, database, changeStream, storage, driverPipeline));
+    for (v_uint32 i = 1; i < m_config.bridges; i++) {
+      bridges->push_back(createBridge(i, descriptor));
+    }
+    return bridges;
+  }());
+
+  /**
+   *  Answers SSDP searches for all bridges
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<SsdpServer>, ssdpServer)([this] {
+    OATPP_COMPONENT(std::shared_ptr<Bridge::List>, bridges);
+    OATPP_COMPONENT(std::shared_ptr<Metrics>, metrics);
+    std::vector<std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>> descriptors;
+    for (auto& bridge : *bridges) {
+      descriptors.push_back(bridge->getDescriptor());
+    }
+    return SsdpServer::createShared(m_config.ssdp, descriptors, metrics);
+  }());
+
+private:
+
+  /**
+   *  Make `database` report and drive fades, unless transitions are disabled. Call before the Database is shared.
+   *  @return - the TransitionEngine of `database` or `nullptr`
+   */
+  std::shared_ptr<TransitionEngine> attachTransitionEngine(const std::shared_ptr<Database>& database) const {
+    if (m_config.transitions.tickMs <= 0) {
+      return nullptr;
+    }
+    auto engine = TransitionEngine::createShared(m_config.transitions);
+    database->setStateOverlay(engine);
+    database->addChangeListener(engine); // writes without transition end the fades they interrupt
+    return engine;
+  }
+
+  /**
+   *  Stream of the changes committed to `database`. Fed by `transitionEngine` if there is one,
+   *  which tells the stream when a fading light reached its target.
+   */
+  std::shared_ptr<ChangeStream> createChangeStream(const std::shared_ptr<Database>& database,
+                                                   const std::shared_ptr<TransitionEngine>& transitionEngine) const {
+    auto stream = ChangeStream::createShared(m_config.events);
+    if (transitionEngine) {
+      transitionEngine->addListener(stream, false);
+    } else {
+      database->addChangeListener(stream);
+    }
+    return stream;
+  }
+
+  /**
+   *  Bridge `index` > 0. The LightDriver (`--driver-output`) drives the lights of the first bridge only.
+   */
+  std::shared_ptr<Bridge> createBridge(v_uint32 index, const std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>& first) const {
+    OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper);
+    OATPP_COMPONENT(std::shared_ptr<Metrics>, metrics);
+    v_uint16 port = (v_uint16) (m_config.port + index);
+    auto database = std::make_shared<Database>(objectMapper);
+    database->setMetrics(metrics); // the series are shared with the first bridge's Database
+    auto transitionEngine = attachTransitionEngine(database); // owned by the Database
+    std::shared_ptr<Storage> storage;
+    if (!m_config.storage.directory.empty()) {
+      Storage::Config config = m_config.storage;
+      config.directory += "/bridge-" + std::to_string(index);
+      storage = Storage::createShared(database, config);
+    }
+    auto changeStream = createChangeStream(database, transitionEngine);
+    return Bridge::createShared(index, port, first->deriveBridge(index, port), database, changeStream, storage, nullptr);
+  }
+
+public:
+
+  /**
+   * Create the ConnectionProvider of a bridge which listens on its port - one per shard.
+   * With more than one shard the port is bound with `SO_REUSEPORT` by every shard.
+   * If keep-alive is enabled for any client, idle connections are closed by a ConnectionMonitor.
+   * @param port
+   * @return - ServerConnectionProvider
+   */
+  std::shared_ptr<oatpp::network::ServerConnectionProvider> createConnectionProvider(v_uint16 port) const {
+    std::shared_ptr<oatpp::network::ServerConnectionProvider> provider;
+    if (m_config.shards > 1) {
+      provider = ReusePortConnectionProvider::createShared({"0.0.0.0", port, oatpp::network::Address::IP_4});
+    } else {
+      provider = oatpp::network::tcp::server::ConnectionProvider::createShared({"0.0.0.0", port, oatpp::network::Address::IP_4});
+    }
+    if (m_config.connectionPolicy.allowsKeepAlive()) {
+      std::chrono::duration<v_int64, std::micro> idleTimeout = std::chrono::seconds(m_config.connectionPolicy.idleTimeoutSeconds);
+      std::chrono::duration<v_int64, std::micro> maxLifetime = std::chrono::hours(24); // long lived event streams
+      auto monitor = std::make_shared<oatpp::network::monitor::ConnectionMonitor>(provider);
+      monitor->addMetricsChecker(std::make_shared<oatpp::network::monitor::ConnectionInactivityChecker>(idleTimeout, maxLifetime));
+      provider = monitor;
+    }
+    return provider;
+  }
+
+  /**
+   * Create the ConnectionHandler of a bridge which uses the bridge's router to route requests.
+   * In async mode connections are processed by coroutines on the executor threads shared by all bridges
+   * instead of one thread per connection.
+   * The ConnectionPolicyInterceptor decides per response whether the connection is kept open.
+   * @param router
+   * @return - ConnectionHandler
+   */
+  std::shared_ptr<oatpp::network::ConnectionHandler> createConnectionHandler(const std::shared_ptr<oatpp::web::server::HttpRouter>& router) const {
+    OATPP_COMPONENT(std::shared_ptr<ConnectionMetrics>, metrics);
+    OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+    auto interceptor = ConnectionPolicyInterceptor::createShared(m_config.connectionPolicy, metrics);
+    std::shared_ptr<oatpp::network::ConnectionHandler> handler;
+    if (executor) {
+      auto asyncHandler = oatpp::web::server::AsyncHttpConnectionHandler::createShared(router, executor);
+      asyncHandler->addResponseInterceptor(interceptor);
+      handler = asyncHandler;
+    } else {
+      auto syncHandler = oatpp::web::server::HttpConnectionHandler::createShared(router);
+      syncHandler->addResponseInterceptor(interceptor);
+      handler = syncHandler;
+    }
+    return std::static_pointer_cast<oatpp::network::ConnectionHandler>(TrackedConnectionHandler::createShared(handler, metrics));
+  }
+
 };
 
 #endif /* AppComponent_hpp */
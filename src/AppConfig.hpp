@@ -0,0 +1,207 @@
+#ifndef AppConfig_hpp
+#define AppConfig_hpp
+
+#include "connection/ConnectionPolicy.hpp"
+#include "events/ChangeStream.hpp"
+#include "driver/DriverPipeline.hpp"
+#include "db/Storage.hpp"
+#include "logging/AsyncLogger.hpp"
+#include "ssdp/SsdpServer.hpp"
+#include "transition/TransitionEngine.hpp"
+
+#include "oatpp/core/base/CommandLineArguments.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+#include "oatpp/core/Types.hpp"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ *  Startup options of the hub, read from the command line.
+ *
+ *  --port <port>           HTTP port (default 80)
+ *  --bridges <n>           virtual bridges hosted by the process, bridge i listens on port + i (default 1)
+ *  --ssdp-port <port>      SSDP port all bridges are advertised on (default 1900)
+ *  --shards <n>            acceptor threads per bridge port, bound with SO_REUSEPORT if more than 1 - 0 for one per core (default 1)
+ *  --pin-shards            pin the n-th acceptor of every port, and the connection threads it starts, to CPU n
+ *  --async                 serve the Hue API with AsyncHttpConnectionHandler and coroutine endpoints
+ *  --data-workers <n>      async executor data-processing workers (default 4)
+ *  --io-workers <n>        async executor I/O workers (default 1)
+ *  --timer-workers <n>     async executor timer workers (default 1)
+ *  --keep-alive            keep HTTP connections open for all clients (default: `Connection: close`)
+ *  --keep-alive-agents <a,b,...>  keep connections open for clients whose User-Agent contains one of the values
+ *  --close-agents <a,b,...>       always close connections of clients whose User-Agent contains one of the values
+ *  --keep-alive-timeout <s>       close keep-alive connections idle for longer (default 5)
+ *  --keep-alive-max <n>           requests per keep-alive connection (default 100)
+ *  --events-window <ms>    coalescing window of the light change stream (default 50)
+ *  --events-queue <n>      lights queued per change stream subscriber before it gets a full resync (default 256)
+ *  --driver-output <path>  drive lights with FileLightDriver, writing frames to a file or named pipe ("-" for stdout)
+ *  --driver-latency <ms>   simulated time FileLightDriver takes per frame (default 0)
+ *  --driver-tick <ms>      collect light changes for this long per frame (default 20)
+ *  --driver-queue <n>      driver commands queued before the driver gets a resync, rounded up to a power of two (default 4096)
+ *  --transition-tick <ms>  move fading lights towards their new state this often, 0 - apply `transitiontime` states at once (default 20)
+ *  --data-dir <path>       keep devices and groups in this directory across restarts (default: in memory only)
+ *  --data-no-sync          don't wait for the journal to reach the disk before answering a write
+ *  --data-compact <KB>     fold the journal into a new snapshot once it is larger (default 4096)
+ *  --log-level <V|D|I|W|E> log level of all tags (default D)
+ *  --log-tags <tag=L,...>  log levels of single tags, i.E. `HueDeviceController=W`
+ *  --log-ring <KB>         log records buffered per logging thread before they are dropped (default 64)
+ *  --log-endpoint          let clients on this host change levels at runtime with `PUT /log/{tag}?level=`
+ */
+class AppConfig {
+public:
+  v_uint16 port = 80;
+  v_uint32 bridges = 1;
+  v_uint32 shards = 1;
+  bool pinShards = false;
+  SsdpServer::Config ssdp;
+  bool async = false;
+  v_int32 dataWorkers = 4;
+  v_int32 ioWorkers = 1;
+  v_int32 timerWorkers = 1;
+  ConnectionPolicy connectionPolicy;
+  ChangeStream::Config events;
+  std::string driverOutput; ///< empty - no LightDriver
+  v_int32 driverLatencyMs = 0;
+  DriverPipeline::Config driver;
+  TransitionEngine::Config transitions;
+  Storage::Config storage;
+  AsyncLogger::Config log;
+  bool logEndpoint = false;
+private:
+
+  static v_int32 getInt(const oatpp::base::CommandLineArguments& args, const char* name, v_int32 defaultValue) {
+    const char* value = args.getNamedArgumentValue(name, nullptr);
+    if (value == nullptr) {
+      return defaultValue;
+    }
+    bool success;
+    v_int32 result = oatpp::utils::conversion::strToInt32(oatpp::String(value), success);
+    if (!success) {
+      OATPP_LOGE("AppConfig", "Invalid value '%s' for '%s', using %d", value, name, defaultValue);
+      return defaultValue;
+    }
+    return result;
+  }
+
+  /**
+   * Read a capacity of a lock-free queue, rounded up to the next power of two.
+   * Values below 2 or above 2^30 are rejected in favour of `defaultValue`.
+   */
+  static v_uint32 getPowerOfTwo(const oatpp::base::CommandLineArguments& args, const char* name, v_uint32 defaultValue) {
+    v_int32 value = getInt(args, name, (v_int32) defaultValue);
+    if (value < 2 || value > (1 << 30)) {
+      OATPP_LOGE("AppConfig", "Invalid value '%d' for '%s', expected 2 to %d, using %u", value, name, 1 << 30, defaultValue);
+      return defaultValue;
+    }
+    v_uint32 result = 2;
+    while (result < (v_uint32) value) {
+      result <<= 1;
+    }
+    if (result != (v_uint32) value) {
+      OATPP_LOGW("AppConfig", "'%s' has to be a power of two, using %u", name, result);
+    }
+    return result;
+  }
+
+  static void addTagLevels(const oatpp::base::CommandLineArguments& args, const char* name,
+                          std::vector<std::pair<std::string, v_uint32>>& tagLevels) {
+    const char* value = args.getNamedArgumentValue(name, nullptr);
+    if (value == nullptr) {
+      return;
+    }
+    std::string list = value;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+      size_t end = list.find(',', begin);
+      if (end == std::string::npos) {
+        end = list.size();
+      }
+      std::string item = list.substr(begin, end - begin);
+      size_t separator = item.find('=');
+      v_uint32 level;
+      if (separator != std::string::npos && separator > 0 && AsyncLogger::parseLevel(item.c_str() + separator + 1, level)) {
+        tagLevels.push_back({item.substr(0, separator), level});
+      } else if (!item.empty()) {
+        OATPP_LOGE("AppConfig", "Invalid value '%s' for '%s', expected <tag>=<V|D|I|W|E>", item.c_str(), name);
+      }
+      begin = end + 1;
+    }
+  }
+
+  static void addRules(const oatpp::base::CommandLineArguments& args, const char* name,
+                       ConnectionPolicy::Mode mode, std::vector<ConnectionPolicy::Rule>& rules) {
+    const char* value = args.getNamedArgumentValue(name, nullptr);
+    if (value == nullptr) {
+      return;
+    }
+    std::string list = value;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+      size_t end = list.find(',', begin);
+      if (end == std::string::npos) {
+        end = list.size();
+      }
+      if (end > begin) {
+        rules.push_back({list.substr(begin, end - begin), mode});
+      }
+      begin = end + 1;
+    }
+  }
+
+public:
+
+  static AppConfig fromArgs(const oatpp::base::CommandLineArguments& args) {
+    AppConfig config;
+    config.port = (v_uint16) getInt(args, "--port", config.port);
+    config.bridges = (v_uint32) std::max(1, getInt(args, "--bridges", (v_int32) config.bridges));
+    config.ssdp.port = (v_uint16) getInt(args, "--ssdp-port", config.ssdp.port);
+    config.shards = (v_uint32) std::max(0, getInt(args, "--shards", (v_int32) config.shards));
+    if (config.shards == 0) {
+      config.shards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    config.pinShards = args.hasArgument("--pin-shards");
+    config.async = args.hasArgument("--async");
+    config.dataWorkers = getInt(args, "--data-workers", config.dataWorkers);
+    config.ioWorkers = getInt(args, "--io-workers", config.ioWorkers);
+    config.timerWorkers = getInt(args, "--timer-workers", config.timerWorkers);
+
+    auto& policy = config.connectionPolicy;
+    if (args.hasArgument("--keep-alive")) {
+      policy.defaultMode = ConnectionPolicy::Mode::KEEP_ALIVE;
+    }
+    addRules(args, "--close-agents", ConnectionPolicy::Mode::CLOSE, policy.rules);
+    addRules(args, "--keep-alive-agents", ConnectionPolicy::Mode::KEEP_ALIVE, policy.rules);
+    policy.idleTimeoutSeconds = getInt(args, "--keep-alive-timeout", policy.idleTimeoutSeconds);
+    policy.maxRequests = (v_uint32) getInt(args, "--keep-alive-max", (v_int32) policy.maxRequests);
+
+    config.events.windowMs = getInt(args, "--events-window", config.events.windowMs);
+    config.events.queueCapacity = (v_uint32) getInt(args, "--events-queue", (v_int32) config.events.queueCapacity);
+    if (policy.allowsKeepAlive()) {
+      // ping event streams before the ConnectionMonitor considers them idle
+      config.events.pingIntervalMs = std::min(config.events.pingIntervalMs, std::max(500, policy.idleTimeoutSeconds * 1000 / 2));
+    }
+
+    config.driverOutput = args.getNamedArgumentValue("--driver-output", "");
+    config.driverLatencyMs = getInt(args, "--driver-latency", config.driverLatencyMs);
+    config.driver.tickMs = getInt(args, "--driver-tick", config.driver.tickMs);
+    config.driver.queueCapacity = getPowerOfTwo(args, "--driver-queue", config.driver.queueCapacity);
+    config.transitions.tickMs = std::max(0, getInt(args, "--transition-tick", config.transitions.tickMs));
+
+    config.storage.directory = args.getNamedArgumentValue("--data-dir", "");
+    config.storage.sync = !args.hasArgument("--data-no-sync");
+    config.storage.compactBytes = (v_int64) getInt(args, "--data-compact", (v_int32) (config.storage.compactBytes / 1024)) * 1024;
+
+    const char* level = args.getNamedArgumentValue("--log-level", nullptr);
+    if (level != nullptr && !AsyncLogger::parseLevel(level, config.log.level)) {
+      OATPP_LOGE("AppConfig", "Invalid value '%s' for '--log-level', using D", level);
+    }
+    addTagLevels(args, "--log-tags", config.log.tagLevels);
+    config.log.ringBytes = (v_uint32) getInt(args, "--log-ring", (v_int32) (config.log.ringBytes / 1024)) * 1024;
+    config.logEndpoint = args.hasArgument("--log-endpoint");
+    return config;
+  }
+
+};
+
+#endif /* AppConfig_hpp */
@@ -2,17 +2,196 @@
 #ifndef DeviceDescriptorComponent_hpp
 #define DeviceDescriptorComponent_hpp
 
+#include "oatpp/core/data/stream/BufferStream.hpp"
 #include "oatpp/core/Types.hpp"
 #include "oatpp/core/macro/component.hpp"
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
 class DeviceDescriptorComponent {
 public:
   class DeviceDescriptor {
+  public:
+
+    /**
+     *  Everything derived from the descriptor that is sent unchanged with every response.
+     *  Rendered once and shared by all requests.
+     */
+    class Rendered {
+    public:
+      oatpp::String descriptionXml; ///< body of `GET /description.xml`
+      oatpp::String location; ///< SSDP LOCATION header
+      oatpp::String usn; ///< SSDP USN header
+      std::vector<oatpp::String> searchTargets; ///< `ST` of the root device, UUID and device type
+      std::vector<oatpp::String> searchResponses; ///< whole datagrams answering an `M-SEARCH *` for each of the searchTargets
+      std::vector<oatpp::String> aliveNotifications; ///< `NOTIFY * ssdp:alive` datagrams of the same
+      std::vector<oatpp::String> byebyeNotifications; ///< `NOTIFY * ssdp:byebye` datagrams of the same
+    private:
+      friend class DeviceDescriptor;
+      // descriptor fields this was rendered from
+      std::shared_ptr<std::string> sn;
+      std::shared_ptr<std::string> uuid;
+      std::shared_ptr<std::string> ipPort;
+      std::shared_ptr<std::string> mac;
+    };
+
+  private:
+    std::shared_ptr<const Rendered> m_rendered; // access via std::atomic_load/std::atomic_store only
+  private:
+
+    bool isRenderedFrom(const Rendered& rendered) const {
+      return rendered.sn == sn.getPtr() && rendered.uuid == uuid.getPtr() &&
+             rendered.ipPort == ipPort.getPtr() && rendered.mac == mac.getPtr();
+    }
+
+    std::shared_ptr<const Rendered> render() const {
+
+      auto rendered = std::make_shared<Rendered>();
+      rendered->sn = sn.getPtr();
+      rendered->uuid = uuid.getPtr();
+      rendered->ipPort = ipPort.getPtr();
+      rendered->mac = mac.getPtr();
+
+      oatpp::data::stream::BufferOutputStream ss;
+      ss <<
+        "<?xml version=\"1.0\"?>\n"
+        "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">\n"
+        "  <specVersion>\n"
+        "    <major>1</major>\n"
+        "    <minor>0</minor>\n"
+        "  </specVersion>\n"
+        "  <URLBase>http://" << ipPort << "/</URLBase>\n"
+        "  <device>\n"
+        "    <deviceType>urn:schemas-upnp-org:device:Basic:1</deviceType>\n"
+        "    <friendlyName>Philips hue (" << ipPort << ")</friendlyName>\n"
+        "    <manufacturer>Royal Philips Electronics</manufacturer>\n"
+        "    <manufacturerURL>http://www.philips.com</manufacturerURL>\n"
+        "    <modelDescription>Philips hue Personal Wireless Lighting</modelDescription>\n"
+        "    <modelName>Philips hue bridge 2012</modelName>\n"
+        "    <modelNumber>" << sn << "</modelNumber>\n"
+        "    <modelURL>http://www.meethue.com</modelURL>\n"
+        "    <serialNumber>" << mac << "</serialNumber>\n"
+        "    <UDN>uuid:" << uuid << "</UDN>\n"
+        "    <presentationURL>index.html</presentationURL>\n"
+        "    <serviceList>\n"
+        "      <service>\n"
+        "        <serviceType>(null)</serviceType>\n"
+        "        <serviceId>(null)</serviceId>\n"
+        "        <controlURL>(null)</controlURL>\n"
+        "        <eventSubURL>(null)</eventSubURL>\n"
+        "        <SCPDURL>(null)</SCPDURL>\n"
+        "      </service>\n"
+        "    </serviceList>\n"
+        "  </device>\n"
+        "</root>";
+      rendered->descriptionXml = ss.toString();
+
+      rendered->location = "http://" + ipPort + "/description.xml";
+      rendered->usn = "uuid:" + uuid + "::upnp:rootdevice";
+
+      const std::string maxAge = std::to_string(MAX_AGE_SECONDS);
+
+      // ST/NT and USN of the answers and announcements
+      const oatpp::String uuidUsn = "uuid:" + uuid;
+      const oatpp::String targets[3][2] = {
+        {"upnp:rootdevice", rendered->usn},
+        {uuidUsn, uuidUsn},
+        {"urn:schemas-upnp-org:device:basic:1", uuidUsn + "::urn:schemas-upnp-org:device:basic:1"}
+      };
+      for (auto& target : targets) {
+        rendered->searchTargets.push_back(target[0]);
+
+        oatpp::data::stream::BufferOutputStream search;
+        search <<
+          "HTTP/1.1 200 OK\r\n"
+          "CACHE-CONTROL: max-age=" << maxAge.c_str() << "\r\n"
+          "EXT:\r\n"
+          "LOCATION: " << rendered->location << "\r\n"
+          "SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0\r\n"
+          "ST: " << target[0] << "\r\n"
+          "USN: " << target[1] << "\r\n"
+          "\r\n";
+        rendered->searchResponses.push_back(search.toString());
+
+        oatpp::data::stream::BufferOutputStream alive;
+        alive <<
+          "NOTIFY * HTTP/1.1\r\n"
+          "HOST: 239.255.255.250:1900\r\n"
+          "CACHE-CONTROL: max-age=" << maxAge.c_str() << "\r\n"
+          "LOCATION: " << rendered->location << "\r\n"
+          "SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0\r\n"
+          "NTS: ssdp:alive\r\n"
+          "NT: " << target[0] << "\r\n"
+          "USN: " << target[1] << "\r\n"
+          "\r\n";
+        rendered->aliveNotifications.push_back(alive.toString());
+
+        oatpp::data::stream::BufferOutputStream byebye;
+        byebye <<
+          "NOTIFY * HTTP/1.1\r\n"
+          "HOST: 239.255.255.250:1900\r\n"
+          "NTS: ssdp:byebye\r\n"
+          "NT: " << target[0] << "\r\n"
+          "USN: " << target[1] << "\r\n"
+          "\r\n";
+        rendered->byebyeNotifications.push_back(byebye.toString());
+      }
+
+      return rendered;
+
+    }
+
+  public:
+    static constexpr const char* UUID_PREFIX = "2f402f80-da50-11e1-9b23-"; ///< followed by the MAC
+    static constexpr v_int32 MAX_AGE_SECONDS = 100; ///< SSDP CACHE-CONTROL, announcements are repeated well within it
   public:
     oatpp::String sn;
     oatpp::String uuid;
     oatpp::String ipPort;
     oatpp::String mac;
+  public:
+
+    /**
+     * Get the pre-rendered responses. They are rendered on first use and again only after a field was reassigned.
+     * @return - shared immutable Rendered
+     */
+    std::shared_ptr<const Rendered> getRendered() {
+      auto rendered = std::atomic_load(&m_rendered);
+      if (!rendered || !isRenderedFrom(*rendered)) {
+        rendered = render();
+        std::atomic_store(&m_rendered, rendered);
+      }
+      return rendered;
+    }
+
+    /**
+     * Descriptor of another bridge hosted by the same process: same address and serial number,
+     * its own port and a MAC (and with it an UUID) of its own.
+     * @param index - index of the bridge, the MAC is counted up by it
+     * @param port - HTTP port of the bridge
+     * @return - new DeviceDescriptor
+     */
+    std::shared_ptr<DeviceDescriptor> deriveBridge(v_uint32 index, v_uint16 port) const {
+      auto desc = std::make_shared<DeviceDescriptor>();
+      std::string host = ipPort->substr(0, ipPort->find(':'));
+      desc->ipPort = host + ":" + std::to_string(port);
+
+      // the last 4 digits of the MAC are counted up, i.E. be5t0a70cafe, be5t0a70caff, be5t0a70cb00...
+      std::string prefix = mac->size() > 4 ? mac->substr(0, mac->size() - 4) : std::string();
+      v_uint32 suffix = (v_uint32) std::strtoul(mac->c_str() + prefix.size(), nullptr, 16);
+      char digits[8];
+      std::snprintf(digits, sizeof(digits), "%04x", (suffix + index) & 0xFFFF);
+      desc->mac = prefix + digits;
+
+      desc->sn = sn;
+      desc->uuid = UUID_PREFIX + desc->mac;
+      return desc;
+    }
+
   };
 
   OATPP_CREATE_COMPONENT(std::shared_ptr<DeviceDescriptor>, deviceDescriptor)("deviceDescriptor", [] {
@@ -25,7 +204,9 @@ public:
 
     // fixed
     desc->sn = "1000000471337";
-    desc->uuid = "2f402f80-da50-11e1-9b23-" + desc->mac;
+    desc->uuid = DeviceDescriptor::UUID_PREFIX + desc->mac;
+
+    desc->getRendered(); // render once at startup
     return desc;
   }());
 
@@ -0,0 +1,27 @@
+
+#include "Bridge.hpp"
+
+#include "oatpp/core/macro/component.hpp"
+
+Bridge::Bridge(v_uint32 index,
+               v_uint16 port,
+               const std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>& descriptor,
+               const std::shared_ptr<Database>& database,
+               const std::shared_ptr<ChangeStream>& changeStream,
+               const std::shared_ptr<Storage>& storage,
+               const std::shared_ptr<DriverPipeline>& driverPipeline)
+  : m_index(index)
+  , m_port(port)
+  , m_descriptor(descriptor)
+  , m_database(database)
+  , m_changeStream(changeStream)
+  , m_storage(storage)
+  , m_driverPipeline(driverPipeline)
+{}
+
+std::shared_ptr<Bridge> Bridge::createFromComponents() {
+  OATPP_COMPONENT(std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>, descriptor);
+  OATPP_COMPONENT(std::shared_ptr<Database>, database);
+  OATPP_COMPONENT(std::shared_ptr<ChangeStream>, changeStream);
+  return createShared(0, 0 /* not served by a BridgeHost */, descriptor, database, changeStream);
+}
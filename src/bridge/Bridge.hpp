@@ -0,0 +1,98 @@
+#ifndef bridge_Bridge_hpp
+#define bridge_Bridge_hpp
+
+#include "DeviceDescriptorComponent.hpp"
+#include "db/Database.hpp"
+#include "db/Storage.hpp"
+#include "driver/DriverPipeline.hpp"
+#include "events/ChangeStream.hpp"
+
+#include "oatpp/core/Types.hpp"
+
+#include <vector>
+
+/**
+ *  One virtual Hue bridge: its descriptor, its HTTP port, and its devices.
+ *  A process hosts one or more bridges (`--bridges`). They share the ObjectMapper, the Metrics,
+ *  the async executor and the SSDP socket - everything else is per bridge.
+ */
+class Bridge {
+public:
+  typedef std::vector<std::shared_ptr<Bridge>> List;
+private:
+  const v_uint32 m_index;
+  const v_uint16 m_port;
+  const std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor> m_descriptor;
+  const std::shared_ptr<Database> m_database;
+  const std::shared_ptr<ChangeStream> m_changeStream;
+  const std::shared_ptr<Storage> m_storage;
+  const std::shared_ptr<DriverPipeline> m_driverPipeline;
+public:
+
+  /**
+   * Constructor.
+   * @param index - `0` for the first bridge of the process
+   * @param port - HTTP port the bridge's Hue API is served on
+   * @param descriptor
+   * @param database - devices and groups of this bridge only
+   * @param changeStream - listening to `database`
+   * @param storage - `nullptr` if the devices are kept in memory only
+   * @param driverPipeline - `nullptr` if no LightDriver drives this bridge's lights
+   */
+  Bridge(v_uint32 index,
+         v_uint16 port,
+         const std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>& descriptor,
+         const std::shared_ptr<Database>& database,
+         const std::shared_ptr<ChangeStream>& changeStream,
+         const std::shared_ptr<Storage>& storage,
+         const std::shared_ptr<DriverPipeline>& driverPipeline);
+
+  static std::shared_ptr<Bridge> createShared(v_uint32 index,
+                                              v_uint16 port,
+                                              const std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>& descriptor,
+                                              const std::shared_ptr<Database>& database,
+                                              const std::shared_ptr<ChangeStream>& changeStream,
+                                              const std::shared_ptr<Storage>& storage = nullptr,
+                                              const std::shared_ptr<DriverPipeline>& driverPipeline = nullptr)
+  {
+    return std::make_shared<Bridge>(index, port, descriptor, database, changeStream, storage, driverPipeline);
+  }
+
+  /**
+   * The bridge of a single-bridge process, made of the `deviceDescriptor`, `Database` and `ChangeStream` components.
+   * Used by the controllers when they are created without a bridge, i.E. by the benchmarks.
+   * @return - new Bridge
+   */
+  static std::shared_ptr<Bridge> createFromComponents();
+
+  v_uint32 getIndex() const {
+    return m_index;
+  }
+
+  v_uint16 getPort() const {
+    return m_port;
+  }
+
+  const std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>& getDescriptor() const {
+    return m_descriptor;
+  }
+
+  const std::shared_ptr<Database>& getDatabase() const {
+    return m_database;
+  }
+
+  const std::shared_ptr<ChangeStream>& getChangeStream() const {
+    return m_changeStream;
+  }
+
+  const std::shared_ptr<Storage>& getStorage() const {
+    return m_storage;
+  }
+
+  const std::shared_ptr<DriverPipeline>& getDriverPipeline() const {
+    return m_driverPipeline;
+  }
+
+};
+
+#endif /* bridge_Bridge_hpp */
@@ -0,0 +1,138 @@
+
+#include "BridgeHost.hpp"
+
+#include "controller/HueDeviceController.hpp"
+#include "controller/HueDeviceAsyncController.hpp"
+#include "metrics/MeteredRequestHandler.hpp"
+
+#include "oatpp-swagger/Controller.hpp"
+#include "oatpp-swagger/AsyncController.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+
+namespace {
+
+const char* const HTTP_FAMILY = "hue_http_request_duration";
+const char* const HTTP_HELP = "Time endpoints took to produce their response";
+
+/**
+ *  Pin the calling thread to `cpu` modulo the CPUs of the host.
+ */
+void pinToCpu(v_uint32 cpu) {
+  v_uint32 cpus = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % cpus, &set);
+  if (::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) != 0) {
+    OATPP_LOGW("Server", "Can't pin the acceptor to CPU %d", (v_int32) (cpu % cpus));
+  }
+}
+
+}
+
+BridgeHost::BridgeHost(const std::shared_ptr<AppComponent>& components)
+  : m_components(components)
+{
+
+  const AppConfig& config = components->getConfig();
+  auto bridges = components->bridges.getObject();
+
+  /* latency of every endpoint is recorded into the Metrics served on GET /metrics - the series are shared by the bridges */
+  auto metrics = components->metrics.getObject();
+
+  /* create the Swagger endpoint documentation engine*/
+  oatpp::web::server::api::Endpoints docEndpoints;
+
+  for (auto& bridge : *bridges) {
+
+    Listener listener;
+    listener.bridge = bridge;
+    listener.router = oatpp::web::server::HttpRouter::createShared();
+
+    std::shared_ptr<oatpp::web::server::api::ApiController> controller;
+    if (config.async) {
+      /* the Hue HTTP REST controller with coroutine endpoints for the AsyncHttpConnectionHandler */
+      controller = HueDeviceAsyncController::createShared(bridge, config.logEndpoint);
+    } else {
+      controller = HueDeviceController::createShared(bridge, config.logEndpoint);
+    }
+    MeteredRequestHandler::addController(listener.router, controller, metrics, HTTP_FAMILY, HTTP_HELP);
+
+    if (m_listeners.empty()) {
+      docEndpoints.append(controller->getEndpoints()); // the same for every bridge
+    }
+
+    for (v_uint32 i = 0; i < config.shards; i++) {
+      Shard shard;
+      shard.provider = components->createConnectionProvider(bridge->getPort());
+      shard.handler = components->createConnectionHandler(listener.router);
+      shard.server = std::make_shared<oatpp::network::Server>(shard.provider, shard.handler);
+      listener.shards.push_back(shard);
+    }
+    m_listeners.push_back(listener);
+
+  }
+
+  /* one swagger UI controller for all bridges */
+  std::shared_ptr<oatpp::web::server::api::ApiController> swagger;
+  if (config.async) {
+    swagger = oatpp::swagger::AsyncController::createShared(docEndpoints);
+  } else {
+    swagger = oatpp::swagger::Controller::createShared(docEndpoints);
+  }
+  for (auto& listener : m_listeners) {
+    listener.router->addController(swagger);
+  }
+
+}
+
+BridgeHost::~BridgeHost() {
+  stop();
+  join();
+}
+
+void BridgeHost::start() {
+  const AppConfig& config = m_components->getConfig();
+  for (auto& listener : m_listeners) {
+    for (v_uint32 i = 0; i < listener.shards.size(); i++) {
+      auto server = listener.shards[i].server;
+      bool pin = config.pinShards;
+      m_threads.emplace_back([server, pin, i] {
+        if (pin) {
+          pinToCpu(i);
+        }
+        server->run();
+      });
+    }
+  }
+  OATPP_LOGD("Server", "Running HTTP of %d bridges on ports %d-%d, %d shards each%s (%s, %s)...",
+             (v_int32) m_listeners.size(),
+             (v_int32) m_listeners.front().bridge->getPort(),
+             (v_int32) m_listeners.back().bridge->getPort(),
+             (v_int32) config.shards,
+             config.pinShards ? " pinned to CPUs" : "",
+             config.async ? "async" : "thread per connection",
+             config.connectionPolicy.allowsKeepAlive() ? "keep-alive" : "connection: close");
+}
+
+void BridgeHost::stop() {
+  for (auto& listener : m_listeners) {
+    for (auto& shard : listener.shards) {
+      shard.server->stop();
+      shard.provider->stop();
+      shard.handler->stop();
+    }
+  }
+}
+
+void BridgeHost::join() {
+  for (auto& thread : m_threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  m_threads.clear();
+}
@@ -0,0 +1,79 @@
+#ifndef bridge_BridgeHost_hpp
+#define bridge_BridgeHost_hpp
+
+#include "AppComponent.hpp"
+
+#include "oatpp/network/Server.hpp"
+
+#include <thread>
+#include <vector>
+
+/**
+ *  Serves the Hue API of every bridge on the bridge's own port.
+ *
+ *  Each bridge gets a router with a Hue controller of its own and an oatpp::network::Server
+ *  whose thread only accepts connections. The Swagger controller, the endpoint metrics and - with `--async` -
+ *  the executor threads processing the requests are shared by all bridges.
+ *
+ *  With `--shards <n>` a bridge's port is served by n Servers, each accepting on a socket of its own bound with
+ *  `SO_REUSEPORT`, so accepting isn't limited to one thread. The shards of a bridge share its router and Database.
+ *  With `--pin-shards` the n-th shard of every bridge runs on CPU n - threads inherit the CPUs of the thread
+ *  starting them, so do the connection threads of HttpConnectionHandler.
+ */
+class BridgeHost {
+private:
+
+  struct Shard {
+    std::shared_ptr<oatpp::network::ServerConnectionProvider> provider;
+    std::shared_ptr<oatpp::network::ConnectionHandler> handler;
+    std::shared_ptr<oatpp::network::Server> server;
+  };
+
+  struct Listener {
+    std::shared_ptr<Bridge> bridge;
+    std::shared_ptr<oatpp::web::server::HttpRouter> router;
+    std::vector<Shard> shards;
+  };
+
+private:
+  std::shared_ptr<AppComponent> m_components;
+  std::vector<Listener> m_listeners;
+  std::vector<std::thread> m_threads;
+public:
+
+  /**
+   * Constructor. Binds the ports of all bridges of `components`.
+   * @param components
+   */
+  BridgeHost(const std::shared_ptr<AppComponent>& components);
+
+  /**
+   * Stops and joins the servers.
+   */
+  ~BridgeHost();
+
+  /**
+   * Run every server - shard of a bridge - in a thread of its own.
+   */
+  void start();
+
+  /**
+   * Stop accepting connections on all ports.
+   */
+  void stop();
+
+  /**
+   * Wait for the servers to stop.
+   */
+  void join();
+
+  /**
+   * @return - router of the first bridge, to log its mappings
+   */
+  std::shared_ptr<oatpp::web::server::HttpRouter> getRouter() const {
+    return m_listeners.front().router;
+  }
+
+};
+
+#endif /* bridge_BridgeHost_hpp */
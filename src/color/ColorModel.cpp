@@ -0,0 +1,313 @@
+
+#include "ColorModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) || defined(_MSC_VER)
+  #define HUE_RESTRICT __restrict
+#else
+  #define HUE_RESTRICT
+#endif
+
+const ColorModel::Gamut ColorModel::GAMUT_B = {0.675f, 0.322f, 0.409f, 0.518f, 0.167f, 0.04f};
+
+constexpr v_uint16 ColorModel::MIN_CT;
+constexpr v_uint16 ColorModel::MAX_CT;
+constexpr v_uint8 ColorModel::MAX_SAT;
+constexpr float ColorModel::XY_SCALE;
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 256; ///< lights per kernel call of convert(), its arrays stay on the stack
+
+/*
+ * The kernels - straight loops over contiguous floats, conditions are selects between values computed up front.
+ * Restrict-qualified parameters tell the compiler the arrays don't overlap, so it vectorizes them without runtime checks.
+ * GCC only turns float comparisons into selects with -fno-trapping-math, this file is built with it - see CMakeLists.txt.
+ * Selects of several values on one condition may still end up as a branch, see clampToGamutKernel().
+ */
+
+void hueSatToXyKernel(const float* HUE_RESTRICT hue, const float* HUE_RESTRICT sat,
+                      float* HUE_RESTRICT x, float* HUE_RESTRICT y, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+
+    // HSV (v = 1) to RGB: the fully saturated color of the hue, h in sextants, mixed with white by s
+    float h = hue[i] * (6.0f / 65536.0f);
+    float s = std::min(sat[i] * (1.0f / ColorModel::MAX_SAT), 1.0f);
+    float r = 1.0f - s + s * std::min(std::max(std::abs(h - 3.0f) - 1.0f, 0.0f), 1.0f);
+    float g = 1.0f - s + s * std::min(std::max(2.0f - std::abs(h - 2.0f), 0.0f), 1.0f);
+    float b = 1.0f - s + s * std::min(std::max(2.0f - std::abs(h - 4.0f), 0.0f), 1.0f);
+
+    // linear sRGB to XYZ, D65
+    float cx = 0.4124564f * r + 0.3575761f * g + 0.1804375f * b;
+    float cy = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+    float cz = 0.0193339f * r + 0.1191920f * g + 0.9503041f * b;
+    float inverseSum = 1.0f / (cx + cy + cz); // one channel is always 1
+
+    x[i] = cx * inverseSum;
+    y[i] = cy * inverseSum;
+
+  }
+}
+
+void xyToHueSatKernel(const float* HUE_RESTRICT x, const float* HUE_RESTRICT y,
+                      float* HUE_RESTRICT hue, float* HUE_RESTRICT sat, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+
+    // XYZ at Y = 1 to linear sRGB, colors outside of sRGB lose their negative channel
+    float inverseY = 1.0f / std::max(y[i], 1e-4f);
+    float cx = x[i] * inverseY;
+    float cz = (1.0f - x[i] - y[i]) * inverseY;
+    float r = std::max(3.2404542f * cx - 1.5371385f - 0.4985314f * cz, 0.0f);
+    float g = std::max(-0.9692660f * cx + 1.8760108f + 0.0415560f * cz, 0.0f);
+    float b = std::max(0.0556434f * cx - 0.2040259f + 1.0572252f * cz, 0.0f);
+
+    float max = std::max(std::max(r, g), b);
+    float chroma = max - std::min(std::min(r, g), b);
+    float inverseChroma = 1.0f / std::max(chroma, 1e-9f); // gray has no hue, the differences below are 0 then
+
+    // sextant of the largest channel
+    float hr = (g - b) * inverseChroma;
+    float hg = (b - r) * inverseChroma + 2.0f;
+    float hb = (r - g) * inverseChroma + 4.0f;
+    float h = max == r ? hr : max == g ? hg : hb;
+    h = h < 0.0f ? h + 6.0f : h;
+
+    hue[i] = h * (65536.0f / 6.0f);
+    sat[i] = chroma / std::max(max, 1e-9f) * ColorModel::MAX_SAT;
+
+  }
+}
+
+void ctToXyKernel(const float* HUE_RESTRICT ct, float* HUE_RESTRICT x, float* HUE_RESTRICT y, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+
+    // Kim et al., in u = 1000 / T
+    float mired = std::min(std::max(ct[i], (float) ColorModel::MIN_CT), (float) ColorModel::MAX_CT);
+    float u = mired * 0.001f;
+    float u2 = u * u;
+    float u3 = u2 * u;
+    float xWarm = -0.2661239f * u3 - 0.2343589f * u2 + 0.8776956f * u + 0.179910f; // up to 4000K
+    float xCold = -3.0258469f * u3 + 2.1070379f * u2 + 0.2226347f * u + 0.240390f;
+    float px = mired >= 250.0f ? xWarm : xCold;
+
+    float px2 = px * px;
+    float px3 = px2 * px;
+    float yWarm = -1.1063814f * px3 - 1.34811020f * px2 + 2.18555832f * px - 0.20219683f; // up to 2222K
+    float yMid = -0.9549476f * px3 - 1.37418593f * px2 + 2.09137015f * px - 0.16748867f; // up to 4000K
+    float yCold = 3.0817580f * px3 - 5.87338670f * px2 + 3.75112997f * px - 0.37001483f;
+
+    x[i] = px;
+    y[i] = mired >= 450.045f ? yWarm : mired >= 250.0f ? yMid : yCold;
+
+  }
+}
+
+void xyToCtKernel(const float* HUE_RESTRICT x, const float* HUE_RESTRICT y, float* HUE_RESTRICT ct, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    // McCamy, n = (x - xe) / (ye - y) around the epicenter (0.3320, 0.1858)
+    float denominator = 0.1858f - y[i];
+    denominator = denominator >= 0.0f ? std::max(denominator, 1e-6f) : std::min(denominator, -1e-6f);
+    float n = (x[i] - 0.3320f) / denominator;
+    float kelvin = ((449.0f * n + 3525.0f) * n + 6823.3f) * n + 5520.33f;
+    // far off the locus the approximation runs out of range, the clamps take it to one of the ends
+    float mired = 1000000.0f / std::max(kelvin, 1000.0f);
+    ct[i] = std::min(std::max(mired, (float) ColorModel::MIN_CT), (float) ColorModel::MAX_CT);
+  }
+}
+
+/**
+ *  Edge of a gamut, from (ax, ay) to (ax + dx, ay + dy).
+ */
+struct Edge {
+  float ax, ay;
+  float dx, dy;
+  float inverseLength2; ///< 1 / squared length
+
+  Edge(float fromX, float fromY, float toX, float toY)
+    : ax(fromX), ay(fromY)
+    , dx(toX - fromX), dy(toY - fromY)
+    , inverseLength2(1.0f / (dx * dx + dy * dy))
+  {}
+
+  /**
+   * > 0 if p is left of the edge.
+   */
+  float side(float px, float py) const {
+    return dx * (py - ay) - dy * (px - ax);
+  }
+
+  /**
+   * Closest point of the edge to p, returns its squared distance.
+   */
+  float closest(float px, float py, float& qx, float& qy) const {
+    float t = std::min(std::max(((px - ax) * dx + (py - ay) * dy) * inverseLength2, 0.0f), 1.0f);
+    qx = ax + t * dx;
+    qy = ay + t * dy;
+    return (px - qx) * (px - qx) + (py - qy) * (py - qy);
+  }
+
+};
+
+void clampToGamutKernel(const ColorModel::Gamut& gamut, float* HUE_RESTRICT x, float* HUE_RESTRICT y, size_t count) {
+
+  // the corners are counterclockwise, points inside are left of every edge
+  const Edge redGreen(gamut.redX, gamut.redY, gamut.greenX, gamut.greenY);
+  const Edge greenBlue(gamut.greenX, gamut.greenY, gamut.blueX, gamut.blueY);
+  const Edge blueRed(gamut.blueX, gamut.blueY, gamut.redX, gamut.redY);
+
+  for (size_t i = 0; i < count; i++) {
+
+    float px = x[i];
+    float py = y[i];
+    float inside = std::min(std::min(redGreen.side(px, py), greenBlue.side(px, py)), blueRed.side(px, py));
+
+    float rgX, rgY, gbX, gbY, brX, brY;
+    float rgDistance = redGreen.closest(px, py, rgX, rgY);
+    float gbDistance = greenBlue.closest(px, py, gbX, gbY);
+    float brDistance = blueRed.closest(px, py, brX, brY);
+
+    float qx = rgDistance <= gbDistance ? rgX : gbX;
+    float qy = rgDistance <= gbDistance ? rgY : gbY;
+    float qDistance = std::min(rgDistance, gbDistance);
+    qx = brDistance < qDistance ? brX : qx;
+    qy = brDistance < qDistance ? brY : qy;
+
+    // one select for both coordinates - two selects on the same condition become a branch
+    float outside = inside >= 0.0f ? 0.0f : 1.0f;
+    x[i] = px + (qx - px) * outside;
+    y[i] = py + (qy - py) * outside;
+
+  }
+
+}
+
+v_uint16 toHue(float value) {
+  return (v_uint16) ((v_int32) (value + 0.5f) & 0xFFFF); // 65536 wraps to 0
+}
+
+v_uint8 toSat(float value) {
+  return (v_uint8) std::min(value + 0.5f, (float) ColorModel::MAX_SAT);
+}
+
+v_uint16 toCt(float value) {
+  return (v_uint16) (value + 0.5f);
+}
+
+v_uint16 toFixed(float coordinate) {
+  return (v_uint16) (std::min(std::max(coordinate, 0.0f), 1.0f) * ColorModel::XY_SCALE + 0.5f);
+}
+
+}
+
+void ColorModel::hueSatToXy(const float* hue, const float* sat, float* x, float* y, size_t count) {
+  hueSatToXyKernel(hue, sat, x, y, count);
+}
+
+void ColorModel::xyToHueSat(const float* x, const float* y, float* hue, float* sat, size_t count) {
+  xyToHueSatKernel(x, y, hue, sat, count);
+}
+
+void ColorModel::ctToXy(const float* ct, float* x, float* y, size_t count) {
+  ctToXyKernel(ct, x, y, count);
+}
+
+void ColorModel::xyToCt(const float* x, const float* y, float* ct, size_t count) {
+  xyToCtKernel(x, y, ct, count);
+}
+
+void ColorModel::clampToGamut(const Gamut& gamut, float* x, float* y, size_t count) {
+  clampToGamutKernel(gamut, x, y, count);
+}
+
+void ColorModel::convert(const HueDevice* hueDevices, Color* colors, size_t count) {
+
+  float hue[CHUNK_SIZE], sat[CHUNK_SIZE], ct[CHUNK_SIZE];
+  float x[CHUNK_SIZE], y[CHUNK_SIZE];
+  float hsX[CHUNK_SIZE], hsY[CHUNK_SIZE], ctX[CHUNK_SIZE], ctY[CHUNK_SIZE];
+
+  for (size_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+
+    const HueDevice* devices = hueDevices + begin;
+    const size_t size = std::min(CHUNK_SIZE, count - begin);
+
+    // every light goes through every kernel, the colormode picks the result afterwards
+    for (size_t i = 0; i < size; i++) {
+      const HueDevice& hueDevice = devices[i];
+      bool hs = hueDevice.mode == HueColorMode::HS;
+      bool xy = hueDevice.mode == HueColorMode::XY;
+      hue[i] = hs ? hueDevice.hue : 0;
+      sat[i] = hs ? hueDevice.sat : 0;
+      ct[i] = hs || xy ? MIN_CT : hueDevice.ct;
+      x[i] = xy ? hueDevice.x * (1.0f / XY_SCALE) : 0;
+      y[i] = xy ? hueDevice.y * (1.0f / XY_SCALE) : 0;
+    }
+
+    hueSatToXyKernel(hue, sat, hsX, hsY, size);
+    ctToXyKernel(ct, ctX, ctY, size);
+
+    for (size_t i = 0; i < size; i++) {
+      switch (devices[i].mode) {
+        case HueColorMode::HS: x[i] = hsX[i]; y[i] = hsY[i]; break;
+        case HueColorMode::XY: break;
+        default: x[i] = ctX[i]; y[i] = ctY[i];
+      }
+    }
+
+    clampToGamutKernel(GAMUT_B, x, y, size);
+    // the native coordinates are kept, the arrays of the others are reused for the derived ones
+    xyToHueSatKernel(x, y, hsX, hsY, size);
+    xyToCtKernel(x, y, ctX, size);
+
+    for (size_t i = 0; i < size; i++) {
+      const HueDevice& hueDevice = devices[i];
+      Color& color = colors[begin + i];
+      bool hs = hueDevice.mode == HueColorMode::HS;
+      color.x = x[i];
+      color.y = y[i];
+      color.hue = hs ? hueDevice.hue : toHue(hsX[i]);
+      color.sat = hs ? hueDevice.sat : toSat(hsY[i]);
+      color.ct = hueDevice.mode == HueColorMode::CT ? hueDevice.ct : toCt(ctX[i]);
+    }
+
+  }
+
+}
+
+ColorModel::Color ColorModel::convert(const HueDevice& hueDevice) {
+  Color color;
+  convert(&hueDevice, &color, 1);
+  return color;
+}
+
+void ColorModel::setMode(HueDevice& hueDevice, HueColorMode mode) {
+  if (hueDevice.mode == mode) {
+    return;
+  }
+  Color color = convert(hueDevice);
+  switch (mode) {
+    case HueColorMode::HS:
+      hueDevice.hue = color.hue;
+      hueDevice.sat = color.sat;
+      break;
+    case HueColorMode::XY:
+      hueDevice.x = toFixed(color.x);
+      hueDevice.y = toFixed(color.y);
+      break;
+    default:
+      hueDevice.ct = color.ct;
+  }
+  hueDevice.mode = mode;
+}
+
+void ColorModel::setXy(HueDevice& hueDevice, float x, float y) {
+  x = std::min(std::max(x, 0.0f), 1.0f);
+  y = std::min(std::max(y, 0.0f), 1.0f);
+  clampToGamutKernel(GAMUT_B, &x, &y, 1);
+  hueDevice.x = toFixed(x);
+  hueDevice.y = toFixed(y);
+  hueDevice.mode = HueColorMode::XY;
+}
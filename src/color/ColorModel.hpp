@@ -0,0 +1,129 @@
+#ifndef color_ColorModel_hpp
+#define color_ColorModel_hpp
+
+#include "db/model/HueDevice.hpp"
+
+#include <cstddef>
+
+/**
+ *  Conversions between the color spaces of the Hue API - CIE 1931 `xy`, `hue`/`sat` and `ct` (mired).
+ *
+ *  A HueDevice keeps its color once, in the space of its colormode. Everything the API reports besides it
+ *  is derived here: the color is taken to xy, clamped to the gamut of the bulb, and taken from there
+ *  to hue/sat and ct. So every space of a light describes the same color.
+ *
+ *  - hue/sat is HSV (v = 1) over linear RGB with the sRGB primaries and D65 white point.
+ *  - ct to xy follows the Planckian locus (Kim et al. cubic spline), xy to ct uses McCamy's approximation.
+ *
+ *  The kernels work on arrays - one array per coordinate, `count` lights - as straight loops without branches,
+ *  which the compiler vectorizes. Converting a whole frame or page of lights at once is several times faster
+ *  than a light at a time, see ColorBench.
+ */
+class ColorModel {
+public:
+
+  /**
+   *  Triangle of the colors a bulb can show, corners in xy.
+   */
+  struct Gamut {
+    float redX, redY;
+    float greenX, greenY;
+    float blueX, blueY;
+  };
+
+  /**
+   *  Color of a light in every space the Hue API reports.
+   */
+  struct Color {
+    float x;
+    float y;
+    v_uint16 hue;
+    v_uint8 sat;
+    v_uint16 ct;
+  };
+
+public:
+  static const Gamut GAMUT_B; ///< gamut of the "LCT007" bulbs the hub reports
+  static constexpr v_uint16 MIN_CT = 153; ///< 6500K
+  static constexpr v_uint16 MAX_CT = 500; ///< 2000K
+  static constexpr v_uint8 MAX_SAT = 254;
+  static constexpr float XY_SCALE = 65535.0f; ///< HueDevice keeps x and y in 1/65535
+public:
+
+  /**
+   * @param hue - 0..65535 around the color wheel
+   * @param sat - 0..254
+   * @param x - out
+   * @param y - out
+   * @param count
+   */
+  static void hueSatToXy(const float* hue, const float* sat, float* x, float* y, size_t count);
+
+  /**
+   * Colors outside of sRGB are taken to the sRGB color of the same hue.
+   * @param x
+   * @param y
+   * @param hue - out: 0..65536, wraps around
+   * @param sat - out: 0..254
+   * @param count
+   */
+  static void xyToHueSat(const float* x, const float* y, float* hue, float* sat, size_t count);
+
+  /**
+   * @param ct - mired, clamped to MIN_CT..MAX_CT
+   * @param x - out
+   * @param y - out
+   * @param count
+   */
+  static void ctToXy(const float* ct, float* x, float* y, size_t count);
+
+  /**
+   * @param x
+   * @param y
+   * @param ct - out: mired of the correlated color temperature, clamped to MIN_CT..MAX_CT
+   * @param count
+   */
+  static void xyToCt(const float* x, const float* y, float* ct, size_t count);
+
+  /**
+   * Move colors outside of the gamut to the closest color inside. Colors inside are kept.
+   * @param gamut
+   * @param x - in/out
+   * @param y - in/out
+   * @param count
+   */
+  static void clampToGamut(const Gamut& gamut, float* x, float* y, size_t count);
+
+  /**
+   * Color of lights in every space. Converts 256 lights per kernel call.
+   * @param hueDevices
+   * @param colors - out: `count` colors
+   * @param count
+   */
+  static void convert(const HueDevice* hueDevices, Color* colors, size_t count);
+
+  /**
+   * Color of a light in every space.
+   * @param hueDevice
+   * @return
+   */
+  static Color convert(const HueDevice& hueDevice);
+
+  /**
+   * Keep the color of a light in another space, i.E. before only some of its coordinates are changed.
+   * @param hueDevice
+   * @param mode
+   */
+  static void setMode(HueDevice& hueDevice, HueColorMode mode);
+
+  /**
+   * Set the xy color of a light, clamped to the gamut.
+   * @param hueDevice - switched to colormode "xy"
+   * @param x
+   * @param y
+   */
+  static void setXy(HueDevice& hueDevice, float x, float y);
+
+};
+
+#endif /* color_ColorModel_hpp */
@@ -0,0 +1,35 @@
+#ifndef ConnectionMetrics_hpp
+#define ConnectionMetrics_hpp
+
+#include "dto/ConnectionMetricsDto.hpp"
+
+#include <atomic>
+
+/**
+ *  Counters of the HTTP server, updated by TrackedConnectionHandler and ConnectionPolicyInterceptor.
+ *  `requestsServed / connectionsOpened` shows how well keep-alive connections are reused.
+ */
+class ConnectionMetrics {
+public:
+  std::atomic<v_int64> connectionsOpened{0};
+  std::atomic<v_int64> connectionsClosed{0};
+  std::atomic<v_int64> requestsServed{0};
+  std::atomic<v_int64> keepAliveResponses{0}; ///< responses that left their connection open
+public:
+
+  oatpp::Object<ConnectionMetricsDto> toDto() const {
+    auto dto = ConnectionMetricsDto::createShared();
+    v_int64 opened = connectionsOpened.load();
+    v_int64 closed = connectionsClosed.load();
+    v_int64 requests = requestsServed.load();
+    dto->connectionsOpened = opened;
+    dto->connectionsActive = opened - closed;
+    dto->requestsServed = requests;
+    dto->keepAliveResponses = keepAliveResponses.load();
+    dto->requestsPerConnection = opened > 0 ? (v_float64) requests / opened : 0.0;
+    return dto;
+  }
+
+};
+
+#endif /* ConnectionMetrics_hpp */
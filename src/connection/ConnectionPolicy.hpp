@@ -0,0 +1,69 @@
+#ifndef ConnectionPolicy_hpp
+#define ConnectionPolicy_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ *  Decides whether a client may keep its HTTP connection open.
+ *  `close` is the default since some Hue clients can't handle persistent connections,
+ *  keep-alive can be enabled for everyone or for selected client classes by User-Agent.
+ */
+class ConnectionPolicy {
+public:
+
+  enum class Mode : v_int32 {
+    CLOSE = 0,
+    KEEP_ALIVE = 1
+  };
+
+  /**
+   *  Mode for clients whose User-Agent contains `userAgent`.
+   */
+  struct Rule {
+    std::string userAgent;
+    Mode mode;
+  };
+
+public:
+  Mode defaultMode = Mode::CLOSE;
+  std::vector<Rule> rules; ///< checked in order, the first match wins
+  v_int32 idleTimeoutSeconds = 5; ///< keep-alive connections idle for longer are closed
+  v_uint32 maxRequests = 100; ///< requests per keep-alive connection, the last response closes it
+public:
+
+  /**
+   * @param userAgent - User-Agent header of the request, may be `nullptr`
+   * @return - Mode for this client
+   */
+  Mode getMode(const oatpp::String& userAgent) const {
+    if (userAgent) {
+      for (const auto& rule : rules) {
+        if (userAgent->find(rule.userAgent) != std::string::npos) {
+          return rule.mode;
+        }
+      }
+    }
+    return defaultMode;
+  }
+
+  /**
+   * @return - `true` if any client may get a keep-alive connection
+   */
+  bool allowsKeepAlive() const {
+    if (defaultMode == Mode::KEEP_ALIVE) {
+      return true;
+    }
+    for (const auto& rule : rules) {
+      if (rule.mode == Mode::KEEP_ALIVE) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+};
+
+#endif /* ConnectionPolicy_hpp */
@@ -0,0 +1,39 @@
+
+#include "ConnectionPolicyInterceptor.hpp"
+#include "TrackedConnectionHandler.hpp"
+
+#include "oatpp/core/data/stream/BufferStream.hpp"
+
+ConnectionPolicyInterceptor::ConnectionPolicyInterceptor(const ConnectionPolicy& policy,
+                                                         const std::shared_ptr<ConnectionMetrics>& metrics)
+  : m_policy(policy)
+  , m_metrics(metrics)
+{
+  oatpp::data::stream::BufferOutputStream ss;
+  ss << "timeout=" << m_policy.idleTimeoutSeconds << ", max=" << (v_int64) m_policy.maxRequests;
+  m_keepAliveHeader = ss.toString();
+}
+
+std::shared_ptr<ConnectionPolicyInterceptor::OutgoingResponse>
+ConnectionPolicyInterceptor::intercept(const std::shared_ptr<IncomingRequest>& request,
+                                       const std::shared_ptr<OutgoingResponse>& response) {
+
+  m_metrics->requestsServed++;
+
+  bool keepAlive = false;
+  if (m_policy.getMode(request->getHeader("User-Agent")) == ConnectionPolicy::Mode::KEEP_ALIVE) {
+    auto connection = std::dynamic_pointer_cast<TrackedConnection>(request->getConnection());
+    keepAlive = connection && connection->onRequest() < m_policy.maxRequests;
+  }
+
+  if (keepAlive) {
+    m_metrics->keepAliveResponses++;
+    response->putHeaderIfNotExists("Connection", "keep-alive");
+    response->putHeaderIfNotExists("Keep-Alive", m_keepAliveHeader);
+  } else {
+    response->putHeaderIfNotExists("Connection", "close");
+  }
+
+  return response;
+
+}
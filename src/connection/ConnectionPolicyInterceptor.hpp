@@ -0,0 +1,33 @@
+#ifndef ConnectionPolicyInterceptor_hpp
+#define ConnectionPolicyInterceptor_hpp
+
+#include "ConnectionPolicy.hpp"
+#include "ConnectionMetrics.hpp"
+
+#include "oatpp/web/server/interceptor/ResponseInterceptor.hpp"
+
+/**
+ *  Sets the `Connection` header of every HTTP response according to the ConnectionPolicy.
+ *  Expects the connections to be handed in by TrackedConnectionHandler to enforce ConnectionPolicy::maxRequests,
+ *  any other connection is closed after its first response.
+ */
+class ConnectionPolicyInterceptor : public oatpp::web::server::interceptor::ResponseInterceptor {
+private:
+  ConnectionPolicy m_policy;
+  std::shared_ptr<ConnectionMetrics> m_metrics;
+  oatpp::String m_keepAliveHeader; ///< pre-rendered `Keep-Alive` header value
+public:
+
+  ConnectionPolicyInterceptor(const ConnectionPolicy& policy, const std::shared_ptr<ConnectionMetrics>& metrics);
+
+  static std::shared_ptr<ConnectionPolicyInterceptor> createShared(const ConnectionPolicy& policy,
+                                                                   const std::shared_ptr<ConnectionMetrics>& metrics) {
+    return std::make_shared<ConnectionPolicyInterceptor>(policy, metrics);
+  }
+
+  std::shared_ptr<OutgoingResponse> intercept(const std::shared_ptr<IncomingRequest>& request,
+                                              const std::shared_ptr<OutgoingResponse>& response) override;
+
+};
+
+#endif /* ConnectionPolicyInterceptor_hpp */
@@ -0,0 +1,109 @@
+#include "ReusePortConnectionProvider.hpp"
+
+#include "oatpp/network/tcp/Connection.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+constexpr v_int32 ReusePortConnectionProvider::POLL_INTERVAL_MS;
+
+void ReusePortConnectionProvider::Invalidator::invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) {
+  auto tcpConnection = std::static_pointer_cast<oatpp::network::tcp::Connection>(connection);
+  ::shutdown(tcpConnection->getHandle(), SHUT_RDWR);
+}
+
+ReusePortConnectionProvider::ReusePortConnectionProvider(const oatpp::network::Address& address)
+  : m_invalidator(std::make_shared<Invalidator>())
+  , m_listening(true)
+  , m_fd(::socket(AF_INET, SOCK_STREAM, 0))
+{
+
+  setProperty(PROPERTY_HOST, address.host);
+  setProperty(PROPERTY_PORT, oatpp::utils::conversion::int32ToStr(address.port));
+
+  if (m_fd < 0) {
+    throw std::runtime_error(std::string("Can't create server socket: ") + std::strerror(errno));
+  }
+
+  int yes = 1;
+  ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  if (::setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) != 0) {
+    std::string message = std::string("Can't set SO_REUSEPORT: ") + std::strerror(errno);
+    ::close(m_fd);
+    throw std::runtime_error(message);
+  }
+
+  sockaddr_in sockAddress;
+  std::memset(&sockAddress, 0, sizeof(sockAddress));
+  sockAddress.sin_family = AF_INET;
+  sockAddress.sin_port = htons(address.port);
+  if (address.family != oatpp::network::Address::IP_4 ||
+      ::inet_pton(AF_INET, address.host->c_str(), &sockAddress.sin_addr) != 1 ||
+      ::bind(m_fd, (const sockaddr*) &sockAddress, sizeof(sockAddress)) != 0 ||
+      ::listen(m_fd, SOMAXCONN) != 0)
+  {
+    std::string message = "Can't listen on " + *address.host + ":" + std::to_string(address.port) + ": " + std::strerror(errno);
+    ::close(m_fd);
+    throw std::runtime_error(message);
+  }
+
+  // accept() never blocks after poll() - accepted connections are blocking, they don't inherit the flag
+  ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+
+}
+
+ReusePortConnectionProvider::~ReusePortConnectionProvider() {
+  ::close(m_fd);
+}
+
+oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream> ReusePortConnectionProvider::get() {
+
+  while (m_listening) {
+
+    pollfd pollFd;
+    pollFd.fd = m_fd;
+    pollFd.events = POLLIN;
+    pollFd.revents = 0;
+    if (::poll(&pollFd, 1, POLL_INTERVAL_MS) <= 0) {
+      continue;
+    }
+
+    int handle = ::accept(m_fd, nullptr, nullptr);
+    if (handle < 0) {
+      // the client gave up already
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EINTR) {
+        continue;
+      }
+      return nullptr;
+    }
+
+    return oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>(
+      std::make_shared<oatpp::network::tcp::Connection>(handle),
+      m_invalidator
+    );
+
+  }
+
+  return nullptr;
+
+}
+
+oatpp::async::CoroutineStarterForResult<const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>&>
+ReusePortConnectionProvider::getAsync() {
+  throw std::runtime_error("[ReusePortConnectionProvider::getAsync()]: Error. Not implemented.");
+}
+
+void ReusePortConnectionProvider::stop() {
+  m_listening = false;
+  ::shutdown(m_fd, SHUT_RDWR); // wakes a thread waiting in get()
+}
@@ -0,0 +1,64 @@
+#ifndef ReusePortConnectionProvider_hpp
+#define ReusePortConnectionProvider_hpp
+
+#include "oatpp/network/ConnectionProvider.hpp"
+#include "oatpp/network/Address.hpp"
+
+#include <atomic>
+
+/**
+ *  TCP server ConnectionProvider binding its port with `SO_REUSEPORT`.
+ *  Several of them - each accepting on a thread of its own - can listen on the same port,
+ *  the kernel spreads the incoming connections over their sockets. Used by BridgeHost with `--shards`.
+ *
+ *  oatpp's tcp::server::ConnectionProvider binds with `SO_REUSEADDR` only, a second one on the port fails to bind.
+ *  Connections are handed on as oatpp::network::tcp::Connection, the same as with oatpp's provider.
+ */
+class ReusePortConnectionProvider : public oatpp::network::ServerConnectionProvider {
+private:
+
+  /**
+   *  Shuts an accepted connection down, it is closed once the last handle to it is gone.
+   */
+  class Invalidator : public oatpp::provider::Invalidator<oatpp::data::stream::IOStream> {
+  public:
+    void invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) override;
+  };
+
+private:
+  static constexpr v_int32 POLL_INTERVAL_MS = 500; ///< stop() takes effect within this time
+private:
+  std::shared_ptr<Invalidator> m_invalidator;
+  std::atomic<bool> m_listening;
+  int m_fd;
+public:
+
+  /**
+   * Constructor. Binds and listens.
+   * @param address - IPv4 only
+   * @throws - `std::runtime_error` if the port can't be bound
+   */
+  ReusePortConnectionProvider(const oatpp::network::Address& address);
+
+  ~ReusePortConnectionProvider() override;
+
+  static std::shared_ptr<ReusePortConnectionProvider> createShared(const oatpp::network::Address& address) {
+    return std::make_shared<ReusePortConnectionProvider>(address);
+  }
+
+  /**
+   * Wait for the next connection.
+   * @return - the connection, `nullptr` if accepting failed or the provider was stopped
+   */
+  oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream> get() override;
+
+  /**
+   * Not implemented - oatpp::network::Server accepts with get() in async mode too.
+   */
+  oatpp::async::CoroutineStarterForResult<const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>&> getAsync() override;
+
+  void stop() override;
+
+};
+
+#endif /* ReusePortConnectionProvider_hpp */
@@ -0,0 +1,95 @@
+
+#include "TrackedConnectionHandler.hpp"
+
+#include "oatpp/network/tcp/Connection.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+TrackedConnection::TrackedConnection(const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& connection,
+                                     const std::shared_ptr<ConnectionMetrics>& metrics)
+  : m_connection(connection)
+  , m_metrics(metrics)
+  , m_requests(0)
+{
+  m_metrics->connectionsOpened++;
+}
+
+TrackedConnection::~TrackedConnection() {
+  m_metrics->connectionsClosed++;
+}
+
+bool TrackedConnection::isLoopback() const {
+  auto connection = std::dynamic_pointer_cast<oatpp::network::tcp::Connection>(m_connection.object);
+  if (!connection) {
+    return false;
+  }
+  sockaddr_storage address;
+  socklen_t size = sizeof(address);
+  if (::getpeername(connection->getHandle(), (sockaddr*) &address, &size) != 0) {
+    return false;
+  }
+  if (address.ss_family == AF_INET) {
+    return (ntohl(((sockaddr_in*) &address)->sin_addr.s_addr) >> 24) == 127;
+  }
+  if (address.ss_family == AF_INET6) {
+    const in6_addr& ip = ((sockaddr_in6*) &address)->sin6_addr;
+    return IN6_IS_ADDR_LOOPBACK(&ip) || (IN6_IS_ADDR_V4MAPPED(&ip) && ip.s6_addr[12] == 127);
+  }
+  return false;
+}
+
+oatpp::v_io_size TrackedConnection::write(const void *buff, v_buff_size count, oatpp::async::Action& action) {
+  return m_connection.object->write(buff, count, action);
+}
+
+oatpp::v_io_size TrackedConnection::read(void *buff, v_buff_size count, oatpp::async::Action& action) {
+  return m_connection.object->read(buff, count, action);
+}
+
+void TrackedConnection::setOutputStreamIOMode(oatpp::data::stream::IOMode ioMode) {
+  m_connection.object->setOutputStreamIOMode(ioMode);
+}
+
+oatpp::data::stream::IOMode TrackedConnection::getOutputStreamIOMode() {
+  return m_connection.object->getOutputStreamIOMode();
+}
+
+oatpp::data::stream::Context& TrackedConnection::getOutputStreamContext() {
+  return m_connection.object->getOutputStreamContext();
+}
+
+void TrackedConnection::setInputStreamIOMode(oatpp::data::stream::IOMode ioMode) {
+  m_connection.object->setInputStreamIOMode(ioMode);
+}
+
+oatpp::data::stream::IOMode TrackedConnection::getInputStreamIOMode() {
+  return m_connection.object->getInputStreamIOMode();
+}
+
+oatpp::data::stream::Context& TrackedConnection::getInputStreamContext() {
+  return m_connection.object->getInputStreamContext();
+}
+
+void TrackedConnectionHandler::Invalidator::invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) {
+  auto& accepted = std::static_pointer_cast<TrackedConnection>(connection)->getConnection();
+  accepted.invalidator->invalidate(accepted.object);
+}
+
+TrackedConnectionHandler::TrackedConnectionHandler(const std::shared_ptr<oatpp::network::ConnectionHandler>& handler,
+                                                   const std::shared_ptr<ConnectionMetrics>& metrics)
+  : m_handler(handler)
+  , m_metrics(metrics)
+  , m_invalidator(std::make_shared<Invalidator>())
+{}
+
+void TrackedConnectionHandler::handleConnection(const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& connection,
+                                                const std::shared_ptr<const ParameterMap>& params) {
+  auto tracked = std::make_shared<TrackedConnection>(connection, m_metrics);
+  m_handler->handleConnection(oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>(tracked, m_invalidator), params);
+}
+
+void TrackedConnectionHandler::stop() {
+  m_handler->stop();
+}
@@ -0,0 +1,93 @@
+#ifndef TrackedConnectionHandler_hpp
+#define TrackedConnectionHandler_hpp
+
+#include "ConnectionMetrics.hpp"
+
+#include "oatpp/network/ConnectionHandler.hpp"
+
+/**
+ *  Connection passed on by TrackedConnectionHandler.
+ *  Forwards all I/O to the accepted connection and counts the requests served on it.
+ */
+class TrackedConnection : public oatpp::data::stream::IOStream {
+private:
+  oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream> m_connection;
+  std::shared_ptr<ConnectionMetrics> m_metrics;
+  std::atomic<v_uint32> m_requests;
+public:
+
+  TrackedConnection(const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& connection,
+                    const std::shared_ptr<ConnectionMetrics>& metrics);
+
+  ~TrackedConnection() override;
+
+  /**
+   * Count a request served on this connection.
+   * @return - number of requests served so far, including this one
+   */
+  v_uint32 onRequest() {
+    return ++m_requests;
+  }
+
+  /**
+   * The connection as accepted from the ConnectionProvider.
+   */
+  const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& getConnection() const {
+    return m_connection;
+  }
+
+  /**
+   * @return - `true` if the peer is on this host, i.E. connected from 127.0.0.0/8 or ::1
+   */
+  bool isLoopback() const;
+
+  oatpp::v_io_size write(const void *buff, v_buff_size count, oatpp::async::Action& action) override;
+  oatpp::v_io_size read(void *buff, v_buff_size count, oatpp::async::Action& action) override;
+
+  void setOutputStreamIOMode(oatpp::data::stream::IOMode ioMode) override;
+  oatpp::data::stream::IOMode getOutputStreamIOMode() override;
+  oatpp::data::stream::Context& getOutputStreamContext() override;
+
+  void setInputStreamIOMode(oatpp::data::stream::IOMode ioMode) override;
+  oatpp::data::stream::IOMode getInputStreamIOMode() override;
+  oatpp::data::stream::Context& getInputStreamContext() override;
+
+};
+
+/**
+ *  ConnectionHandler decorator. Counts accepted connections and hands them on as TrackedConnection,
+ *  so ConnectionPolicyInterceptor can see how many requests a connection has served.
+ */
+class TrackedConnectionHandler : public oatpp::network::ConnectionHandler {
+private:
+
+  /**
+   *  Invalidates the accepted connection wrapped by a TrackedConnection.
+   */
+  class Invalidator : public oatpp::provider::Invalidator<oatpp::data::stream::IOStream> {
+  public:
+    void invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) override;
+  };
+
+private:
+  std::shared_ptr<oatpp::network::ConnectionHandler> m_handler;
+  std::shared_ptr<ConnectionMetrics> m_metrics;
+  std::shared_ptr<Invalidator> m_invalidator;
+public:
+
+  TrackedConnectionHandler(const std::shared_ptr<oatpp::network::ConnectionHandler>& handler,
+                           const std::shared_ptr<ConnectionMetrics>& metrics);
+
+  static std::shared_ptr<TrackedConnectionHandler> createShared(const std::shared_ptr<oatpp::network::ConnectionHandler>& handler,
+                                                                const std::shared_ptr<ConnectionMetrics>& metrics) {
+    return std::make_shared<TrackedConnectionHandler>(handler, metrics);
+  }
+
+  void handleConnection(const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& connection,
+                        const std::shared_ptr<const ParameterMap>& params) override;
+
+  void stop() override;
+
+};
+
+#endif /* TrackedConnectionHandler_hpp */
@@ -0,0 +1,524 @@
+#ifndef HueDeviceAsyncController_hpp
+#define HueDeviceAsyncController_hpp
+
+#include "HueDeviceController.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include OATPP_CODEGEN_BEGIN(ApiController) //< Begin codegen section
+
+/**
+ *  The Hue API of HueDeviceController as ENDPOINT_ASYNC coroutines.
+ *  Used instead of HueDeviceController when the hub runs with `--async` (AsyncHttpConnectionHandler).
+ *  Paths, responses and response bodies are identical to the synchronous controller.
+ */
+class HueDeviceAsyncController : public oatpp::web::server::api::ApiController {
+public:
+  HueDeviceAsyncController(const std::shared_ptr<ObjectMapper>& objectMapper, const std::shared_ptr<Bridge>& bridge, bool logEndpoint = false)
+    : oatpp::web::server::api::ApiController(objectMapper)
+    , m_bridge(bridge)
+    , m_database(bridge->getDatabase())
+    , m_desc(bridge->getDescriptor())
+    , m_changeStream(bridge->getChangeStream())
+    , m_logEndpoint(logEndpoint)
+  {}
+private:
+
+  /**
+   *  Database, descriptor and change stream of the bridge this controller serves
+   */
+  std::shared_ptr<Bridge> m_bridge;
+  std::shared_ptr<Database> m_database;
+  std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor> m_desc;
+  std::shared_ptr<ChangeStream> m_changeStream;
+
+  /**
+   *  Serve `PUT /log/{tag}` to loopback clients, see `--log-endpoint`
+   */
+  bool m_logEndpoint;
+
+  /**
+   *  Shared by all bridges of the process
+   */
+  OATPP_COMPONENT(std::shared_ptr<ConnectionMetrics>, m_connectionMetrics);
+  OATPP_COMPONENT(std::shared_ptr<Metrics>, m_metrics);
+public:
+
+  /**
+   *  Inject @objectMapper component here as default parameter
+   *  Do not return bare Controllable* object! use shared_ptr!
+   */
+  static std::shared_ptr<HueDeviceAsyncController> createShared(const std::shared_ptr<Bridge>& bridge = Bridge::createFromComponents(),
+                                                                bool logEndpoint = false,
+                                                                OATPP_COMPONENT(std::shared_ptr<ObjectMapper>, objectMapper)){
+    return std::make_shared<HueDeviceAsyncController>(objectMapper, bridge, logEndpoint);
+  }
+
+  std::shared_ptr<OutgoingResponse> addHueHeaders(std::shared_ptr<OutgoingResponse> rsp) {
+    // "Connection" is set by the ConnectionPolicyInterceptor
+    return rsp;
+  }
+
+  std::shared_ptr<OutgoingResponse> createJsonResponse(const Status& status, const oatpp::String& json) {
+    auto rsp = createResponse(status, json);
+    rsp->putHeader("Content-Type", "application/json");
+    return rsp;
+  }
+
+  /**
+   *  Parse a numeric path variable like `{hueId}`
+   *  @return - `false` if it is missing or not a number
+   */
+  static bool getIntPathVariable(const std::shared_ptr<IncomingRequest>& request, const char* name, v_int32& value) {
+    auto str = request->getPathVariable(name);
+    if (!str) {
+      return false;
+    }
+    bool success;
+    value = oatpp::utils::conversion::strToInt32(str, success);
+    return success;
+  }
+
+  ENDPOINT_INFO(Description) {
+    info->description = "Answers with a correct XML-Description for this hue-hub implementation";
+  }
+  ENDPOINT_ASYNC("GET", "/description.xml", Description) {
+
+    ENDPOINT_ASYNC_INIT(Description)
+
+    Action act() override {
+      HUE_LOGD("HueDeviceController", "Request for description");
+      auto rsp = controller->createResponse(Status::CODE_200, controller->m_desc->getRendered()->descriptionXml);
+      rsp->putHeader("Content-Type", "text/xml");
+      return _return(controller->addHueHeaders(rsp));
+    }
+
+  };
+
+  ENDPOINT_INFO(AppRegister) {
+    info->description = "Handles the Hue-User Registration. Creates a random username is none is provided in the UserRegisterDto.";
+    info->addConsumes<oatpp::Object<UserRegisterDto>>("application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+  }
+  ENDPOINT_ASYNC("POST", "/api", AppRegister) {
+
+    ENDPOINT_ASYNC_INIT(AppRegister)
+
+    Action act() override {
+      return request->readBodyToDtoAsync<oatpp::Object<UserRegisterDto>>(controller->getDefaultObjectMapper())
+        .callbackTo(&AppRegister::onBodyObtained);
+    }
+
+    Action onBodyObtained(const oatpp::Object<UserRegisterDto>& userRegister) {
+      auto responseDto = HueDeviceController::createRegisterResponseDto(userRegister);
+      return _return(controller->addHueHeaders(controller->createDtoResponse(Status::CODE_200, responseDto)));
+    }
+
+  };
+
+  ENDPOINT_INFO(GetLights) {
+    info->description = "Lists all available 'lights' known to this 'hub'. "
+                        "Clients other than Hue apps may page through large hubs with `offset` and `limit`";
+    info->addResponse<Fields<oatpp::Object<HueDeviceDto>>>(Status::CODE_200, "application/json");
+    info->pathParams.add<String>("username");
+    info->queryParams.add<UInt32>("offset").required = false;
+    info->queryParams.add<UInt32>("limit").required = false;
+  }
+  ENDPOINT_ASYNC("GET", "/api/{username}/lights", GetLights) {
+
+    ENDPOINT_ASYNC_INIT(GetLights)
+
+    Action act() override {
+      HUE_LOGD("HueDeviceController", "GET on /api/{username}/lights");
+      v_uint32 offset;
+      v_uint32 limit;
+      if (!HueDeviceController::parsePaging(request->getQueryParameter("offset"), request->getQueryParameter("limit"),
+                                            offset, limit)) {
+        return _return(controller->createResponse(Status::CODE_400, "Invalid offset or limit"));
+      }
+      // list all, joined from the pre-rendered per-device JSON
+      return _return(controller->addHueHeaders(
+        HueDeviceController::createLightsResponse(controller->m_database, offset, limit)
+      ));
+    }
+
+  };
+
+  ENDPOINT_INFO(GetLight) {
+    info->description = "Returns the state of 'light' no. `hueId`.";
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+    info->pathParams.add<String>("username");
+    info->pathParams.add<Int32>("hueId");
+  }
+  ENDPOINT_ASYNC("GET", "/api/{username}/lights/{hueId}", GetLight) {
+
+    ENDPOINT_ASYNC_INIT(GetLight)
+
+    Action act() override {
+      v_int32 hueId;
+      if (!getIntPathVariable(request, "hueId", hueId)) {
+        return _return(controller->createResponse(Status::CODE_400, "Invalid hueId"));
+      }
+      HUE_LOGD("HueDeviceController", "GET on /api/%s/lights/%d", request->getPathVariable("username")->c_str(), hueId);
+      // list all
+      if (hueId == 0) {
+        return _return(controller->addHueHeaders(HueDeviceController::createLightsResponse(controller->m_database)));
+      }
+      // list specific
+      auto specific = controller->m_database->getHueDeviceJsonById(hueId - 1);
+      if (specific == nullptr) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_404, HueDeviceController::createLightNotFoundJson(hueId))
+        ));
+      }
+      return _return(controller->addHueHeaders(controller->createJsonResponse(Status::CODE_200, specific)));
+    }
+
+  };
+
+  ENDPOINT_INFO(UpdateState) {
+    info->description = "Sets the state for 'light' no. `hueId`. This endpoint is called by devices (i.E. Alexa) to control a light";
+    info->addConsumes<oatpp::Object<HueDeviceStateDto>>("application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+    info->pathParams.add<String>("username");
+    info->pathParams.add<Int32>("hueId");
+  }
+  ENDPOINT_ASYNC("PUT", "/api/{username}/lights/{hueId}/state", UpdateState) {
+
+    ENDPOINT_ASYNC_INIT(UpdateState)
+
+    v_int32 m_hueId;
+    Database::PendingWrite m_pending;
+    std::shared_ptr<OutgoingResponse> m_response; ///< sent once m_pending is durable
+
+    Action act() override {
+      if (!getIntPathVariable(request, "hueId", m_hueId)) {
+        return _return(controller->createResponse(Status::CODE_400, "Invalid hueId"));
+      }
+      return request->readBodyToStringAsync().callbackTo(&UpdateState::onBodyObtained);
+    }
+
+    Action onBodyObtained(const oatpp::String& body) {
+      HUE_LOGD("HueDeviceController", "PUT on /api/%s/lights/%d/state", request->getPathVariable("username")->c_str(), m_hueId);
+      HueStateUpdate state;
+      if (!body || !HueStateParser::parse(body->data(), body->size(), controller->getDefaultObjectMapper().get(), state)) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_400, HueDeviceController::createInvalidBodyJson("/lights/state"))
+        ));
+      }
+      HueDevice updated;
+      if (!controller->m_database->updateHueDeviceState(m_hueId - 1, state, updated, &m_pending)) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_404, HueDeviceController::createLightNotFoundJson(m_hueId))
+        ));
+      }
+      m_response = controller->addHueHeaders(controller->createJsonResponse(
+        Status::CODE_200, HueDeviceController::createStateResponseJson(m_hueId, state, updated)
+      ));
+      return onWritten();
+    }
+
+    /**
+     *  Answer once the journal saved the write, without blocking the executor's worker on its sync
+     */
+    Action onWritten() {
+      bool durable;
+      if (!m_pending.poll(durable)) {
+        return waitRepeat(std::chrono::milliseconds(1));
+      }
+      if (!durable) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_500, HueDeviceController::createNotSavedJson("/lights/state"))
+        ));
+      }
+      return _return(m_response);
+    }
+
+  };
+
+  ENDPOINT_INFO(GetGroups) {
+    info->description = "Lists all groups of 'lights' known to this 'hub'. Group 0 (all lights) is not listed.";
+    info->addResponse<Fields<oatpp::Object<HueGroupDto>>>(Status::CODE_200, "application/json");
+    info->pathParams.add<String>("username");
+  }
+  ENDPOINT_ASYNC("GET", "/api/{username}/groups", GetGroups) {
+
+    ENDPOINT_ASYNC_INIT(GetGroups)
+
+    Action act() override {
+      HUE_LOGD("HueDeviceController", "GET on /api/%s/groups", request->getPathVariable("username")->c_str());
+      return _return(controller->addHueHeaders(controller->createDtoResponse(Status::CODE_200, controller->m_database->getGroups())));
+    }
+
+  };
+
+  ENDPOINT_INFO(CreateGroup) {
+    info->description = "Creates a group of 'lights'. Answers with the id of the new group.";
+    info->addConsumes<oatpp::Object<HueGroupDto>>("application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+    info->pathParams.add<String>("username");
+  }
+  ENDPOINT_ASYNC("POST", "/api/{username}/groups", CreateGroup) {
+
+    ENDPOINT_ASYNC_INIT(CreateGroup)
+
+    Database::PendingWrite m_pending;
+    std::shared_ptr<OutgoingResponse> m_response; ///< sent once m_pending is durable
+
+    Action act() override {
+      return request->readBodyToDtoAsync<oatpp::Object<HueGroupDto>>(controller->getDefaultObjectMapper())
+        .callbackTo(&CreateGroup::onBodyObtained);
+    }
+
+    Action onBodyObtained(const oatpp::Object<HueGroupDto>& group) {
+      HUE_LOGD("HueDeviceController", "POST on /api/%s/groups", request->getPathVariable("username")->c_str());
+      std::vector<v_int32> ids;
+      if (!HueDeviceController::parseLightIds(group->lights, ids)) {
+        return _return(controller->addHueHeaders(controller->createJsonResponse(
+          Status::CODE_400, HueDeviceController::createInvalidValueJson("/groups/lights", "invalid value for parameter, lights")
+        )));
+      }
+      v_int32 groupId;
+      try {
+        groupId = controller->m_database->createGroup(group->name, ids, &m_pending);
+      } catch (const std::runtime_error&) {
+        return _return(controller->addHueHeaders(controller->createJsonResponse(
+          Status::CODE_400, HueDeviceController::createInvalidValueJson("/groups/lights", "unknown light in parameter, lights")
+        )));
+      }
+      m_response = controller->addHueHeaders(controller->createJsonResponse(
+        Status::CODE_200, HueDeviceController::createGroupCreatedJson(groupId)
+      ));
+      return onWritten();
+    }
+
+    /**
+     *  Answer once the journal saved the write, without blocking the executor's worker on its sync
+     */
+    Action onWritten() {
+      bool durable;
+      if (!m_pending.poll(durable)) {
+        return waitRepeat(std::chrono::milliseconds(1));
+      }
+      if (!durable) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_500, HueDeviceController::createNotSavedJson("/groups"))
+        ));
+      }
+      return _return(m_response);
+    }
+
+  };
+
+  ENDPOINT_INFO(GetGroup) {
+    info->description = "Returns group no. `groupId`. Group 0 contains all lights.";
+    info->addResponse<oatpp::Object<HueGroupDto>>(Status::CODE_200, "application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_404, "application/json");
+    info->pathParams.add<String>("username");
+    info->pathParams.add<Int32>("groupId");
+  }
+  ENDPOINT_ASYNC("GET", "/api/{username}/groups/{groupId}", GetGroup) {
+
+    ENDPOINT_ASYNC_INIT(GetGroup)
+
+    Action act() override {
+      v_int32 groupId;
+      if (!getIntPathVariable(request, "groupId", groupId)) {
+        return _return(controller->createResponse(Status::CODE_400, "Invalid groupId"));
+      }
+      HUE_LOGD("HueDeviceController", "GET on /api/%s/groups/%d", request->getPathVariable("username")->c_str(), groupId);
+      auto group = controller->m_database->getGroupById(groupId);
+      if (group == nullptr) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_404, HueDeviceController::createGroupNotFoundJson(groupId))
+        ));
+      }
+      return _return(controller->addHueHeaders(controller->createDtoResponse(Status::CODE_200, group)));
+    }
+
+  };
+
+  ENDPOINT_INFO(DeleteGroup) {
+    info->description = "Deletes group no. `groupId`. Group 0 can't be deleted.";
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_404, "application/json");
+    info->pathParams.add<String>("username");
+    info->pathParams.add<Int32>("groupId");
+  }
+  ENDPOINT_ASYNC("DELETE", "/api/{username}/groups/{groupId}", DeleteGroup) {
+
+    ENDPOINT_ASYNC_INIT(DeleteGroup)
+
+    Database::PendingWrite m_pending;
+    std::shared_ptr<OutgoingResponse> m_response; ///< sent once m_pending is durable
+
+    Action act() override {
+      v_int32 groupId;
+      if (!getIntPathVariable(request, "groupId", groupId)) {
+        return _return(controller->createResponse(Status::CODE_400, "Invalid groupId"));
+      }
+      HUE_LOGD("HueDeviceController", "DELETE on /api/%s/groups/%d", request->getPathVariable("username")->c_str(), groupId);
+      if (!controller->m_database->deleteGroup(groupId, &m_pending)) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_404, HueDeviceController::createGroupNotFoundJson(groupId))
+        ));
+      }
+      m_response = controller->addHueHeaders(
+        controller->createJsonResponse(Status::CODE_200, HueDeviceController::createGroupDeletedJson(groupId))
+      );
+      return onWritten();
+    }
+
+    /**
+     *  Answer once the journal saved the write, without blocking the executor's worker on its sync
+     */
+    Action onWritten() {
+      bool durable;
+      if (!m_pending.poll(durable)) {
+        return waitRepeat(std::chrono::milliseconds(1));
+      }
+      if (!durable) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_500, HueDeviceController::createNotSavedJson("/groups"))
+        ));
+      }
+      return _return(m_response);
+    }
+
+  };
+
+  ENDPOINT_INFO(SetGroupAction) {
+    info->description = "Sets the state of all 'lights' in group no. `groupId` at once. Group 0 addresses all lights.";
+    info->addConsumes<oatpp::Object<HueDeviceStateDto>>("application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+    info->pathParams.add<String>("username");
+    info->pathParams.add<Int32>("groupId");
+  }
+  ENDPOINT_ASYNC("PUT", "/api/{username}/groups/{groupId}/action", SetGroupAction) {
+
+    ENDPOINT_ASYNC_INIT(SetGroupAction)
+
+    v_int32 m_groupId;
+    Database::PendingWrite m_pending;
+    std::shared_ptr<OutgoingResponse> m_response; ///< sent once m_pending is durable
+
+    Action act() override {
+      if (!getIntPathVariable(request, "groupId", m_groupId)) {
+        return _return(controller->createResponse(Status::CODE_400, "Invalid groupId"));
+      }
+      return request->readBodyToStringAsync().callbackTo(&SetGroupAction::onBodyObtained);
+    }
+
+    Action onBodyObtained(const oatpp::String& body) {
+      HUE_LOGD("HueDeviceController", "PUT on /api/%s/groups/%d/action", request->getPathVariable("username")->c_str(), m_groupId);
+      HueStateUpdate state;
+      if (!body || !HueStateParser::parse(body->data(), body->size(), controller->getDefaultObjectMapper().get(), state)) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_400, HueDeviceController::createInvalidBodyJson("/groups/action"))
+        ));
+      }
+      HueDevice action;
+      if (!controller->m_database->updateGroupState(m_groupId, state, action, &m_pending)) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_404, HueDeviceController::createGroupNotFoundJson(m_groupId))
+        ));
+      }
+      m_response = controller->addHueHeaders(controller->createJsonResponse(
+        Status::CODE_200, HueDeviceController::createGroupActionResponseJson(m_groupId, state, action)
+      ));
+      return onWritten();
+    }
+
+    /**
+     *  Answer once the journal saved the write, without blocking the executor's worker on its sync
+     */
+    Action onWritten() {
+      bool durable;
+      if (!m_pending.poll(durable)) {
+        return waitRepeat(std::chrono::milliseconds(1));
+      }
+      if (!durable) {
+        return _return(controller->addHueHeaders(
+          controller->createJsonResponse(Status::CODE_500, HueDeviceController::createNotSavedJson("/groups/action"))
+        ));
+      }
+      return _return(m_response);
+    }
+
+  };
+
+  ENDPOINT_INFO(Events) {
+    info->description = "Server-sent events of light changes. Starts with a 'resync' event holding all lights, "
+                        "followed by 'lights' events with the lights changed since, keyed by light number (`null` if deleted).";
+    info->addResponse<String>(Status::CODE_200, "text/event-stream");
+    info->pathParams.add<String>("username");
+  }
+  ENDPOINT_ASYNC("GET", "/api/{username}/events", Events) {
+
+    ENDPOINT_ASYNC_INIT(Events)
+
+    Action act() override {
+      HUE_LOGD("HueDeviceController", "GET on /api/%s/events", request->getPathVariable("username")->c_str());
+      return _return(controller->addHueHeaders(
+        HueDeviceController::createEventStreamResponse(controller->m_changeStream, controller->m_database, false)
+      ));
+    }
+
+  };
+
+  ENDPOINT_INFO(GetConnectionMetrics) {
+    info->description = "Connections opened versus requests served by the HTTP server";
+    info->addResponse<oatpp::Object<ConnectionMetricsDto>>(Status::CODE_200, "application/json");
+  }
+  ENDPOINT_ASYNC("GET", "/metrics/connections", GetConnectionMetrics) {
+
+    ENDPOINT_ASYNC_INIT(GetConnectionMetrics)
+
+    Action act() override {
+      return _return(controller->createDtoResponse(Status::CODE_200, controller->m_connectionMetrics->toDto()));
+    }
+
+  };
+
+  ENDPOINT_INFO(GetMetrics) {
+    info->description = "Latency histograms of all endpoints, the Database write lock and SSDP searches, "
+                        "and the open connections in the Prometheus text format";
+    info->addResponse<String>(Status::CODE_200, "text/plain");
+  }
+  ENDPOINT_ASYNC("GET", "/metrics", GetMetrics) {
+
+    ENDPOINT_ASYNC_INIT(GetMetrics)
+
+    Action act() override {
+      return _return(HueDeviceController::createMetricsResponse(controller->m_metrics));
+    }
+
+  };
+
+  ENDPOINT_INFO(LogLevel) {
+    info->description = "Set the log level of a tag at runtime, '*' for all tags without a level of their own. "
+                        "Levels are V, D, I, W and E, 'default' returns the tag to the default level. "
+                        "Only served to loopback clients of a hub started with --log-endpoint";
+    info->addResponse<String>(Status::CODE_200, "text/plain");
+    info->addResponse<String>(Status::CODE_400, "text/plain");
+    info->addResponse<String>(Status::CODE_403, "text/plain");
+    info->addResponse<String>(Status::CODE_404, "text/plain");
+  }
+  ENDPOINT_ASYNC("PUT", "/log/{tag}", LogLevel) {
+
+    ENDPOINT_ASYNC_INIT(LogLevel)
+
+    Action act() override {
+      Status status = Status::CODE_403;
+      if (controller->m_logEndpoint && HueDeviceController::isLoopback(request)) {
+        status = HueDeviceController::setLogLevel(request->getPathVariable("tag"), request->getQueryParameter("level"));
+      }
+      return _return(controller->createResponse(status, HueDeviceController::getLogLevelMessage(status)));
+    }
+
+  };
+
+};
+
+#include OATPP_CODEGEN_END(ApiController) //< End of codegen section
+
+#endif /* HueDeviceAsyncController_hpp */
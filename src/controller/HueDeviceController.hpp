@@ -4,16 +4,30 @@
 
 #include "DeviceDescriptorComponent.hpp"
 
+#include "bridge/Bridge.hpp"
+#include "connection/ConnectionMetrics.hpp"
+#include "connection/TrackedConnectionHandler.hpp"
 #include "db/Database.hpp"
-
+#include "events/EventStreamReader.hpp"
+#include "logging/AsyncLogger.hpp"
+#include "metrics/Metrics.hpp"
+#include "parser/HueStateParser.hpp"
+#include "response/HueResponseWriter.hpp"
+#include "response/LightsJsonReader.hpp"
+
+#include "dto/HueGroupDto.hpp"
 #include "dto/UserRegisterDto.hpp"
 #include "dto/GenericResponseDto.hpp"
 
 #include "oatpp/web/server/api/ApiController.hpp"
+#include "oatpp/web/protocol/http/outgoing/BufferBody.hpp"
+#include "oatpp/web/protocol/http/outgoing/StreamingBody.hpp"
 #include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
 #include "oatpp/core/macro/codegen.hpp"
 #include "oatpp/core/macro/component.hpp"
 
+#include <limits>
 
 #include OATPP_CODEGEN_BEGIN(ApiController) //< Begin codegen section
 
@@ -24,28 +38,47 @@
  */
 class HueDeviceController : public oatpp::web::server::api::ApiController {
 public:
-  HueDeviceController(const std::shared_ptr<ObjectMapper>& objectMapper)
+  HueDeviceController(const std::shared_ptr<ObjectMapper>& objectMapper, const std::shared_ptr<Bridge>& bridge, bool logEndpoint = false)
     : oatpp::web::server::api::ApiController(objectMapper)
+    , m_bridge(bridge)
+    , m_database(bridge->getDatabase())
+    , m_desc(bridge->getDescriptor())
+    , m_changeStream(bridge->getChangeStream())
+    , m_logEndpoint(logEndpoint)
   {}
 private:
 
   /**
-   *  Inject Database component
+   *  Database, descriptor and change stream of the bridge this controller serves
+   */
+  std::shared_ptr<Bridge> m_bridge;
+  std::shared_ptr<Database> m_database;
+  std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor> m_desc;
+  std::shared_ptr<ChangeStream> m_changeStream;
+
+  /**
+   *  Serve `PUT /log/{tag}` to loopback clients, see `--log-endpoint`
    */
-  OATPP_COMPONENT(std::shared_ptr<Database>, m_database);
-  OATPP_COMPONENT(std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>, m_desc);
+  bool m_logEndpoint;
+
+  /**
+   *  Shared by all bridges of the process
+   */
+  OATPP_COMPONENT(std::shared_ptr<ConnectionMetrics>, m_connectionMetrics);
+  OATPP_COMPONENT(std::shared_ptr<Metrics>, m_metrics);
 public:
 
   /**
    *  Inject @objectMapper component here as default parameter
    *  Do not return bare Controllable* object! use shared_ptr!
    */
-  static std::shared_ptr<HueDeviceController> createShared(OATPP_COMPONENT(std::shared_ptr<ObjectMapper>,
-                                                                           objectMapper)){
-    return std::make_shared<HueDeviceController>(objectMapper);
+  static std::shared_ptr<HueDeviceController> createShared(const std::shared_ptr<Bridge>& bridge = Bridge::createFromComponents(),
+                                                           bool logEndpoint = false,
+                                                           OATPP_COMPONENT(std::shared_ptr<ObjectMapper>, objectMapper)){
+    return std::make_shared<HueDeviceController>(objectMapper, bridge, logEndpoint);
   }
 
-  void gen_random(char *s, const int len) {
+  static void gen_random(char *s, const int len) {
     static const char alphanum[] =
       "0123456789"
       "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -58,53 +91,261 @@ public:
     s[len] = 0;
   }
 
+  /*
+   *  Response bodies shared with HueDeviceAsyncController
+   */
+
+  static GenericResponseDto createRegisterResponseDto(const oatpp::Object<UserRegisterDto>& userRegister) {
+    if (userRegister->username == nullptr) {
+      userRegister->username = "OatppSsdpHueDefaultUser_________________";
+      gen_random((char*)userRegister->username->data() + 23, 17);
+      HUE_LOGD("HueDeviceController", "POST on /api with empty user, generated '%s'", userRegister->username->c_str());
+    } else {
+      HUE_LOGD("HueDeviceController", "POST on /api for user '%s'", userRegister->username->c_str());
+    }
+    HUE_LOGD("HueDeviceController", "Devicetype: %s", userRegister->devicetype->c_str());
+    auto responseDto = GenericResponseDto::createShared();
+    responseDto->push_back(oatpp::Object<ResponseTypeDto>::createShared());
+    responseDto->front()->success = {{"username", userRegister->username}};
+    return responseDto;
+  }
+
+  /*
+   *  "success"/"error" arrays, written by HueResponseWriter
+   */
+
+  static oatpp::String createNotAvailableJson(const char* resource, v_int32 number) {
+    char address[32];
+    char description[64];
+    snprintf(address, 32, "%s%d", resource, number);
+    snprintf(description, 64, "resource, %s, not available", address);
+    HueResponseWriter writer;
+    writer.addError(HueResponseWriter::ERROR_RESOURCE_NOT_AVAILABLE, address, description);
+    return writer.toString();
+  }
+
+  static oatpp::String createLightNotFoundJson(v_int32 hueId) {
+    return createNotAvailableJson("/lights/", hueId);
+  }
+
+  static oatpp::String createGroupNotFoundJson(v_int32 groupId) {
+    return createNotAvailableJson("/groups/", groupId);
+  }
+
+  static oatpp::String createStateResponseJson(v_int32 hueId, const HueStateUpdate& state, const HueDevice& updated) {
+    /*
+     * The state is committed to the Database at this point. Lights are switched by the LightDriver
+     * the DriverPipeline feeds from the Database - implement your "light turning on/off" there (see FileLightDriver).
+     */
+    HUE_LOGI("HueDeviceController", "updateState: Setting light %d %s", hueId, updated.isOn() ? "on" : "off");
+    HueResponseWriter writer;
+    writer.addStateSuccess("/lights/", hueId, "/state/", state, updated);
+    return writer.toString();
+  }
+
+  static oatpp::String createGroupActionResponseJson(v_int32 groupId, const HueStateUpdate& state, const HueDevice& action) {
+    HUE_LOGI("HueDeviceController", "setGroupAction: Setting group %d %s", groupId, action.isOn() ? "on" : "off");
+    HueResponseWriter writer;
+    writer.addStateSuccess("/groups/", groupId, "/action/", state, action);
+    return writer.toString();
+  }
+
+  static oatpp::String createGroupCreatedJson(v_int32 groupId) {
+    char id[16];
+    snprintf(id, 16, "%d", groupId);
+    HueResponseWriter writer;
+    writer.addSuccess("id", id);
+    return writer.toString();
+  }
+
+  static oatpp::String createGroupDeletedJson(v_int32 groupId) {
+    char message[48];
+    snprintf(message, 48, "/groups/%d deleted", groupId);
+    HueResponseWriter writer;
+    writer.addSuccess(message);
+    return writer.toString();
+  }
+
+  static oatpp::String createInvalidBodyJson(const char* address) {
+    HueResponseWriter writer;
+    writer.addError(HueResponseWriter::ERROR_INVALID_JSON, address, "body contains invalid json");
+    return writer.toString();
+  }
+
+  static oatpp::String createInvalidValueJson(const char* address, const char* description) {
+    HueResponseWriter writer;
+    writer.addError(HueResponseWriter::ERROR_INVALID_VALUE, address, description);
+    return writer.toString();
+  }
+
+  static oatpp::String createNotSavedJson(const char* address) {
+    HueResponseWriter writer;
+    writer.addError(HueResponseWriter::ERROR_INTERNAL, address, "Internal error, the change was applied but could not be saved");
+    return writer.toString();
+  }
+
+  /**
+   *  Convert the Hue light numbers of a group to HueDeviceIds
+   *  @return - `false` if one of them is not a number
+   */
+  static bool parseLightIds(const oatpp::List<oatpp::String>& lights, std::vector<v_int32>& ids) {
+    if (lights == nullptr) {
+      return true;
+    }
+    for (const auto& light : *lights) {
+      bool success;
+      v_int32 hueId = oatpp::utils::conversion::strToInt32(light, success);
+      if (!success || hueId < 1) {
+        return false;
+      }
+      ids.push_back(hueId - 1);
+    }
+    return true;
+  }
+
   std::shared_ptr<OutgoingResponse> addHueHeaders(std::shared_ptr<OutgoingResponse> rsp) {
     //rsp->putHeader("Server", "FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0");
-    rsp->putHeader("Connection", "close");
+    // "Connection" is set by the ConnectionPolicyInterceptor
+    return rsp;
+  }
+
+  /**
+   *  Respond with an already serialized JSON body (i.E. from the Database's JSON cache)
+   */
+  std::shared_ptr<OutgoingResponse> createJsonResponse(const Status& status, const oatpp::String& json) {
+    auto rsp = createResponse(status, json);
+    rsp->putHeader("Content-Type", "application/json");
+    return rsp;
+  }
+
+  /**
+   *  Parse `?offset=&limit=` of `GET /api/{username}/lights`, both are optional
+   *  @return - `false` if one of them is not a number or negative
+   */
+  static bool parsePaging(const oatpp::String& offsetStr, const oatpp::String& limitStr, v_uint32& offset, v_uint32& limit) {
+    offset = 0;
+    limit = std::numeric_limits<v_uint32>::max();
+    bool success = true;
+    if (offsetStr) {
+      v_int32 value = oatpp::utils::conversion::strToInt32(offsetStr, success);
+      if (!success || value < 0) {
+        return false;
+      }
+      offset = (v_uint32) value;
+    }
+    if (limitStr) {
+      v_int32 value = oatpp::utils::conversion::strToInt32(limitStr, success);
+      if (!success || value < 0) {
+        return false;
+      }
+      limit = (v_uint32) value;
+    }
+    return true;
+  }
+
+  /**
+   *  Lights object of `GET /api/{username}/lights`, rendered from the Database's JSON cache.
+   *  Up to LightsJsonReader::STREAM_THRESHOLD lights are sent at once, more are streamed chunk by chunk.
+   *  @param offset - lights to skip
+   *  @param limit - lights to list at most
+   */
+  static std::shared_ptr<OutgoingResponse> createLightsResponse(const std::shared_ptr<Database>& database,
+                                                               v_uint32 offset = 0,
+                                                               v_uint32 limit = std::numeric_limits<v_uint32>::max())
+  {
+    auto cursor = database->getHueDevicesJsonCursor(offset, limit);
+    if (cursor.getMaxCount() <= LightsJsonReader::STREAM_THRESHOLD) {
+      std::string json;
+      cursor.next(json, std::numeric_limits<v_buff_size>::max() / 2);
+      auto body = oatpp::web::protocol::http::outgoing::BufferBody::createShared(oatpp::String(std::move(json)), "application/json");
+      return OutgoingResponse::createShared(Status::CODE_200, body);
+    }
+    auto reader = std::make_shared<LightsJsonReader>(cursor);
+    auto body = std::make_shared<oatpp::web::protocol::http::outgoing::StreamingBody>(reader);
+    auto rsp = OutgoingResponse::createShared(Status::CODE_200, body);
+    rsp->putHeader("Content-Type", "application/json");
+    return rsp;
+  }
+
+  /**
+   *  Server-sent events of one ChangeStream subscription, see EventStreamReader
+   *  @param blocking - wait for changes on the connection's thread, `false` for the AsyncHttpConnectionHandler
+   */
+  static std::shared_ptr<OutgoingResponse> createEventStreamResponse(const std::shared_ptr<ChangeStream>& changeStream,
+                                                                    const std::shared_ptr<Database>& database,
+                                                                    bool blocking)
+  {
+    auto reader = std::make_shared<EventStreamReader>(changeStream, database, blocking);
+    auto body = std::make_shared<oatpp::web::protocol::http::outgoing::StreamingBody>(reader);
+    auto rsp = OutgoingResponse::createShared(Status::CODE_200, body);
+    rsp->putHeader("Content-Type", "text/event-stream");
+    rsp->putHeader("Cache-Control", "no-cache");
     return rsp;
   }
 
+  /**
+   *  All Metrics in the Prometheus text format
+   */
+  static std::shared_ptr<OutgoingResponse> createMetricsResponse(const std::shared_ptr<Metrics>& metrics) {
+    auto body = oatpp::web::protocol::http::outgoing::BufferBody::createShared(metrics->render(), "text/plain; version=0.0.4");
+    return OutgoingResponse::createShared(Status::CODE_200, body);
+  }
+
+  /**
+   *  Set the level of a log tag for `PUT /log/{tag}?level=`
+   *  @param tag - `*` for the default level, otherwise a tag that logged already
+   *  @param level - `V`, `D`, `I`, `W`, `E`, or `default` to return the tag to the default level
+   *  @return - CODE_400 if the level is none of them, CODE_404 if there is no such tag, CODE_200 otherwise
+   */
+  static Status setLogLevel(const oatpp::String& tag, const oatpp::String& level) {
+    v_int32 priority = -1;
+    if (!tag || !level) {
+      return Status::CODE_400;
+    }
+    if (level != "default") {
+      v_uint32 parsed;
+      if (!AsyncLogger::parseLevel(level->c_str(), parsed)) {
+        return Status::CODE_400;
+      }
+      priority = (v_int32) parsed;
+    }
+    if (!AsyncLogger::setLevel(*tag, priority)) {
+      return Status::CODE_404;
+    }
+    return Status::CODE_200;
+  }
+
+  /**
+   *  @return - `true` if the client of `request` is on this host
+   */
+  static bool isLoopback(const std::shared_ptr<IncomingRequest>& request) {
+    auto connection = std::dynamic_pointer_cast<TrackedConnection>(request->getConnection());
+    return connection && connection->isLoopback();
+  }
+
+  /**
+   *  Response to `PUT /log/{tag}?level=`, see setLogLevel()
+   */
+  static const char* getLogLevelMessage(const Status& status) {
+    if (status == Status::CODE_400) {
+      return "Invalid level";
+    } else if (status == Status::CODE_404) {
+      return "Unknown tag";
+    } else if (status == Status::CODE_403) {
+      return "Log levels can only be changed on the hub's own host, with --log-endpoint";
+    }
+    return "OK";
+  }
+
   ENDPOINT_INFO(description) {
     info->description = "Answers with a correct XML-Description for this hue-hub implementation";
   }
   ENDPOINT("GET", "/description.xml", description) {
 
-    OATPP_LOGD("HueDeviceController", "Request for description");
-
-    oatpp::data::stream::BufferOutputStream ss;
-    ss <<
-      "<?xml version=\"1.0\"?>\n"
-      "<root xmlns=\"urn:schemas-upnp-org:device-1-0\">\n"
-      "  <specVersion>\n"
-      "    <major>1</major>\n"
-      "    <minor>0</minor>\n"
-      "  </specVersion>\n"
-      "  <URLBase>http://" << m_desc->ipPort << "/</URLBase>\n"
-      "  <device>\n"
-      "    <deviceType>urn:schemas-upnp-org:device:Basic:1</deviceType>\n"
-      "    <friendlyName>Philips hue (" << m_desc->ipPort << ")</friendlyName>\n"
-      "    <manufacturer>Royal Philips Electronics</manufacturer>\n"
-      "    <manufacturerURL>http://www.philips.com</manufacturerURL>\n"
-      "    <modelDescription>Philips hue Personal Wireless Lighting</modelDescription>\n"
-      "    <modelName>Philips hue bridge 2012</modelName>\n"
-      "    <modelNumber>" << m_desc->sn << "</modelNumber>\n"
-      "    <modelURL>http://www.meethue.com</modelURL>\n"
-      "    <serialNumber>" << m_desc->mac << "</serialNumber>\n"
-      "    <UDN>uuid:" + m_desc->uuid + "</UDN>\n"
-      "    <presentationURL>index.html</presentationURL>\n"
-      "    <serviceList>\n"
-      "      <service>\n"
-      "        <serviceType>(null)</serviceType>\n"
-      "        <serviceId>(null)</serviceId>\n"
-      "        <controlURL>(null)</controlURL>\n"
-      "        <eventSubURL>(null)</eventSubURL>\n"
-      "        <SCPDURL>(null)</SCPDURL>\n"
-      "      </service>\n"
-      "    </serviceList>\n"
-      "  </device>\n"
-      "</root>";
-
-    return addHueHeaders(createResponse(Status::CODE_200, ss.toString()));
+    HUE_LOGD("HueDeviceController", "Request for description");
+    auto rsp = createResponse(Status::CODE_200, m_desc->getRendered()->descriptionXml);
+    rsp->putHeader("Content-Type", "text/xml");
+    return addHueHeaders(rsp);
   }
 
   ENDPOINT_INFO(appRegister) {
@@ -115,46 +356,30 @@ public:
   ENDPOINT("POST", "/api", appRegister,
            BODY_DTO(oatpp::Object<UserRegisterDto>, userRegister))
   {
-    if (userRegister->username == nullptr) {
-      userRegister->username = "OatppSsdpHueDefaultUser_________________";
-      gen_random((char*)userRegister->username->data() + 23, 17);
-      OATPP_LOGD("HueDeviceController", "POST on /api with empty user, generated '%s'", userRegister->username->c_str());
-    } else {
-      OATPP_LOGD("HueDeviceController", "POST on /api for user '%s'", userRegister->username->c_str());
-    }
-    OATPP_LOGD("HueDeviceController", "Devicetype: %s", userRegister->devicetype->c_str());
-    auto responseDto = GenericResponseDto::createShared();
-    responseDto->push_back(oatpp::Object<ResponseTypeDto>::createShared());
-    responseDto->front()->success = {{"username", userRegister->username}};
-
+    auto responseDto = createRegisterResponseDto(userRegister);
     auto response = createDtoResponse(Status::CODE_200, responseDto);
     return addHueHeaders(response);
   }
 
   ENDPOINT_INFO(getLights) {
-    info->description = "Lists all available 'lights' known to this 'hub'";
+    info->description = "Lists all available 'lights' known to this 'hub'. "
+                        "Clients other than Hue apps may page through large hubs with `offset` and `limit`";
     info->addResponse<Fields<oatpp::Object<HueDeviceDto>>>(Status::CODE_200, "application/json");
+    info->queryParams.add<UInt32>("offset").required = false;
+    info->queryParams.add<UInt32>("limit").required = false;
   }
   ENDPOINT("GET", "/api/{username}/lights", getLights,
-           PATH(String, username))
+           PATH(String, username),
+           QUERIES(QueryParams, queryParams))
   {
-    OATPP_LOGD("HueDeviceController", "GET on /api/{username}/lights");
-    // list all
-    auto devices = m_database->getHueDevices();
-    auto response = Fields<oatpp::Object<HueDeviceDto>>::createShared();
-    for (auto device = devices->begin(); device != devices->end(); device++) {
-      char num[32];
-      memset(num, 0, 18);
-      snprintf(num, 18, "%u", *(device->first.get()) + 1);
-      if (device->second->state->colormode == nullptr) {
-        device->second->state->colormode = "ct";
-        if (device->second->state->ct == nullptr) {
-          device->second->state->ct = 500;
-        }
-      }
-      response[num] = device->second;
+    HUE_LOGD("HueDeviceController", "GET on /api/{username}/lights");
+    v_uint32 offset;
+    v_uint32 limit;
+    if (!parsePaging(queryParams.get("offset"), queryParams.get("limit"), offset, limit)) {
+      return createResponse(Status::CODE_400, "Invalid offset or limit");
     }
-    return addHueHeaders(createDtoResponse(Status::CODE_200, response));
+    // list all, joined from the pre-rendered per-device JSON
+    return addHueHeaders(createLightsResponse(m_database, offset, limit));
   }
 
   ENDPOINT_INFO(getLight) {
@@ -165,29 +390,17 @@ public:
            PATH(String, username),
            PATH(Int32, hueId))
   {
-    OATPP_LOGD("HueDeviceController", "GET on /api/%s/lights/%d", username->c_str(), *hueId.get());
+    HUE_LOGD("HueDeviceController", "GET on /api/%s/lights/%d", username->c_str(), *hueId.get());
     // list all
     if (hueId == 0) {
-      return getLights(username);
+      return addHueHeaders(createLightsResponse(m_database));
     }
     // list specific
-    auto specific = m_database->getHueDeviceById(hueId - 1);
+    auto specific = m_database->getHueDeviceJsonById(hueId - 1);
     if (specific == nullptr) {
-      char num[32];
-      auto responseDto = GenericResponseDto::createShared();
-      responseDto->push_back(oatpp::Object<ResponseTypeDto>::createShared());
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d", *hueId.get());
-      responseDto->back()->error = {{oatpp::String(num), oatpp::String("Not Found")}};
-      auto response = createDtoResponse(Status::CODE_404, responseDto);
-    }
-    if (specific->state->colormode == nullptr) {
-      specific->state->colormode = "ct";
-      if (specific->state->ct == nullptr) {
-        specific->state->ct = 500;
-      }
+      return addHueHeaders(createJsonResponse(Status::CODE_404, createLightNotFoundJson(hueId)));
     }
-    return addHueHeaders(createDtoResponse(Status::CODE_200, specific));
+    return addHueHeaders(createJsonResponse(Status::CODE_200, specific));
   }
 
   ENDPOINT_INFO(updateState) {
@@ -198,82 +411,167 @@ public:
   ENDPOINT("PUT", "/api/{username}/lights/{hueId}/state", updateState,
            PATH(String, username),
            PATH(Int32, hueId),
-           BODY_DTO(Object<HueDeviceStateDto>, state))
+           REQUEST(std::shared_ptr<IncomingRequest>, request))
   {
-    OATPP_LOGD("HueDeviceController", "PUT on /api/%s/lights/%d/state", username->c_str(), *hueId.get());
-    v_int32 id = hueId;
-    id--;
-    char num[32];
-    auto responseDto = GenericResponseDto::createShared();
-    auto updated = m_database->updateHueDeviceState(id, state);
-
-    if (updated == nullptr) {
-      responseDto->push_back(oatpp::Object<ResponseTypeDto>::createShared());
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d/state/on", *hueId.get());
-      responseDto->back()->error = {{oatpp::String(num), state->on}};
-      auto response = createDtoResponse(Status::CODE_200, responseDto);
+    HUE_LOGD("HueDeviceController", "PUT on /api/%s/lights/%d/state", username->c_str(), *hueId.get());
+    HueStateUpdate state; // read in place, see HueStateParser
+    if (!HueStateParser::read(request, getDefaultObjectMapper().get(), state)) {
+      return addHueHeaders(createJsonResponse(Status::CODE_400, createInvalidBodyJson("/lights/state")));
     }
-
-    /*
-     * ToDo: Implement your "light turning on/off" here!
-     * Better: Replace the Database with your state and control logic so the "database" is in sync to your logic.
-     */
-    OATPP_LOGI("HueDeviceController", "updateState: Setting light %d %s", *hueId.get(), updated->state->on ? "on" : "off");
-
-    responseDto->push_back(oatpp::Object<ResponseTypeDto>::createShared());
-    if (state->on != nullptr) {
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d/state/on", *hueId.get());
-      if (responseDto->back()->success.get() == nullptr) {
-        responseDto->back()->success = {{oatpp::String(num), updated->state->on}};
-      } else {
-        responseDto->back()->success->push_back({oatpp::String(num), updated->state->on});
+    HueDevice updated;
+    try {
+      if (!m_database->updateHueDeviceState(hueId - 1, state, updated)) {
+        return addHueHeaders(createJsonResponse(Status::CODE_404, createLightNotFoundJson(hueId)));
       }
+    } catch (const Database::NotDurableError&) {
+      return addHueHeaders(createJsonResponse(Status::CODE_500, createNotSavedJson("/lights/state")));
     }
+    return addHueHeaders(createJsonResponse(Status::CODE_200, createStateResponseJson(hueId, state, updated)));
+  }
 
-    if (state->bri != nullptr) {
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d/state/bri", *hueId.get());
-      if (responseDto->back()->success.get() == nullptr) {
-        responseDto->back()->success = {{oatpp::String(num), updated->state->bri}};
-      } else {
-        responseDto->back()->success->push_back({oatpp::String(num), updated->state->bri});
-      }
+  ENDPOINT_INFO(getGroups) {
+    info->description = "Lists all groups of 'lights' known to this 'hub'. Group 0 (all lights) is not listed.";
+    info->addResponse<Fields<oatpp::Object<HueGroupDto>>>(Status::CODE_200, "application/json");
+  }
+  ENDPOINT("GET", "/api/{username}/groups", getGroups,
+           PATH(String, username))
+  {
+    HUE_LOGD("HueDeviceController", "GET on /api/%s/groups", username->c_str());
+    return addHueHeaders(createDtoResponse(Status::CODE_200, m_database->getGroups()));
+  }
+
+  ENDPOINT_INFO(createGroup) {
+    info->description = "Creates a group of 'lights'. Answers with the id of the new group.";
+    info->addConsumes<oatpp::Object<HueGroupDto>>("application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+  }
+  ENDPOINT("POST", "/api/{username}/groups", createGroup,
+           PATH(String, username),
+           BODY_DTO(Object<HueGroupDto>, group))
+  {
+    HUE_LOGD("HueDeviceController", "POST on /api/%s/groups", username->c_str());
+    std::vector<v_int32> ids;
+    if (!parseLightIds(group->lights, ids)) {
+      return addHueHeaders(createJsonResponse(Status::CODE_400, createInvalidValueJson("/groups/lights", "invalid value for parameter, lights")));
+    }
+    try {
+      return addHueHeaders(createJsonResponse(Status::CODE_200, createGroupCreatedJson(m_database->createGroup(group->name, ids))));
+    } catch (const Database::NotDurableError&) {
+      return addHueHeaders(createJsonResponse(Status::CODE_500, createNotSavedJson("/groups")));
+    } catch (const std::runtime_error&) {
+      return addHueHeaders(createJsonResponse(Status::CODE_400, createInvalidValueJson("/groups/lights", "unknown light in parameter, lights")));
     }
+  }
 
-    if (state->hue != nullptr) {
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d/state/hue", *hueId.get());
-      if (responseDto->back()->success.get() == nullptr) {
-        responseDto->back()->success = {{oatpp::String(num), updated->state->hue}};
-      } else {
-        responseDto->back()->success->push_back({oatpp::String(num), updated->state->hue});
-      }
+  ENDPOINT_INFO(getGroup) {
+    info->description = "Returns group no. `groupId`. Group 0 contains all lights.";
+    info->addResponse<oatpp::Object<HueGroupDto>>(Status::CODE_200, "application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_404, "application/json");
+  }
+  ENDPOINT("GET", "/api/{username}/groups/{groupId}", getGroup,
+           PATH(String, username),
+           PATH(Int32, groupId))
+  {
+    HUE_LOGD("HueDeviceController", "GET on /api/%s/groups/%d", username->c_str(), *groupId.get());
+    auto group = m_database->getGroupById(groupId);
+    if (group == nullptr) {
+      return addHueHeaders(createJsonResponse(Status::CODE_404, createGroupNotFoundJson(groupId)));
     }
+    return addHueHeaders(createDtoResponse(Status::CODE_200, group));
+  }
 
-    if (state->sat != nullptr) {
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d/state/sat", *hueId.get());
-      if (responseDto->back()->success.get() == nullptr) {
-        responseDto->back()->success = {{oatpp::String(num), updated->state->sat}};
-      } else {
-        responseDto->back()->success->push_back({oatpp::String(num), updated->state->sat});
+  ENDPOINT_INFO(deleteGroup) {
+    info->description = "Deletes group no. `groupId`. Group 0 can't be deleted.";
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_404, "application/json");
+  }
+  ENDPOINT("DELETE", "/api/{username}/groups/{groupId}", deleteGroup,
+           PATH(String, username),
+           PATH(Int32, groupId))
+  {
+    HUE_LOGD("HueDeviceController", "DELETE on /api/%s/groups/%d", username->c_str(), *groupId.get());
+    try {
+      if (!m_database->deleteGroup(groupId)) {
+        return addHueHeaders(createJsonResponse(Status::CODE_404, createGroupNotFoundJson(groupId)));
       }
+    } catch (const Database::NotDurableError&) {
+      return addHueHeaders(createJsonResponse(Status::CODE_500, createNotSavedJson("/groups")));
     }
+    return addHueHeaders(createJsonResponse(Status::CODE_200, createGroupDeletedJson(groupId)));
+  }
 
-    if (state->ct != nullptr) {
-      memset(num, 0, 32);
-      snprintf(num, 32, "/lights/%d/state/ct", *hueId.get());
-      if (responseDto->back()->success.get() == nullptr) {
-        responseDto->back()->success = {{oatpp::String(num), updated->state->ct}};
-      } else {
-        responseDto->back()->success->push_back({oatpp::String(num), updated->state->ct});
+  ENDPOINT_INFO(setGroupAction) {
+    info->description = "Sets the state of all 'lights' in group no. `groupId` at once. Group 0 addresses all lights.";
+    info->addConsumes<oatpp::Object<HueDeviceStateDto>>("application/json");
+    info->addResponse<oatpp::Object<ResponseTypeDto>>(Status::CODE_200, "application/json");
+  }
+  ENDPOINT("PUT", "/api/{username}/groups/{groupId}/action", setGroupAction,
+           PATH(String, username),
+           PATH(Int32, groupId),
+           REQUEST(std::shared_ptr<IncomingRequest>, request))
+  {
+    HUE_LOGD("HueDeviceController", "PUT on /api/%s/groups/%d/action", username->c_str(), *groupId.get());
+    HueStateUpdate state; // read in place, see HueStateParser
+    if (!HueStateParser::read(request, getDefaultObjectMapper().get(), state)) {
+      return addHueHeaders(createJsonResponse(Status::CODE_400, createInvalidBodyJson("/groups/action")));
+    }
+    HueDevice action;
+    try {
+      if (!m_database->updateGroupState(groupId, state, action)) {
+        return addHueHeaders(createJsonResponse(Status::CODE_404, createGroupNotFoundJson(groupId)));
       }
+    } catch (const Database::NotDurableError&) {
+      return addHueHeaders(createJsonResponse(Status::CODE_500, createNotSavedJson("/groups/action")));
     }
+    return addHueHeaders(createJsonResponse(Status::CODE_200, createGroupActionResponseJson(groupId, state, action)));
+  }
 
-    auto response = createDtoResponse(Status::CODE_200, responseDto);
-    return addHueHeaders(response);
+  ENDPOINT_INFO(events) {
+    info->description = "Server-sent events of light changes. Starts with a 'resync' event holding all lights, "
+                        "followed by 'lights' events with the lights changed since, keyed by light number (`null` if deleted).";
+    info->addResponse<String>(Status::CODE_200, "text/event-stream");
+  }
+  ENDPOINT("GET", "/api/{username}/events", events,
+           PATH(String, username))
+  {
+    HUE_LOGD("HueDeviceController", "GET on /api/%s/events", username->c_str());
+    return addHueHeaders(createEventStreamResponse(m_changeStream, m_database, true));
+  }
+
+  ENDPOINT_INFO(connectionMetrics) {
+    info->description = "Connections opened versus requests served by the HTTP server";
+    info->addResponse<oatpp::Object<ConnectionMetricsDto>>(Status::CODE_200, "application/json");
+  }
+  ENDPOINT("GET", "/metrics/connections", connectionMetrics) {
+    return createDtoResponse(Status::CODE_200, m_connectionMetrics->toDto());
+  }
+
+  ENDPOINT_INFO(prometheusMetrics) {
+    info->description = "Latency histograms of all endpoints, the Database write lock and SSDP searches, "
+                        "and the open connections in the Prometheus text format";
+    info->addResponse<String>(Status::CODE_200, "text/plain");
+  }
+  ENDPOINT("GET", "/metrics", prometheusMetrics) {
+    return createMetricsResponse(m_metrics);
+  }
+
+  ENDPOINT_INFO(logLevel) {
+    info->description = "Set the log level of a tag at runtime, '*' for all tags without a level of their own. "
+                        "Levels are V, D, I, W and E, 'default' returns the tag to the default level. "
+                        "Only served to loopback clients of a hub started with --log-endpoint";
+    info->addResponse<String>(Status::CODE_200, "text/plain");
+    info->addResponse<String>(Status::CODE_400, "text/plain");
+    info->addResponse<String>(Status::CODE_403, "text/plain");
+    info->addResponse<String>(Status::CODE_404, "text/plain");
+  }
+  ENDPOINT("PUT", "/log/{tag}", logLevel,
+           REQUEST(std::shared_ptr<IncomingRequest>, request),
+           PATH(String, tag),
+           QUERY(String, level)) {
+    Status status = Status::CODE_403;
+    if (m_logEndpoint && isLoopback(request)) {
+      status = setLogLevel(tag, level);
+    }
+    return createResponse(status, getLogLevelMessage(status));
   }
 
 };
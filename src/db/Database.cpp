@@ -1,165 +1,745 @@
-
 #include "Database.hpp"
-#include "oatpp/core/parser/Caret.hpp"
+#include "Journal.hpp"
 
-HueDevice Database::updateFromStateDto(v_int32 id, const oatpp::Object<HueDeviceStateDto> &hueDeviceStateDto) {
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+#include "color/ColorModel.hpp"
+#include "metrics/Metrics.hpp"
 
-  auto it = m_HueDevicesById.find(id);
-  if(it == m_HueDevicesById.end()){
-    throw std::runtime_error("Unable to find HueDevice with ID");
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+constexpr v_uint32 Database::PAGE_SIZE;
+constexpr v_uint32 Database::JSON_CHUNK_SIZE;
+constexpr v_uint32 Database::SLOT_BITS;
+constexpr v_uint32 Database::SLOT_MASK;
+constexpr v_uint32 Database::GENERATION_MASK;
+
+namespace {
+
+/**
+ * xy is reported with 4 decimals, like the Hue bridge does.
+ */
+v_float64 roundCoordinate(float coordinate) {
+  return std::round(coordinate * 10000.0) / 10000.0;
+}
+
+}
+
+Database::WriteGuard::WriteGuard(Database& database)
+  : m_database(database)
+  , m_released(false)
+{
+  if (!m_database.m_metrics) {
+    m_database.m_writeLock.lock();
+    return;
+  }
+  auto start = Metrics::Clock::now();
+  m_database.m_writeLock.lock();
+  m_locked = Metrics::Clock::now();
+  m_database.m_metrics->record(m_database.m_lockWaitSeries,
+                               (v_uint64) std::chrono::duration_cast<std::chrono::nanoseconds>(m_locked - start).count());
+}
+
+Database::WriteGuard::~WriteGuard() {
+  if (!m_released) {
+    unlock(nullptr);
   }
+}
+
+void Database::WriteGuard::release(PendingWrite* pending) {
+  if (!unlock(pending)) {
+    throw NotDurableError();
+  }
+}
 
-  if (hueDeviceStateDto->bri != nullptr) {
-    it->second.bri = hueDeviceStateDto->bri;
+bool Database::WriteGuard::unlock(PendingWrite* pending) {
+  m_released = true;
+  std::shared_ptr<Journal> journal;
+  v_uint64 sequence = m_database.m_journalSequence;
+  if (sequence != 0) {
+    journal = m_database.m_journal;
+    m_database.m_journalSequence = 0;
+  }
+  if (m_database.m_metrics) {
+    auto unlocked = Metrics::Clock::now();
+    m_database.m_writeLock.unlock();
+    m_database.m_metrics->record(m_database.m_lockHoldSeries,
+                                 (v_uint64) std::chrono::duration_cast<std::chrono::nanoseconds>(unlocked - m_locked).count());
+  } else {
+    m_database.m_writeLock.unlock();
+  }
+  if (journal && pending != nullptr) {
+    pending->m_journal = journal;
+    pending->m_sequence = sequence;
+    return true;
   }
+  return !journal || journal->waitDurable(sequence);
+}
+
+bool Database::PendingWrite::poll(bool& durable) const {
+  if (!m_journal) {
+    durable = true;
+    return true;
+  }
+  return m_journal->pollDurable(m_sequence, durable);
+}
+
+std::shared_ptr<const Database::Snapshot> Database::createInitialSnapshot() {
+  auto allLights = std::make_shared<HueGroup>();
+  allLights->id = 0;
+  allLights->name = "Lightset 0";
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->groups.push_back(allLights);
+  return snapshot;
+}
 
-  if (hueDeviceStateDto->on != nullptr) {
-    it->second.on = hueDeviceStateDto->on;
-    if (it->second.on) { // if "on" was set to true an brightness is 0, set it to max brightness
-      if (it->second.bri == 0) {
-        it->second.bri = 254;
+std::shared_ptr<const Database::Snapshot> Database::loadSnapshot() const {
+  return std::atomic_load(&m_snapshot);
+}
+
+std::shared_ptr<Database::Snapshot> Database::beginWrite() const {
+  // writers are serialized by m_writeLock so the current snapshot can't change under us
+  auto next = std::make_shared<Snapshot>(*m_snapshot);
+  next->version++;
+  return next;
+}
+
+void Database::commitWrite(const std::shared_ptr<Snapshot>& next) {
+  if (!m_journalRecords.empty()) {
+    // appended in the order of the snapshot versions, the journal replays to the same table
+    m_journalSequence = m_journal->append(m_journalRecords);
+    m_journalRecords.clear();
+  }
+  std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(next));
+  // listeners are told after publishing, so whatever they read back already contains the change
+  if (!m_changed.empty()) {
+    for (auto it = m_changeListeners.begin(); it != m_changeListeners.end();) {
+      auto listener = it->lock();
+      if (listener) {
+        listener->onHueDevicesChanged(m_changed);
+        ++it;
+      } else {
+        it = m_changeListeners.erase(it);
       }
     }
+    m_changed.clear();
+  }
+}
+
+void Database::markChanged(const HueDevice& hueDevice) {
+  if (!m_changeListeners.empty()) {
+    m_changed.push_back(hueDevice);
+  }
+}
+
+void Database::journalGroup(v_int32 groupId, const HueGroup* group) {
+  if (m_journal) {
+    Journal::writeGroup(m_journalRecords, groupId, group);
+  }
+}
+
+bool Database::getSlot(const Snapshot& snapshot, v_uint32 index, Slot& slot) {
+  if (index >= snapshot.slotsCount) {
+    return false;
+  }
+  slot.page = snapshot.pages[index / PAGE_SIZE].get();
+  slot.offset = index % PAGE_SIZE;
+  return (slot.page->hueDevices[slot.offset].flags & HueDevice::FLAG_IN_USE) != 0;
+}
+
+bool Database::findSlot(const Snapshot& snapshot, v_int32 id, Slot& slot) {
+  if (id < 0 || !getSlot(snapshot, slotOf(id), slot)) {
+    return false;
+  }
+  // the slot might have been reused - the generation encoded in the id has to match as well
+  return slot.page->hueDevices[slot.offset].id == id;
+}
+
+std::shared_ptr<const HueGroup> Database::findGroup(const Snapshot& snapshot, v_int32 groupId) {
+  if (groupId < 0 || (size_t) groupId >= snapshot.groups.size()) {
+    return nullptr;
+  }
+  return snapshot.groups[groupId];
+}
+
+Database::Page::Page()
+  : infos(std::make_shared<InfoPage>())
+{
+  for (auto& chunk : jsonChunks) {
+    chunk = std::make_shared<JsonChunk>();
   }
+}
 
-  if (hueDeviceStateDto->hue != nullptr) {
-    // if hue is set from the api-call, colormode "hue" is assumed
-    it->second.hue = hueDeviceStateDto->hue;
-    it->second.mode = "hue"; // is this realy the name?
+// Cold data still shared with the page this one was copied from is copied before it is modified,
+// like the pages themselves in editSlot().
+
+Database::DeviceInfo& Database::Page::editInfo(v_uint32 offset) {
+  if (infos.use_count() > 1) {
+    infos = std::make_shared<InfoPage>(*infos);
   }
+  return infos->infos[offset];
+}
 
-  if (hueDeviceStateDto->sat != nullptr) {
-    it->second.sat = hueDeviceStateDto->sat;
+Database::CachedJson& Database::Page::editJson(v_uint32 offset) {
+  auto& chunk = jsonChunks[offset / JSON_CHUNK_SIZE];
+  if (chunk.use_count() > 1) {
+    chunk = std::make_shared<JsonChunk>(*chunk);
   }
+  return chunk->json[offset % JSON_CHUNK_SIZE];
+}
 
-  if (hueDeviceStateDto->ct != nullptr) {
-    // if ct is set from the api-call, colormode "ct" is assumed
-    it->second.ct = hueDeviceStateDto->ct;
-    it->second.mode = "ct";
+Database::Slot Database::editSlot(Snapshot& next, v_uint32 index) {
+  auto& page = next.pages[index / PAGE_SIZE];
+  // A page owned by `next` alone was already copied during this write.
+  // Otherwise it is shared with published snapshots and has to be copied before it is modified.
+  if (page.use_count() > 1) {
+    page = std::make_shared<Page>(*page);
   }
+  return {page.get(), index % PAGE_SIZE};
+}
+
+v_int32 Database::insert(Snapshot& next, HueDevice hueDevice, const oatpp::String& name) {
+  v_uint32 index;
+  v_uint32 generation = 0;
+  if (!m_freeSlots.empty()) {
+    index = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    // a deleted record keeps its last id, so the reused slot gets the next generation
+    generation = (generationOf(next.pages[index / PAGE_SIZE]->hueDevices[index % PAGE_SIZE].id) + 1) & GENERATION_MASK;
+  } else {
+    if (next.slotsCount > SLOT_MASK) {
+      throw std::runtime_error("Too many HueDevices");
+    }
+    index = next.slotsCount++;
+    if (next.pages.size() * PAGE_SIZE < next.slotsCount) {
+      next.pages.push_back(std::make_shared<Page>());
+    }
+  }
+  hueDevice.id = makeId(index, generation);
+  hueDevice.flags |= HueDevice::FLAG_IN_USE;
+  auto slot = editSlot(next, index);
+  slot.page->hueDevices[slot.offset] = hueDevice;
+  setInfo(slot, name);
+  renderJson(slot);
+  return hueDevice.id;
+}
 
-  if (hueDeviceStateDto->colormode != nullptr) {
-    it->second.mode = hueDeviceStateDto->colormode;
+void Database::setInfo(const Slot& slot, const oatpp::String& name) {
+  DeviceInfo& info = slot.page->editInfo(slot.offset);
+  if (info.uniqueid) {
+    m_idsByUniqueId.erase(*info.uniqueid);
   }
+  info.name = name;
+  info.uniqueid = makeUniqueId(name, slot.page->hueDevices[slot.offset].id);
+  m_idsByUniqueId[*info.uniqueid] = slot.page->hueDevices[slot.offset].id;
+}
 
-  return it->second;
+void Database::renderJson(const Slot& slot) {
+  const HueDevice& hueDevice = slot.page->hueDevices[slot.offset];
+  markChanged(hueDevice); // every change of a device re-renders its JSON
+  if (m_journal) {
+    Journal::writeDevice(m_journalRecords, hueDevice, slot.page->getInfo(slot.offset).name);
+  }
+  CachedJson& cached = slot.page->editJson(slot.offset);
+  cached.version = hueDevice.version;
+  cached.json = m_objectMapper->writeToString(deserializeToDto(hueDevice, slot.page->getInfo(slot.offset)));
 }
 
-HueDevice Database::serializeFromDto(const oatpp::Object<HueDeviceDto>& hueDeviceDto){
+HueDevice Database::serializeFromDto(const oatpp::Object<HueDeviceDto>& hueDeviceDto, oatpp::String& name){
   HueDevice hueDevice = HueDevice();
+  name = hueDeviceDto->name;
   if (hueDeviceDto->state) {
     if (hueDeviceDto->state->on != nullptr)
-      hueDevice.on = hueDeviceDto->state->on;
+      hueDevice.setOn(*hueDeviceDto->state->on);
     if (hueDeviceDto->state->bri != nullptr)
-      hueDevice.bri = hueDeviceDto->state->bri;
-    if (hueDeviceDto->state->hue != nullptr)
-      hueDevice.hue = hueDeviceDto->state->hue;
-    if (hueDeviceDto->state->sat != nullptr)
-      hueDevice.sat = hueDeviceDto->state->sat;
-    if (hueDeviceDto->state->ct != nullptr)
-      hueDevice.ct = hueDeviceDto->state->ct;
-    if (hueDeviceDto->state->colormode != nullptr)
-      hueDevice.mode = hueDeviceDto->state->colormode;
-  }
-  if(hueDeviceDto->uniqueid){
-    oatpp::parser::Caret caret(hueDeviceDto->uniqueid);
-    caret.setPosition(hueDeviceDto->uniqueid->size() - 4);
-    v_int32 id = caret.parseInt();
-    if (caret.hasError())
-      throw std::runtime_error("Malformed uniqueid: Unable to parse id integer");
-    hueDevice.id = id - 1;
+      hueDevice.bri = *hueDeviceDto->state->bri;
+    HueStateUpdate::fromDto(hueDeviceDto->state).applyColorTo(hueDevice);
   }
   return hueDevice;
 }
 
-oatpp::Object<HueDeviceDto> Database::deserializeToDto(const HueDevice& hueDevice){
-  auto dto = HueDeviceDto::createShared();
-  size_t namehash = std::hash<std::string>{}(*hueDevice.name);
+oatpp::String Database::makeUniqueId(const oatpp::String& name, v_int32 id) {
+  size_t namehash = name ? std::hash<std::string>{}(*name) : 0;
   char idstr[32] = {0};
   if (sizeof(size_t) == 8) {
     // Mod with the largest prime under 2^32 to map the 64bit hash to 32bit
     // This will not harm a good hash, yet certainly make weak hashes better.
     namehash = namehash % 4294967291;
   }
-  snprintf(idstr, 32, "%08zx%04d", namehash, hueDevice.id + 1);
-  dto->uniqueid = idstr;
-  dto->name = hueDevice.name;
-  dto->state->bri = hueDevice.bri;
-  dto->state->on = hueDevice.on;
-  dto->state->ct = hueDevice.ct;
-  dto->state->hue = hueDevice.hue;
-  dto->state->sat = hueDevice.sat;
-  dto->state->colormode = hueDevice.mode;
+  snprintf(idstr, 32, "%08zx%04d", namehash, id + 1);
+  return idstr;
+}
+
+oatpp::Object<HueDeviceStateDto> Database::deserializeStateToDto(const HueDevice& hueDevice){
+  auto dto = HueDeviceStateDto::createShared();
+  dto->bri = hueDevice.bri;
+  dto->on = hueDevice.isOn();
+  ColorModel::Color color = ColorModel::convert(hueDevice);
+  dto->ct = color.ct;
+  dto->hue = color.hue;
+  dto->sat = color.sat;
+  dto->xy = {roundCoordinate(color.x), roundCoordinate(color.y)};
+  dto->reachable = hueDevice.isReachable();
+  dto->colormode = HueDevice::colorModeToString(hueDevice.mode);
+  return dto;
+}
+
+oatpp::Object<HueDeviceDto> Database::deserializeToDto(const HueDevice& hueDevice, const DeviceInfo& info){
+  auto dto = HueDeviceDto::createShared();
+  dto->uniqueid = info.uniqueid;
+  dto->name = info.name;
+  dto->state = deserializeStateToDto(hueDevice);
+  return dto;
+}
+
+oatpp::Object<HueGroupDto> Database::deserializeGroupToDto(const Snapshot& snapshot, const HueGroup& group){
+  auto dto = HueGroupDto::createShared();
+  dto->name = group.name;
+  dto->lights = oatpp::List<oatpp::String>::createShared();
+  dto->action = deserializeStateToDto(group.action);
+  Slot slot;
+  auto addLight = [&snapshot, &slot, &dto](v_uint32 index) {
+    if (getSlot(snapshot, index, slot)) {
+      dto->lights->push_back(oatpp::utils::conversion::int32ToStr(slot.page->hueDevices[slot.offset].id + 1));
+    }
+  };
+  if (group.id == 0) {
+    for (v_uint32 index = 0; index < snapshot.slotsCount; index++) {
+      addLight(index);
+    }
+  } else {
+    group.forEachMember(addLight);
+  }
   return dto;
 }
 
 oatpp::Object<HueDeviceDto> Database::createHueDevice(const oatpp::Object<HueDeviceDto>& hueDeviceDto){
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
-  auto hueDevice = serializeFromDto(hueDeviceDto);
-  hueDevice.id = m_idCounter++;
-  m_HueDevicesById[hueDevice.id] = hueDevice;
-  return deserializeToDto(hueDevice);
+  WriteGuard guard(*this);
+  oatpp::String name;
+  auto hueDevice = serializeFromDto(hueDeviceDto, name);
+  auto next = beginWrite();
+  Slot slot;
+  findSlot(*next, insert(*next, hueDevice, name), slot);
+  commitWrite(next);
+  auto result = deserializeToDto(slot.page->hueDevices[slot.offset], slot.page->getInfo(slot.offset));
+  guard.release();
+  return result;
+}
+
+void Database::applyState(const Slot& slot, const HueStateUpdate& update) {
+  HueDevice& hueDevice = slot.page->hueDevices[slot.offset];
+  if (m_stateOverlay && update.has(HueStateUpdate::FIELD_TRANSITIONTIME) && update.transitiontime > 0) {
+    HueDevice previous = hueDevice;
+    update.applyTo(hueDevice);
+    m_stateOverlay->onStateUpdated(previous, hueDevice, update.transitiontime * 100);
+  } else {
+    update.applyTo(hueDevice);
+  }
+  renderJson(slot);
+}
+
+bool Database::applyHueDeviceState(v_int32 id, const HueStateUpdate& update, Slot& slot) {
+  if(!findSlot(*m_snapshot, id, slot)){
+    return false;
+  }
+  auto next = beginWrite();
+  slot = editSlot(*next, slotOf(id));
+  applyState(slot, update);
+  commitWrite(next);
+  return true;
 }
 
 oatpp::Object<HueDeviceDto> Database::updateHueDeviceState(v_int32 id,
                                                            const oatpp::Object<HueDeviceStateDto> &hueDeviceStateDto) {
-  return deserializeToDto(updateFromStateDto(id, hueDeviceStateDto));
+  WriteGuard guard(*this);
+  Slot slot;
+  if(!applyHueDeviceState(id, HueStateUpdate::fromDto(hueDeviceStateDto), slot)){
+    throw std::runtime_error("Unable to find HueDevice with ID");
+  }
+  auto result = deserializeToDto(slot.page->hueDevices[slot.offset], slot.page->getInfo(slot.offset));
+  guard.release();
+  return result;
+}
+
+bool Database::updateHueDeviceState(v_int32 id, const HueStateUpdate& update, HueDevice& updated, PendingWrite* pending) {
+  WriteGuard guard(*this);
+  Slot slot;
+  if(!applyHueDeviceState(id, update, slot)){
+    return false;
+  }
+  updated = slot.page->hueDevices[slot.offset];
+  guard.release(pending);
+  return true;
 }
 
 oatpp::Object<HueDeviceDto> Database::updateHueDevice(const oatpp::Object<HueDeviceDto>& hueDeviceDto){
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
-  auto hueDevice = serializeFromDto(hueDeviceDto);
-  if(hueDevice.id < 0){
-    throw std::runtime_error("HueDevice Id cannot be less than 0");
-  }
-  auto it = m_HueDevicesById.find(hueDevice.id);
-  if(it != m_HueDevicesById.end()) {
-    m_HueDevicesById[hueDevice.id] = hueDevice;
-  } else {
-    throw new std::runtime_error("Such HueDevice not found");
+  WriteGuard guard(*this);
+  if (!hueDeviceDto->uniqueid) {
+    throw std::runtime_error("HueDevice uniqueid is required");
   }
-  return deserializeToDto(hueDevice);
+  auto idIt = m_idsByUniqueId.find(*hueDeviceDto->uniqueid);
+  if(idIt == m_idsByUniqueId.end()) {
+    throw std::runtime_error("Such HueDevice not found");
+  }
+  oatpp::String name;
+  auto hueDevice = serializeFromDto(hueDeviceDto, name);
+  hueDevice.id = idIt->second;
+  auto next = beginWrite();
+  auto slot = editSlot(*next, slotOf(hueDevice.id));
+  hueDevice.version = slot.page->hueDevices[slot.offset].version + 1;
+  hueDevice.flags |= HueDevice::FLAG_IN_USE;
+  slot.page->hueDevices[slot.offset] = hueDevice;
+  if (name != slot.page->getInfo(slot.offset).name) {
+    setInfo(slot, name); // renamed - the uniqueid follows the name
+  }
+  renderJson(slot);
+  commitWrite(next);
+  auto result = deserializeToDto(hueDevice, slot.page->getInfo(slot.offset));
+  guard.release();
+  return result;
+}
+
+Database::StateOverlay* Database::getActiveOverlay() const {
+  if (m_stateOverlay && !m_stateOverlay->isEmpty()) {
+    return m_stateOverlay.get();
+  }
+  return nullptr;
+}
+
+bool Database::renderOverlaid(StateOverlay& overlay, oatpp::data::mapping::ObjectMapper& objectMapper, const Slot& slot, oatpp::String& json) {
+  HueDevice current = slot.page->hueDevices[slot.offset];
+  if (!overlay.getState(current)) {
+    return false;
+  }
+  json = objectMapper.writeToString(deserializeToDto(current, slot.page->getInfo(slot.offset)));
+  return true;
 }
 
 oatpp::Object<HueDeviceDto> Database::getHueDeviceById(v_int32 id) {
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
-  auto it = m_HueDevicesById.find(id);
-  if(it == m_HueDevicesById.end()){
+  auto snapshot = loadSnapshot();
+  Slot slot;
+  if(!findSlot(*snapshot, id, slot)){
     return nullptr;
   }
-  return deserializeToDto(it->second);
+  HueDevice hueDevice = slot.page->hueDevices[slot.offset];
+  if (auto overlay = getActiveOverlay()) {
+    overlay->getState(hueDevice);
+  }
+  return deserializeToDto(hueDevice, slot.page->getInfo(slot.offset));
 }
 
 oatpp::PairList<oatpp::UInt32, oatpp::Object<HueDeviceDto>> Database::getHueDevices(){
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+  auto snapshot = loadSnapshot();
+  auto overlay = getActiveOverlay();
   oatpp::PairList<oatpp::UInt32, oatpp::Object<HueDeviceDto>> result({});
-  auto it = m_HueDevicesById.begin();
-  while (it != m_HueDevicesById.end()) {
-    result->emplace_back(it->first, deserializeToDto(it->second));
-    it++;
+  Slot slot;
+  for (v_uint32 index = 0; index < snapshot->slotsCount; index++) {
+    if (getSlot(*snapshot, index, slot)) {
+      HueDevice hueDevice = slot.page->hueDevices[slot.offset];
+      if (overlay) {
+        overlay->getState(hueDevice);
+      }
+      result->emplace_back(hueDevice.id, deserializeToDto(hueDevice, slot.page->getInfo(slot.offset)));
+    }
   }
   return result;
 }
 
+oatpp::String Database::getHueDeviceJsonById(v_int32 id) {
+  auto snapshot = loadSnapshot();
+  Slot slot;
+  if(!findSlot(*snapshot, id, slot)){
+    return nullptr;
+  }
+  oatpp::String json;
+  auto overlay = getActiveOverlay();
+  if (overlay && renderOverlaid(*overlay, *m_objectMapper, slot, json)) {
+    return json;
+  }
+  return slot.page->getJson(slot.offset).json;
+}
+
+oatpp::String Database::getHueDevicesJson() {
+  auto snapshot = loadSnapshot();
+  auto overlay = getActiveOverlay();
+  oatpp::String overlaid;
+  Slot slot;
+
+  v_buff_size size = 2;
+  for (v_uint32 index = 0; index < snapshot->slotsCount; index++) {
+    if (getSlot(*snapshot, index, slot)) {
+      size += slot.page->getJson(slot.offset).json->size() + 16; // fragment + "<key>":,
+    }
+  }
+
+  std::string result;
+  result.reserve(size);
+
+  char key[24];
+  result += '{';
+  for (v_uint32 index = 0; index < snapshot->slotsCount; index++) {
+    if (getSlot(*snapshot, index, slot)) {
+      if (result.size() > 1) {
+        result += ',';
+      }
+      v_int32 keySize = snprintf(key, sizeof(key), "\"%d\":", slot.page->hueDevices[slot.offset].id + 1);
+      result.append(key, keySize);
+      if (overlay && renderOverlaid(*overlay, *m_objectMapper, slot, overlaid)) {
+        result.append(*overlaid);
+      } else {
+        result.append(*slot.page->getJson(slot.offset).json);
+      }
+    }
+  }
+  result += '}';
+
+  return oatpp::String(std::move(result));
+}
+
+Database::HueDevicesJsonCursor Database::getHueDevicesJsonCursor(v_uint32 offset, v_uint32 limit) {
+  return HueDevicesJsonCursor(loadSnapshot(), m_stateOverlay, m_objectMapper, offset, limit);
+}
+
+Database::HueDevicesJsonCursor::HueDevicesJsonCursor(const std::shared_ptr<const Snapshot>& snapshot,
+                                                     const std::shared_ptr<StateOverlay>& overlay,
+                                                     const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                                                     v_uint32 offset, v_uint32 limit)
+  : m_snapshot(snapshot)
+  , m_overlay(overlay)
+  , m_objectMapper(objectMapper)
+  , m_index(0)
+  , m_skip(offset)
+  , m_left(limit)
+  , m_rendered(0)
+  , m_begun(false)
+  , m_done(false)
+{}
+
+bool Database::HueDevicesJsonCursor::next(std::string& out, v_buff_size size) {
+
+  if (m_done) {
+    return false;
+  }
+
+  const v_buff_size end = (v_buff_size) out.size() + size;
+
+  if (!m_begun) {
+    out += '{';
+    m_begun = true;
+  }
+
+  // fades start and end while the client reads, the overlay is looked at per chunk
+  StateOverlay* overlay = m_overlay && !m_overlay->isEmpty() ? m_overlay.get() : nullptr;
+  oatpp::String overlaid;
+  Slot slot;
+  char key[24];
+  while (m_left > 0 && m_index < m_snapshot->slotsCount && (v_buff_size) out.size() < end) {
+    if (getSlot(*m_snapshot, m_index++, slot)) {
+      if (m_skip > 0) {
+        m_skip--;
+        continue;
+      }
+      v_int32 keySize = snprintf(key, sizeof(key), "%s\"%d\":", m_rendered > 0 ? "," : "", slot.page->hueDevices[slot.offset].id + 1);
+      out.append(key, keySize);
+      if (overlay && renderOverlaid(*overlay, *m_objectMapper, slot, overlaid)) {
+        out.append(*overlaid);
+      } else {
+        out.append(*slot.page->getJson(slot.offset).json);
+      }
+      m_rendered++;
+      m_left--;
+    }
+  }
+
+  if (m_left == 0 || m_index >= m_snapshot->slotsCount) {
+    out += '}';
+    m_done = true;
+  }
+
+  return true;
+
+}
+
+v_uint32 Database::HueDevicesJsonCursor::getMaxCount() const {
+  v_uint32 slots = m_snapshot->slotsCount - std::min(m_skip, m_snapshot->slotsCount);
+  return std::min(m_left, slots);
+}
+
 bool Database::deleteHueDevice(v_int32 id){
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
-  auto it = m_HueDevicesById.find(id);
-  if(it == m_HueDevicesById.end()){
+  WriteGuard guard(*this);
+  Slot slot;
+  if(!findSlot(*m_snapshot, id, slot)){
     return false;
   }
-  m_HueDevicesById.erase(it);
+  auto next = beginWrite();
+  slot = editSlot(*next, slotOf(id));
+  slot.page->hueDevices[slot.offset] = HueDevice();
+  slot.page->hueDevices[slot.offset].id = id; // keep the generation for the next device in this slot
+  m_idsByUniqueId.erase(*slot.page->getInfo(slot.offset).uniqueid);
+  slot.page->editInfo(slot.offset) = DeviceInfo();
+  slot.page->editJson(slot.offset) = CachedJson();
+  for (auto& group : next->groups) {
+    if (group && group->hasMember(slotOf(id))) {
+      auto changed = std::make_shared<HueGroup>(*group);
+      changed->removeMember(slotOf(id));
+      group = changed;
+      journalGroup(changed->id, changed.get());
+    }
+  }
+  m_freeSlots.push_back(slotOf(id));
+  markChanged(slot.page->hueDevices[slot.offset]);
+  if (m_journal) {
+    Journal::writeDevice(m_journalRecords, slot.page->hueDevices[slot.offset], nullptr);
+  }
+  commitWrite(next);
+  guard.release();
+  return true;
+}
+
+v_int32 Database::createGroup(const oatpp::String& name, const std::vector<v_int32>& hueDeviceIds, PendingWrite* pending) {
+  WriteGuard guard(*this);
+  auto group = std::make_shared<HueGroup>();
+  group->name = name;
+  Slot slot;
+  for (v_int32 id : hueDeviceIds) {
+    if (!findSlot(*m_snapshot, id, slot)) {
+      throw std::runtime_error("Unable to find HueDevice with ID");
+    }
+    group->addMember(slotOf(id));
+  }
+  auto next = beginWrite();
+  size_t groupId = 1;
+  while (groupId < next->groups.size() && next->groups[groupId]) {
+    groupId++;
+  }
+  if (groupId == next->groups.size()) {
+    next->groups.push_back(nullptr);
+  }
+  group->id = (v_int32) groupId;
+  next->groups[groupId] = group;
+  journalGroup(group->id, group.get());
+  commitWrite(next);
+  guard.release(pending);
+  return group->id;
+}
+
+oatpp::Object<HueGroupDto> Database::getGroupById(v_int32 groupId) {
+  auto snapshot = loadSnapshot();
+  auto group = findGroup(*snapshot, groupId);
+  if (!group) {
+    return nullptr;
+  }
+  return deserializeGroupToDto(*snapshot, *group);
+}
+
+oatpp::Fields<oatpp::Object<HueGroupDto>> Database::getGroups() {
+  auto snapshot = loadSnapshot();
+  oatpp::Fields<oatpp::Object<HueGroupDto>> result({});
+  for (size_t groupId = 1; groupId < snapshot->groups.size(); groupId++) {
+    if (snapshot->groups[groupId]) {
+      result->emplace_back(oatpp::utils::conversion::int32ToStr((v_int32) groupId),
+                           deserializeGroupToDto(*snapshot, *snapshot->groups[groupId]));
+    }
+  }
+  return result;
+}
+
+bool Database::deleteGroup(v_int32 groupId, PendingWrite* pending) {
+  WriteGuard guard(*this);
+  if (groupId == 0 || !findGroup(*m_snapshot, groupId)) {
+    return false;
+  }
+  auto next = beginWrite();
+  next->groups[groupId] = nullptr;
+  journalGroup(groupId, nullptr);
+  commitWrite(next);
+  guard.release(pending);
+  return true;
+}
+
+oatpp::Object<HueDeviceStateDto> Database::updateGroupState(v_int32 groupId,
+                                                            const oatpp::Object<HueDeviceStateDto>& hueDeviceStateDto) {
+  HueDevice action;
+  if (!updateGroupState(groupId, HueStateUpdate::fromDto(hueDeviceStateDto), action)) {
+    return nullptr;
+  }
+  return deserializeStateToDto(action);
+}
+
+bool Database::updateGroupState(v_int32 groupId, const HueStateUpdate& update, HueDevice& action, PendingWrite* pending) {
+  WriteGuard guard(*this);
+  auto current = findGroup(*m_snapshot, groupId);
+  if (!current) {
+    return false;
+  }
+  auto next = beginWrite();
+  auto group = std::make_shared<HueGroup>(*current);
+  update.applyTo(group->action);
+
+  // every touched page is copied at most once, the change is published as one snapshot version
+  auto apply = [this, &next, &update](v_uint32 index) {
+    Slot slot;
+    if (getSlot(*next, index, slot)) {
+      applyState(editSlot(*next, index), update);
+    }
+  };
+  if (groupId == 0) {
+    for (v_uint32 index = 0; index < next->slotsCount; index++) {
+      apply(index);
+    }
+  } else {
+    group->forEachMember(apply);
+  }
+
+  next->groups[groupId] = group;
+  journalGroup(groupId, group.get());
+  commitWrite(next);
+  action = group->action;
+  guard.release(pending);
   return true;
 }
 
 v_int32 Database::registerHueDevice(const oatpp::String &name, const oatpp::Boolean &on, const oatpp::Int32 &bri) {
-  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_lock);
+  WriteGuard guard(*this);
   HueDevice hueDevice;
-  hueDevice.name = name;
-  hueDevice.on = on;
-  hueDevice.bri = bri;
-  hueDevice.id = m_idCounter++;
-  m_HueDevicesById[hueDevice.id] = hueDevice;
-  return hueDevice.id;
+  if (on != nullptr) {
+    hueDevice.setOn(*on);
+  }
+  if (bri != nullptr) {
+    hueDevice.bri = (v_uint8) std::min<v_int32>(std::max<v_int32>(*bri, 0), 254);
+  }
+  auto next = beginWrite();
+  v_int32 id = insert(*next, hueDevice, name);
+  commitWrite(next);
+  guard.release();
+  return id;
+}
+
+void Database::setMetrics(const std::shared_ptr<Metrics>& metrics) {
+  m_lockWaitSeries = metrics->addSeries("hue_db_write_lock_wait", "Time writers waited for the Database write lock", "");
+  m_lockHoldSeries = metrics->addSeries("hue_db_write_lock_hold", "Time writers held the Database write lock", "");
+  m_metrics = metrics;
+}
+
+void Database::setStateOverlay(const std::shared_ptr<StateOverlay>& overlay) {
+  m_stateOverlay = overlay;
+}
+
+void Database::addChangeListener(const std::shared_ptr<ChangeListener>& listener) {
+  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_writeLock);
+  m_changeListeners.push_back(listener);
 }
 
+v_uint32 Database::getHueDevicesCount() const {
+  v_uint32 count = 0;
+  forEachHueDevice([&count](const HueDevice&) {
+    count++;
+  });
+  return count;
+}
+
+v_uint64 Database::getVersion() const {
+  return loadSnapshot()->version;
+}
@@ -3,32 +3,346 @@
 #define Database_hpp
 
 #include "dto/HueDeviceDto.hpp"
+#include "dto/HueGroupDto.hpp"
 #include "db/model/HueDevice.hpp"
+#include "db/model/HueGroup.hpp"
+#include "db/model/HueStateUpdate.hpp"
 
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
 #include "oatpp/core/concurrency/SpinLock.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
+#include <vector>
+#include <memory>
+
+class Journal;
+class Metrics;
+class Storage;
 
 /**
- *  Trivial in-memory Database based on unordered_map container.
+ *  Trivial in-memory Database based on a slot-map of packed HueDevice records.
  *  For demo purposes only :)
  *  This database contains our devices we are serving.
  *  You can/should replace this database with your own state-logic implementation.
+ *
+ *  The device table is published as an immutable, versioned Snapshot (copy-on-write).
+ *  Readers load the current snapshot and never lock, writers serialize on m_writeLock,
+ *  copy the current snapshot, apply their change and publish the copy as the next version.
+ *  The table is split into pages so a writer copies the page table and only the pages it touches,
+ *  and of those only the parts it changes - see Page.
+ *
+ *  A HueDeviceId is the index of the device's slot plus the slot's generation in the upper bits.
+ *  Slots of deleted devices are reused with the next generation, so a stale id never resolves to a new device.
+ *
+ *  Groups are part of the snapshot as well. Their members are a bitset over the device slots,
+ *  a group action updates all members within one write.
+ *
+ *  ChangeListeners are told the devices changed by a write once that write is published.
+ *
+ *  With a StateOverlay set, the devices it overlays (fading lights) are read with their overlaid state,
+ *  rendered per read instead of served from the JSON cache.
+ *
+ *  With a Storage attached every write appends the new records of what it changed to the Journal
+ *  and returns once the journal made them durable - see WriteGuard. A write the journal failed to save
+ *  throws NotDurableError.
  */
 class Database {
+public:
+
+  /**
+   *  Thrown by writes the journal failed to make durable. The change is applied and published all the same,
+   *  but it won't survive a restart of the hub.
+   */
+  class NotDurableError : public std::runtime_error {
+  public:
+    NotDurableError()
+      : std::runtime_error("The change was applied but not saved")
+    {}
+  };
+
+  /**
+   *  A write which returned before the journal made it durable, see the `pending` parameter of the writes.
+   *  Lets callers which can't block, i.E. coroutines, poll for the outcome.
+   */
+  class PendingWrite {
+    friend class Database;
+  private:
+    std::shared_ptr<Journal> m_journal; ///< `nullptr` - nothing to wait for
+    v_uint64 m_sequence = 0;
+  public:
+
+    /**
+     * @param durable - out: `false` if the journal failed to save the write. Set once the write is done.
+     * @return - `false` while the journal is still writing
+     */
+    bool poll(bool& durable) const;
+
+  };
+
+  /**
+   *  Receives the records of the devices changed by each committed write - created, updated or deleted.
+   *  A deleted device is passed with its id but without HueDevice::FLAG_IN_USE.
+   *  Called with the write lock held, so implementations should only queue the changes.
+   */
+  class ChangeListener {
+  public:
+    virtual ~ChangeListener() = default;
+    virtual void onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) = 0;
+  };
+
+  /**
+   *  State of devices which differs from their committed record for a while - lights fading to a new state,
+   *  see TransitionEngine. The read paths report the overlaid state instead of the committed one.
+   */
+  class StateOverlay {
+  public:
+    virtual ~StateOverlay() = default;
+
+    /**
+     * A state change with a `transitiontime` was applied. Called with the write lock held, before the write is published.
+     * @param previous - record before the change
+     * @param updated - record after the change
+     * @param transitionMs - requested transition time
+     */
+    virtual void onStateUpdated(const HueDevice& previous, const HueDevice& updated, v_int32 transitionMs) = 0;
+
+    /**
+     * @return - `true` if no device is overlaid, the read paths serve the committed records without asking
+     */
+    virtual bool isEmpty() const = 0;
+
+    /**
+     * @param hueDevice - in: committed record, out: current state
+     * @return - `false` if the device is not overlaid, or not any more for the committed record's version
+     */
+    virtual bool getState(HueDevice& hueDevice) const = 0;
+  };
+
+public:
+  static constexpr v_uint32 PAGE_SIZE = 256;
+  static constexpr v_uint32 JSON_CHUNK_SIZE = 16; ///< JSON fragments copied together by a write
+  static constexpr v_uint32 SLOT_BITS = 20; ///< up to 2^20 slots
+  static constexpr v_uint32 SLOT_MASK = (1u << SLOT_BITS) - 1;
+  static constexpr v_uint32 GENERATION_MASK = 0x7FF; ///< 11 bits, keeps ids positive
+public:
+
+  static v_uint32 slotOf(v_int32 id) {
+    return (v_uint32) id & SLOT_MASK;
+  }
+
+  static v_uint32 generationOf(v_int32 id) {
+    return ((v_uint32) id >> SLOT_BITS) & GENERATION_MASK;
+  }
+
+  static v_int32 makeId(v_uint32 slot, v_uint32 generation) {
+    return (v_int32) ((generation << SLOT_BITS) | slot);
+  }
+
+private:
+
+  /**
+   *  JSON of a HueDeviceDto rendered once per HueDevice::version.
+   */
+  struct CachedJson {
+    v_uint32 version = 0; ///< HueDevice::version the fragment was rendered from
+    oatpp::String json;
+  };
+
+  /**
+   *  Cold per-device data.
+   */
+  struct DeviceInfo {
+    oatpp::String name;
+    oatpp::String uniqueid; ///< computed once on register/rename, see makeUniqueId()
+  };
+
+  struct InfoPage {
+    DeviceInfo infos[PAGE_SIZE];
+  };
+
+  struct JsonChunk {
+    CachedJson json[JSON_CHUNK_SIZE];
+  };
+
+  /**
+   *  PAGE_SIZE storage slots. The packed records are kept apart from the cold data.
+   *  Free slots keep the id of their last device, so the generation survives the delete.
+   *
+   *  A copy of the page copies the records only. The cold data is shared with the copied page
+   *  and copied itself once it changes - the names on register, rename and delete,
+   *  a chunk of JSON_CHUNK_SIZE fragments when one of them is re-rendered.
+   */
+  struct Page {
+    HueDevice hueDevices[PAGE_SIZE]; ///< packed device records, HueDevice::FLAG_IN_USE marks occupied slots
+    std::shared_ptr<InfoPage> infos; ///< names and uniqueids
+    std::shared_ptr<JsonChunk> jsonChunks[PAGE_SIZE / JSON_CHUNK_SIZE]; ///< pre-rendered JSON of each device
+
+    Page();
+
+    const DeviceInfo& getInfo(v_uint32 offset) const {
+      return infos->infos[offset];
+    }
+
+    const CachedJson& getJson(v_uint32 offset) const {
+      return jsonChunks[offset / JSON_CHUNK_SIZE]->json[offset % JSON_CHUNK_SIZE];
+    }
+
+    DeviceInfo& editInfo(v_uint32 offset); // call with m_writeLock held, on a page owned by the current write
+    CachedJson& editJson(v_uint32 offset); // call with m_writeLock held, on a page owned by the current write
+  };
+
+  /**
+   *  Immutable view of the device table. Never modified once published.
+   *  Pages are shared between snapshots until a writer touches them.
+   */
+  struct Snapshot {
+    v_uint64 version = 0;
+    v_uint32 slotsCount = 0; ///< number of slots handed out so far
+    std::vector<std::shared_ptr<Page>> pages;
+    std::vector<std::shared_ptr<const HueGroup>> groups; ///< indexed by group id, groups[0] is "all lights", deleted groups are `nullptr`
+  };
+
+  /**
+   *  Location of a device inside a snapshot.
+   */
+  struct Slot {
+    Page* page;
+    v_uint32 offset;
+  };
+
+  /**
+   *  Holds m_writeLock for one write. Once the lock is released, waits until the journal made the write durable,
+   *  so concurrent writers queue for the same fsync instead of for the lock.
+   *  With Metrics set, records the time spent waiting for the lock and holding it.
+   */
+  class WriteGuard {
+  private:
+    Database& m_database;
+    std::chrono::steady_clock::time_point m_locked; ///< set if the Database has Metrics
+    bool m_released;
+  private:
+    bool unlock(PendingWrite* pending); // returns `false` if the journal didn't make the write durable
+  public:
+    explicit WriteGuard(Database& database);
+
+    /**
+     * Releases the lock of a write which didn't finish, without reporting the journal's outcome.
+     */
+    ~WriteGuard();
+
+    /**
+     * Release the lock and wait for the journal. Call once the results of the write were taken from the snapshot.
+     * @param pending - if given, don't wait - the caller polls the journal's outcome instead
+     * @throws - NotDurableError
+     */
+    void release(PendingWrite* pending = nullptr);
+  };
+
+public:
+
+  /**
+   *  Renders the lights object of one snapshot piece by piece, for streaming `GET /api/{username}/lights`.
+   *  Holds on to the snapshot, so the object is consistent however long the client takes to read it.
+   *  Devices are rendered in slot order, which `offset` and `limit` count in.
+   */
+  class HueDevicesJsonCursor {
+    friend class Database;
+  private:
+    std::shared_ptr<const Snapshot> m_snapshot;
+    std::shared_ptr<StateOverlay> m_overlay;
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper; ///< renders overlaid devices
+    v_uint32 m_index; ///< next slot
+    v_uint32 m_skip; ///< devices still to skip
+    v_uint32 m_left; ///< devices still to render
+    v_uint32 m_rendered;
+    bool m_begun;
+    bool m_done;
+  private:
+    HueDevicesJsonCursor(const std::shared_ptr<const Snapshot>& snapshot,
+                         const std::shared_ptr<StateOverlay>& overlay,
+                         const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                         v_uint32 offset, v_uint32 limit);
+  public:
+
+    /**
+     * Append the next devices to `out`, starting with `{` and ending with `}`.
+     * @param out
+     * @param size - stop after appending at least this many bytes. Rendering stops between two devices, so one device may exceed it.
+     * @return - `false` if the object was rendered completely before, nothing was appended
+     */
+    bool next(std::string& out, v_buff_size size);
+
+    /**
+     * @return - upper bound of the number of devices rendered
+     */
+    v_uint32 getMaxCount() const;
+
+  };
+
 private:
-  oatpp::concurrency::SpinLock m_lock;
-  v_int32 m_idCounter; ///< counter to generate HueDeviceIds
-  std::unordered_map<v_int32, HueDevice> m_HueDevicesById; ///< Map HueDeviceId to HueDevice
+  friend class Storage;
 private:
-  static HueDevice serializeFromDto(const oatpp::Object<HueDeviceDto>& hueDeviceDto);
-  HueDevice updateFromStateDto(v_int32 id, const oatpp::Object<HueDeviceStateDto> &hueDeviceStateDto);
-  static oatpp::Object<HueDeviceDto> deserializeToDto(const HueDevice& hueDevice);
+  oatpp::concurrency::SpinLock m_writeLock; ///< taken by writers only
+  std::shared_ptr<const Snapshot> m_snapshot; ///< access via std::atomic_load/std::atomic_store only
+  std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper; ///< renders the JSON cache
+  std::vector<v_uint32> m_freeSlots; ///< slots of deleted devices, guarded by m_writeLock
+  std::unordered_map<std::string, v_int32> m_idsByUniqueId; ///< reverse index uniqueid -> HueDeviceId, guarded by m_writeLock
+  std::vector<std::weak_ptr<ChangeListener>> m_changeListeners; ///< guarded by m_writeLock
+  std::vector<HueDevice> m_changed; ///< devices changed by the current write, guarded by m_writeLock
+  std::shared_ptr<Journal> m_journal; ///< set by Storage, `nullptr` - in memory only. Guarded by m_writeLock
+  std::string m_journalRecords; ///< journal records of the current write, guarded by m_writeLock
+  v_uint64 m_journalSequence = 0; ///< journal sequence of the last commit, handed to the WriteGuard. Guarded by m_writeLock
+  std::shared_ptr<StateOverlay> m_stateOverlay; ///< set before the Database is shared, `nullptr` - transitions are not faded
+  std::shared_ptr<Metrics> m_metrics; ///< set before the Database is shared, `nullptr` - writes are not timed
+  v_int32 m_lockWaitSeries = -1;
+  v_int32 m_lockHoldSeries = -1;
+private:
+  std::shared_ptr<const Snapshot> loadSnapshot() const;
+  std::shared_ptr<Snapshot> beginWrite() const; // call with m_writeLock held
+  void commitWrite(const std::shared_ptr<Snapshot>& next); // call with m_writeLock held
+  static bool getSlot(const Snapshot& snapshot, v_uint32 index, Slot& slot);
+  static bool findSlot(const Snapshot& snapshot, v_int32 id, Slot& slot);
+  static Slot editSlot(Snapshot& next, v_uint32 index);
+  v_int32 insert(Snapshot& next, HueDevice hueDevice, const oatpp::String& name); // call with m_writeLock held
+  void setInfo(const Slot& slot, const oatpp::String& name); // call with m_writeLock held
+  void markChanged(const HueDevice& hueDevice); // call with m_writeLock held
+  void journalGroup(v_int32 groupId, const HueGroup* group); // call with m_writeLock held
+  void renderJson(const Slot& slot);
+  bool applyHueDeviceState(v_int32 id, const HueStateUpdate& update, Slot& slot); // call with m_writeLock held
+  void applyState(const Slot& slot, const HueStateUpdate& update); // call with m_writeLock held
+  StateOverlay* getActiveOverlay() const;
+  static std::shared_ptr<const HueGroup> findGroup(const Snapshot& snapshot, v_int32 groupId);
+private:
+  static std::shared_ptr<const Snapshot> createInitialSnapshot();
+  static oatpp::String makeUniqueId(const oatpp::String& name, v_int32 id);
+  static HueDevice serializeFromDto(const oatpp::Object<HueDeviceDto>& hueDeviceDto, oatpp::String& name);
+  static oatpp::Object<HueDeviceStateDto> deserializeStateToDto(const HueDevice& hueDevice);
+  static oatpp::Object<HueDeviceDto> deserializeToDto(const HueDevice& hueDevice, const DeviceInfo& info);
+  static oatpp::Object<HueGroupDto> deserializeGroupToDto(const Snapshot& snapshot, const HueGroup& group);
+  static bool renderOverlaid(StateOverlay& overlay, oatpp::data::mapping::ObjectMapper& objectMapper, const Slot& slot, oatpp::String& json);
 public:
-  
+
+  /**
+   * Constructor.
+   * @param objectMapper - mapper used to render the per-device JSON cache. Should be configured like the API's mapper.
+   */
+  Database(const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper)
+    : m_snapshot(createInitialSnapshot())
+    , m_objectMapper(objectMapper)
+  {}
+
   Database()
-    : m_idCounter(0)
+    : Database(createDefaultObjectMapper())
   {}
 
+  static std::shared_ptr<oatpp::data::mapping::ObjectMapper> createDefaultObjectMapper() {
+    auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+    return objectMapper;
+  }
+
   /**
    * Use this function in `App.cpp` to initially add a new 'light' to this 'hub'
    * @param name - the name the 'light' should be found and called by
@@ -39,12 +353,151 @@ public:
   v_int32 registerHueDevice(const oatpp::String &name, const oatpp::Boolean &on = false, const oatpp::Int32 &bri = 254);
 
   oatpp::Object<HueDeviceDto> createHueDevice(const oatpp::Object<HueDeviceDto>& hueDeviceDto);
+
+  /**
+   * Replace name and state of the device identified by `hueDeviceDto->uniqueid`.
+   * @param hueDeviceDto
+   * @return - the updated device
+   */
   oatpp::Object<HueDeviceDto> updateHueDevice(const oatpp::Object<HueDeviceDto>& hueDeviceDto);
   oatpp::Object<HueDeviceDto> updateHueDeviceState(v_int32 id, const oatpp::Object<HueDeviceStateDto>& hueDeviceStateDto);
+
+  /**
+   * Apply a state change to a device.
+   * @param id - HueDeviceId
+   * @param update - requested attributes, i.E. parsed by HueStateParser
+   * @param updated - out: the device record after the change
+   * @param pending - if given, return without waiting for the journal, see PendingWrite
+   * @return - `false` if there is no such device
+   */
+  bool updateHueDeviceState(v_int32 id, const HueStateUpdate& update, HueDevice& updated, PendingWrite* pending = nullptr);
+
   oatpp::Object<HueDeviceDto> getHueDeviceById(v_int32 id);
   oatpp::PairList<oatpp::UInt32, oatpp::Object<HueDeviceDto>> getHueDevices();
   bool deleteHueDevice(v_int32 id);
-  
+
+  /**
+   * Pre-rendered JSON of a single device, served straight from the cache.
+   * @param id - HueDeviceId
+   * @return - JSON of the HueDeviceDto or `nullptr` if there is no such device
+   */
+  oatpp::String getHueDeviceJsonById(v_int32 id);
+
+  /**
+   * JSON object of all devices keyed by their Hue light number (`id + 1`), joined from the cached fragments.
+   * @return - JSON object as served by `GET /api/{username}/lights`
+   */
+  oatpp::String getHueDevicesJson();
+
+  /**
+   * Same object as getHueDevicesJson(), rendered incrementally from the current snapshot.
+   * @param offset - devices to skip
+   * @param limit - devices to render at most
+   * @return - HueDevicesJsonCursor
+   */
+  HueDevicesJsonCursor getHueDevicesJsonCursor(v_uint32 offset = 0, v_uint32 limit = (v_uint32) -1);
+
+  /**
+   * Create a group.
+   * @param name - name of the group
+   * @param hueDeviceIds - HueDeviceIds of the members
+   * @param pending - if given, return without waiting for the journal, see PendingWrite
+   * @return - id of the new group, never 0
+   * @throws - `std::runtime_error` if one of the devices doesn't exist
+   */
+  v_int32 createGroup(const oatpp::String& name, const std::vector<v_int32>& hueDeviceIds, PendingWrite* pending = nullptr);
+
+  /**
+   * @param groupId - group id, `0` is the "all lights" group
+   * @return - the group or `nullptr` if there is no such group
+   */
+  oatpp::Object<HueGroupDto> getGroupById(v_int32 groupId);
+
+  /**
+   * All groups except group 0, keyed by group id - as served by `GET /api/{username}/groups`
+   */
+  oatpp::Fields<oatpp::Object<HueGroupDto>> getGroups();
+
+  /**
+   * Delete a group. Group 0 can't be deleted.
+   * @param groupId
+   * @param pending - if given, return without waiting for the journal, see PendingWrite
+   * @return - `false` if there is no such group
+   */
+  bool deleteGroup(v_int32 groupId, PendingWrite* pending = nullptr);
+
+  /**
+   * Apply one state change to every member of a group within a single write.
+   * @param groupId - group id, `0` applies the state to all lights
+   * @param hueDeviceStateDto - state to apply
+   * @return - the group's action after the change or `nullptr` if there is no such group
+   */
+  oatpp::Object<HueDeviceStateDto> updateGroupState(v_int32 groupId, const oatpp::Object<HueDeviceStateDto>& hueDeviceStateDto);
+
+  /**
+   * Same as above for a parsed state change.
+   * @param groupId - group id, `0` applies the state to all lights
+   * @param update - requested attributes, i.E. parsed by HueStateParser
+   * @param action - out: the group's action after the change
+   * @param pending - if given, return without waiting for the journal, see PendingWrite
+   * @return - `false` if there is no such group
+   */
+  bool updateGroupState(v_int32 groupId, const HueStateUpdate& update, HueDevice& action, PendingWrite* pending = nullptr);
+
+  /**
+   * Walk the packed records of the current snapshot in slot order.
+   * The snapshot stays alive and unchanged during the walk. These are the committed records, the StateOverlay is not applied.
+   * @param callback - called with `const HueDevice&` for every device
+   */
+  template<class Callback>
+  void forEachHueDevice(const Callback& callback) const {
+    auto snapshot = loadSnapshot();
+    for (v_uint32 i = 0; i < snapshot->slotsCount; i += PAGE_SIZE) {
+      const Page& page = *snapshot->pages[i / PAGE_SIZE];
+      v_uint32 count = snapshot->slotsCount - i;
+      if (count > PAGE_SIZE) {
+        count = PAGE_SIZE;
+      }
+      for (v_uint32 offset = 0; offset < count; offset++) {
+        if (page.hueDevices[offset].flags & HueDevice::FLAG_IN_USE) {
+          callback(page.hueDevices[offset]);
+        }
+      }
+    }
+  }
+
+  /**
+   * @return - number of devices
+   */
+  v_uint32 getHueDevicesCount() const;
+
+  /**
+   * Record the time writers wait for and hold the write lock.
+   * Call before the Database is shared between threads.
+   * @param metrics
+   */
+  void setMetrics(const std::shared_ptr<Metrics>& metrics);
+
+  /**
+   * Report the state of the overlay instead of the committed records, and tell it about transitions.
+   * Call before the Database is shared between threads.
+   * @param overlay - i.E. TransitionEngine
+   */
+  void setStateOverlay(const std::shared_ptr<StateOverlay>& overlay);
+
+  /**
+   * Add a listener told about every committed device change.
+   * The Database doesn't own its listeners - a listener is dropped once it is destroyed.
+   * @param listener
+   */
+  void addChangeListener(const std::shared_ptr<ChangeListener>& listener);
+
+  /**
+   * Version of the currently published snapshot. Increases with every committed write.
+   * @return - snapshot version
+   */
+  v_uint64 getVersion() const;
+
 };
 
 #endif /* Database_hpp */
@@ -0,0 +1,404 @@
+#include "Journal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+constexpr v_uint8 Journal::RECORD_DEVICE;
+constexpr v_uint8 Journal::RECORD_GROUP;
+constexpr v_uint8 Journal::RECORD_NAME;
+constexpr size_t Journal::MAX_FAILURES;
+
+namespace {
+
+const char* const TAG = "Journal";
+const v_uint32 HEADER_SIZE = 8; // size + crc32
+const v_uint16 NULL_STRING = 0xFFFF;
+
+struct Crc32Table {
+  v_uint32 values[256];
+  Crc32Table() {
+    for (v_uint32 i = 0; i < 256; i++) {
+      v_uint32 value = i;
+      for (v_int32 bit = 0; bit < 8; bit++) {
+        value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+      }
+      values[i] = value;
+    }
+  }
+};
+
+const Crc32Table CRC32_TABLE;
+
+template<typename T>
+void put(std::string& buffer, const T& value) {
+  buffer.append((const char*) &value, sizeof(T));
+}
+
+/**
+ *  Bounds checked reads from a record's payload.
+ */
+class PayloadReader {
+private:
+  const char* m_data;
+  v_buff_size m_size;
+  v_buff_size m_position;
+public:
+
+  PayloadReader(const char* data, v_buff_size size)
+    : m_data(data)
+    , m_size(size)
+    , m_position(0)
+  {}
+
+  template<typename T>
+  bool get(T& value) {
+    if (m_size - m_position < (v_buff_size) sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, m_data + m_position, sizeof(T));
+    m_position += sizeof(T);
+    return true;
+  }
+
+  bool getString(oatpp::String& str) {
+    v_uint16 size;
+    if (!get(size)) {
+      return false;
+    }
+    if (size == NULL_STRING) {
+      str = nullptr;
+      return true;
+    }
+    if (m_size - m_position < size) {
+      return false;
+    }
+    str = oatpp::String(m_data + m_position, size);
+    m_position += size;
+    return true;
+  }
+
+  bool isEnd() const {
+    return m_position == m_size;
+  }
+
+};
+
+}
+
+v_uint32 Journal::crc32(const char* data, v_buff_size size, v_uint32 crc) {
+  crc = ~crc;
+  for (v_buff_size i = 0; i < size; i++) {
+    crc = CRC32_TABLE.values[(crc ^ (v_uint8) data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+bool Journal::writeFully(int fd, const char* data, v_buff_size size) {
+  while (size > 0) {
+    ssize_t written = ::write(fd, data, (size_t) size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool Journal::syncFile(int fd) {
+#if defined(__APPLE__)
+  return ::fsync(fd) == 0;
+#else
+  return ::fdatasync(fd) == 0;
+#endif
+}
+
+int Journal::openFile(const std::string& path) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Can't open journal '" + path + "': " + std::strerror(errno));
+  }
+  return fd;
+}
+
+Journal::Journal(const std::string& path, bool sync)
+  : m_sync(sync)
+  , m_written(0)
+  , m_appended(0)
+  , m_durable(0)
+  , m_running(true)
+  , m_failing(false)
+  , m_size(0)
+  , m_commits(0)
+  , m_syncs(0)
+  , m_bytes(0)
+{
+  m_file.fd = openFile(path);
+  m_file.size = (v_int64) ::lseek(m_file.fd, 0, SEEK_END);
+  m_file.failed = false;
+  m_size = m_file.size;
+  m_flusher = std::thread(&Journal::run, this);
+}
+
+Journal::~Journal() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_appendedCondition.notify_one();
+  m_flusher.join();
+  ::close(m_file.fd);
+}
+
+void Journal::run() {
+  std::string batch;
+  std::vector<Rotation> rotations;
+  while (true) {
+    v_uint64 sequence;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_appendedCondition.wait(lock, [this] { return !m_buffer.empty() || !m_rotations.empty() || !m_running; });
+      if (m_buffer.empty() && m_rotations.empty()) {
+        return; // stopped and everything written
+      }
+      // appends and rotations continue into the emptied members while these are written
+      batch.swap(m_buffer);
+      rotations.swap(m_rotations);
+      sequence = m_appended;
+    }
+
+    for (Rotation& rotation : rotations) {
+      write(rotation.tail, rotation.sequence);
+      ::close(m_file.fd);
+      m_file.fd = rotation.fd;
+      m_file.size = 0;
+      m_file.failed = false;
+      m_failing = false;
+    }
+    rotations.clear();
+    write(batch, sequence);
+    batch.clear();
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_durable = sequence;
+    }
+    m_durableCondition.notify_all();
+  }
+}
+
+void Journal::write(const std::string& batch, v_uint64 sequence) {
+
+  if (sequence == m_written) {
+    return; // nothing was appended
+  }
+
+  bool success = !m_file.failed;
+  if (success) {
+    success = writeFully(m_file.fd, batch.data(), (v_buff_size) batch.size());
+    if (success && m_sync) {
+      success = syncFile(m_file.fd);
+      m_syncs++;
+    }
+    if (success) {
+      m_file.size += (v_int64) batch.size();
+      m_bytes += (v_int64) batch.size();
+    } else {
+      OATPP_LOGE(TAG, "Writing the journal failed, no more writes go to this file: %s", std::strerror(errno));
+      // replay stops at a torn record - cut it off, so the file ends with the last good batch
+      if (::ftruncate(m_file.fd, m_file.size) != 0) {
+        OATPP_LOGE(TAG, "Truncating the journal failed: %s", std::strerror(errno));
+      }
+      m_file.failed = true;
+      m_failing = true;
+    }
+  }
+
+  if (!success) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_failures.empty() && m_failures.back().to == m_written) {
+      m_failures.back().to = sequence;
+    } else {
+      if (m_failures.size() == MAX_FAILURES) {
+        m_failures.erase(m_failures.begin());
+      }
+      m_failures.push_back({m_written + 1, sequence});
+    }
+  }
+  m_written = sequence;
+
+}
+
+bool Journal::isFailed(v_uint64 sequence) const {
+  for (const Failure& failure : m_failures) {
+    if (sequence >= failure.from && sequence <= failure.to) {
+      return true;
+    }
+  }
+  return false;
+}
+
+v_uint64 Journal::append(const std::string& records) {
+  v_uint64 sequence;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffer.append(records);
+    sequence = ++m_appended;
+  }
+  m_size += (v_int64) records.size();
+  m_commits++;
+  m_appendedCondition.notify_one();
+  return sequence;
+}
+
+bool Journal::waitDurable(v_uint64 sequence) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_sync) {
+    m_durableCondition.wait(lock, [this, sequence] { return m_durable >= sequence; });
+  }
+  // without sync only a failure the flusher ran into already is reported
+  return !isFailed(sequence);
+}
+
+bool Journal::pollDurable(v_uint64 sequence, bool& durable) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_sync && m_durable < sequence) {
+    return false;
+  }
+  durable = !isFailed(sequence);
+  return true;
+}
+
+void Journal::rotate(int fd) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rotations.push_back({std::string(), m_appended, fd});
+    m_rotations.back().tail.swap(m_buffer);
+  }
+  m_size = 0;
+  m_appendedCondition.notify_one();
+}
+
+Journal::Stats Journal::getStats() const {
+  Stats stats;
+  stats.commits = m_commits.load();
+  stats.syncs = m_syncs.load();
+  stats.bytes = m_bytes.load();
+  return stats;
+}
+
+size_t Journal::beginRecord(std::string& buffer, v_uint8 type) {
+  size_t start = buffer.size();
+  buffer.append(HEADER_SIZE, '\0'); // filled by endRecord()
+  put(buffer, type);
+  return start;
+}
+
+void Journal::endRecord(std::string& buffer, size_t start) {
+  v_uint32 size = (v_uint32) (buffer.size() - start - HEADER_SIZE);
+  v_uint32 crc = crc32(&buffer[start + HEADER_SIZE], size);
+  std::memcpy(&buffer[start], &size, sizeof(size));
+  std::memcpy(&buffer[start + sizeof(size)], &crc, sizeof(crc));
+}
+
+void Journal::writeString(std::string& buffer, const oatpp::String& str) {
+  if (!str) {
+    put(buffer, NULL_STRING);
+    return;
+  }
+  v_uint16 size = (v_uint16) std::min<size_t>(str->size(), NULL_STRING - 1);
+  put(buffer, size);
+  buffer.append(str->data(), size);
+}
+
+void Journal::writeDevice(std::string& buffer, const HueDevice& hueDevice, const oatpp::String& name) {
+  size_t start = beginRecord(buffer, RECORD_DEVICE);
+  put(buffer, hueDevice);
+  writeString(buffer, name);
+  endRecord(buffer, start);
+}
+
+void Journal::writeGroup(std::string& buffer, v_int32 groupId, const HueGroup* group) {
+  size_t start = beginRecord(buffer, RECORD_GROUP);
+  put(buffer, groupId);
+  put(buffer, (v_uint8) (group != nullptr ? 1 : 0));
+  if (group != nullptr) {
+    put(buffer, group->action);
+    writeString(buffer, group->name);
+    put(buffer, (v_uint32) group->members.size());
+    buffer.append((const char*) group->members.data(), group->members.size() * sizeof(v_uint64));
+  }
+  endRecord(buffer, start);
+}
+
+void Journal::writeName(std::string& buffer, v_uint32 slot, const oatpp::String& name) {
+  size_t start = beginRecord(buffer, RECORD_NAME);
+  put(buffer, slot);
+  writeString(buffer, name);
+  endRecord(buffer, start);
+}
+
+bool Journal::Reader::next(Record& record) {
+
+  v_uint32 size;
+  v_uint32 crc;
+  if (m_size - m_position < HEADER_SIZE) {
+    return false;
+  }
+  std::memcpy(&size, m_data + m_position, sizeof(size));
+  std::memcpy(&crc, m_data + m_position + sizeof(size), sizeof(crc));
+  const char* payload = m_data + m_position + HEADER_SIZE;
+  if (size == 0 || m_size - m_position - HEADER_SIZE < size || crc32(payload, size) != crc) {
+    return false;
+  }
+
+  PayloadReader reader(payload, size);
+  record = Record();
+  bool success = reader.get(record.type);
+  switch (record.type) {
+
+    case RECORD_DEVICE:
+      success = success && reader.get(record.hueDevice) && reader.getString(record.name);
+      break;
+
+    case RECORD_GROUP: {
+      v_uint8 exists = 0;
+      success = success && reader.get(record.groupId) && reader.get(exists);
+      if (success && exists) {
+        record.group = std::make_shared<HueGroup>();
+        record.group->id = record.groupId;
+        v_uint32 wordsCount = 0;
+        success = reader.get(record.group->action) && reader.getString(record.group->name) && reader.get(wordsCount);
+        for (v_uint32 i = 0; success && i < wordsCount; i++) {
+          v_uint64 word;
+          success = reader.get(word);
+          record.group->members.push_back(word);
+        }
+      }
+      break;
+    }
+
+    case RECORD_NAME:
+      success = success && reader.get(record.slot) && reader.getString(record.name);
+      break;
+
+    default:
+      success = false;
+
+  }
+
+  if (!success || !reader.isEnd()) {
+    return false;
+  }
+  m_position += HEADER_SIZE + size;
+  return true;
+
+}
@@ -0,0 +1,252 @@
+#ifndef db_Journal_hpp
+#define db_Journal_hpp
+
+#include "db/model/HueDevice.hpp"
+#include "db/model/HueGroup.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ *  Append-only file of the changes committed by the Database.
+ *
+ *  Writers append the records of a write to an in-memory buffer and get a sequence number back.
+ *  A single flusher thread writes the buffer to the file and syncs it. Everything appended while
+ *  a sync is running goes out with the next one, so a burst of writes costs one fsync (group commit).
+ *
+ *  A record is `v_uint32 size | v_uint32 crc32 | v_uint8 type | payload`, in host byte order.
+ *  Records hold the full new state of a device or group, so replaying them in order rebuilds the table.
+ *  A torn or corrupt record ends the journal - it was never acknowledged as durable.
+ *
+ *  A batch which fails to write or sync is cut off the file again, and nothing more is written to that file:
+ *  every write appended to it from the failed batch on is reported as failed by waitDurable(),
+ *  until the journal is rotated to a new file.
+ */
+class Journal {
+public:
+  static constexpr v_uint8 RECORD_DEVICE = 1; ///< HueDevice + name. A device without HueDevice::FLAG_IN_USE was deleted.
+  static constexpr v_uint8 RECORD_GROUP = 2; ///< group id + action + name + members, or just the id of a deleted group
+  static constexpr v_uint8 RECORD_NAME = 3; ///< slot + name, used by snapshot files next to the raw HueDevice records
+public:
+
+  /**
+   *  A decoded record.
+   */
+  struct Record {
+    v_uint8 type = 0;
+    HueDevice hueDevice; ///< RECORD_DEVICE
+    oatpp::String name; ///< RECORD_DEVICE, RECORD_NAME
+    v_uint32 slot = 0; ///< RECORD_NAME
+    v_int32 groupId = 0; ///< RECORD_GROUP
+    std::shared_ptr<HueGroup> group; ///< RECORD_GROUP, `nullptr` if the group was deleted
+  };
+
+  /**
+   *  Decodes records from memory, i.E. a journal read from disk or a mapped snapshot.
+   */
+  class Reader {
+  private:
+    const char* m_data;
+    v_buff_size m_size;
+    v_buff_size m_position;
+  public:
+
+    Reader(const char* data, v_buff_size size)
+      : m_data(data)
+      , m_size(size)
+      , m_position(0)
+    {}
+
+    /**
+     * Decode the next record.
+     * @param record - out
+     * @return - `false` at the end of the data or at a torn or corrupt record
+     */
+    bool next(Record& record);
+
+    /**
+     * @return - end of the last good record
+     */
+    v_buff_size getPosition() const {
+      return m_position;
+    }
+
+  };
+
+  struct Stats {
+    v_int64 commits; ///< writes appended
+    v_int64 syncs; ///< fsyncs of the file - `commits / syncs` is the group commit ratio
+    v_int64 bytes; ///< bytes written to disk
+  };
+
+private:
+
+  /**
+   *  File written by the flusher.
+   */
+  struct File {
+    int fd;
+    v_int64 size; ///< end of the last batch written completely, a failed batch is cut back to it
+    bool failed; ///< a batch failed, nothing more is written to the file
+  };
+
+  /**
+   *  Switch to another file, queued by rotate() for the flusher.
+   */
+  struct Rotation {
+    std::string tail; ///< appended before the rotation, still to be written to the old file
+    v_uint64 sequence; ///< sequence of the last write in `tail`
+    int fd; ///< the new file
+  };
+
+  /**
+   *  Sequences of failed writes, `from` to `to` inclusive.
+   */
+  struct Failure {
+    v_uint64 from;
+    v_uint64 to;
+  };
+
+private:
+  static constexpr size_t MAX_FAILURES = 16; ///< failed ranges kept for waitDurable(), one per failed file at most
+private:
+  const bool m_sync;
+  File m_file; ///< used by the flusher only
+  v_uint64 m_written; ///< last sequence handed to a file, used by the flusher only
+  std::mutex m_mutex;
+  std::condition_variable m_appendedCondition;
+  std::condition_variable m_durableCondition;
+  std::string m_buffer; ///< appended but not written yet, guarded by m_mutex
+  std::vector<Rotation> m_rotations; ///< guarded by m_mutex
+  v_uint64 m_appended; ///< guarded by m_mutex
+  v_uint64 m_durable; ///< guarded by m_mutex
+  std::vector<Failure> m_failures; ///< guarded by m_mutex
+  bool m_running; ///< guarded by m_mutex
+  std::atomic<bool> m_failing; ///< the current file failed
+  std::atomic<v_int64> m_size; ///< bytes of the current file, including the buffer
+  std::atomic<v_int64> m_commits;
+  std::atomic<v_int64> m_syncs;
+  std::atomic<v_int64> m_bytes;
+  std::thread m_flusher;
+private:
+  static size_t beginRecord(std::string& buffer, v_uint8 type);
+  static void endRecord(std::string& buffer, size_t start);
+  static void writeString(std::string& buffer, const oatpp::String& str);
+  void run();
+  void write(const std::string& batch, v_uint64 sequence); // called by the flusher
+  bool isFailed(v_uint64 sequence) const; // call with m_mutex held
+public:
+
+  /**
+   * Constructor. Opens the file for appending and starts the flusher.
+   * @param path
+   * @param sync - fsync every batch. Without it writes survive a crash of the hub but not of the machine.
+   * @throws - `std::runtime_error` if the file can't be opened
+   */
+  Journal(const std::string& path, bool sync);
+
+  /**
+   * Writes what is still buffered, stops the flusher and closes the file.
+   */
+  ~Journal();
+
+  /**
+   * Append the records of one write.
+   * @param records - written by writeDevice() and writeGroup()
+   * @return - sequence number to wait for with waitDurable()
+   */
+  v_uint64 append(const std::string& records);
+
+  /**
+   * Block until everything up to `sequence` was synced. Returns right away if the journal doesn't sync.
+   * @param sequence - returned by append()
+   * @return - `false` if the write didn't make it to the file
+   */
+  bool waitDurable(v_uint64 sequence);
+
+  /**
+   * waitDurable() without blocking, for coroutines.
+   * @param sequence - returned by append()
+   * @param durable - out: `false` if the write didn't make it to the file. Set once the write is done.
+   * @return - `false` while the write is still on its way to the file
+   */
+  bool pollDurable(v_uint64 sequence, bool& durable);
+
+  /**
+   * Open a file to append to, for the constructor or rotate().
+   * @param path
+   * @return - file descriptor
+   * @throws - `std::runtime_error` if the file can't be opened
+   */
+  static int openFile(const std::string& path);
+
+  /**
+   * Continue in another file. Only hands the file to the flusher, which writes and syncs
+   * what was appended before to the old file, closes it, and goes on in the new one.
+   * Cheap enough to be called with the Database write lock held.
+   * @param fd - opened by openFile(), owned by the journal from now on
+   */
+  void rotate(int fd);
+
+  bool isSync() const {
+    return m_sync;
+  }
+
+  /**
+   * @return - `true` if a batch failed in the current file. Writes fail until the journal is rotated.
+   */
+  bool isFailing() const {
+    return m_failing.load();
+  }
+
+  /**
+   * @return - size of the current file plus what is buffered for it
+   */
+  v_int64 getSize() const {
+    return m_size.load();
+  }
+
+  Stats getStats() const;
+
+public:
+
+  /**
+   * Append the record of a device's new state.
+   * @param buffer
+   * @param hueDevice
+   * @param name - name of the device, may be `nullptr`
+   */
+  static void writeDevice(std::string& buffer, const HueDevice& hueDevice, const oatpp::String& name);
+
+  /**
+   * Append the record of a group's new state.
+   * @param buffer
+   * @param groupId
+   * @param group - `nullptr` if the group was deleted
+   */
+  static void writeGroup(std::string& buffer, v_int32 groupId, const HueGroup* group);
+
+  static void writeName(std::string& buffer, v_uint32 slot, const oatpp::String& name);
+
+  static v_uint32 crc32(const char* data, v_buff_size size, v_uint32 crc = 0);
+
+  /**
+   * `write()` all of `data`, retrying on interrupts and partial writes.
+   * @return - `false` on error
+   */
+  static bool writeFully(int fd, const char* data, v_buff_size size);
+
+  /**
+   * Flush the file's data to the disk.
+   * @return - `false` on error
+   */
+  static bool syncFile(int fd);
+
+};
+
+#endif /* db_Journal_hpp */
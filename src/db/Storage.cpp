@@ -0,0 +1,422 @@
+#include "Storage.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const TAG = "Storage";
+const char SNAPSHOT_MAGIC[8] = {'H', 'U', 'E', 'S', 'N', 'A', 'P', '1'};
+const char* const JOURNAL_PREFIX = "journal.";
+
+/**
+ *  First bytes of a snapshot file, followed by `slotsCount` HueDevice records and `recordsSize` bytes of Journal records.
+ */
+struct SnapshotHeader {
+  char magic[8];
+  v_uint32 slotsCount;
+  v_uint32 journalNumber; ///< first journal not contained in the snapshot
+  v_uint64 recordsSize;
+  v_uint32 crc; ///< crc32 of everything after the header
+  v_uint32 reserved;
+};
+
+/**
+ *  Read-only mapping of a file, unmapped when it goes out of scope.
+ */
+class MappedFile {
+private:
+  void* m_data;
+  size_t m_size;
+public:
+
+  MappedFile(int fd, size_t size)
+    : m_data(::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0))
+    , m_size(size)
+  {}
+
+  ~MappedFile() {
+    if (m_data != MAP_FAILED) {
+      ::munmap(m_data, m_size);
+    }
+  }
+
+  const char* getData() const {
+    return m_data == MAP_FAILED ? nullptr : (const char*) m_data;
+  }
+
+};
+
+std::runtime_error error(const std::string& what, const std::string& path) {
+  return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+}
+
+Storage::Storage(const std::shared_ptr<Database>& database, const Config& config)
+  : m_config(config)
+  , m_database(database)
+  , m_journalNumber(0)
+  , m_loadMicros(0)
+  , m_snapshotDevices(0)
+  , m_journalRecords(0)
+  , m_compactions(0)
+  , m_stopped(false)
+{
+  load();
+  m_compactor = std::thread(&Storage::run, this);
+}
+
+Storage::~Storage() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_condition.notify_one();
+  m_compactor.join();
+  std::lock_guard<oatpp::concurrency::SpinLock> lock(m_database->m_writeLock);
+  m_database->m_journal = nullptr;
+}
+
+std::string Storage::getSnapshotPath() const {
+  return m_config.directory + "/snapshot";
+}
+
+std::string Storage::getJournalPath(v_uint32 number) const {
+  return m_config.directory + "/" + JOURNAL_PREFIX + std::to_string(number);
+}
+
+std::vector<v_uint32> Storage::listJournals() const {
+  std::vector<v_uint32> numbers;
+  DIR* dir = ::opendir(m_config.directory.c_str());
+  if (dir == nullptr) {
+    throw error("Can't list", m_config.directory);
+  }
+  size_t prefixSize = std::strlen(JOURNAL_PREFIX);
+  while (struct dirent* entry = ::readdir(dir)) {
+    if (std::strncmp(entry->d_name, JOURNAL_PREFIX, prefixSize) == 0) {
+      char* end;
+      unsigned long number = std::strtoul(entry->d_name + prefixSize, &end, 10);
+      if (*end == '\0' && end != entry->d_name + prefixSize) {
+        numbers.push_back((v_uint32) number);
+      }
+    }
+  }
+  ::closedir(dir);
+  std::sort(numbers.begin(), numbers.end());
+  return numbers;
+}
+
+void Storage::load() {
+
+  auto start = std::chrono::steady_clock::now();
+
+  if (::mkdir(m_config.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw error("Can't create data directory", m_config.directory);
+  }
+
+  Database& db = *m_database;
+  std::lock_guard<oatpp::concurrency::SpinLock> lock(db.m_writeLock);
+  if (db.m_snapshot->slotsCount != 0) {
+    throw std::runtime_error("Storage has to be opened on an empty Database");
+  }
+
+  auto next = db.beginWrite();
+  v_uint32 journalNumber = 0;
+  loadSnapshot(*next, journalNumber);
+
+  for (v_uint32 number : listJournals()) {
+    if (number < journalNumber) {
+      ::unlink(getJournalPath(number).c_str()); // contained in the snapshot, left behind by an interrupted compaction
+      continue;
+    }
+    replayJournal(*next, number);
+    journalNumber = number + 1;
+  }
+
+  // what isn't stored is derived from the records
+  db.m_freeSlots.clear();
+  Database::Slot slot;
+  for (v_uint32 index = 0; index < next->slotsCount; index++) {
+    if (Database::getSlot(*next, index, slot)) {
+      db.renderJson(slot);
+    } else {
+      db.m_freeSlots.push_back(index);
+    }
+  }
+
+  // new writes go to a fresh journal, a torn record at the end of the last one stays behind it
+  m_journalNumber = journalNumber;
+  m_journal = std::make_shared<Journal>(getJournalPath(journalNumber), m_config.sync);
+  db.commitWrite(next);
+  db.m_journal = m_journal;
+
+  m_loadMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+}
+
+bool Storage::loadSnapshot(Database::Snapshot& next, v_uint32& journalNumber) {
+
+  std::string path = getSnapshotPath();
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    throw error("Can't open snapshot", path);
+  }
+  struct stat info;
+  bool statted = ::fstat(fd, &info) == 0;
+  size_t size = statted ? (size_t) info.st_size : 0;
+  MappedFile file(fd, size);
+  ::close(fd);
+  if (size < sizeof(SnapshotHeader) || file.getData() == nullptr) {
+    throw std::runtime_error("Can't read snapshot '" + path + "'");
+  }
+
+  SnapshotHeader header;
+  std::memcpy(&header, file.getData(), sizeof(header));
+  v_uint64 devicesSize = (v_uint64) header.slotsCount * sizeof(HueDevice);
+  const char* devices = file.getData() + sizeof(header);
+  if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+      header.slotsCount > Database::SLOT_MASK + 1 ||
+      size != sizeof(header) + devicesSize + header.recordsSize ||
+      Journal::crc32(devices, (v_buff_size) (devicesSize + header.recordsSize)) != header.crc) {
+    throw std::runtime_error("Corrupt snapshot '" + path + "'");
+  }
+
+  // the records are laid out as in memory - copy them a page at a time
+  next.slotsCount = header.slotsCount;
+  m_database->m_idsByUniqueId.reserve(header.slotsCount);
+  for (v_uint32 index = 0; index < header.slotsCount; index += Database::PAGE_SIZE) {
+    auto page = std::make_shared<Database::Page>();
+    v_uint32 count = std::min(header.slotsCount - index, Database::PAGE_SIZE);
+    std::memcpy(page->hueDevices, devices + (size_t) index * sizeof(HueDevice), count * sizeof(HueDevice));
+    for (v_uint32 offset = 0; offset < count; offset++) {
+      if (page->hueDevices[offset].flags & HueDevice::FLAG_IN_USE) {
+        m_snapshotDevices++;
+      }
+    }
+    next.pages.push_back(page);
+  }
+
+  Journal::Reader reader(devices + devicesSize, (v_buff_size) header.recordsSize);
+  Journal::Record record;
+  while (reader.next(record)) {
+    apply(next, record);
+  }
+  if ((v_uint64) reader.getPosition() != header.recordsSize) {
+    throw std::runtime_error("Corrupt snapshot '" + path + "'");
+  }
+
+  journalNumber = header.journalNumber;
+  return true;
+
+}
+
+void Storage::replayJournal(Database::Snapshot& next, v_uint32 number) {
+
+  std::string path = getJournalPath(number);
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw error("Can't open journal", path);
+  }
+  std::string content;
+  char buffer[64 * 1024];
+  ssize_t size;
+  while ((size = ::read(fd, buffer, sizeof(buffer))) != 0) {
+    if (size < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      throw error("Can't read journal", path);
+    }
+    content.append(buffer, (size_t) size);
+  }
+  ::close(fd);
+
+  Journal::Reader reader(content.data(), (v_buff_size) content.size());
+  Journal::Record record;
+  while (reader.next(record)) {
+    apply(next, record);
+    m_journalRecords++;
+  }
+  if ((size_t) reader.getPosition() != content.size()) {
+    OATPP_LOGW(TAG, "Journal '%s' ends with a torn record, ignoring the last %lld bytes",
+               path.c_str(), (long long) (content.size() - reader.getPosition()));
+  }
+
+}
+
+void Storage::apply(Database::Snapshot& next, const Journal::Record& record) {
+
+  Database& db = *m_database;
+
+  switch (record.type) {
+
+    case Journal::RECORD_DEVICE:
+    case Journal::RECORD_NAME: {
+      v_uint32 index = record.type == Journal::RECORD_DEVICE ? Database::slotOf(record.hueDevice.id) : record.slot;
+      if (index > Database::SLOT_MASK) {
+        return;
+      }
+      if (index >= next.slotsCount) {
+        next.slotsCount = index + 1;
+        while (next.pages.size() * Database::PAGE_SIZE < next.slotsCount) {
+          next.pages.push_back(std::make_shared<Database::Page>());
+        }
+      }
+      auto slot = Database::editSlot(next, index);
+      if (record.type == Journal::RECORD_DEVICE) {
+        slot.page->hueDevices[slot.offset] = record.hueDevice;
+      }
+      const Database::DeviceInfo& info = slot.page->getInfo(slot.offset);
+      if (slot.page->hueDevices[slot.offset].flags & HueDevice::FLAG_IN_USE) {
+        if (!info.uniqueid || info.name != record.name) {
+          db.setInfo(slot, record.name);
+        }
+      } else if (info.uniqueid) {
+        db.m_idsByUniqueId.erase(*info.uniqueid);
+        slot.page->editInfo(slot.offset) = Database::DeviceInfo();
+      }
+      break;
+    }
+
+    case Journal::RECORD_GROUP:
+      if (record.groupId < 0) {
+        return;
+      }
+      if ((size_t) record.groupId >= next.groups.size()) {
+        next.groups.resize(record.groupId + 1);
+      }
+      next.groups[record.groupId] = record.group;
+      break;
+
+    default:
+      break;
+
+  }
+
+}
+
+void Storage::writeSnapshot(const Database::Snapshot& snapshot, v_uint32 journalNumber) {
+
+  std::string records;
+  Database::Slot slot;
+  for (v_uint32 index = 0; index < snapshot.slotsCount; index++) {
+    if (Database::getSlot(snapshot, index, slot)) {
+      Journal::writeName(records, index, slot.page->getInfo(slot.offset).name);
+    }
+  }
+  for (auto& group : snapshot.groups) {
+    if (group) {
+      Journal::writeGroup(records, group->id, group.get());
+    }
+  }
+
+  SnapshotHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.slotsCount = snapshot.slotsCount;
+  header.journalNumber = journalNumber;
+  header.recordsSize = records.size();
+  for (v_uint32 index = 0; index < snapshot.slotsCount; index += Database::PAGE_SIZE) {
+    v_uint32 count = std::min(snapshot.slotsCount - index, Database::PAGE_SIZE);
+    header.crc = Journal::crc32((const char*) snapshot.pages[index / Database::PAGE_SIZE]->hueDevices,
+                                count * sizeof(HueDevice), header.crc);
+  }
+  header.crc = Journal::crc32(records.data(), (v_buff_size) records.size(), header.crc);
+
+  std::string path = getSnapshotPath();
+  std::string tmpPath = path + ".tmp";
+  int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw error("Can't create snapshot", tmpPath);
+  }
+  bool success = Journal::writeFully(fd, (const char*) &header, sizeof(header));
+  for (v_uint32 index = 0; success && index < snapshot.slotsCount; index += Database::PAGE_SIZE) {
+    v_uint32 count = std::min(snapshot.slotsCount - index, Database::PAGE_SIZE);
+    success = Journal::writeFully(fd, (const char*) snapshot.pages[index / Database::PAGE_SIZE]->hueDevices,
+                                  count * sizeof(HueDevice));
+  }
+  success = success && Journal::writeFully(fd, records.data(), (v_buff_size) records.size()) && Journal::syncFile(fd);
+  ::close(fd);
+  if (!success || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    auto e = error("Can't write snapshot", tmpPath);
+    ::unlink(tmpPath.c_str());
+    throw e;
+  }
+
+  // make the rename durable before the journals it replaces are removed
+  int dir = ::open(m_config.directory.c_str(), O_RDONLY | O_CLOEXEC);
+  if (dir >= 0) {
+    ::fsync(dir);
+    ::close(dir);
+  }
+
+}
+
+void Storage::compact() {
+
+  std::lock_guard<std::mutex> compactLock(m_compactMutex);
+
+  v_uint32 journalNumber = m_journalNumber + 1;
+  int fd = Journal::openFile(getJournalPath(journalNumber));
+  std::shared_ptr<const Database::Snapshot> snapshot;
+  {
+    // no write can commit between switching the journal and taking the table.
+    // Only the file is switched here, the old one is written and synced by the journal's flusher - outside of the lock
+    std::lock_guard<oatpp::concurrency::SpinLock> lock(m_database->m_writeLock);
+    m_journal->rotate(fd);
+    snapshot = m_database->m_snapshot;
+  }
+  m_journalNumber = journalNumber;
+
+  writeSnapshot(*snapshot, journalNumber);
+
+  for (v_uint32 number : listJournals()) {
+    if (number < journalNumber) {
+      ::unlink(getJournalPath(number).c_str());
+    }
+  }
+  m_compactions++;
+
+}
+
+void Storage::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stopped) {
+    m_condition.wait_for(lock, std::chrono::seconds(1));
+    // a failed journal takes no more writes - the snapshot saves what it lost, the next journal starts clean
+    if (!m_stopped && (m_journal->getSize() >= m_config.compactBytes || m_journal->isFailing())) {
+      lock.unlock();
+      try {
+        compact();
+      } catch (const std::exception& e) {
+        OATPP_LOGE(TAG, "Compaction failed: %s", e.what());
+      }
+      lock.lock();
+    }
+  }
+}
+
+Storage::Stats Storage::getStats() const {
+  Stats stats;
+  stats.loadMicros = m_loadMicros;
+  stats.snapshotDevices = m_snapshotDevices;
+  stats.journalRecords = m_journalRecords;
+  stats.compactions = m_compactions.load();
+  stats.journal = m_journal->getStats();
+  return stats;
+}
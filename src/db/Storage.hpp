@@ -0,0 +1,96 @@
+#ifndef db_Storage_hpp
+#define db_Storage_hpp
+
+#include "Database.hpp"
+#include "Journal.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ *  Keeps the devices and groups of a Database on disk, so names and states survive a restart of the hub.
+ *
+ *  <directory>/snapshot     - the device table at some point: raw HueDevice records as laid out in memory,
+ *                             followed by names and groups encoded as Journal records
+ *  <directory>/journal.<n>  - changes committed after the snapshot, replayed in order of <n> on open
+ *
+ *  The snapshot is memory-mapped on open and its records are copied into the pages page-wise,
+ *  then the journals are replayed on top. A compactor thread rotates the journal once it grew past
+ *  Config::compactBytes - or failed to write - writes the table of the moment of the rotation as the new snapshot
+ *  and removes the journals the snapshot contains.
+ *
+ *  Files are written in host byte order - they are not meant to be moved to another machine.
+ */
+class Storage {
+public:
+
+  struct Config {
+    std::string directory; ///< empty - in memory only
+    bool sync = true; ///< a write returns once its journal records were fsynced
+    v_int64 compactBytes = 4 * 1024 * 1024; ///< rotate the journal into a new snapshot once it is larger
+  };
+
+  struct Stats {
+    v_int64 loadMicros; ///< time taken by the constructor to restore the Database
+    v_int64 snapshotDevices; ///< devices restored from the snapshot
+    v_int64 journalRecords; ///< records replayed from journals
+    v_int64 compactions;
+    Journal::Stats journal;
+  };
+
+private:
+  const Config m_config;
+  std::shared_ptr<Database> m_database;
+  std::shared_ptr<Journal> m_journal;
+  v_uint32 m_journalNumber; ///< number of the current journal file, guarded by m_compactMutex
+  std::mutex m_compactMutex;
+  v_int64 m_loadMicros;
+  v_int64 m_snapshotDevices;
+  v_int64 m_journalRecords;
+  std::atomic<v_int64> m_compactions;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stopped; ///< guarded by m_mutex
+  std::thread m_compactor;
+private:
+  std::string getSnapshotPath() const;
+  std::string getJournalPath(v_uint32 number) const;
+  std::vector<v_uint32> listJournals() const;
+  void load();
+  bool loadSnapshot(Database::Snapshot& next, v_uint32& journalNumber);
+  void replayJournal(Database::Snapshot& next, v_uint32 number);
+  void apply(Database::Snapshot& next, const Journal::Record& record);
+  void writeSnapshot(const Database::Snapshot& snapshot, v_uint32 journalNumber);
+  void run();
+public:
+
+  /**
+   * Constructor. Restores the Database from the directory - creating it if needed - and attaches the journal to it.
+   * @param database - has to be empty
+   * @param config
+   * @throws - `std::runtime_error` if the directory can't be used or the snapshot is corrupt
+   */
+  Storage(const std::shared_ptr<Database>& database, const Config& config);
+
+  /**
+   * Detaches the journal from the Database and stops the compactor.
+   * The Database keeps working in memory.
+   */
+  ~Storage();
+
+  static std::shared_ptr<Storage> createShared(const std::shared_ptr<Database>& database, const Config& config) {
+    return std::make_shared<Storage>(database, config);
+  }
+
+  /**
+   * Fold the journal into a new snapshot now. Called by the compactor once the journal is larger than Config::compactBytes.
+   */
+  void compact();
+
+  Stats getStats() const;
+
+};
+
+#endif /* db_Storage_hpp */
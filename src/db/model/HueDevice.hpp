@@ -1,22 +1,98 @@
-
 #ifndef db_HueDevice_hpp
 #define db_HueDevice_hpp
 
 #include "oatpp/core/Types.hpp"
 
+#include <type_traits>
+
+/**
+ *  Colormode of a HueDevice. Stored as one byte, mapped to the Hue API strings at the DTO boundary.
+ */
+enum class HueColorMode : v_uint8 {
+  HS = 0,
+  XY = 1,
+  CT = 2
+};
+
 /**
  *  Object of HueDevice stored in the Demo-Database.
+ *  Packed, trivially copyable record (16 bytes) - the device name and other cold data live next to it in the Database.
+ *
+ *  The color is kept once, in the space of `mode`: `hue` and `sat` for "hs", `ct` for "ct", `x` and `y` for "xy".
+ *  `x` and `y` share the bytes of `hue` and `ct`, the coordinates of the other spaces are not kept - see ColorModel.
  */
 class HueDevice {
 public:
-  v_int32 id;
-  oatpp::String name;
-  oatpp::String mode;
-  oatpp::Boolean on = false;
-  oatpp::UInt8 bri = (v_uint8)0;
-  oatpp::UInt8 sat = (v_uint8)0;
-  oatpp::UInt16 hue = (v_uint16)0;
-  oatpp::UInt16 ct = (v_uint16)500;
+  static constexpr v_uint8 FLAG_ON = 1;
+  static constexpr v_uint8 FLAG_REACHABLE = 2;
+  static constexpr v_uint8 FLAG_IN_USE = 128; ///< set by the Database on occupied storage slots
+public:
+  v_int32 id = 0;
+  v_uint32 version = 0; ///< bumped on every change, tags the pre-rendered JSON of this device
+  union {
+    v_uint16 hue = 0;
+    v_uint16 x; ///< CIE x in 1/65535
+  };
+  union {
+    v_uint16 ct = 500; ///< mired
+    v_uint16 y; ///< CIE y in 1/65535
+  };
+  v_uint8 bri = 0;
+  v_uint8 sat = 0;
+  v_uint8 flags = FLAG_REACHABLE;
+  HueColorMode mode = HueColorMode::CT;
+public:
+
+  bool isOn() const {
+    return (flags & FLAG_ON) != 0;
+  }
+
+  void setOn(bool on) {
+    flags = (v_uint8) (on ? (flags | FLAG_ON) : (flags & ~FLAG_ON));
+  }
+
+  bool isReachable() const {
+    return (flags & FLAG_REACHABLE) != 0;
+  }
+
+  /**
+   * Hue API name of the colormode.
+   * @param mode
+   * @return - "hs", "xy" or "ct"
+   */
+  static const char* colorModeToString(HueColorMode mode) {
+    switch (mode) {
+      case HueColorMode::HS: return "hs";
+      case HueColorMode::XY: return "xy";
+      default: return "ct";
+    }
+  }
+
+  /**
+   * Parse Hue API colormode name. "hue" is accepted as an alias of "hs" since older versions of this hub reported it.
+   * @param str - colormode name
+   * @param mode - out: parsed mode
+   * @return - `false` if `str` is not a known colormode
+   */
+  static bool colorModeFromString(const oatpp::String& str, HueColorMode& mode) {
+    if (!str) {
+      return false;
+    }
+    if (str == "hs" || str == "hue") {
+      mode = HueColorMode::HS;
+    } else if (str == "xy") {
+      mode = HueColorMode::XY;
+    } else if (str == "ct") {
+      mode = HueColorMode::CT;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
 };
 
+static_assert(std::is_trivially_copyable<HueDevice>::value, "HueDevice has to stay trivially copyable");
+static_assert(sizeof(HueDevice) == 16, "HueDevice has to stay packed");
+
 #endif /* db_HueDevice_hpp */
@@ -0,0 +1,69 @@
+#ifndef db_HueGroup_hpp
+#define db_HueGroup_hpp
+
+#include "HueDevice.hpp"
+
+#include <vector>
+
+/**
+ *  Object of HueGroup stored in the Demo-Database.
+ *  Members are kept as a bitset over the Database's device slots, one bit per slot.
+ */
+class HueGroup {
+public:
+  v_int32 id = 0; ///< Hue group number, group 0 is "all lights"
+  oatpp::String name;
+  std::vector<v_uint64> members; ///< bit `slot % 64` of word `slot / 64` is set for member slots
+  HueDevice action; ///< last state applied to the whole group
+public:
+
+  bool hasMember(v_uint32 slot) const {
+    return slot / 64 < members.size() && (members[slot / 64] >> (slot % 64)) & 1;
+  }
+
+  void addMember(v_uint32 slot) {
+    if (slot / 64 >= members.size()) {
+      members.resize(slot / 64 + 1, 0);
+    }
+    members[slot / 64] |= (v_uint64) 1 << (slot % 64);
+  }
+
+  void removeMember(v_uint32 slot) {
+    if (slot / 64 < members.size()) {
+      members[slot / 64] &= ~((v_uint64) 1 << (slot % 64));
+    }
+  }
+
+  /**
+   * Call `callback(slot)` for every member slot in ascending order.
+   */
+  template<class Callback>
+  void forEachMember(const Callback& callback) const {
+    for (v_uint32 word = 0; word < members.size(); word++) {
+      v_uint64 bits = members[word];
+      while (bits != 0) {
+        v_uint32 bit = countTrailingZeros(bits);
+        callback(word * 64 + bit);
+        bits &= bits - 1;
+      }
+    }
+  }
+
+private:
+
+  static v_uint32 countTrailingZeros(v_uint64 bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (v_uint32) __builtin_ctzll(bits);
+#else
+    v_uint32 count = 0;
+    while ((bits & 1) == 0) {
+      bits >>= 1;
+      count++;
+    }
+    return count;
+#endif
+  }
+
+};
+
+#endif /* db_HueGroup_hpp */
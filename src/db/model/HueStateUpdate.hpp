@@ -0,0 +1,153 @@
+#ifndef db_HueStateUpdate_hpp
+#define db_HueStateUpdate_hpp
+
+#include "HueDevice.hpp"
+
+#include "color/ColorModel.hpp"
+#include "dto/HueDeviceDto.hpp"
+
+/**
+ *  A state change requested by `PUT .../lights/{hueId}/state` or `.../groups/{groupId}/action`.
+ *  Small and trivially copyable, so it can be parsed into on the stack - see HueStateParser.
+ *  Only the attributes flagged in `fields` were requested.
+ */
+class HueStateUpdate {
+public:
+  static constexpr v_uint8 FIELD_ON = 1;
+  static constexpr v_uint8 FIELD_BRI = 2;
+  static constexpr v_uint8 FIELD_HUE = 4;
+  static constexpr v_uint8 FIELD_SAT = 8;
+  static constexpr v_uint8 FIELD_CT = 16;
+  static constexpr v_uint8 FIELD_COLORMODE = 32;
+  static constexpr v_uint8 FIELD_TRANSITIONTIME = 64;
+  static constexpr v_uint8 FIELD_XY = 128;
+public:
+  v_uint8 fields = 0;
+  bool on = false;
+  v_uint8 bri = 0;
+  v_uint8 sat = 0;
+  v_uint16 hue = 0;
+  v_uint16 ct = 0;
+  v_uint16 transitiontime = 0; ///< in 100ms steps
+  float x = 0; ///< CIE x, 0..1
+  float y = 0; ///< CIE y, 0..1
+  HueColorMode colormode = HueColorMode::CT; ///< only valid with FIELD_COLORMODE
+public:
+
+  bool has(v_uint8 field) const {
+    return (fields & field) != 0;
+  }
+
+  /**
+   * Apply the requested attributes to a device and bump its version.
+   * @param hueDevice
+   */
+  void applyTo(HueDevice& hueDevice) const {
+
+    if (has(FIELD_BRI)) {
+      hueDevice.bri = bri;
+    }
+
+    if (has(FIELD_ON)) {
+      hueDevice.setOn(on);
+      if (hueDevice.isOn()) { // if "on" was set to true an brightness is 0, set it to max brightness
+        if (hueDevice.bri == 0) {
+          hueDevice.bri = 254;
+        }
+      }
+    }
+
+    applyColorTo(hueDevice);
+
+    hueDevice.version++;
+
+  }
+
+  /**
+   * Apply the requested color attributes only. The version is left alone.
+   *
+   * The light takes the requested `colormode`, else the mode of the requested coordinates -
+   * `xy` over `ct` over `hue`/`sat`, as with the Hue API. Its color is carried over into that mode first,
+   * so coordinates which were not requested (i.E. `sat` with only `hue` requested) keep describing the current color.
+   * @param hueDevice
+   */
+  void applyColorTo(HueDevice& hueDevice) const {
+
+    HueColorMode mode;
+    if (has(FIELD_COLORMODE)) {
+      mode = colormode;
+    } else if (has(FIELD_XY)) {
+      mode = HueColorMode::XY;
+    } else if (has(FIELD_CT)) {
+      mode = HueColorMode::CT;
+    } else if (has(FIELD_HUE) || has(FIELD_SAT)) {
+      mode = HueColorMode::HS;
+    } else {
+      return;
+    }
+
+    ColorModel::setMode(hueDevice, mode);
+    switch (mode) {
+      case HueColorMode::HS:
+        if (has(FIELD_HUE)) {
+          hueDevice.hue = hue;
+        }
+        if (has(FIELD_SAT)) {
+          hueDevice.sat = sat;
+        }
+        break;
+      case HueColorMode::XY:
+        if (has(FIELD_XY)) {
+          ColorModel::setXy(hueDevice, x, y);
+        }
+        break;
+      default:
+        if (has(FIELD_CT)) {
+          hueDevice.ct = ct;
+        }
+    }
+
+  }
+
+  static HueStateUpdate fromDto(const oatpp::Object<HueDeviceStateDto>& dto) {
+    HueStateUpdate update;
+    if (dto->on != nullptr) {
+      update.fields |= FIELD_ON;
+      update.on = *dto->on;
+    }
+    if (dto->bri != nullptr) {
+      update.fields |= FIELD_BRI;
+      update.bri = *dto->bri;
+    }
+    if (dto->hue != nullptr) {
+      update.fields |= FIELD_HUE;
+      update.hue = *dto->hue;
+    }
+    if (dto->sat != nullptr) {
+      update.fields |= FIELD_SAT;
+      update.sat = *dto->sat;
+    }
+    if (dto->ct != nullptr) {
+      update.fields |= FIELD_CT;
+      update.ct = *dto->ct;
+    }
+    if (dto->xy && dto->xy->size() == 2 && dto->xy[0] != nullptr && dto->xy[1] != nullptr) {
+      update.fields |= FIELD_XY;
+      update.x = (float) *dto->xy[0];
+      update.y = (float) *dto->xy[1];
+    }
+    if (HueDevice::colorModeFromString(dto->colormode, update.colormode)) {
+      update.fields |= FIELD_COLORMODE;
+    }
+    if (dto->transitiontime != nullptr) {
+      update.fields |= FIELD_TRANSITIONTIME;
+      update.transitiontime = *dto->transitiontime;
+    }
+    return update;
+  }
+
+};
+
+static_assert(std::is_trivially_copyable<HueStateUpdate>::value, "HueStateUpdate has to stay trivially copyable");
+
+#endif /* db_HueStateUpdate_hpp */
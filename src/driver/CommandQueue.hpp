@@ -0,0 +1,108 @@
+#ifndef CommandQueue_hpp
+#define CommandQueue_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+/**
+ *  Bounded lock-free multi-producer/multi-consumer queue (Vyukov's array queue).
+ *  Every cell carries a sequence number telling whether it is ready to be written or read,
+ *  so producers and consumers only contend on their own position counter.
+ *  @tparam T - trivially copyable value
+ */
+template<class T>
+class CommandQueue {
+private:
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+private:
+  std::unique_ptr<Cell[]> m_cells;
+  const size_t m_mask;
+  alignas(64) std::atomic<size_t> m_enqueuePosition;
+  alignas(64) std::atomic<size_t> m_dequeuePosition;
+private:
+
+  static size_t checkCapacity(size_t capacity) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+      throw std::invalid_argument("CommandQueue capacity has to be a power of two");
+    }
+    return capacity;
+  }
+
+public:
+
+  /**
+   * Constructor.
+   * @param capacity - power of two
+   */
+  explicit CommandQueue(size_t capacity)
+    : m_cells(new Cell[checkCapacity(capacity)]) // checked before anything is allocated
+    , m_mask(capacity - 1)
+    , m_enqueuePosition(0)
+    , m_dequeuePosition(0)
+  {
+    for (size_t i = 0; i < capacity; i++) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t getCapacity() const {
+    return m_mask + 1;
+  }
+
+  /**
+   * @return - `false` if the queue is full
+   */
+  bool tryPush(const T& value) {
+    size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = m_cells[position & m_mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t) sequence - (intptr_t) position;
+      if (diff == 0) {
+        if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        position = m_enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @return - `false` if the queue is empty
+   */
+  bool tryPop(T& value) {
+    size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = m_cells[position & m_mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t) sequence - (intptr_t) (position + 1);
+      if (diff == 0) {
+        if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = cell.value;
+          cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        position = m_dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+};
+
+#endif /* CommandQueue_hpp */
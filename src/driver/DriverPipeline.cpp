@@ -0,0 +1,119 @@
+
+#include "DriverPipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+DriverPipeline::DriverPipeline(const std::shared_ptr<Database>& database,
+                               const std::shared_ptr<LightDriver>& driver,
+                               const Config& config)
+  : m_config(config)
+  , m_database(database)
+  , m_driver(driver)
+  , m_queue(config.queueCapacity)
+  , m_overflow(false)
+  , m_commandsQueued(0)
+  , m_commandsDropped(0)
+  , m_framesWritten(0)
+  , m_lightsWritten(0)
+  , m_resyncs(0)
+  , m_stopped(false)
+  , m_worker(&DriverPipeline::run, this)
+{}
+
+DriverPipeline::~DriverPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_condition.notify_all();
+  m_worker.join();
+}
+
+DriverPipeline::Stats DriverPipeline::getStats() const {
+  Stats stats;
+  stats.commandsQueued = m_commandsQueued.load();
+  stats.commandsDropped = m_commandsDropped.load();
+  stats.framesWritten = m_framesWritten.load();
+  stats.lightsWritten = m_lightsWritten.load();
+  stats.resyncs = m_resyncs.load();
+  return stats;
+}
+
+void DriverPipeline::onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) {
+  // called by the Database writer - never block here
+  for (const HueDevice& hueDevice : hueDevices) {
+    if (m_queue.tryPush(hueDevice)) {
+      m_commandsQueued++;
+    } else {
+      m_commandsDropped++;
+      m_overflow = true;
+    }
+  }
+}
+
+bool DriverPipeline::collect(LightDriver::Frame& frame, std::unordered_map<v_int32, size_t>& positions) {
+
+  frame.resync = false;
+  frame.lights.clear();
+  positions.clear();
+
+  // the queue is in commit order, a later command supersedes an earlier one of the same light
+  HueDevice hueDevice;
+  while (m_queue.tryPop(hueDevice)) {
+    auto it = positions.find(hueDevice.id);
+    if (it == positions.end()) {
+      positions[hueDevice.id] = frame.lights.size();
+      frame.lights.push_back(hueDevice);
+    } else {
+      frame.lights[it->second] = hueDevice;
+    }
+  }
+
+  if (m_overflow.exchange(false)) {
+    // changes were lost - whatever is queued is older than the snapshot read now
+    frame.resync = true;
+    frame.lights.clear();
+    m_database->forEachHueDevice([&frame](const HueDevice& current) {
+      frame.lights.push_back(current);
+    });
+  }
+
+  return frame.resync || !frame.lights.empty();
+
+}
+
+void DriverPipeline::run() {
+
+  LightDriver::Frame frame;
+  std::unordered_map<v_int32, size_t> positions;
+  auto tick = std::chrono::milliseconds(m_config.tickMs);
+  auto next = std::chrono::steady_clock::now() + tick;
+
+  bool stopped = false;
+  while (!stopped) {
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait_until(lock, next, [this] {
+        return m_stopped;
+      });
+      stopped = m_stopped;
+    }
+
+    if (collect(frame, positions)) {
+      frame.sequence++;
+      m_driver->writeFrame(frame);
+      m_framesWritten++;
+      m_lightsWritten += (v_int64) frame.lights.size();
+      if (frame.resync) {
+        m_resyncs++;
+      }
+    }
+
+    // a slow driver doesn't make ticks pile up - the next frame simply collects more changes
+    next = std::max(next + tick, std::chrono::steady_clock::now());
+
+  }
+
+}
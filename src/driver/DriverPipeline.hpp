@@ -0,0 +1,91 @@
+#ifndef DriverPipeline_hpp
+#define DriverPipeline_hpp
+
+#include "LightDriver.hpp"
+#include "CommandQueue.hpp"
+
+#include "db/Database.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/**
+ *  Feeds the states committed by the Database to a LightDriver, off the HTTP threads.
+ *
+ *  Committed device records are pushed into a lock-free CommandQueue by the writer, which returns right away.
+ *  A worker thread drains the queue once per tick and keeps only the latest state of every light -
+ *  ten brightness changes to the same light within one tick reach the driver as one.
+ *  If the queue overflows because the driver can't keep up, the queued changes are dropped
+ *  and the next frame is a resync with the state of all lights.
+ */
+class DriverPipeline : public Database::ChangeListener {
+public:
+
+  struct Config {
+    v_int32 tickMs = 20; ///< collect changes for this long before writing a frame
+    v_uint32 queueCapacity = 4096; ///< power of two
+  };
+
+  /**
+   *  Counters of the pipeline. `commandsQueued / lightsWritten` is the coalescing ratio.
+   */
+  struct Stats {
+    v_int64 commandsQueued;
+    v_int64 commandsDropped; ///< lost to a full queue, replaced by resyncs
+    v_int64 framesWritten;
+    v_int64 lightsWritten;
+    v_int64 resyncs;
+  };
+
+private:
+  const Config m_config;
+  std::shared_ptr<Database> m_database;
+  std::shared_ptr<LightDriver> m_driver;
+  CommandQueue<HueDevice> m_queue;
+  std::atomic<bool> m_overflow;
+  std::atomic<v_int64> m_commandsQueued;
+  std::atomic<v_int64> m_commandsDropped;
+  std::atomic<v_int64> m_framesWritten;
+  std::atomic<v_int64> m_lightsWritten;
+  std::atomic<v_int64> m_resyncs;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stopped; ///< guarded by m_mutex
+  std::thread m_worker;
+private:
+  void run();
+  bool collect(LightDriver::Frame& frame, std::unordered_map<v_int32, size_t>& positions);
+public:
+
+  /**
+   * Constructor. Starts the worker, register the pipeline with `Database::addChangeListener()` to feed it.
+   * @param database - read for resyncs
+   * @param driver
+   * @param config
+   */
+  DriverPipeline(const std::shared_ptr<Database>& database,
+                 const std::shared_ptr<LightDriver>& driver,
+                 const Config& config);
+
+  /**
+   * Writes what is still queued and stops the worker.
+   */
+  ~DriverPipeline() override;
+
+  static std::shared_ptr<DriverPipeline> createShared(const std::shared_ptr<Database>& database,
+                                                      const std::shared_ptr<LightDriver>& driver,
+                                                      const Config& config)
+  {
+    return std::make_shared<DriverPipeline>(database, driver, config);
+  }
+
+  Stats getStats() const;
+
+  void onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) override;
+
+};
+
+#endif /* DriverPipeline_hpp */
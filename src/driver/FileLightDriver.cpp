@@ -0,0 +1,55 @@
+
+#include "FileLightDriver.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+FileLightDriver::FileLightDriver(const std::string& path, v_int32 latencyMs)
+  : m_file(path == "-" ? stdout : std::fopen(path.c_str(), "w"))
+  , m_latencyMs(latencyMs)
+{
+  if (m_file == nullptr) {
+    throw std::runtime_error("Can't open light driver output '" + path + "'");
+  }
+}
+
+FileLightDriver::~FileLightDriver() {
+  if (m_file != stdout) {
+    std::fclose(m_file);
+  }
+}
+
+void FileLightDriver::writeFrame(const Frame& frame) {
+
+  char line[128];
+  m_buffer.clear();
+
+  v_int32 size = snprintf(line, sizeof(line), "frame %llu%s lights %d\n",
+                          (unsigned long long) frame.sequence, frame.resync ? " resync" : "", (v_int32) frame.lights.size());
+  m_buffer.append(line, size);
+
+  m_colors.resize(frame.lights.size());
+  ColorModel::convert(frame.lights.data(), m_colors.data(), frame.lights.size());
+
+  for (size_t i = 0; i < frame.lights.size(); i++) {
+    const HueDevice& light = frame.lights[i];
+    const ColorModel::Color& color = m_colors[i];
+    if (light.flags & HueDevice::FLAG_IN_USE) {
+      size = snprintf(line, sizeof(line), "light %d on %d bri %d hue %d sat %d ct %d xy %.4f %.4f mode %s\n",
+                      light.id + 1, light.isOn() ? 1 : 0, light.bri, color.hue, color.sat, color.ct, color.x, color.y,
+                      HueDevice::colorModeToString(light.mode));
+    } else {
+      size = snprintf(line, sizeof(line), "light %d deleted\n", light.id + 1);
+    }
+    m_buffer.append(line, size);
+  }
+
+  if (m_latencyMs > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_latencyMs));
+  }
+
+  std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+  std::fflush(m_file);
+
+}
@@ -0,0 +1,50 @@
+#ifndef FileLightDriver_hpp
+#define FileLightDriver_hpp
+
+#include "LightDriver.hpp"
+
+#include "color/ColorModel.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ *  Stand-in LightDriver writing every frame as text to a file or a named pipe,
+ *  to watch the pipeline (throughput, coalescing) without hardware:
+ *
+ *  ```
+ *  frame 12 lights 2
+ *  light 1 on 1 bri 254 hue 3890 sat 227 ct 366 xy 0.4567 0.4101 mode ct
+ *  light 2 deleted
+ *  ```
+ *
+ *  A resync frame starts with `frame <n> resync lights <count>`.
+ *  Every light is written in every color space, the frame is converted at once - see ColorModel.
+ */
+class FileLightDriver : public LightDriver {
+private:
+  FILE* m_file;
+  v_int32 m_latencyMs;
+  std::string m_buffer;
+  std::vector<ColorModel::Color> m_colors;
+public:
+
+  /**
+   * Constructor.
+   * @param path - file or named pipe, opened for writing. "-" writes to stdout.
+   * @param latencyMs - simulated bus time per frame
+   * @throws - `std::runtime_error` if the file can't be opened
+   */
+  FileLightDriver(const std::string& path, v_int32 latencyMs = 0);
+  ~FileLightDriver() override;
+
+  static std::shared_ptr<FileLightDriver> createShared(const std::string& path, v_int32 latencyMs = 0) {
+    return std::make_shared<FileLightDriver>(path, latencyMs);
+  }
+
+  void writeFrame(const Frame& frame) override;
+
+};
+
+#endif /* FileLightDriver_hpp */
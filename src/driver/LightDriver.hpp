@@ -0,0 +1,38 @@
+#ifndef LightDriver_hpp
+#define LightDriver_hpp
+
+#include "db/model/HueDevice.hpp"
+
+#include <vector>
+
+/**
+ *  Backend moving committed light states to the real hardware (a bus, a bridge, LEDs...).
+ *  Implement this instead of driving lights from the HTTP handlers, see DriverPipeline.
+ */
+class LightDriver {
+public:
+
+  /**
+   *  The light states collected by DriverPipeline during one tick.
+   *  Each light is contained at most once, with its latest committed state.
+   */
+  struct Frame {
+    v_uint64 sequence = 0; ///< number of the frame, counting from 1
+    bool resync = false; ///< changes were lost - `lights` holds all lights, lights not contained are gone
+    std::vector<HueDevice> lights; ///< deleted lights come without HueDevice::FLAG_IN_USE
+  };
+
+public:
+
+  virtual ~LightDriver() = default;
+
+  /**
+   * Write one frame to the hardware. Called on the DriverPipeline's worker thread only,
+   * so it may block for as long as the backend needs - changes arriving meanwhile are coalesced into the next frame.
+   * @param frame
+   */
+  virtual void writeFrame(const Frame& frame) = 0;
+
+};
+
+#endif /* LightDriver_hpp */
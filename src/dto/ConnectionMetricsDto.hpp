@@ -0,0 +1,26 @@
+#ifndef ConnectionMetricsDto_hpp
+#define ConnectionMetricsDto_hpp
+
+#include "oatpp/core/macro/codegen.hpp"
+#include "oatpp/core/Types.hpp"
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+/**
+ *  Connection reuse of the HTTP server, served by `GET /metrics/connections`
+ */
+class ConnectionMetricsDto : public oatpp::DTO {
+
+  DTO_INIT(ConnectionMetricsDto, DTO);
+
+  DTO_FIELD(Int64, connectionsOpened);
+  DTO_FIELD(Int64, connectionsActive);
+  DTO_FIELD(Int64, requestsServed);
+  DTO_FIELD(Int64, keepAliveResponses);
+  DTO_FIELD(Float64, requestsPerConnection);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#endif /* ConnectionMetricsDto_hpp */
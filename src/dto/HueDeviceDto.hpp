@@ -30,11 +30,12 @@ class HueDeviceStateDto : public oatpp::DTO {
   DTO_FIELD(UInt8, bri);
   DTO_FIELD(UInt8, sat);
   DTO_FIELD(UInt16, hue);
-  DTO_FIELD(UInt16, ct); // white color temperature, 154 (cold) - 500 (warm)
+  DTO_FIELD(UInt16, ct); // white color temperature, 153 (cold) - 500 (warm)
+  DTO_FIELD(List<Float64>, xy); // CIE 1931 x and y, 0 - 1
   DTO_FIELD(String, colormode);
+  DTO_FIELD(UInt16, transitiontime); // request only, in 100ms steps
 
   // Fixed values
-  DTO_FIELD(List<Int32>, xy) = {0,0};
   DTO_FIELD(Boolean, reachable) = true;
   DTO_FIELD(String, alert) = "none";
   DTO_FIELD(String, effect) = "none";
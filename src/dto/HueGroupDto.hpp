@@ -0,0 +1,28 @@
+#ifndef HueGroupDto_hpp
+#define HueGroupDto_hpp
+
+#include "HueDeviceDto.hpp"
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+/*
+ * DTO of the philips hue `groups` resource
+ */
+
+class HueGroupDto : public oatpp::DTO {
+
+  DTO_INIT(HueGroupDto, DTO);
+
+  // User values
+  DTO_FIELD(String, name);
+  DTO_FIELD(List<String>, lights); // Hue light numbers (HueDeviceId + 1)
+  DTO_FIELD(oatpp::Object<HueDeviceStateDto>, action); // last state applied to the group
+
+  // Fixed values
+  DTO_FIELD(String, type) = "LightGroup";
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#endif /* HueGroupDto_hpp */
@@ -0,0 +1,184 @@
+
+#include "ChangeStream.hpp"
+
+#include <algorithm>
+
+ChangeStream::Subscriber::Subscriber(v_uint32 capacity)
+  : m_capacity(capacity)
+  , m_resync(true)
+  , m_closed(false)
+{}
+
+bool ChangeStream::Subscriber::push(const std::vector<v_int32>& ids) {
+  bool overflow = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_resync) {
+      return false; // the resync will contain these changes anyway
+    }
+    for (v_int32 id : ids) {
+      if (m_queued.insert(id).second) {
+        m_ids.push_back(id);
+      }
+    }
+    if (m_ids.size() > m_capacity) {
+      // a slow subscriber - drop the queue and send the full state once it catches up
+      m_ids.clear();
+      m_queued.clear();
+      m_resync = true;
+      overflow = true;
+    }
+  }
+  m_condition.notify_one();
+  return overflow;
+}
+
+void ChangeStream::Subscriber::resync() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ids.clear();
+    m_queued.clear();
+    m_resync = true;
+  }
+  m_condition.notify_one();
+}
+
+void ChangeStream::Subscriber::close() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+  }
+  m_condition.notify_one();
+}
+
+bool ChangeStream::Subscriber::take(std::vector<v_int32>& ids, bool& resync, const std::chrono::milliseconds& wait) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (wait.count() > 0) {
+    m_condition.wait_for(lock, wait, [this] {
+      return m_closed || m_resync || !m_ids.empty();
+    });
+  }
+  ids.clear();
+  ids.swap(m_ids);
+  m_queued.clear();
+  resync = m_resync;
+  m_resync = false;
+  return !m_closed || resync || !ids.empty();
+}
+
+ChangeStream::ChangeStream(const Config& config)
+  : m_config(config)
+  , m_pendingOverflow(false)
+  , m_subscribersCount(0)
+  , m_resyncs(0)
+  , m_stopped(false)
+  , m_dispatcher(&ChangeStream::dispatch, this)
+{}
+
+ChangeStream::~ChangeStream() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+    for (auto& subscriber : m_subscribers) {
+      subscriber->close();
+    }
+  }
+  m_condition.notify_all();
+  m_dispatcher.join();
+}
+
+std::shared_ptr<ChangeStream::Subscriber> ChangeStream::subscribe() {
+  auto subscriber = std::make_shared<Subscriber>(m_config.queueCapacity);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_stopped) {
+    subscriber->close();
+  }
+  m_subscribers.push_back(subscriber);
+  m_subscribersCount = (v_int32) m_subscribers.size();
+  return subscriber;
+}
+
+void ChangeStream::unsubscribe(const std::shared_ptr<Subscriber>& subscriber) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = std::find(m_subscribers.begin(), m_subscribers.end(), subscriber);
+  if (it != m_subscribers.end()) {
+    *it = m_subscribers.back();
+    m_subscribers.pop_back();
+  }
+  m_subscribersCount = (v_int32) m_subscribers.size();
+}
+
+void ChangeStream::onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) {
+  if (m_subscribersCount.load() == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pendingOverflow) {
+      return;
+    }
+    for (const HueDevice& hueDevice : hueDevices) {
+      m_pending.push_back(hueDevice.id);
+    }
+    if (m_pending.size() > m_config.queueCapacity) {
+      // a burst - drop repeated changes of the same devices
+      std::sort(m_pending.begin(), m_pending.end());
+      m_pending.erase(std::unique(m_pending.begin(), m_pending.end()), m_pending.end());
+      if (m_pending.size() > m_config.queueCapacity) {
+        // more devices than any subscriber may queue - everyone gets a resync anyway
+        m_pending.clear();
+        m_pendingOverflow = true;
+      }
+    }
+  }
+  m_condition.notify_all();
+}
+
+void ChangeStream::dispatch() {
+
+  std::vector<v_int32> ids;
+  std::vector<std::shared_ptr<Subscriber>> subscribers;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+
+    m_condition.wait(lock, [this] {
+      return m_stopped || m_pendingOverflow || !m_pending.empty();
+    });
+    if (m_stopped) {
+      break;
+    }
+
+    // let the burst settle - further changes to the same devices are coalesced
+    m_condition.wait_for(lock, std::chrono::milliseconds(m_config.windowMs), [this] {
+      return m_stopped;
+    });
+    if (m_stopped) {
+      break;
+    }
+
+    ids.clear();
+    ids.swap(m_pending);
+    bool overflow = m_pendingOverflow;
+    m_pendingOverflow = false;
+    subscribers = m_subscribers;
+    lock.unlock();
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    for (auto& subscriber : subscribers) {
+      if (overflow) {
+        subscriber->resync();
+        m_resyncs++;
+      } else if (subscriber->push(ids)) {
+        m_resyncs++;
+      }
+    }
+    subscribers.clear();
+
+    lock.lock();
+
+  }
+
+}
@@ -0,0 +1,124 @@
+#ifndef ChangeStream_hpp
+#define ChangeStream_hpp
+
+#include "db/Database.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ *  Fans the device changes committed by the Database out to the subscribers of `GET /api/{username}/events`.
+ *
+ *  The Database only queues the changed ids here. A dispatcher thread waits for the coalescing window
+ *  to pass after the first change of a burst, then hands the distinct ids to every subscriber.
+ *  Subscribers render the changed devices from the current snapshot themselves, so neither the database lock
+ *  nor the lock of this stream is held while an event is written.
+ */
+class ChangeStream : public Database::ChangeListener {
+public:
+
+  struct Config {
+    v_int32 windowMs = 50; ///< changes within this window are delivered together, one delta per device
+    v_uint32 queueCapacity = 256; ///< devices queued per subscriber before it is sent a full resync instead
+    v_int32 pingIntervalMs = 15000; ///< idle streams are sent a comment this often, to detect closed connections
+  };
+
+  /**
+   *  Bounded queue of the devices changed since a subscriber last took its events.
+   *  A device changed again before it was taken is queued only once.
+   */
+  class Subscriber {
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<v_int32> m_ids;
+    std::unordered_set<v_int32> m_queued;
+    v_uint32 m_capacity;
+    bool m_resync; ///< send the full state instead of m_ids
+    bool m_closed;
+  public:
+
+    /**
+     * Constructor. A new subscriber starts with a resync - the full state.
+     * @param capacity - devices to queue before falling back to a resync
+     */
+    Subscriber(v_uint32 capacity);
+
+    /**
+     * Queue changed devices. Called by the dispatcher.
+     * @param ids - distinct HueDeviceIds
+     * @return - `true` if the queue overflowed with these ids and was replaced by a resync
+     */
+    bool push(const std::vector<v_int32>& ids);
+
+    /**
+     * Make the next take() a resync.
+     */
+    void resync();
+
+    /**
+     * End the subscription, take() returns `false` once the queue is drained.
+     */
+    void close();
+
+    /**
+     * Take the queued changes.
+     * @param ids - out: changed HueDeviceIds, empty on resync
+     * @param resync - out: `true` if the full state has to be sent
+     * @param wait - time to wait for changes if there are none queued, zero to return at once
+     * @return - `false` if the subscription was closed
+     */
+    bool take(std::vector<v_int32>& ids, bool& resync, const std::chrono::milliseconds& wait);
+
+  };
+
+private:
+  const Config m_config;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::vector<v_int32> m_pending; ///< changed ids not dispatched yet, guarded by m_mutex
+  bool m_pendingOverflow; ///< too many changes to track - resync everyone, guarded by m_mutex
+  std::vector<std::shared_ptr<Subscriber>> m_subscribers; ///< guarded by m_mutex
+  std::atomic<v_int32> m_subscribersCount;
+  std::atomic<v_int64> m_resyncs; ///< resyncs caused by overflowing queues
+  bool m_stopped; ///< guarded by m_mutex
+  std::thread m_dispatcher;
+private:
+  void dispatch();
+public:
+
+  ChangeStream(const Config& config);
+  ~ChangeStream() override;
+
+  static std::shared_ptr<ChangeStream> createShared(const Config& config) {
+    return std::make_shared<ChangeStream>(config);
+  }
+
+  const Config& getConfig() const {
+    return m_config;
+  }
+
+  std::shared_ptr<Subscriber> subscribe();
+  void unsubscribe(const std::shared_ptr<Subscriber>& subscriber);
+
+  v_int32 getSubscribersCount() const {
+    return m_subscribersCount.load();
+  }
+
+  /**
+   * Number of resyncs sent because a queue overflowed. Initial resyncs of new subscribers are not counted.
+   */
+  v_int64 getOverflowResyncs() const {
+    return m_resyncs.load();
+  }
+
+  void onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) override;
+
+};
+
+#endif /* ChangeStream_hpp */
@@ -0,0 +1,105 @@
+
+#include "EventStreamReader.hpp"
+
+#include "oatpp/core/base/Environment.hpp"
+
+#include <cstring>
+
+EventStreamReader::EventStreamReader(const std::shared_ptr<ChangeStream>& stream,
+                                     const std::shared_ptr<Database>& database,
+                                     bool blocking)
+  : m_stream(stream)
+  , m_subscriber(stream->subscribe())
+  , m_database(database)
+  , m_blocking(blocking)
+  , m_position(0)
+  , m_lastWriteMicros(oatpp::base::Environment::getMicroTickCount())
+{}
+
+EventStreamReader::~EventStreamReader() {
+  m_stream->unsubscribe(m_subscriber);
+}
+
+void EventStreamReader::render(bool resync) {
+
+  if (resync) {
+    m_buffer += "event: resync\ndata: ";
+    m_buffer += *m_database->getHueDevicesJson();
+    m_buffer += "\n\n";
+    return;
+  }
+
+  char key[24];
+  m_buffer += "event: lights\ndata: {";
+  for (size_t i = 0; i < m_ids.size(); i++) {
+    v_int32 keySize = snprintf(key, sizeof(key), "%s\"%d\":", i > 0 ? "," : "", m_ids[i] + 1);
+    m_buffer.append(key, keySize);
+    auto json = m_database->getHueDeviceJsonById(m_ids[i]);
+    if (json) {
+      m_buffer += *json;
+    } else {
+      m_buffer += "null";
+    }
+  }
+  m_buffer += "}\n\n";
+
+}
+
+bool EventStreamReader::fill() {
+
+  m_buffer.clear();
+  m_position = 0;
+
+  const v_int64 pingIntervalMicros = (v_int64) m_stream->getConfig().pingIntervalMs * 1000;
+  std::chrono::milliseconds wait(0);
+  if (m_blocking) {
+    wait = std::chrono::milliseconds(m_stream->getConfig().pingIntervalMs);
+  }
+
+  bool resync;
+  if (!m_subscriber->take(m_ids, resync, wait)) {
+    return false;
+  }
+
+  if (resync || !m_ids.empty()) {
+    render(resync);
+  }
+
+  v_int64 now = oatpp::base::Environment::getMicroTickCount();
+  if (m_buffer.empty() && now - m_lastWriteMicros >= pingIntervalMicros) {
+    m_buffer = ":\n\n";
+  }
+  if (!m_buffer.empty()) {
+    m_lastWriteMicros = now;
+  }
+
+  return true;
+
+}
+
+oatpp::v_io_size EventStreamReader::read(void *buffer, v_buff_size count, oatpp::async::Action& action) {
+
+  if (m_position == m_buffer.size()) {
+    if (!fill()) {
+      return 0; // closed - end of the stream
+    }
+    if (m_buffer.empty()) {
+      if (m_blocking) {
+        return oatpp::IOError::RETRY_READ; // nothing within the ping interval, wait again
+      }
+      // nothing yet - come back after the coalescing window
+      v_int64 next = oatpp::base::Environment::getMicroTickCount() + (v_int64) m_stream->getConfig().windowMs * 1000;
+      action = oatpp::async::Action::createWaitRepeatAction(next);
+      return oatpp::IOError::RETRY_READ;
+    }
+  }
+
+  v_buff_size size = (v_buff_size) (m_buffer.size() - m_position);
+  if (size > count) {
+    size = count;
+  }
+  std::memcpy(buffer, m_buffer.data() + m_position, (size_t) size);
+  m_position += (size_t) size;
+  return size;
+
+}
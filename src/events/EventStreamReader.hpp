@@ -0,0 +1,47 @@
+#ifndef EventStreamReader_hpp
+#define EventStreamReader_hpp
+
+#include "ChangeStream.hpp"
+
+#include "oatpp/core/data/stream/Stream.hpp"
+
+#include <string>
+
+/**
+ *  Body of `GET /api/{username}/events` - one ChangeStream subscription rendered as server-sent events:
+ *
+ *  - `event: resync`, data is the full lights object as served by `GET /api/{username}/lights`.
+ *    Sent first and again whenever the subscriber fell behind.
+ *  - `event: lights`, data is an object of the lights changed within one coalescing window,
+ *    keyed by Hue light number. Deleted lights are `null`.
+ *
+ *  Devices are rendered from the Database's JSON cache of the current snapshot when the body is read.
+ *  With `blocking` the reader waits for changes on the calling thread (HttpConnectionHandler),
+ *  otherwise it asks the coroutine to come back later (AsyncHttpConnectionHandler).
+ */
+class EventStreamReader : public oatpp::data::stream::ReadCallback {
+private:
+  std::shared_ptr<ChangeStream> m_stream;
+  std::shared_ptr<ChangeStream::Subscriber> m_subscriber;
+  std::shared_ptr<Database> m_database;
+  bool m_blocking;
+  std::string m_buffer; ///< rendered events not read yet
+  size_t m_position;
+  std::vector<v_int32> m_ids;
+  v_int64 m_lastWriteMicros;
+private:
+  bool fill();
+  void render(bool resync);
+public:
+
+  EventStreamReader(const std::shared_ptr<ChangeStream>& stream,
+                    const std::shared_ptr<Database>& database,
+                    bool blocking);
+
+  ~EventStreamReader() override;
+
+  oatpp::v_io_size read(void *buffer, v_buff_size count, oatpp::async::Action& action) override;
+
+};
+
+#endif /* EventStreamReader_hpp */
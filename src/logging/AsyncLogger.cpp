@@ -0,0 +1,605 @@
+#include "AsyncLogger.hpp"
+
+#include <cstdarg>
+#include <ctime>
+#include <unordered_map>
+
+constexpr v_uint8 AsyncLogger::RECORD_FORMAT;
+constexpr v_uint8 AsyncLogger::RECORD_TEXT;
+constexpr v_uint8 AsyncLogger::ARG_INT;
+constexpr v_uint8 AsyncLogger::ARG_UINT;
+constexpr v_uint8 AsyncLogger::ARG_DOUBLE;
+constexpr v_uint8 AsyncLogger::ARG_STRING;
+constexpr v_uint8 AsyncLogger::ARG_POINTER;
+constexpr v_buff_size AsyncLogger::MAX_RECORD_SIZE;
+constexpr v_buff_size AsyncLogger::MAX_TEXT_RECORD_SIZE;
+
+std::atomic<v_uint32> AsyncLogger::s_defaultLevel(AsyncLogger::PRIORITY_V);
+std::atomic<v_uint32> AsyncLogger::s_minLevel(AsyncLogger::PRIORITY_V);
+std::atomic<AsyncLogger*> AsyncLogger::s_instance(nullptr);
+
+namespace {
+
+std::atomic<v_uint64> NEXT_ID(1);
+
+const char LEVEL_NAMES[] = {'V', 'D', 'I', 'W', 'E'};
+
+/**
+ *  size, kind, priority, timestamp.
+ */
+const v_buff_size HEADER_SIZE = sizeof(v_uint32) + 2 * sizeof(v_uint8) + sizeof(v_int64);
+const v_buff_size FORMAT_HEADER_SIZE = HEADER_SIZE + sizeof(AsyncLogger::Tag*) + sizeof(const char*);
+
+struct TagRegistry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<AsyncLogger::Tag>> tags;
+};
+
+/**
+ *  Never destroyed - call sites keep their tags in function-local statics.
+ */
+TagRegistry& getRegistry() {
+  static TagRegistry* registry = new TagRegistry();
+  return *registry;
+}
+
+/**
+ *  Rings used by this thread, one per AsyncLogger. Handed back when the thread exits.
+ */
+struct ThreadRings {
+
+  std::vector<std::pair<v_uint64, std::shared_ptr<AsyncLogger::Ring>>> rings;
+
+  ~ThreadRings() {
+    for (auto& pair : rings) {
+      pair.second->owned.store(false, std::memory_order_release);
+    }
+  }
+
+};
+
+thread_local ThreadRings THREAD_RINGS;
+
+/**
+ *  Tags of the OATPP_LOG* calls of this thread, so that log() doesn't take the registry lock per message.
+ */
+thread_local std::unordered_map<std::string, AsyncLogger::Tag*> THREAD_TAGS;
+
+class RecordReader {
+private:
+  const char* m_data;
+  v_buff_size m_size;
+  v_buff_size m_position;
+public:
+
+  RecordReader(const char* data, v_buff_size size)
+    : m_data(data)
+    , m_size(size)
+    , m_position(0)
+  {}
+
+  template<typename T>
+  bool get(T& value) {
+    if (m_size - m_position < (v_buff_size) sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, m_data + m_position, sizeof(T));
+    m_position += sizeof(T);
+    return true;
+  }
+
+  bool getString(std::string& value) {
+    v_uint16 size;
+    if (!get(size) || m_size - m_position < size) {
+      return false;
+    }
+    value.assign(m_data + m_position, size);
+    m_position += size;
+    return true;
+  }
+
+};
+
+void appendv(std::string& out, const char* format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  va_list retry;
+  va_copy(retry, args);
+  int size = std::vsnprintf(buffer, sizeof(buffer), format, args);
+  if (size >= (int) sizeof(buffer)) {
+    size_t start = out.size();
+    out.resize(start + (size_t) size + 1);
+    std::vsnprintf(&out[start], (size_t) size + 1, format, retry);
+    out.resize(start + (size_t) size);
+  } else if (size > 0) {
+    out.append(buffer, (size_t) size);
+  }
+  va_end(retry);
+  va_end(args);
+}
+
+bool isIntegerConversion(char c) {
+  return c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' || c == 'c';
+}
+
+bool isFloatConversion(char c) {
+  return c == 'f' || c == 'F' || c == 'e' || c == 'E' || c == 'g' || c == 'G' || c == 'a' || c == 'A';
+}
+
+/**
+ *  Format one argument with the flags, width and precision of `spec` (`%` up to the conversion, without length).
+ *  Conversions that don't fit the argument's type are replaced by one that does.
+ */
+void appendArg(std::string& out, std::string spec, char conversion, RecordReader& reader) {
+
+  v_uint8 type;
+  if (!reader.get(type)) {
+    out += "<?>";
+    return;
+  }
+
+  switch (type) {
+
+    case AsyncLogger::ARG_INT: {
+      v_int64 value = 0;
+      reader.get(value);
+      if (conversion == 'c') {
+        appendv(out, (spec + "c").c_str(), (int) value);
+      } else if (isFloatConversion(conversion)) {
+        appendv(out, (spec + conversion).c_str(), (double) value);
+      } else if (isIntegerConversion(conversion) && conversion != 'd' && conversion != 'i') {
+        appendv(out, (spec + "ll" + conversion).c_str(), (unsigned long long) value);
+      } else {
+        appendv(out, (spec + "lld").c_str(), (long long) value);
+      }
+      return;
+    }
+
+    case AsyncLogger::ARG_UINT: {
+      v_uint64 value = 0;
+      reader.get(value);
+      if (conversion == 'c') {
+        appendv(out, (spec + "c").c_str(), (int) value);
+      } else if (isFloatConversion(conversion)) {
+        appendv(out, (spec + conversion).c_str(), (double) value);
+      } else if (conversion == 'x' || conversion == 'X' || conversion == 'o') {
+        appendv(out, (spec + "ll" + conversion).c_str(), (unsigned long long) value);
+      } else {
+        appendv(out, (spec + "llu").c_str(), (unsigned long long) value);
+      }
+      return;
+    }
+
+    case AsyncLogger::ARG_DOUBLE: {
+      v_float64 value = 0;
+      reader.get(value);
+      appendv(out, (spec + (isFloatConversion(conversion) ? conversion : 'g')).c_str(), value);
+      return;
+    }
+
+    case AsyncLogger::ARG_STRING: {
+      std::string value;
+      reader.getString(value);
+      appendv(out, (spec + "s").c_str(), value.c_str());
+      return;
+    }
+
+    case AsyncLogger::ARG_POINTER: {
+      v_uint64 value = 0;
+      reader.get(value);
+      appendv(out, "%p", (void*) (uintptr_t) value);
+      return;
+    }
+
+    default:
+      out += "<?>";
+      return;
+
+  }
+
+}
+
+void appendLine(std::string& out, v_uint32 priority, v_int64 micros, const std::string& tag, const std::string& message) {
+  time_t seconds = (time_t) (micros / 1000000);
+  struct tm time;
+  localtime_r(&seconds, &time);
+  char date[32];
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &time);
+  appendv(out, " %c |%s %lld| ", LEVEL_NAMES[std::min<v_uint32>(priority, 4)], date, (long long) micros);
+  out += tag;
+  out += ':';
+  out += message;
+  out += '\n';
+}
+
+}
+
+AsyncLogger::Ring::Ring(v_uint32 capacity)
+  : head(0)
+  , tail(0)
+  , dropped(0)
+  , owned(true)
+{
+  v_uint64 size = 2 * MAX_TEXT_RECORD_SIZE;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  data.reset(new char[size]);
+  mask = size - 1;
+}
+
+AsyncLogger::AsyncLogger(const Config& config, FILE* output)
+  : m_config(config)
+  , m_id(NEXT_ID++)
+  , m_running(true)
+  , m_written(0)
+  , m_output(output)
+{
+  setLevel("*", (v_int32) config.level);
+  for (auto& tagLevel : config.tagLevels) {
+    getTag(tagLevel.first); // configured tags may log for the first time later on
+    setLevel(tagLevel.first, (v_int32) tagLevel.second);
+  }
+  s_instance.store(this, std::memory_order_release);
+  m_writer = std::thread(&AsyncLogger::run, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+  AsyncLogger* self = this;
+  s_instance.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition.notify_all();
+  if (m_writer.joinable()) {
+    m_writer.join();
+  }
+  writeOut();
+}
+
+AsyncLogger::Ring* AsyncLogger::getRing() {
+  for (auto& pair : THREAD_RINGS.rings) {
+    if (pair.first == m_id) {
+      return pair.second.get();
+    }
+  }
+  return acquireRing();
+}
+
+AsyncLogger::Ring* AsyncLogger::acquireRing() {
+
+  auto& cache = THREAD_RINGS.rings;
+
+  // rings of destroyed loggers are only held by the cache anymore
+  for (size_t i = cache.size(); i-- > 0;) {
+    if (cache[i].second.use_count() == 1) {
+      cache[i] = cache.back();
+      cache.pop_back();
+    }
+  }
+
+  std::shared_ptr<Ring> ring;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& candidate : m_rings) {
+      bool owned = false;
+      if (candidate->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+        ring = candidate;
+        break;
+      }
+    }
+    if (!ring) {
+      ring = std::make_shared<Ring>(m_config.ringBytes);
+      m_rings.push_back(ring);
+    }
+  }
+
+  cache.emplace_back(m_id, ring);
+  return ring.get();
+
+}
+
+bool AsyncLogger::append(const char* record, v_buff_size size) {
+
+  Ring* ring = getRing();
+  v_uint64 capacity = ring->mask + 1;
+  v_uint64 head = ring->head.load(std::memory_order_relaxed);
+  v_uint64 tail = ring->tail.load(std::memory_order_acquire);
+
+  if (head - tail + (v_uint64) size > capacity) {
+    // only this thread writes the counter - load + store instead of a locked read-modify-write
+    ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  v_uint64 offset = head & ring->mask;
+  v_uint64 first = std::min<v_uint64>((v_uint64) size, capacity - offset);
+  std::memcpy(ring->data.get() + offset, record, (size_t) first);
+  std::memcpy(ring->data.get(), record + first, (size_t) ((v_uint64) size - first));
+  ring->head.store(head + (v_uint64) size, std::memory_order_release);
+  return true;
+
+}
+
+void AsyncLogger::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_running) {
+    m_condition.wait_for(lock, std::chrono::milliseconds(m_config.flushIntervalMs));
+    lock.unlock();
+    writeOut();
+    lock.lock();
+  }
+}
+
+void AsyncLogger::drain(std::string& out) {
+
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    rings = m_rings;
+  }
+
+  // copy the records out first, so that the rings have room again while they are formatted
+  std::string batch;
+  for (auto& ring : rings) {
+    v_uint64 tail = ring->tail.load(std::memory_order_relaxed);
+    v_uint64 head = ring->head.load(std::memory_order_acquire);
+    v_uint64 offset = tail & ring->mask;
+    v_uint64 size = head - tail;
+    v_uint64 first = std::min<v_uint64>(size, ring->mask + 1 - offset);
+    batch.append(ring->data.get() + offset, (size_t) first);
+    batch.append(ring->data.get(), (size_t) (size - first));
+    ring->tail.store(head, std::memory_order_release);
+  }
+
+  struct Entry {
+    v_int64 micros;
+    v_buff_size offset;
+    v_buff_size size;
+  };
+
+  std::vector<Entry> entries;
+  v_buff_size position = 0;
+  while ((v_buff_size) batch.size() - position >= HEADER_SIZE) {
+    RecordReader reader(batch.data() + position, HEADER_SIZE);
+    v_uint32 size = 0;
+    v_uint8 kind;
+    v_uint8 priority;
+    Entry entry;
+    reader.get(size);
+    reader.get(kind);
+    reader.get(priority);
+    reader.get(entry.micros);
+    if (size < HEADER_SIZE || size > batch.size() - position) {
+      break;
+    }
+    entry.offset = position;
+    entry.size = size;
+    entries.push_back(entry);
+    position += size;
+  }
+
+  // rings are in order each, merge them by time
+  std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.micros < b.micros;
+  });
+
+  for (auto& entry : entries) {
+    RecordReader reader(batch.data() + entry.offset, entry.size);
+    v_uint32 size;
+    v_uint8 kind;
+    v_uint8 priority;
+    v_int64 micros;
+    reader.get(size);
+    reader.get(kind);
+    reader.get(priority);
+    reader.get(micros);
+    if (kind == RECORD_FORMAT) {
+      Tag* tag = nullptr;
+      const char* format = nullptr;
+      reader.get(tag);
+      reader.get(format);
+      appendLine(out, priority, micros, tag->name,
+                 formatMessage(format, batch.data() + entry.offset + FORMAT_HEADER_SIZE, entry.size - FORMAT_HEADER_SIZE));
+    } else {
+      v_uint8 type;
+      std::string tag;
+      std::string message;
+      reader.get(type);
+      reader.getString(tag);
+      reader.get(type);
+      reader.getString(message);
+      appendLine(out, priority, micros, tag, message);
+    }
+  }
+
+  m_written.fetch_add((v_int64) entries.size(), std::memory_order_relaxed);
+
+}
+
+void AsyncLogger::writeOut() {
+  std::lock_guard<std::mutex> lock(m_drainMutex);
+  std::string out;
+  drain(out);
+  if (!out.empty()) {
+    std::fwrite(out.data(), 1, out.size(), m_output);
+    std::fflush(m_output);
+  }
+}
+
+void AsyncLogger::log(v_uint32 priority, const std::string& tag, const std::string& message) {
+
+  Tag* logTag;
+  auto it = THREAD_TAGS.find(tag);
+  if (it != THREAD_TAGS.end()) {
+    logTag = it->second;
+  } else {
+    logTag = getTag(tag);
+    THREAD_TAGS.insert({tag, logTag});
+  }
+
+  if (!logTag->isEnabled(priority)) {
+    return;
+  }
+
+  char record[MAX_TEXT_RECORD_SIZE];
+  RecordWriter writer(record, MAX_TEXT_RECORD_SIZE);
+  writer.put((v_uint32) 0);
+  writer.put(RECORD_TEXT);
+  writer.put((v_uint8) priority);
+  writer.put(getMicroseconds());
+  writer.put(ARG_STRING);
+  writer.putString(tag.data(), (v_buff_size) tag.size());
+  writer.put(ARG_STRING);
+  writer.putString(message.data(), (v_buff_size) message.size());
+  v_uint32 size = (v_uint32) writer.getSize();
+  std::memcpy(record, &size, sizeof(size));
+  append(record, size);
+
+}
+
+void AsyncLogger::flush() {
+  writeOut();
+}
+
+AsyncLogger::Stats AsyncLogger::getStats() const {
+  Stats stats;
+  stats.written = m_written.load(std::memory_order_relaxed);
+  stats.dropped = 0;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& ring : m_rings) {
+    stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+AsyncLogger::Tag* AsyncLogger::getTag(const std::string& name) {
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto& tag : registry.tags) {
+    if (tag->name == name) {
+      return tag.get();
+    }
+  }
+  registry.tags.emplace_back(new Tag(name));
+  return registry.tags.back().get();
+}
+
+AsyncLogger::Tag* AsyncLogger::findTag(const std::string& name) {
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto& tag : registry.tags) {
+    if (tag->name == name) {
+      return tag.get();
+    }
+  }
+  return nullptr;
+}
+
+bool AsyncLogger::setLevel(const std::string& tag, v_int32 level) {
+
+  if (tag != "*") {
+    Tag* logTag = findTag(tag);
+    if (logTag == nullptr) {
+      return false;
+    }
+    logTag->setLevel(level);
+  } else {
+    s_defaultLevel.store(level < 0 ? PRIORITY_D : (v_uint32) level, std::memory_order_relaxed);
+  }
+
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  v_uint32 minLevel = s_defaultLevel.load(std::memory_order_relaxed);
+  for (auto& t : registry.tags) {
+    v_int32 tagLevel = t->getLevel();
+    if (tagLevel >= 0) {
+      minLevel = std::min(minLevel, (v_uint32) tagLevel);
+    }
+  }
+  s_minLevel.store(minLevel, std::memory_order_relaxed);
+  return true;
+
+}
+
+bool AsyncLogger::parseLevel(const char* str, v_uint32& level) {
+  if (str == nullptr || str[0] == 0 || str[1] != 0) {
+    return false;
+  }
+  for (v_uint32 i = 0; i < sizeof(LEVEL_NAMES); i++) {
+    if (LEVEL_NAMES[i] == str[0] || LEVEL_NAMES[i] == str[0] - 'a' + 'A') {
+      level = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+v_int64 AsyncLogger::getDroppedCount() {
+  AsyncLogger* logger = s_instance.load(std::memory_order_acquire);
+  return logger == nullptr ? 0 : logger->getStats().dropped;
+}
+
+void AsyncLogger::writeFallback(v_uint32 priority, Tag* tag, const char* format, const char* record, v_buff_size size) {
+  oatpp::base::Environment::log(priority, tag->name,
+                                formatMessage(format, record + FORMAT_HEADER_SIZE, size - FORMAT_HEADER_SIZE));
+}
+
+std::string AsyncLogger::formatMessage(const char* format, const char* args, v_buff_size size) {
+
+  std::string out;
+  RecordReader reader(args, size);
+  const char* p = format;
+
+  while (*p != 0) {
+
+    if (*p != '%') {
+      const char* end = std::strchr(p, '%');
+      if (end == nullptr) {
+        out += p;
+        break;
+      }
+      out.append(p, (size_t) (end - p));
+      p = end;
+      continue;
+    }
+
+    if (p[1] == '%') {
+      out += '%';
+      p += 2;
+      continue;
+    }
+
+    // %[flags][width][.precision][length]conversion - length is dropped, the argument's type decides
+    std::string spec = "%";
+    const char* c = p + 1;
+    while (*c != 0 && std::strchr("-+ #0", *c) != nullptr) {
+      spec += *c++;
+    }
+    while (*c >= '0' && *c <= '9') {
+      spec += *c++;
+    }
+    if (*c == '.') {
+      spec += *c++;
+      while (*c >= '0' && *c <= '9') {
+        spec += *c++;
+      }
+    }
+    while (*c != 0 && std::strchr("hljztLq", *c) != nullptr) {
+      c++;
+    }
+    if (*c == 0) {
+      out += p;
+      break;
+    }
+
+    appendArg(out, spec, *c, reader);
+    p = c + 1;
+
+  }
+
+  return out;
+
+}
@@ -0,0 +1,364 @@
+#ifndef logging_AsyncLogger_hpp
+#define logging_AsyncLogger_hpp
+
+#include "oatpp/core/base/Environment.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ *  Logger that keeps formatting and output off the threads that log.
+ *
+ *  Every logging thread appends binary records to a ring buffer of its own - format string, tag and raw arguments,
+ *  no formatting, no lock. A background thread drains the rings every Config::flushIntervalMs,
+ *  formats the records in time order and writes them out. If a ring is full the record is dropped and counted.
+ *
+ *  Registered with `oatpp::base::Environment::setLogger()` it also takes OATPP_LOG* messages -
+ *  these are formatted by oatpp already, only their output moves to the background thread.
+ *  Request paths log with the HUE_LOG* macros instead, which defer formatting as well.
+ *
+ *  Levels are kept per tag and can be changed at runtime, see setLevel().
+ */
+class AsyncLogger : public oatpp::base::Logger {
+public:
+
+  struct Config {
+    v_uint32 level = PRIORITY_D; ///< level of tags without a level of their own
+    std::vector<std::pair<std::string, v_uint32>> tagLevels;
+    v_uint32 ringBytes = 64 * 1024; ///< per logging thread, rounded up to a power of two
+    v_int32 flushIntervalMs = 10;
+  };
+
+  /**
+   *  A log tag and its level. Tags are never destroyed, call sites keep a pointer to theirs.
+   */
+  class Tag {
+  private:
+    std::atomic<v_int32> m_level; ///< `-1` - the default level
+  public:
+    const std::string name;
+
+    Tag(const std::string& tagName)
+      : m_level(-1)
+      , name(tagName)
+    {}
+
+    v_int32 getLevel() const {
+      return m_level.load(std::memory_order_relaxed);
+    }
+
+    void setLevel(v_int32 level) {
+      m_level.store(level, std::memory_order_relaxed);
+    }
+
+    bool isEnabled(v_uint32 priority) const {
+      v_int32 level = m_level.load(std::memory_order_relaxed);
+      return (v_int32) priority >= (level < 0 ? (v_int32) s_defaultLevel.load(std::memory_order_relaxed) : level);
+    }
+
+  };
+
+  struct Stats {
+    v_int64 written; ///< records written out
+    v_int64 dropped; ///< records dropped because the ring of their thread was full
+  };
+
+  /**
+   *  Ring buffer of one logging thread. Written by that thread only, read by the background thread.
+   */
+  struct Ring {
+    std::unique_ptr<char[]> data;
+    v_uint64 mask;
+    std::atomic<v_uint64> head; ///< end of the written records, stored by the owning thread
+    std::atomic<v_uint64> tail; ///< end of the consumed records, stored by the background thread
+    std::atomic<v_int64> dropped; ///< stored by the owning thread
+    std::atomic<bool> owned; ///< a thread writes into this ring
+    Ring(v_uint32 capacity);
+  };
+
+  /*
+   *  A record starts with its v_uint32 size, kind, v_uint8 priority and v_int64 timestamp in microseconds.
+   *  RECORD_FORMAT continues with the Tag*, the format pointer and the encoded arguments,
+   *  RECORD_TEXT with the tag and the message as ARG_STRING payloads.
+   */
+  static constexpr v_uint8 RECORD_FORMAT = 0; ///< format and arguments of a HUE_LOG* call
+  static constexpr v_uint8 RECORD_TEXT = 1; ///< tag and message of an OATPP_LOG* call
+  static constexpr v_uint8 ARG_INT = 1;
+  static constexpr v_uint8 ARG_UINT = 2;
+  static constexpr v_uint8 ARG_DOUBLE = 3;
+  static constexpr v_uint8 ARG_STRING = 4;
+  static constexpr v_uint8 ARG_POINTER = 5;
+  static constexpr v_buff_size MAX_RECORD_SIZE = 1024; ///< arguments beyond are cut
+  static constexpr v_buff_size MAX_TEXT_RECORD_SIZE = 4096;
+
+  /**
+   *  Encodes one record on the stack of the logging thread.
+   */
+  class RecordWriter {
+  private:
+    char* m_data;
+    v_buff_size m_size;
+    v_buff_size m_capacity;
+  public:
+
+    RecordWriter(char* data, v_buff_size capacity)
+      : m_data(data)
+      , m_size(0)
+      , m_capacity(capacity)
+    {}
+
+    template<typename T>
+    void put(const T& value) {
+      if (m_capacity - m_size >= (v_buff_size) sizeof(T)) {
+        std::memcpy(m_data + m_size, &value, sizeof(T));
+        m_size += sizeof(T);
+      }
+    }
+
+    void putString(const char* str, v_buff_size size) {
+      if (m_capacity - m_size < (v_buff_size) sizeof(v_uint16)) {
+        return;
+      }
+      size = std::min<v_buff_size>(size, std::min<v_buff_size>(m_capacity - m_size - sizeof(v_uint16), 0xFFFF));
+      put((v_uint16) size);
+      std::memcpy(m_data + m_size, str, (size_t) size);
+      m_size += size;
+    }
+
+    v_buff_size getSize() const {
+      return m_size;
+    }
+
+  };
+
+private:
+  static std::atomic<v_uint32> s_defaultLevel;
+  static std::atomic<v_uint32> s_minLevel; ///< lowest level of any tag, OATPP_LOG* below are not even formatted
+  static std::atomic<AsyncLogger*> s_instance;
+private:
+  const Config m_config;
+  const v_uint64 m_id; ///< identifies the logger in the ring cache of a thread
+  mutable std::mutex m_mutex;
+  std::vector<std::shared_ptr<Ring>> m_rings; ///< guarded by m_mutex
+  std::condition_variable m_condition;
+  bool m_running; ///< guarded by m_mutex
+  std::mutex m_drainMutex; ///< one drain at a time, keeps the output in order
+  std::atomic<v_int64> m_written;
+  FILE* m_output;
+  std::thread m_writer;
+private:
+  Ring* getRing();
+  Ring* acquireRing();
+  bool append(const char* record, v_buff_size size);
+  void run();
+  void drain(std::string& out);
+  void writeOut();
+private:
+
+  static void encode(RecordWriter&) {}
+
+  template<typename T, typename ... Args>
+  static void encode(RecordWriter& writer, const T& value, const Args& ... args) {
+    encodeArg(writer, value);
+    encode(writer, args...);
+  }
+
+  template<typename T>
+  static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+  encodeArg(RecordWriter& writer, T value) {
+    writer.put(ARG_INT);
+    writer.put((v_int64) value);
+  }
+
+  template<typename T>
+  static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+  encodeArg(RecordWriter& writer, T value) {
+    writer.put(ARG_UINT);
+    writer.put((v_uint64) value);
+  }
+
+  template<typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type
+  encodeArg(RecordWriter& writer, T value) {
+    writer.put(ARG_DOUBLE);
+    writer.put((v_float64) value);
+  }
+
+  static void encodeArg(RecordWriter& writer, const char* value) {
+    writer.put(ARG_STRING);
+    if (value == nullptr) {
+      value = "(null)";
+    }
+    writer.putString(value, (v_buff_size) std::strlen(value));
+  }
+
+  static void encodeArg(RecordWriter& writer, char* value) {
+    encodeArg(writer, (const char*) value);
+  }
+
+  static void encodeArg(RecordWriter& writer, const std::string& value) {
+    writer.put(ARG_STRING);
+    writer.putString(value.data(), (v_buff_size) value.size());
+  }
+
+  static void encodeArg(RecordWriter& writer, const void* value) {
+    writer.put(ARG_POINTER);
+    writer.put((v_uint64) (uintptr_t) value);
+  }
+
+  static v_int64 getMicroseconds() {
+    return (v_int64) std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  static void writeFallback(v_uint32 priority, Tag* tag, const char* format, const char* record, v_buff_size size);
+
+public:
+
+  /**
+   * Constructor. Starts the background thread and makes this the logger of the HUE_LOG* macros.
+   * @param config
+   * @param output - stream written to, i.E. `stdout`
+   */
+  AsyncLogger(const Config& config, FILE* output);
+
+  /**
+   * Writes what is left in the rings and stops the background thread.
+   * Threads must not log to this logger anymore.
+   */
+  ~AsyncLogger() override;
+
+  static std::shared_ptr<AsyncLogger> createShared(const Config& config, FILE* output = stdout) {
+    return std::make_shared<AsyncLogger>(config, output);
+  }
+
+  /**
+   * Take an already formatted message - called by `oatpp::base::Environment` for OATPP_LOG*.
+   */
+  void log(v_uint32 priority, const std::string& tag, const std::string& message) override;
+
+  bool isLogPriorityEnabled(v_uint32 priority) override {
+    return priority >= s_minLevel.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Write everything appended so far before returning.
+   */
+  void flush();
+
+  Stats getStats() const;
+
+public:
+
+  /**
+   * @param name
+   * @return - the tag called `name`, created on the first call
+   */
+  static Tag* getTag(const std::string& name);
+
+  /**
+   * @param name
+   * @return - the tag called `name`, `nullptr` if nothing logged with it or configured it yet
+   */
+  static Tag* findTag(const std::string& name);
+
+  /**
+   * Set the level of a tag at runtime. Tags are not created here, see findTag().
+   * @param tag - `*` for the default level of all tags without a level of their own
+   * @param level - `PRIORITY_*`, `-1` to return the tag to the default level
+   * @return - `false` if there is no such tag
+   */
+  static bool setLevel(const std::string& tag, v_int32 level);
+
+  /**
+   * @param str - `V`, `D`, `I`, `W` or `E`
+   * @param level - out
+   * @return - `false` if `str` is none of them
+   */
+  static bool parseLevel(const char* str, v_uint32& level);
+
+  /**
+   * Records dropped by the running logger, 0 if there is none.
+   */
+  static v_int64 getDroppedCount();
+
+  /**
+   * Append a record to the calling thread's ring, use the HUE_LOG* macros instead.
+   * Without a running AsyncLogger the record is formatted right away and passed to `oatpp::base::Environment`.
+   * @param priority
+   * @param tag
+   * @param format - printf-style format, has to outlive the logger - i.E. a string literal
+   * @param args - integers, floating point numbers, C strings, `std::string`s and pointers
+   */
+  template<typename ... Args>
+  static void write(v_uint32 priority, Tag* tag, const char* format, const Args& ... args) {
+    char record[MAX_RECORD_SIZE];
+    RecordWriter writer(record, MAX_RECORD_SIZE);
+    writer.put((v_uint32) 0); // size, set below
+    writer.put(RECORD_FORMAT);
+    writer.put((v_uint8) priority);
+    writer.put(getMicroseconds());
+    writer.put(tag);
+    writer.put(format);
+    encode(writer, args...);
+    v_uint32 size = (v_uint32) writer.getSize();
+    std::memcpy(record, &size, sizeof(size));
+    AsyncLogger* logger = s_instance.load(std::memory_order_acquire);
+    if (logger == nullptr) {
+      writeFallback(priority, tag, format, record, size);
+      return;
+    }
+    logger->append(record, size);
+  }
+
+  /**
+   * Format a record's message. Arguments are matched to the conversions of the format by position,
+   * a conversion without a matching argument prints `<?>` instead of reading garbage.
+   * @param format
+   * @param args - encoded arguments
+   * @param size - size of `args`
+   * @return
+   */
+  static std::string formatMessage(const char* format, const char* args, v_buff_size size);
+
+};
+
+#define HUE_LOG(PRIORITY, TAG, ...) \
+  do { \
+    static AsyncLogger::Tag* const hueLogTag_ = AsyncLogger::getTag(TAG); \
+    if (hueLogTag_->isEnabled(PRIORITY)) { \
+      AsyncLogger::write(PRIORITY, hueLogTag_, __VA_ARGS__); \
+    } \
+  } while (false)
+
+/*
+ *  Like OATPP_LOG*, compiled out with HUE_DISABLE_LOG*. Release builds define HUE_DISABLE_LOGD.
+ */
+
+#ifndef HUE_DISABLE_LOGD
+  #define HUE_LOGD(TAG, ...) HUE_LOG(oatpp::base::Logger::PRIORITY_D, TAG, __VA_ARGS__)
+#else
+  #define HUE_LOGD(TAG, ...) ((void) 0)
+#endif
+
+#ifndef HUE_DISABLE_LOGI
+  #define HUE_LOGI(TAG, ...) HUE_LOG(oatpp::base::Logger::PRIORITY_I, TAG, __VA_ARGS__)
+#else
+  #define HUE_LOGI(TAG, ...) ((void) 0)
+#endif
+
+#define HUE_LOGW(TAG, ...) HUE_LOG(oatpp::base::Logger::PRIORITY_W, TAG, __VA_ARGS__)
+#define HUE_LOGE(TAG, ...) HUE_LOG(oatpp::base::Logger::PRIORITY_E, TAG, __VA_ARGS__)
+
+#endif /* logging_AsyncLogger_hpp */
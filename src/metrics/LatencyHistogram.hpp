@@ -0,0 +1,136 @@
+#ifndef metrics_LatencyHistogram_hpp
+#define metrics_LatencyHistogram_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <vector>
+
+/**
+ *  Log-linear histogram of latencies in nanoseconds, in the style of HdrHistogram:
+ *  every power of two is split into 16 buckets, so a recorded value is off by less than 1/16 (6.25%)
+ *  from any value of its bucket, from 1ns up to ~137s. Larger values go into the last bucket.
+ *
+ *  Holds plain counts. Recording threads keep their own buckets (see Metrics), this class merges them
+ *  and answers percentiles.
+ */
+class LatencyHistogram {
+public:
+  static constexpr v_int32 SUB_BUCKET_BITS = 4;
+  static constexpr v_int32 SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr v_int32 MAX_SHIFT = 32; ///< values up to 2^(MAX_SHIFT + SUB_BUCKET_BITS + 1) ns
+  static constexpr v_int32 BUCKETS_COUNT = (MAX_SHIFT + 2) * SUB_BUCKETS;
+public:
+
+  /**
+   * @param valueNs
+   * @return - index of the bucket `valueNs` is counted in
+   */
+  static v_int32 getBucket(v_uint64 valueNs) {
+    if (valueNs < 2 * SUB_BUCKETS) {
+      return (v_int32) valueNs;
+    }
+    v_int32 shift = 63 - __builtin_clzll(valueNs) - SUB_BUCKET_BITS;
+    if (shift > MAX_SHIFT) {
+      return BUCKETS_COUNT - 1;
+    }
+    return (shift << SUB_BUCKET_BITS) + (v_int32) (valueNs >> shift);
+  }
+
+  /**
+   * @param bucket
+   * @return - smallest value counted in `bucket`
+   */
+  static v_uint64 getBucketLowerBound(v_int32 bucket) {
+    if (bucket < 2 * SUB_BUCKETS) {
+      return (v_uint64) bucket;
+    }
+    v_int32 shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    return (v_uint64) (bucket - (shift << SUB_BUCKET_BITS)) << shift;
+  }
+
+  /**
+   * @param bucket
+   * @return - largest value counted in `bucket`
+   */
+  static v_uint64 getBucketUpperBound(v_int32 bucket) {
+    return getBucketLowerBound(bucket + 1) - 1;
+  }
+
+private:
+  std::vector<v_uint64> m_counts;
+  v_uint64 m_count;
+  v_uint64 m_sumNs;
+public:
+
+  LatencyHistogram()
+    : m_counts(BUCKETS_COUNT, 0)
+    , m_count(0)
+    , m_sumNs(0)
+  {}
+
+  void record(v_uint64 valueNs) {
+    add(getBucket(valueNs), 1, valueNs);
+  }
+
+  /**
+   * Add `count` values to a bucket.
+   * @param bucket
+   * @param count
+   * @param sumNs - sum of the values added
+   */
+  void add(v_int32 bucket, v_uint64 count, v_uint64 sumNs) {
+    m_counts[bucket] += count;
+    m_count += count;
+    m_sumNs += sumNs;
+  }
+
+  v_uint64 getCount() const {
+    return m_count;
+  }
+
+  v_uint64 getSumNs() const {
+    return m_sumNs;
+  }
+
+  /**
+   * @param bucket
+   * @return - values counted in `bucket`
+   */
+  v_uint64 getBucketCount(v_int32 bucket) const {
+    return m_counts[bucket];
+  }
+
+  /**
+   * @param p - percentile in [0, 1]
+   * @return - upper bound of the bucket holding the percentile, 0 if nothing was recorded
+   */
+  v_uint64 getPercentile(v_float64 p) const {
+    if (m_count == 0) {
+      return 0;
+    }
+    v_uint64 rank = (v_uint64) (p * (m_count - 1) + 0.5) + 1;
+    v_uint64 seen = 0;
+    for (v_int32 i = 0; i < BUCKETS_COUNT; i++) {
+      seen += m_counts[i];
+      if (seen >= rank) {
+        return getBucketUpperBound(i);
+      }
+    }
+    return getBucketUpperBound(BUCKETS_COUNT - 1);
+  }
+
+  /**
+   * @param valueNs
+   * @return - number of values counted in buckets that end at or below `valueNs`
+   */
+  v_uint64 getCountAtOrBelow(v_uint64 valueNs) const {
+    v_uint64 count = 0;
+    for (v_int32 i = 0; i < BUCKETS_COUNT && getBucketUpperBound(i) <= valueNs; i++) {
+      count += m_counts[i];
+    }
+    return count;
+  }
+
+};
+
+#endif /* metrics_LatencyHistogram_hpp */
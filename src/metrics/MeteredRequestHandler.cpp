@@ -0,0 +1,74 @@
+#include "MeteredRequestHandler.hpp"
+
+/**
+ *  Runs the endpoint's coroutine and records the time until it returned its response.
+ */
+class MeteredRequestHandler::TimedCoroutine
+  : public oatpp::async::CoroutineWithResult<TimedCoroutine, const std::shared_ptr<OutgoingResponse>&> {
+private:
+  std::shared_ptr<oatpp::web::server::HttpRequestHandler> m_handler;
+  std::shared_ptr<Metrics> m_metrics;
+  v_int32 m_series;
+  std::shared_ptr<IncomingRequest> m_request;
+  Metrics::Clock::time_point m_start;
+public:
+
+  TimedCoroutine(const std::shared_ptr<oatpp::web::server::HttpRequestHandler>& handler,
+                 const std::shared_ptr<Metrics>& metrics,
+                 v_int32 series,
+                 const std::shared_ptr<IncomingRequest>& request)
+    : m_handler(handler)
+    , m_metrics(metrics)
+    , m_series(series)
+    , m_request(request)
+    , m_start(Metrics::Clock::now())
+  {}
+
+  Action act() override {
+    return m_handler->handleAsync(m_request).callbackTo(&TimedCoroutine::onResponse);
+  }
+
+  Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+    m_metrics->recordSince(m_series, m_start);
+    return _return(response);
+  }
+
+};
+
+MeteredRequestHandler::MeteredRequestHandler(const std::shared_ptr<oatpp::web::server::api::ApiController>& controller,
+                                             const std::shared_ptr<oatpp::web::server::HttpRequestHandler>& handler,
+                                             const std::shared_ptr<Metrics>& metrics,
+                                             v_int32 series)
+  : m_controller(controller)
+  , m_handler(handler)
+  , m_metrics(metrics)
+  , m_series(series)
+{}
+
+std::shared_ptr<MeteredRequestHandler::OutgoingResponse>
+MeteredRequestHandler::handle(const std::shared_ptr<IncomingRequest>& request) {
+  auto start = Metrics::Clock::now();
+  auto response = m_handler->handle(request);
+  m_metrics->recordSince(m_series, start);
+  return response;
+}
+
+oatpp::async::CoroutineStarterForResult<const std::shared_ptr<MeteredRequestHandler::OutgoingResponse>&>
+MeteredRequestHandler::handleAsync(const std::shared_ptr<IncomingRequest>& request) {
+  return TimedCoroutine::startForResult(m_handler, m_metrics, m_series, request);
+}
+
+std::shared_ptr<oatpp::web::server::api::ApiController>
+MeteredRequestHandler::addController(const std::shared_ptr<oatpp::web::server::HttpRouter>& router,
+                                     const std::shared_ptr<oatpp::web::server::api::ApiController>& controller,
+                                     const std::shared_ptr<Metrics>& metrics,
+                                     const std::string& family,
+                                     const std::string& help) {
+  for (auto& endpoint : controller->getEndpoints().list) {
+    auto info = endpoint->info();
+    std::string labels = "method=\"" + std::string(info->method->c_str()) + "\",path=\"" + std::string(info->path->c_str()) + "\"";
+    auto handler = std::make_shared<MeteredRequestHandler>(controller, endpoint->handler, metrics, metrics->addSeries(family, help, labels));
+    router->route(info->method, info->path, handler);
+  }
+  return controller;
+}
@@ -0,0 +1,56 @@
+#ifndef metrics_MeteredRequestHandler_hpp
+#define metrics_MeteredRequestHandler_hpp
+
+#include "Metrics.hpp"
+
+#include "oatpp/web/server/api/ApiController.hpp"
+#include "oatpp/web/server/HttpRouter.hpp"
+
+/**
+ *  Decorates the handler of one endpoint and records how long the endpoint took to produce its response
+ *  into the endpoint's series - for ENDPOINT and ENDPOINT_ASYNC alike.
+ *  Writing the response to the connection is not included.
+ */
+class MeteredRequestHandler : public oatpp::web::server::HttpRequestHandler {
+private:
+  class TimedCoroutine;
+private:
+  std::shared_ptr<oatpp::web::server::api::ApiController> m_controller; ///< the endpoint's handler points into it
+  std::shared_ptr<oatpp::web::server::HttpRequestHandler> m_handler;
+  std::shared_ptr<Metrics> m_metrics;
+  v_int32 m_series;
+public:
+
+  MeteredRequestHandler(const std::shared_ptr<oatpp::web::server::api::ApiController>& controller,
+                        const std::shared_ptr<oatpp::web::server::HttpRequestHandler>& handler,
+                        const std::shared_ptr<Metrics>& metrics,
+                        v_int32 series);
+
+  std::shared_ptr<OutgoingResponse> handle(const std::shared_ptr<IncomingRequest>& request) override;
+
+  oatpp::async::CoroutineStarterForResult<const std::shared_ptr<OutgoingResponse>&>
+  handleAsync(const std::shared_ptr<IncomingRequest>& request) override;
+
+public:
+
+  /**
+   * Route all endpoints of `controller` like `HttpRouter::addController()` does,
+   * each through a MeteredRequestHandler with a series of its own in the `family` histogram,
+   * labeled with the endpoint's method and path.
+   * @param router
+   * @param controller
+   * @param metrics
+   * @param family - i.E. `hue_http_request_duration`
+   * @param help
+   * @return - `controller`
+   */
+  static std::shared_ptr<oatpp::web::server::api::ApiController>
+  addController(const std::shared_ptr<oatpp::web::server::HttpRouter>& router,
+                const std::shared_ptr<oatpp::web::server::api::ApiController>& controller,
+                const std::shared_ptr<Metrics>& metrics,
+                const std::string& family,
+                const std::string& help);
+
+};
+
+#endif /* metrics_MeteredRequestHandler_hpp */
@@ -0,0 +1,265 @@
+#include "Metrics.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+
+constexpr v_int32 Metrics::MAX_SERIES;
+
+namespace {
+
+std::atomic<v_uint64> NEXT_ID(1);
+
+/**
+ *  `le` bounds of the rendered histograms, in seconds and in nanoseconds.
+ */
+const char* const BOUNDS[] = {
+  "0.000025", "0.00005", "0.0001", "0.00025", "0.0005",
+  "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05",
+  "0.1", "0.25", "0.5", "1", "2.5", "5", "10"
+};
+const v_uint64 BOUNDS_NS[] = {
+  25000, 50000, 100000, 250000, 500000,
+  1000000, 2500000, 5000000, 10000000, 25000000, 50000000,
+  100000000, 250000000, 500000000, 1000000000, 2500000000ULL, 5000000000ULL, 10000000000ULL
+};
+
+const v_float64 QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+const char* const QUANTILE_NAMES[] = {"0.5", "0.9", "0.99", "0.999"};
+
+/**
+ *  Shards used by this thread, one per Metrics. Handed back when the thread exits.
+ */
+struct ThreadShards {
+
+  std::vector<std::pair<v_uint64, std::shared_ptr<Metrics::Shard>>> shards;
+
+  ~ThreadShards() {
+    for (auto& pair : shards) {
+      pair.second->owned.store(false, std::memory_order_release);
+    }
+  }
+
+};
+
+thread_local ThreadShards THREAD_SHARDS;
+
+void appendf(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+void appendf(std::string& out, const char* format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  va_list retry;
+  va_copy(retry, args);
+  int size = std::vsnprintf(buffer, sizeof(buffer), format, args);
+  if (size >= (int) sizeof(buffer)) {
+    size_t start = out.size();
+    out.resize(start + (size_t) size + 1);
+    std::vsnprintf(&out[start], (size_t) size + 1, format, retry);
+    out.resize(start + (size_t) size);
+  } else if (size > 0) {
+    out.append(buffer, (size_t) size);
+  }
+  va_end(retry);
+  va_end(args);
+}
+
+std::string withLabels(const std::string& labels, const char* extra) {
+  if (labels.empty()) {
+    return extra[0] == 0 ? std::string() : std::string("{") + extra + "}";
+  }
+  return "{" + labels + (extra[0] == 0 ? "" : ",") + extra + "}";
+}
+
+}
+
+Metrics::ShardHistogram::ShardHistogram()
+  : sumNs(0)
+{
+  for (auto& count : counts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+Metrics::Shard::Shard()
+  : owned(true)
+{
+  for (auto& histogram : series) {
+    histogram.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+Metrics::Shard::~Shard() {
+  for (auto& histogram : series) {
+    delete histogram.load(std::memory_order_acquire);
+  }
+}
+
+Metrics::Metrics()
+  : m_id(NEXT_ID++)
+{}
+
+Metrics::Shard* Metrics::getShard() {
+  for (auto& pair : THREAD_SHARDS.shards) {
+    if (pair.first == m_id) {
+      return pair.second.get();
+    }
+  }
+  return acquireShard();
+}
+
+Metrics::Shard* Metrics::acquireShard() {
+
+  auto& cache = THREAD_SHARDS.shards;
+
+  // shards of destroyed Metrics are only held by the cache anymore
+  for (size_t i = cache.size(); i-- > 0;) {
+    if (cache[i].second.use_count() == 1) {
+      cache[i] = cache.back();
+      cache.pop_back();
+    }
+  }
+
+  std::shared_ptr<Shard> shard;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& candidate : m_shards) {
+      bool owned = false;
+      if (candidate->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+        shard = candidate; // counts of the exited thread stay, this thread adds to them
+        break;
+      }
+    }
+    if (!shard) {
+      shard = std::make_shared<Shard>();
+      m_shards.push_back(shard);
+    }
+  }
+
+  cache.emplace_back(m_id, shard);
+  return shard.get();
+
+}
+
+v_int32 Metrics::addSeries(const std::string& family, const std::string& help, const std::string& labels) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Series series;
+  series.family = -1;
+  for (size_t i = 0; i < m_families.size(); i++) {
+    if (m_families[i].name == family) {
+      series.family = (v_int32) i;
+    }
+  }
+  for (size_t i = 0; i < m_series.size(); i++) {
+    if (m_series[i].family == series.family && series.family >= 0 && m_series[i].labels == labels) {
+      return (v_int32) i; // i.E. the same endpoint of another bridge
+    }
+  }
+  if ((v_int32) m_series.size() >= MAX_SERIES) {
+    return -1;
+  }
+  if (series.family < 0) {
+    series.family = (v_int32) m_families.size();
+    m_families.push_back({family, help});
+  }
+  series.labels = labels;
+  m_series.push_back(series);
+  return (v_int32) m_series.size() - 1;
+}
+
+void Metrics::addGauge(const std::string& name, const std::string& help, const std::function<v_int64()>& read) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_gauges.push_back({name, help, read});
+}
+
+LatencyHistogram Metrics::getHistogram(v_int32 series) const {
+  LatencyHistogram result;
+  if (series < 0 || series >= MAX_SERIES) {
+    return result;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& shard : m_shards) {
+    ShardHistogram* histogram = shard->series[series].load(std::memory_order_acquire);
+    if (histogram == nullptr) {
+      continue;
+    }
+    // counts and sum are read one by one while the owner goes on recording, they may be off by the values recorded meanwhile
+    v_uint64 sumNs = histogram->sumNs.load(std::memory_order_relaxed);
+    for (v_int32 i = 0; i < LatencyHistogram::BUCKETS_COUNT; i++) {
+      v_uint64 count = histogram->counts[i].load(std::memory_order_relaxed);
+      if (count > 0) {
+        result.add(i, count, 0);
+      }
+    }
+    result.add(0, 0, sumNs);
+  }
+  return result;
+}
+
+v_int32 Metrics::getShardsCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return (v_int32) m_shards.size();
+}
+
+oatpp::String Metrics::render() const {
+
+  std::vector<Series> series;
+  std::vector<Family> families;
+  std::vector<Gauge> gauges;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    series = m_series;
+    families = m_families;
+    gauges = m_gauges;
+  }
+
+  std::string out;
+
+  for (size_t f = 0; f < families.size(); f++) {
+
+    const Family& family = families[f];
+    std::vector<std::pair<const Series*, LatencyHistogram>> histograms;
+    for (size_t s = 0; s < series.size(); s++) {
+      if (series[s].family == (v_int32) f) {
+        histograms.push_back({&series[s], getHistogram((v_int32) s)});
+      }
+    }
+
+    appendf(out, "# HELP %s_seconds %s\n", family.name.c_str(), family.help.c_str());
+    appendf(out, "# TYPE %s_seconds histogram\n", family.name.c_str());
+    for (auto& pair : histograms) {
+      const std::string& labels = pair.first->labels;
+      const LatencyHistogram& histogram = pair.second;
+      for (size_t b = 0; b < sizeof(BOUNDS_NS) / sizeof(BOUNDS_NS[0]); b++) {
+        std::string le = std::string("le=\"") + BOUNDS[b] + "\"";
+        appendf(out, "%s_seconds_bucket%s %llu\n", family.name.c_str(), withLabels(labels, le.c_str()).c_str(),
+                (unsigned long long) histogram.getCountAtOrBelow(BOUNDS_NS[b]));
+      }
+      appendf(out, "%s_seconds_bucket%s %llu\n", family.name.c_str(), withLabels(labels, "le=\"+Inf\"").c_str(),
+              (unsigned long long) histogram.getCount());
+      appendf(out, "%s_seconds_sum%s %.9f\n", family.name.c_str(), withLabels(labels, "").c_str(), histogram.getSumNs() / 1e9);
+      appendf(out, "%s_seconds_count%s %llu\n", family.name.c_str(), withLabels(labels, "").c_str(),
+              (unsigned long long) histogram.getCount());
+    }
+
+    appendf(out, "# HELP %s_quantile_seconds %s, percentiles\n", family.name.c_str(), family.help.c_str());
+    appendf(out, "# TYPE %s_quantile_seconds gauge\n", family.name.c_str());
+    for (auto& pair : histograms) {
+      for (size_t q = 0; q < sizeof(QUANTILES) / sizeof(QUANTILES[0]); q++) {
+        std::string quantile = std::string("quantile=\"") + QUANTILE_NAMES[q] + "\"";
+        appendf(out, "%s_quantile_seconds%s %.9f\n", family.name.c_str(),
+                withLabels(pair.first->labels, quantile.c_str()).c_str(), pair.second.getPercentile(QUANTILES[q]) / 1e9);
+      }
+    }
+
+  }
+
+  for (auto& gauge : gauges) {
+    appendf(out, "# HELP %s %s\n", gauge.name.c_str(), gauge.help.c_str());
+    appendf(out, "# TYPE %s gauge\n", gauge.name.c_str());
+    appendf(out, "%s %lld\n", gauge.name.c_str(), (long long) gauge.read());
+  }
+
+  return oatpp::String(out.data(), (v_buff_size) out.size());
+
+}
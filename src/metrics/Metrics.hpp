@@ -0,0 +1,153 @@
+#ifndef metrics_Metrics_hpp
+#define metrics_Metrics_hpp
+
+#include "LatencyHistogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ *  Latency histograms and gauges of the hub, rendered in the Prometheus text format for `GET /metrics`.
+ *
+ *  A series is one histogram, i.E. the latency of one endpoint. Series are added at startup, values are recorded
+ *  by any thread. Every thread records into its own shard - buckets only that thread writes,
+ *  so recording is a few plain stores without a lock or a shared atomic. `render()` sums the shards up.
+ *
+ *  A thread gets its shard on its first record() and hands it back when it exits,
+ *  so the thread-per-connection server reuses shards instead of adding one per connection.
+ */
+class Metrics {
+public:
+  static constexpr v_int32 MAX_SERIES = 64;
+public:
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   *  Buckets of one series in one shard. Written by the owning thread only.
+   */
+  struct ShardHistogram {
+    std::atomic<v_uint64> counts[LatencyHistogram::BUCKETS_COUNT];
+    std::atomic<v_uint64> sumNs;
+    ShardHistogram();
+  };
+
+  /**
+   *  Histograms of one thread. Kept by the Metrics and by the thread using it.
+   */
+  struct Shard {
+    std::atomic<ShardHistogram*> series[MAX_SERIES]; ///< created by the owning thread on its first record
+    std::atomic<bool> owned; ///< a thread records into this shard
+    Shard();
+    ~Shard();
+  };
+
+private:
+
+  struct Series {
+    v_int32 family;
+    std::string labels; ///< Prometheus labels without braces, i.E. `method="GET",path="/api"`
+  };
+
+  struct Family {
+    std::string name; ///< histogram is `<name>_seconds`, percentiles are `<name>_quantile_seconds`
+    std::string help;
+  };
+
+  struct Gauge {
+    std::string name;
+    std::string help;
+    std::function<v_int64()> read;
+  };
+
+private:
+  const v_uint64 m_id; ///< identifies the Metrics in the shard cache of a thread
+  mutable std::mutex m_mutex;
+  std::vector<std::shared_ptr<Shard>> m_shards; ///< guarded by m_mutex
+  std::vector<Series> m_series; ///< guarded by m_mutex
+  std::vector<Family> m_families; ///< guarded by m_mutex
+  std::vector<Gauge> m_gauges; ///< guarded by m_mutex
+private:
+  Shard* getShard();
+  Shard* acquireShard();
+public:
+
+  Metrics();
+
+  static std::shared_ptr<Metrics> createShared() {
+    return std::make_shared<Metrics>();
+  }
+
+  /**
+   * Add a histogram series. Adding a series of the same family and labels again returns the existing one.
+   * @param family - metric name without unit, i.E. `hue_http_request_duration`
+   * @param help - description of the family, taken from its first series
+   * @param labels - labels of the series without braces, may be empty
+   * @return - id to record() values with, `-1` if there are MAX_SERIES series already
+   */
+  v_int32 addSeries(const std::string& family, const std::string& help, const std::string& labels);
+
+  /**
+   * Add a gauge, read when the metrics are rendered.
+   * @param name
+   * @param help
+   * @param read - returns the current value, called from render()
+   */
+  void addGauge(const std::string& name, const std::string& help, const std::function<v_int64()>& read);
+
+  /**
+   * Record a value. Writes to the calling thread's shard only.
+   * @param series - returned by addSeries(), values of negative ids are dropped
+   * @param valueNs
+   */
+  void record(v_int32 series, v_uint64 valueNs) {
+    if (series < 0 || series >= MAX_SERIES) {
+      return;
+    }
+    Shard* shard = getShard();
+    ShardHistogram* histogram = shard->series[series].load(std::memory_order_relaxed);
+    if (histogram == nullptr) {
+      histogram = new ShardHistogram();
+      shard->series[series].store(histogram, std::memory_order_release);
+    }
+    // only this thread writes the shard - load + store instead of a locked read-modify-write
+    auto& count = histogram->counts[LatencyHistogram::getBucket(valueNs)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    histogram->sumNs.store(histogram->sumNs.load(std::memory_order_relaxed) + valueNs, std::memory_order_relaxed);
+  }
+
+  /**
+   * Record the time passed since `start`.
+   * @param series
+   * @param start
+   */
+  void recordSince(v_int32 series, Clock::time_point start) {
+    record(series, (v_uint64) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+  }
+
+  /**
+   * @param series
+   * @return - values recorded so far, summed over all shards
+   */
+  LatencyHistogram getHistogram(v_int32 series) const;
+
+  /**
+   * @return - number of shards handed out so far, at most the number of threads recording at the same time
+   */
+  v_int32 getShardsCount() const;
+
+  /**
+   * Render all series and gauges in the Prometheus text exposition format (version 0.0.4).
+   * Histogram buckets are summed from the fine buckets ending at or below each `le`.
+   * @return
+   */
+  oatpp::String render() const;
+
+};
+
+#endif /* metrics_Metrics_hpp */
@@ -0,0 +1,294 @@
+
+#include "HueStateParser.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/**
+ *  Cursor over the body. Every method returns `false` on input it doesn't handle.
+ */
+class Scanner {
+private:
+  const char* m_pos;
+  const char* m_end;
+public:
+
+  Scanner(const char* data, v_buff_size size)
+    : m_pos(data)
+    , m_end(data + size)
+  {}
+
+  void skipWhitespace() {
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r')) {
+      m_pos++;
+    }
+  }
+
+  bool atEnd() const {
+    return m_pos == m_end;
+  }
+
+  bool consume(char c) {
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == c) {
+      m_pos++;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Unescaped string, points into the body.
+   */
+  bool readString(const char*& str, v_buff_size& size) {
+    if (!consume('"')) {
+      return false;
+    }
+    str = m_pos;
+    while (m_pos < m_end && *m_pos != '"') {
+      if (*m_pos == '\\' || (unsigned char) *m_pos < 0x20) {
+        return false;
+      }
+      m_pos++;
+    }
+    if (m_pos == m_end) {
+      return false;
+    }
+    size = m_pos - str;
+    m_pos++;
+    return true;
+  }
+
+  bool readUnsigned(v_uint32 max, v_uint32& value) {
+    skipWhitespace();
+    const char* start = m_pos;
+    v_uint32 result = 0;
+    while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+      result = result * 10 + (v_uint32) (*m_pos - '0');
+      if (result > max) {
+        return false;
+      }
+      m_pos++;
+    }
+    if (m_pos == start || (m_pos < m_end && (*m_pos == '.' || *m_pos == 'e' || *m_pos == 'E'))) {
+      return false;
+    }
+    value = result;
+    return true;
+  }
+
+  /**
+   * Plain decimal between 0 and 1, like the coordinates of `xy`. Digits after the 9th decimal are ignored.
+   */
+  bool readFraction(float& value) {
+    skipWhitespace();
+    const char* start = m_pos;
+    v_uint32 integer = 0;
+    while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+      integer = integer * 10 + (v_uint32) (*m_pos - '0');
+      if (integer > 1) {
+        return false;
+      }
+      m_pos++;
+    }
+    if (m_pos == start) {
+      return false;
+    }
+    v_uint32 fraction = 0;
+    v_uint32 scale = 1;
+    if (m_pos < m_end && *m_pos == '.') {
+      m_pos++;
+      const char* digits = m_pos;
+      while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+        if (scale < 1000000000) {
+          fraction = fraction * 10 + (v_uint32) (*m_pos - '0');
+          scale *= 10;
+        }
+        m_pos++;
+      }
+      if (m_pos == digits) {
+        return false;
+      }
+    }
+    if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+      return false;
+    }
+    if (integer == 1 && fraction != 0) {
+      return false;
+    }
+    value = (float) (integer + (double) fraction / scale);
+    return true;
+  }
+
+  bool readBoolean(bool& value) {
+    skipWhitespace();
+    if (m_end - m_pos >= 4 && std::memcmp(m_pos, "true", 4) == 0) {
+      m_pos += 4;
+      value = true;
+      return true;
+    }
+    if (m_end - m_pos >= 5 && std::memcmp(m_pos, "false", 5) == 0) {
+      m_pos += 5;
+      value = false;
+      return true;
+    }
+    return false;
+  }
+
+};
+
+bool keyEquals(const char* key, v_buff_size size, const char* name) {
+  return (v_buff_size) std::strlen(name) == size && std::memcmp(key, name, (size_t) size) == 0;
+}
+
+bool parseColorMode(const char* str, v_buff_size size, HueColorMode& mode) {
+  if (keyEquals(str, size, "hs") || keyEquals(str, size, "hue")) {
+    mode = HueColorMode::HS;
+  } else if (keyEquals(str, size, "xy")) {
+    mode = HueColorMode::XY;
+  } else if (keyEquals(str, size, "ct")) {
+    mode = HueColorMode::CT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ *  WriteCallback collecting the request body. Stays in the stack buffer unless the body is larger.
+ */
+class BodyBuffer : public oatpp::data::stream::WriteCallback {
+public:
+  static constexpr v_buff_size STACK_SIZE = 512;
+private:
+  char m_stack[STACK_SIZE];
+  v_buff_size m_size;
+  std::string m_heap; ///< used once the body doesn't fit m_stack
+public:
+
+  BodyBuffer()
+    : m_size(0)
+  {}
+
+  oatpp::v_io_size write(const void *data, v_buff_size count, oatpp::async::Action& action) override {
+    (void) action;
+    if (m_heap.empty() && m_size + count <= STACK_SIZE) {
+      std::memcpy(m_stack + m_size, data, (size_t) count);
+    } else {
+      if (m_heap.empty()) {
+        m_heap.assign(m_stack, (size_t) m_size);
+      }
+      m_heap.append((const char*) data, (size_t) count);
+    }
+    m_size += count;
+    return count;
+  }
+
+  const char* getData() const {
+    return m_heap.empty() ? m_stack : m_heap.data();
+  }
+
+  v_buff_size getSize() const {
+    return m_size;
+  }
+
+};
+
+constexpr v_buff_size BodyBuffer::STACK_SIZE;
+
+}
+
+bool HueStateParser::parse(const char* data, v_buff_size size, HueStateUpdate& update) {
+
+  Scanner scanner(data, size);
+  update = HueStateUpdate();
+
+  if (!scanner.consume('{')) {
+    return false;
+  }
+
+  if (!scanner.consume('}')) {
+    do {
+
+      const char* key;
+      v_buff_size keySize;
+      if (!scanner.readString(key, keySize) || !scanner.consume(':')) {
+        return false;
+      }
+
+      v_uint32 value;
+      if (keyEquals(key, keySize, "on")) {
+        if (!scanner.readBoolean(update.on)) return false;
+        update.fields |= HueStateUpdate::FIELD_ON;
+      } else if (keyEquals(key, keySize, "bri")) {
+        if (!scanner.readUnsigned(255, value)) return false;
+        update.bri = (v_uint8) value;
+        update.fields |= HueStateUpdate::FIELD_BRI;
+      } else if (keyEquals(key, keySize, "sat")) {
+        if (!scanner.readUnsigned(255, value)) return false;
+        update.sat = (v_uint8) value;
+        update.fields |= HueStateUpdate::FIELD_SAT;
+      } else if (keyEquals(key, keySize, "hue")) {
+        if (!scanner.readUnsigned(65535, value)) return false;
+        update.hue = (v_uint16) value;
+        update.fields |= HueStateUpdate::FIELD_HUE;
+      } else if (keyEquals(key, keySize, "ct")) {
+        if (!scanner.readUnsigned(65535, value)) return false;
+        update.ct = (v_uint16) value;
+        update.fields |= HueStateUpdate::FIELD_CT;
+      } else if (keyEquals(key, keySize, "xy")) {
+        if (!scanner.consume('[') || !scanner.readFraction(update.x) || !scanner.consume(',') ||
+            !scanner.readFraction(update.y) || !scanner.consume(']')) return false;
+        update.fields |= HueStateUpdate::FIELD_XY;
+      } else if (keyEquals(key, keySize, "transitiontime")) {
+        if (!scanner.readUnsigned(65535, value)) return false;
+        update.transitiontime = (v_uint16) value;
+        update.fields |= HueStateUpdate::FIELD_TRANSITIONTIME;
+      } else if (keyEquals(key, keySize, "colormode")) {
+        const char* mode;
+        v_buff_size modeSize;
+        if (!scanner.readString(mode, modeSize) || !parseColorMode(mode, modeSize, update.colormode)) return false;
+        update.fields |= HueStateUpdate::FIELD_COLORMODE;
+      } else {
+        return false;
+      }
+
+    } while (scanner.consume(','));
+
+    if (!scanner.consume('}')) {
+      return false;
+    }
+  }
+
+  scanner.skipWhitespace();
+  return scanner.atEnd();
+
+}
+
+bool HueStateParser::parse(const char* data, v_buff_size size, oatpp::data::mapping::ObjectMapper* objectMapper, HueStateUpdate& update) {
+  if (parse(data, size, update)) {
+    return true;
+  }
+  oatpp::Object<HueDeviceStateDto> dto;
+  try {
+    dto = objectMapper->readFromString<oatpp::Object<HueDeviceStateDto>>(oatpp::String(data, size));
+  } catch (const std::runtime_error&) { // not JSON at all
+    return false;
+  }
+  if (dto == nullptr) {
+    return false;
+  }
+  update = HueStateUpdate::fromDto(dto);
+  return true;
+}
+
+bool HueStateParser::read(const std::shared_ptr<oatpp::web::protocol::http::incoming::Request>& request,
+                          oatpp::data::mapping::ObjectMapper* objectMapper,
+                          HueStateUpdate& update) {
+  BodyBuffer body;
+  request->transferBody(&body);
+  return parse(body.getData(), body.getSize(), objectMapper, update);
+}
@@ -0,0 +1,53 @@
+#ifndef HueStateParser_hpp
+#define HueStateParser_hpp
+
+#include "db/model/HueStateUpdate.hpp"
+
+#include "oatpp/web/protocol/http/incoming/Request.hpp"
+#include "oatpp/core/data/mapping/ObjectMapper.hpp"
+
+/**
+ *  Reads light state bodies (`{"on":true,"bri":254}`) straight into a HueStateUpdate, without allocating.
+ *
+ *  Only the plain form sent by Hue clients is handled: a flat object of the keys
+ *  `on`, `bri`, `hue`, `sat`, `ct`, `colormode` and `transitiontime` with unsigned integer, boolean or
+ *  unescaped string values, and `xy` as a pair of plain decimals between 0 and 1.
+ *  Anything else (other keys, `null`, escapes, numbers out of range, exponents, ...)
+ *  is rejected and has to go through the ObjectMapper - see `read()`.
+ */
+class HueStateParser {
+public:
+
+  /**
+   * Parse a state body.
+   * @param data - body
+   * @param size - body size
+   * @param update - out: the requested attributes
+   * @return - `false` if the body is not in the plain form. `update` is undefined then.
+   */
+  static bool parse(const char* data, v_buff_size size, HueStateUpdate& update);
+
+  /**
+   * Parse a state body, falling back to HueDeviceStateDto via the ObjectMapper if `parse()` rejects it.
+   * @param data - body
+   * @param size - body size
+   * @param objectMapper - mapper for the fallback
+   * @param update - out: the requested attributes
+   * @return - `false` if the body is not a state object at all
+   */
+  static bool parse(const char* data, v_buff_size size, oatpp::data::mapping::ObjectMapper* objectMapper, HueStateUpdate& update);
+
+  /**
+   * Read and parse the body of a request. Bodies up to 512 bytes are read into a stack buffer.
+   * @param request
+   * @param objectMapper - mapper for the fallback
+   * @param update - out: the requested attributes
+   * @return - `false` if the body is not a state object
+   */
+  static bool read(const std::shared_ptr<oatpp::web::protocol::http::incoming::Request>& request,
+                   oatpp::data::mapping::ObjectMapper* objectMapper,
+                   HueStateUpdate& update);
+
+};
+
+#endif /* HueStateParser_hpp */
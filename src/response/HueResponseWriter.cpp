@@ -0,0 +1,207 @@
+
+#include "HueResponseWriter.hpp"
+
+#include "color/ColorModel.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+constexpr v_buff_size HueResponseWriter::CAPACITY;
+
+namespace {
+
+/**
+ *  Attributes reported by addStateSuccess(), in the order of the Hue API.
+ *  `key` closes the path and the JSON key.
+ */
+struct Attribute {
+  v_uint8 field;
+  const char* key;
+  v_buff_size keySize;
+};
+
+#define HUE_ATTRIBUTE(FIELD, NAME) {HueStateUpdate::FIELD, NAME "\":", sizeof(NAME "\":") - 1}
+
+const Attribute ATTRIBUTES[] = {
+  HUE_ATTRIBUTE(FIELD_ON, "on"),
+  HUE_ATTRIBUTE(FIELD_BRI, "bri"),
+  HUE_ATTRIBUTE(FIELD_HUE, "hue"),
+  HUE_ATTRIBUTE(FIELD_SAT, "sat"),
+  HUE_ATTRIBUTE(FIELD_XY, "xy"),
+  HUE_ATTRIBUTE(FIELD_CT, "ct"),
+  HUE_ATTRIBUTE(FIELD_COLORMODE, "colormode"),
+  HUE_ATTRIBUTE(FIELD_TRANSITIONTIME, "transitiontime")
+};
+
+#undef HUE_ATTRIBUTE
+
+const char SUCCESS_ENTRY[] = "{\"success\":";
+const char ERROR_ENTRY[] = "{\"error\":";
+
+/**
+ *  Upper bound of the size of `str` written by writeString() - every character escaped plus quotes.
+ */
+v_buff_size maxStringSize(const char* str) {
+  return (v_buff_size) std::strlen(str) * 6 + 2;
+}
+
+}
+
+HueResponseWriter::HueResponseWriter()
+  : m_size(1)
+  , m_empty(true)
+{
+  m_data[0] = '[';
+}
+
+void HueResponseWriter::write(const char* data, v_buff_size size) {
+  // keep room for the closing ']'
+  if (size > CAPACITY - 1 - m_size) {
+    size = CAPACITY - 1 - m_size;
+  }
+  std::memcpy(m_data + m_size, data, (size_t) size);
+  m_size += size;
+}
+
+void HueResponseWriter::write(const char* str) {
+  write(str, (v_buff_size) std::strlen(str));
+}
+
+void HueResponseWriter::writeInt(v_int64 value) {
+  char digits[24];
+  v_buff_size pos = sizeof(digits);
+  bool negative = value < 0;
+  v_uint64 rest = negative ? 0 - (v_uint64) value : (v_uint64) value;
+  do {
+    digits[--pos] = (char) ('0' + rest % 10);
+    rest /= 10;
+  } while (rest != 0);
+  if (negative) {
+    digits[--pos] = '-';
+  }
+  write(digits + pos, (v_buff_size) sizeof(digits) - pos);
+}
+
+void HueResponseWriter::writeCoordinates(float x, float y) {
+  char coordinates[32];
+  v_buff_size size = snprintf(coordinates, sizeof(coordinates), "[%.4g,%.4g]", x, y);
+  write(coordinates, size);
+}
+
+void HueResponseWriter::writeString(const char* str) {
+  write("\"", 1);
+  const char* begin = str;
+  for (const char* pos = str; *pos != 0; pos++) {
+    if (*pos == '"' || *pos == '\\' || (unsigned char) *pos < 0x20) {
+      write(begin, pos - begin);
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) *pos);
+      write(escaped, 6);
+      begin = pos + 1;
+    }
+  }
+  write(begin, (v_buff_size) std::strlen(begin));
+  write("\"", 1);
+}
+
+bool HueResponseWriter::beginEntry(const char* type, v_buff_size size, v_buff_size maxPayloadSize) {
+  // an entry has to fit as a whole, with separator, closing '}' and the array's closing ']'
+  if (m_size + 1 + size + maxPayloadSize + 1 + 1 > CAPACITY) {
+    return false;
+  }
+  if (!m_empty) {
+    write(",", 1);
+  }
+  m_empty = false;
+  write(type, size);
+  return true;
+}
+
+void HueResponseWriter::endEntry() {
+  write("}", 1);
+}
+
+void HueResponseWriter::addStateSuccess(const char* resource, v_int32 number, const char* part,
+                                        const HueStateUpdate& requested, const HueDevice& applied)
+{
+  char prefix[64];
+  v_buff_size prefixSize = snprintf(prefix, sizeof(prefix), "{\"%s%d%s", resource, number, part);
+  if (prefixSize < 0 || prefixSize >= (v_buff_size) sizeof(prefix)) {
+    return;
+  }
+
+  // the applied color in the spaces of the requested attributes
+  ColorModel::Color color = {};
+  const v_uint8 colorFields = HueStateUpdate::FIELD_HUE | HueStateUpdate::FIELD_SAT | HueStateUpdate::FIELD_CT | HueStateUpdate::FIELD_XY;
+  if (requested.has(colorFields)) {
+    color = ColorModel::convert(applied);
+  }
+
+  for (const Attribute& attribute : ATTRIBUTES) {
+    // longest value is a 20 digit number, xy takes up to 15 characters
+    if (!requested.has(attribute.field) ||
+        !beginEntry(SUCCESS_ENTRY, sizeof(SUCCESS_ENTRY) - 1, prefixSize + attribute.keySize + 20 + 1)) {
+      continue;
+    }
+    write(prefix, prefixSize);
+    write(attribute.key, attribute.keySize);
+    switch (attribute.field) {
+      case HueStateUpdate::FIELD_ON: write(applied.isOn() ? "true" : "false"); break;
+      case HueStateUpdate::FIELD_BRI: writeInt(applied.bri); break;
+      case HueStateUpdate::FIELD_HUE: writeInt(color.hue); break;
+      case HueStateUpdate::FIELD_SAT: writeInt(color.sat); break;
+      case HueStateUpdate::FIELD_XY: writeCoordinates(color.x, color.y); break;
+      case HueStateUpdate::FIELD_CT: writeInt(color.ct); break;
+      case HueStateUpdate::FIELD_COLORMODE: writeString(HueDevice::colorModeToString(applied.mode)); break;
+      case HueStateUpdate::FIELD_TRANSITIONTIME: writeInt(requested.transitiontime); break;
+      default: break;
+    }
+    write("}", 1);
+    endEntry();
+  }
+}
+
+void HueResponseWriter::addSuccess(const char* key, const char* value) {
+  if (beginEntry(SUCCESS_ENTRY, sizeof(SUCCESS_ENTRY) - 1, maxStringSize(key) + maxStringSize(value) + 3)) {
+    write("{", 1);
+    writeString(key);
+    write(":", 1);
+    writeString(value);
+    write("}", 1);
+    endEntry();
+  }
+}
+
+void HueResponseWriter::addSuccess(const char* message) {
+  if (beginEntry(SUCCESS_ENTRY, sizeof(SUCCESS_ENTRY) - 1, maxStringSize(message))) {
+    writeString(message);
+    endEntry();
+  }
+}
+
+void HueResponseWriter::addError(v_int32 type, const char* address, const char* description) {
+  // {"type":<11 chars>,"address":<address>,"description":<description>}
+  if (beginEntry(ERROR_ENTRY, sizeof(ERROR_ENTRY) - 1, 44 + maxStringSize(address) + maxStringSize(description))) {
+    write("{\"type\":");
+    writeInt(type);
+    write(",\"address\":");
+    writeString(address);
+    write(",\"description\":");
+    writeString(description);
+    write("}", 1);
+    endEntry();
+  }
+}
+
+const char* HueResponseWriter::getData() {
+  m_data[m_size] = ']';
+  return m_data;
+}
+
+v_buff_size HueResponseWriter::getSize() {
+  return m_size + 1;
+}
+
+oatpp::String HueResponseWriter::toString() {
+  return oatpp::String(getData(), getSize());
+}
@@ -0,0 +1,84 @@
+#ifndef HueResponseWriter_hpp
+#define HueResponseWriter_hpp
+
+#include "db/model/HueStateUpdate.hpp"
+
+#include "oatpp/core/Types.hpp"
+
+/**
+ *  Writes the "success"/"error" arrays answered by Hue hubs, i.E.
+ *  `[{"success":{"/lights/1/state/on":true}},{"success":{"/lights/1/state/bri":254}}]` or
+ *  `[{"error":{"type":3,"address":"/lights/9","description":"resource, /lights/9, not available"}}]`,
+ *  straight into a fixed buffer - without building a GenericResponseDto first.
+ *
+ *  The buffer holds any response of a single state change. Entries not fitting into it as a whole are dropped.
+ */
+class HueResponseWriter {
+public:
+  static constexpr v_buff_size CAPACITY = 1024;
+public:
+  /*
+   *  Hue API error types
+   */
+  static constexpr v_int32 ERROR_INVALID_JSON = 2;
+  static constexpr v_int32 ERROR_RESOURCE_NOT_AVAILABLE = 3;
+  static constexpr v_int32 ERROR_INVALID_VALUE = 7;
+  static constexpr v_int32 ERROR_INTERNAL = 901;
+private:
+  char m_data[CAPACITY];
+  v_buff_size m_size;
+  bool m_empty;
+private:
+  void write(const char* data, v_buff_size size);
+  void write(const char* str);
+  void writeInt(v_int64 value);
+  void writeCoordinates(float x, float y);
+  void writeString(const char* str);
+  bool beginEntry(const char* type, v_buff_size size, v_buff_size maxPayloadSize);
+  void endEntry();
+public:
+
+  HueResponseWriter();
+
+  /**
+   * One "success" entry per requested attribute, keyed by `<resource><number><part>/<attribute>` -
+   * i.E. `/lights/1/state/bri`. The key prefix is rendered once for all entries.
+   * @param resource - "/lights/" or "/groups/"
+   * @param number - Hue light or group number
+   * @param part - "/state/" or "/action/"
+   * @param requested - attributes to report
+   * @param applied - values to report, the record after the change
+   */
+  void addStateSuccess(const char* resource, v_int32 number, const char* part,
+                       const HueStateUpdate& requested, const HueDevice& applied);
+
+  /**
+   * `{"success":{"<key>":"<value>"}}`
+   */
+  void addSuccess(const char* key, const char* value);
+
+  /**
+   * `{"success":"<message>"}`
+   */
+  void addSuccess(const char* message);
+
+  /**
+   * `{"error":{"type":<type>,"address":"<address>","description":"<description>"}}`
+   * @param type - one of the `ERROR_*` types
+   */
+  void addError(v_int32 type, const char* address, const char* description);
+
+  /**
+   * The JSON array written so far. Valid until the next `add*()` call.
+   */
+  const char* getData();
+  v_buff_size getSize();
+
+  /**
+   * @return - the JSON array as response body
+   */
+  oatpp::String toString();
+
+};
+
+#endif /* HueResponseWriter_hpp */
@@ -0,0 +1,35 @@
+#include "LightsJsonReader.hpp"
+
+#include <cstring>
+
+constexpr v_buff_size LightsJsonReader::CHUNK_SIZE;
+constexpr v_uint32 LightsJsonReader::STREAM_THRESHOLD;
+
+LightsJsonReader::LightsJsonReader(const Database::HueDevicesJsonCursor& cursor)
+  : m_cursor(cursor)
+  , m_position(0)
+{
+  m_buffer.reserve(CHUNK_SIZE * 2);
+}
+
+oatpp::v_io_size LightsJsonReader::read(void *buffer, v_buff_size count, oatpp::async::Action& action) {
+
+  (void) action;
+
+  if (m_position == m_buffer.size()) {
+    m_buffer.clear();
+    m_position = 0;
+    if (!m_cursor.next(m_buffer, CHUNK_SIZE)) {
+      return 0; // end of the object
+    }
+  }
+
+  v_buff_size size = (v_buff_size) (m_buffer.size() - m_position);
+  if (size > count) {
+    size = count;
+  }
+  std::memcpy(buffer, m_buffer.data() + m_position, (size_t) size);
+  m_position += (size_t) size;
+  return size;
+
+}
@@ -0,0 +1,35 @@
+#ifndef LightsJsonReader_hpp
+#define LightsJsonReader_hpp
+
+#include "db/Database.hpp"
+
+#include "oatpp/core/data/stream/Stream.hpp"
+
+#include <string>
+
+/**
+ *  Body of `GET /api/{username}/lights` for large hubs, sent with `Transfer-Encoding: chunked`.
+ *  Renders about CHUNK_SIZE bytes of the lights object at a time from a Database::HueDevicesJsonCursor,
+ *  so neither the time to the first byte nor the memory taken by the response grow with the number of lights.
+ */
+class LightsJsonReader : public oatpp::data::stream::ReadCallback {
+public:
+  static constexpr v_buff_size CHUNK_SIZE = 16 * 1024;
+
+  /**
+   * Responses of up to this many lights are rendered at once and sent with a Content-Length instead.
+   */
+  static constexpr v_uint32 STREAM_THRESHOLD = 256;
+private:
+  Database::HueDevicesJsonCursor m_cursor;
+  std::string m_buffer; ///< rendered part not read yet
+  size_t m_position;
+public:
+
+  LightsJsonReader(const Database::HueDevicesJsonCursor& cursor);
+
+  oatpp::v_io_size read(void *buffer, v_buff_size count, oatpp::async::Action& action) override;
+
+};
+
+#endif /* LightsJsonReader_hpp */
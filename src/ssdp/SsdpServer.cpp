@@ -0,0 +1,328 @@
+
+#include "SsdpServer.hpp"
+
+#include "logging/AsyncLogger.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+constexpr v_int32 SsdpServer::POLL_INTERVAL_MS;
+constexpr v_int32 SsdpServer::MAX_PACKET_SIZE;
+constexpr v_int32 SsdpServer::STARTUP_DELAY_MS;
+constexpr v_int64 SsdpServer::WHEEL_SLOTS;
+constexpr v_int32 SsdpServer::MAX_RECENT_SEARCHES;
+
+namespace {
+
+const char* const TAG = "SsdpServer";
+const char* const SEARCH_LINE = "M-SEARCH * ";
+const char* const SEARCH_ALL = "ssdp:all";
+
+}
+
+SsdpServer::SsdpServer(const Config& config,
+                       const std::vector<std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>>& descriptors,
+                       const std::shared_ptr<Metrics>& metrics)
+  : m_config(config)
+  , m_descriptors(descriptors)
+  , m_metrics(metrics)
+  , m_series(metrics ? metrics->addSeries("hue_ssdp_search_duration", "Time taken to answer SSDP searches",
+                                         "method=\"M-SEARCH\",path=\"*\"") : -1)
+  , m_fd(::socket(AF_INET, SOCK_DGRAM, 0))
+  , m_port(config.port)
+  , m_running(true)
+  , m_searches(0)
+  , m_responses(0)
+  , m_ignored(0)
+  , m_unmatched(0)
+  , m_duplicates(0)
+  , m_notifications(0)
+  , m_wheel(WHEEL_SLOTS)
+  , m_random(std::random_device()())
+  , m_start(std::chrono::steady_clock::now())
+{
+
+  if (config.tickMs <= 0) {
+    throw std::runtime_error("SSDP tickMs has to be positive");
+  }
+
+  std::memset(&m_notifyAddress, 0, sizeof(m_notifyAddress));
+  m_notifyAddress.sin_family = AF_INET;
+  m_notifyAddress.sin_port = htons(config.notifyPort);
+  if (!config.notifyHost.empty() && ::inet_pton(AF_INET, config.notifyHost.c_str(), &m_notifyAddress.sin_addr) != 1) {
+    throw std::runtime_error("Invalid SSDP notify address '" + config.notifyHost + "'");
+  }
+
+  if (m_fd < 0) {
+    throw std::runtime_error(std::string("Can't create SSDP socket: ") + std::strerror(errno));
+  }
+
+  int yes = 1;
+  ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)); // other UPnP stacks of the host listen on 1900 too
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config.port);
+  if (::inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1 ||
+      ::bind(m_fd, (const sockaddr*) &address, sizeof(address)) != 0)
+  {
+    std::string message = "Can't bind SSDP socket to " + config.host + ":" + std::to_string(config.port) + ": " + std::strerror(errno);
+    ::close(m_fd);
+    throw std::runtime_error(message);
+  }
+
+  socklen_t size = sizeof(address);
+  if (::getsockname(m_fd, (sockaddr*) &address, &size) == 0) {
+    m_port = ntohs(address.sin_port);
+  }
+
+  if (!config.multicastGroup.empty()) {
+    ip_mreq membership;
+    std::memset(&membership, 0, sizeof(membership));
+    membership.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (::inet_pton(AF_INET, config.multicastGroup.c_str(), &membership.imr_multiaddr) != 1 ||
+        ::setsockopt(m_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+    {
+      // i.E. no multicast route - searches sent to the hub directly are still answered
+      OATPP_LOGW(TAG, "Can't join multicast group %s: %s", config.multicastGroup.c_str(), std::strerror(errno));
+    }
+  }
+
+  unsigned char ttl = 4; // UDA 1.0 default for the announcements
+  ::setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+}
+
+SsdpServer::~SsdpServer() {
+  ::close(m_fd);
+}
+
+bool SsdpServer::isSearch(const char* packet, v_buff_size size) {
+  v_buff_size length = (v_buff_size) std::strlen(SEARCH_LINE);
+  return size >= length && std::memcmp(packet, SEARCH_LINE, (size_t) length) == 0;
+}
+
+std::string SsdpServer::getHeader(const char* packet, v_buff_size size, const char* name) {
+  const char* end = packet + size;
+  size_t nameSize = std::strlen(name);
+  const char* line = (const char*) std::memchr(packet, '\n', (size_t) size); // skip the request line
+  while (line != nullptr && ++line < end) {
+    const char* lineEnd = (const char*) std::memchr(line, '\n', (size_t) (end - line));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+    if ((size_t) (lineEnd - line) > nameSize && line[nameSize] == ':' && ::strncasecmp(line, name, nameSize) == 0) {
+      const char* value = line + nameSize + 1;
+      const char* valueEnd = lineEnd;
+      while (value < valueEnd && (*value == ' ' || *value == '\t')) {
+        value++;
+      }
+      while (valueEnd > value && (valueEnd[-1] == '\r' || valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+        valueEnd--;
+      }
+      return std::string(value, (size_t) (valueEnd - value));
+    }
+    line = lineEnd;
+  }
+  return "";
+}
+
+bool SsdpServer::isDuplicate(const sockaddr_storage& sender, socklen_t senderSize, const std::string& target, v_int64 tick) {
+
+  if (m_config.duplicateWindowMs <= 0) {
+    return false;
+  }
+
+  while (!m_recentOrder.empty() && m_recentOrder.front().first <= tick) {
+    auto it = m_recentSearches.find(m_recentOrder.front().second);
+    if (it != m_recentSearches.end() && it->second <= tick) {
+      m_recentSearches.erase(it);
+    }
+    m_recentOrder.pop_front();
+  }
+
+  std::string key((const char*) &sender, (size_t) senderSize);
+  key += target;
+  if (m_recentSearches.find(key) != m_recentSearches.end()) {
+    return true;
+  }
+  if (m_recentSearches.size() < (size_t) MAX_RECENT_SEARCHES) {
+    v_int64 windowEnd = tick + (m_config.duplicateWindowMs + m_config.tickMs - 1) / m_config.tickMs;
+    m_recentSearches[key] = windowEnd;
+    m_recentOrder.emplace_back(windowEnd, std::move(key));
+  }
+  return false;
+
+}
+
+void SsdpServer::answer(const char* packet, v_buff_size size, const sockaddr_storage& sender, socklen_t senderSize) {
+
+  if (!isSearch(packet, size)) {
+    m_ignored.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto start = Metrics::Clock::now();
+  m_searches.fetch_add(1, std::memory_order_relaxed);
+
+  auto target = getHeader(packet, size, "ST");
+  bool all = target == SEARCH_ALL;
+  v_int64 tick = getTicks();
+
+  // MX is required for multicast searches only - unicast searches are answered right away, every time
+  auto mx = getHeader(packet, size, "MX");
+  if (!mx.empty() && isDuplicate(sender, senderSize, target, tick)) {
+    m_duplicates.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  v_int32 maxDelayMs = (v_int32) std::atoi(mx.c_str()) * 1000;
+  if (maxDelayMs > m_config.maxResponseDelayMs) {
+    maxDelayMs = m_config.maxResponseDelayMs;
+  }
+
+  v_int32 answering = 0;
+  for (v_uint32 i = 0; i < m_descriptors.size(); i++) {
+
+    Task task;
+    task.bridge = i;
+    task.targets = 0;
+    auto& targets = m_descriptors[i]->getRendered()->searchTargets;
+    for (v_uint32 t = 0; t < targets.size(); t++) {
+      if (all || target == *targets[t]) {
+        task.targets |= 1u << t;
+      }
+    }
+    if (task.targets == 0) {
+      continue;
+    }
+    answering++;
+
+    std::memcpy(&task.address, &sender, (size_t) senderSize);
+    task.addressSize = senderSize;
+    v_int64 delay = maxDelayMs > 0 ? (v_int64) (m_random() % (v_uint32) (maxDelayMs + 1)) / m_config.tickMs : 0;
+    if (delay == 0) {
+      respond(task);
+    } else {
+      m_wheel.schedule(tick + delay, task);
+    }
+
+  }
+
+  if (answering == 0) {
+    m_unmatched.fetch_add(1, std::memory_order_relaxed);
+  }
+  HUE_LOGD(TAG, "'M-SEARCH *' Received for '%s', answering for %d bridges within %dms", target.c_str(), answering, maxDelayMs);
+
+  if (m_metrics) {
+    m_metrics->recordSince(m_series, start);
+  }
+
+}
+
+void SsdpServer::respond(const Task& task) {
+  auto rendered = m_descriptors[task.bridge]->getRendered();
+  for (v_uint32 t = 0; t < rendered->searchResponses.size(); t++) {
+    if ((task.targets & (1u << t)) == 0) {
+      continue;
+    }
+    auto& response = rendered->searchResponses[t];
+    if (::sendto(m_fd, response->data(), response->size(), 0, (const sockaddr*) &task.address, task.addressSize) >= 0) {
+      m_responses.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void SsdpServer::notify(const std::vector<oatpp::String>& packets) {
+  for (auto& packet : packets) {
+    if (::sendto(m_fd, packet->data(), packet->size(), 0, (const sockaddr*) &m_notifyAddress, sizeof(m_notifyAddress)) >= 0) {
+      m_notifications.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+v_int64 SsdpServer::getTicks() const {
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start).count();
+  return (v_int64) elapsed / m_config.tickMs;
+}
+
+v_int32 SsdpServer::getAnnounceDelayMs() {
+  if (m_config.announceJitterMs <= 0) {
+    return m_config.announceIntervalMs;
+  }
+  return m_config.announceIntervalMs - (v_int32) (m_random() % (v_uint32) (m_config.announceJitterMs + 1));
+}
+
+void SsdpServer::run() {
+
+  const bool announce = !m_config.notifyHost.empty();
+  if (announce) {
+    v_int64 tick = getTicks();
+    for (v_uint32 i = 0; i < m_descriptors.size(); i++) {
+      Task task;
+      task.bridge = i;
+      task.targets = 0;
+      task.addressSize = 0;
+      m_wheel.schedule(tick + (v_int64) (m_random() % STARTUP_DELAY_MS) / m_config.tickMs, task);
+    }
+  }
+
+  char packet[MAX_PACKET_SIZE];
+
+  while (m_running) {
+
+    pollfd pollFd;
+    pollFd.fd = m_fd;
+    pollFd.events = POLLIN;
+    pollFd.revents = 0;
+    if (::poll(&pollFd, 1, m_wheel.getSize() > 0 ? m_config.tickMs : POLL_INTERVAL_MS) > 0) {
+      sockaddr_storage sender;
+      socklen_t senderSize = sizeof(sender);
+      auto res = ::recvfrom(m_fd, packet, sizeof(packet), 0, (sockaddr*) &sender, &senderSize);
+      if (res > 0) {
+        answer(packet, (v_buff_size) res, sender, senderSize);
+      }
+    }
+
+    m_wheel.advance(getTicks(), [this](v_int64 tick, const Task& task) {
+      if (task.targets != 0) {
+        respond(task);
+        return;
+      }
+      notify(m_descriptors[task.bridge]->getRendered()->aliveNotifications);
+      m_wheel.schedule(tick + getAnnounceDelayMs() / m_config.tickMs, task);
+    });
+
+  }
+
+  if (announce) {
+    for (auto& descriptor : m_descriptors) {
+      notify(descriptor->getRendered()->byebyeNotifications);
+    }
+  }
+
+}
+
+void SsdpServer::stop() {
+  m_running = false;
+}
+
+SsdpServer::Stats SsdpServer::getStats() const {
+  Stats stats;
+  stats.searches = m_searches.load(std::memory_order_relaxed);
+  stats.responses = m_responses.load(std::memory_order_relaxed);
+  stats.ignored = m_ignored.load(std::memory_order_relaxed);
+  stats.unmatched = m_unmatched.load(std::memory_order_relaxed);
+  stats.duplicates = m_duplicates.load(std::memory_order_relaxed);
+  stats.notifications = m_notifications.load(std::memory_order_relaxed);
+  return stats;
+}
@@ -0,0 +1,164 @@
+#ifndef ssdp_SsdpServer_hpp
+#define ssdp_SsdpServer_hpp
+
+#include "DeviceDescriptorComponent.hpp"
+#include "TimerWheel.hpp"
+
+#include "metrics/Metrics.hpp"
+
+#include "oatpp/core/Types.hpp"
+
+#include <netinet/in.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Answers the `M-SEARCH *` discovery requests for every bridge of the process on one UDP socket,
+ *  and announces the bridges with `NOTIFY * ssdp:alive` before their max-age runs out - `ssdp:byebye` when stopped.
+ *
+ *  oatpp-ssdp's SsdpStreamHandler answers a request with exactly one packet, so it can't advertise more than one bridge.
+ *  Here a search gets one answer per bridge and matching search target (`ST`), each the datagram pre-rendered
+ *  by the bridge's DeviceDescriptor - nothing is rendered per search.
+ *
+ *  As UPnP requires, every bridge answers a multicast search after a random delay within its `MX` seconds,
+ *  so the answers of many bridges don't arrive at once. Echo devices send the same search several times
+ *  within a second - repeated searches of a client for the same target are answered once within `duplicateWindowMs`.
+ *  Unicast searches have no `MX`, they are answered right away and every time.
+ *
+ *  The delayed answers and the announcements are timers of one TimerWheel, advanced by the thread that receives the searches.
+ *  Every bridge is announced again after a jittered interval, so many bridges don't announce in lockstep.
+ */
+class SsdpServer {
+public:
+
+  struct Config {
+    std::string host = "0.0.0.0"; ///< address to bind to
+    v_uint16 port = 1900; ///< `0` - any free port, see getPort()
+    std::string multicastGroup = "239.255.255.250"; ///< empty - unicast searches only
+    std::string notifyHost = "239.255.255.250"; ///< announcements are sent to, empty - no announcements
+    v_uint16 notifyPort = 1900;
+    v_int32 announceIntervalMs = DeviceDescriptorComponent::DeviceDescriptor::MAX_AGE_SECONDS * 1000 / 2; ///< a bridge is announced this often...
+    v_int32 announceJitterMs = DeviceDescriptorComponent::DeviceDescriptor::MAX_AGE_SECONDS * 1000 / 10; ///< ...less a random time up to this
+    v_int32 maxResponseDelayMs = 5000; ///< `MX` is capped to this, UDA caps it to 5 seconds
+    v_int32 duplicateWindowMs = 1000; ///< `0` - answer every multicast search
+    v_int32 tickMs = 50; ///< resolution of the timers
+  };
+
+  struct Stats {
+    v_int64 searches; ///< `M-SEARCH *` requests received
+    v_int64 responses; ///< answers sent, one per bridge and matching target of a search
+    v_int64 unmatched; ///< searches for targets of no bridge
+    v_int64 duplicates; ///< searches repeated within the duplicate window
+    v_int64 ignored; ///< other packets, i.E. NOTIFY of other devices
+    v_int64 notifications; ///< `NOTIFY *` sent, alive and byebye
+  };
+
+private:
+  static constexpr v_int32 POLL_INTERVAL_MS = 100; ///< stop() takes effect within this time
+  static constexpr v_int32 MAX_PACKET_SIZE = 2048;
+  static constexpr v_int32 STARTUP_DELAY_MS = 100; ///< the first announcements are spread over this time
+  static constexpr v_int64 WHEEL_SLOTS = 1024;
+  static constexpr v_int32 MAX_RECENT_SEARCHES = 4096; ///< more clients than this within the window aren't deduplicated
+private:
+
+  /**
+   *  Timer of the wheel
+   */
+  struct Task {
+    v_uint32 bridge;
+    v_uint32 targets; ///< bit per search target to answer, `0` - announce the bridge
+    sockaddr_storage address; ///< of the search
+    socklen_t addressSize;
+  };
+
+private:
+  const Config m_config;
+  const std::vector<std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>> m_descriptors;
+  std::shared_ptr<Metrics> m_metrics;
+  v_int32 m_series;
+  int m_fd;
+  v_uint16 m_port;
+  std::atomic<bool> m_running;
+  std::atomic<v_int64> m_searches;
+  std::atomic<v_int64> m_responses;
+  std::atomic<v_int64> m_ignored;
+  std::atomic<v_int64> m_unmatched;
+  std::atomic<v_int64> m_duplicates;
+  std::atomic<v_int64> m_notifications;
+  // used by the thread in run() only
+  TimerWheel<Task> m_wheel;
+  std::minstd_rand m_random;
+  sockaddr_in m_notifyAddress;
+  std::chrono::steady_clock::time_point m_start;
+  std::unordered_map<std::string, v_int64> m_recentSearches; ///< client address and `ST` -> tick the window ends
+  std::deque<std::pair<v_int64, std::string>> m_recentOrder; ///< the same, in the order the windows end
+private:
+  void answer(const char* packet, v_buff_size size, const sockaddr_storage& sender, socklen_t senderSize);
+  bool isDuplicate(const sockaddr_storage& sender, socklen_t senderSize, const std::string& target, v_int64 tick);
+  void respond(const Task& task);
+  void notify(const std::vector<oatpp::String>& packets);
+  v_int64 getTicks() const;
+  v_int32 getAnnounceDelayMs();
+public:
+
+  /**
+   * Constructor. Binds the socket and joins the multicast group.
+   * @param config
+   * @param descriptors - one per bridge, in the order the answers are sent
+   * @param metrics - records the time to answer a search, may be `nullptr`
+   * @throws - `std::runtime_error` if the socket can't be bound
+   */
+  SsdpServer(const Config& config,
+             const std::vector<std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>>& descriptors,
+             const std::shared_ptr<Metrics>& metrics);
+
+  ~SsdpServer();
+
+  static std::shared_ptr<SsdpServer> createShared(const Config& config,
+                                                  const std::vector<std::shared_ptr<DeviceDescriptorComponent::DeviceDescriptor>>& descriptors,
+                                                  const std::shared_ptr<Metrics>& metrics = nullptr)
+  {
+    return std::make_shared<SsdpServer>(config, descriptors, metrics);
+  }
+
+  /**
+   * Announce the bridges, receive and answer searches until stop() is called, then say byebye for the bridges.
+   * Returns right away if stop() was called already. Answers not sent yet when stopped are dropped.
+   */
+  void run();
+
+  void stop();
+
+  /**
+   * @return - port the socket is bound to
+   */
+  v_uint16 getPort() const {
+    return m_port;
+  }
+
+  Stats getStats() const;
+
+  /**
+   * @param packet
+   * @param size
+   * @return - `true` if the packet is an `M-SEARCH *` request
+   */
+  static bool isSearch(const char* packet, v_buff_size size);
+
+  /**
+   * @param packet
+   * @param size
+   * @param name - header name, case-insensitive
+   * @return - value of the header without surrounding spaces, empty if the packet has none
+   */
+  static std::string getHeader(const char* packet, v_buff_size size, const char* name);
+
+};
+
+#endif /* ssdp_SsdpServer_hpp */
@@ -0,0 +1,120 @@
+#ifndef ssdp_TimerWheel_hpp
+#define ssdp_TimerWheel_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+/**
+ *  Hashed timing wheel. A timer due at tick `t` is kept in slot `t % slots`, so scheduling is O(1)
+ *  and advancing by one tick only looks at the timers of one slot - however many timers are pending.
+ *  Timers due more than one revolution ahead stay in their slot until their tick comes.
+ *  Not thread safe, used by the thread that advances it.
+ *  @tparam T - value handed to the callback when the timer fires
+ */
+template<class T>
+class TimerWheel {
+private:
+
+  struct Timer {
+    v_int64 tick;
+    T value;
+  };
+
+private:
+  std::vector<std::vector<Timer>> m_slots;
+  const v_int64 m_mask;
+  v_int64 m_tick; ///< timers up to this tick have fired
+  v_int64 m_size;
+  std::vector<Timer> m_due; ///< reused by advance()
+public:
+
+  /**
+   * Constructor.
+   * @param slots - power of two
+   */
+  explicit TimerWheel(v_int64 slots)
+    : m_slots((size_t) slots)
+    , m_mask(slots - 1)
+    , m_tick(0)
+    , m_size(0)
+  {
+    if (slots < 2 || (slots & m_mask) != 0) {
+      throw std::invalid_argument("TimerWheel slots have to be a power of two");
+    }
+  }
+
+  /**
+   * Add a timer. A timer due at or before getTick() fires with the next advance().
+   * @param tick
+   * @param value
+   */
+  void schedule(v_int64 tick, const T& value) {
+    if (tick <= m_tick) {
+      tick = m_tick + 1;
+    }
+    m_slots[(size_t) (tick & m_mask)].push_back({tick, value});
+    m_size++;
+  }
+
+  /**
+   * Fire all timers due up to `tick`, in the order of their ticks.
+   * The callback may schedule new timers, timers due up to `tick` fire in the next advance() then.
+   * @param tick
+   * @param fire - `void(v_int64 tick, const T& value)`
+   */
+  template<class Callback>
+  void advance(v_int64 tick, const Callback& fire) {
+    if (tick <= m_tick) {
+      return;
+    }
+    // a jump of more than one revolution visits every slot once
+    v_int64 steps = tick - m_tick < m_mask + 1 ? tick - m_tick : m_mask + 1;
+    v_int64 from = m_tick;
+    m_due.clear();
+    for (v_int64 step = 1; step <= steps; step++) {
+      auto& slot = m_slots[(size_t) ((from + step) & m_mask)];
+      for (size_t i = 0; i < slot.size();) {
+        if (slot[i].tick <= tick) {
+          m_due.push_back(slot[i]);
+          slot[i] = slot.back();
+          slot.pop_back();
+        } else {
+          i++;
+        }
+      }
+    }
+    m_tick = tick;
+    m_size -= (v_int64) m_due.size();
+    if (steps > m_mask) {
+      // collected out of order
+      std::stable_sort(m_due.begin(), m_due.end(), [](const Timer& a, const Timer& b) { return a.tick < b.tick; });
+    }
+    std::vector<Timer> due;
+    due.swap(m_due);
+    for (auto& timer : due) {
+      fire(timer.tick, timer.value);
+    }
+    due.clear();
+    m_due.swap(due); // keep the capacity
+  }
+
+  /**
+   * @return - the tick timers have fired up to
+   */
+  v_int64 getTick() const {
+    return m_tick;
+  }
+
+  /**
+   * @return - pending timers
+   */
+  v_int64 getSize() const {
+    return m_size;
+  }
+
+};
+
+#endif /* ssdp_TimerWheel_hpp */
@@ -0,0 +1,415 @@
+
+#include "TransitionEngine.hpp"
+
+#include "color/ColorModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) || defined(_MSC_VER)
+  #define HUE_RESTRICT __restrict
+#else
+  #define HUE_RESTRICT
+#endif
+
+constexpr v_int64 TransitionEngine::REBASE_MS;
+
+namespace {
+
+// interpolated values stay between their start and end value, they need no clamping
+
+v_uint8 toUInt8(float value) {
+  return (v_uint8) (value + 0.5f);
+}
+
+v_uint16 toUInt16(float value) {
+  return (v_uint16) (value + 0.5f);
+}
+
+v_uint16 toHue(float value) {
+  return (v_uint16) ((v_int32) std::floor(value + 0.5f) & 0xFFFF); // wraps around the color wheel
+}
+
+/**
+ * Color coordinates kept for the colormode of the record, see Fades.
+ */
+void getCoordinates(const HueDevice& hueDevice, float& a, float& b) {
+  switch (hueDevice.mode) {
+    case HueColorMode::HS: a = hueDevice.hue; b = hueDevice.sat; break;
+    case HueColorMode::XY: a = hueDevice.x; b = hueDevice.y; break;
+    default: a = hueDevice.ct; b = 0;
+  }
+}
+
+/*
+ * The kernels of a tick - straight loops over contiguous floats, without branches.
+ * Restrict-qualified parameters tell the compiler the arrays don't overlap, so it vectorizes them without runtime checks.
+ */
+
+void computeProgress(const float* HUE_RESTRICT starts, const float* HUE_RESTRICT inverseDurations, float nowMs,
+                     float* HUE_RESTRICT progress, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    progress[i] = std::min(std::max((nowMs - starts[i]) * inverseDurations[i], 0.0f), 1.0f);
+  }
+}
+
+void interpolateChannel(const float* HUE_RESTRICT from, const float* HUE_RESTRICT delta, const float* HUE_RESTRICT progress,
+                        float* HUE_RESTRICT value, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    value[i] = from[i] + delta[i] * progress[i];
+  }
+}
+
+}
+
+void TransitionEngine::Fades::resize(size_t size) {
+  records.resize(size);
+  starts.resize(size);
+  inverseDurations.resize(size);
+  progress.resize(size);
+  briFrom.resize(size); briDelta.resize(size); bri.resize(size);
+  colorAFrom.resize(size); colorADelta.resize(size); colorA.resize(size);
+  colorBFrom.resize(size); colorBDelta.resize(size); colorB.resize(size);
+}
+
+void TransitionEngine::Fades::move(size_t from, size_t to) {
+  records[to] = records[from];
+  starts[to] = starts[from];
+  inverseDurations[to] = inverseDurations[from];
+  progress[to] = progress[from];
+  briFrom[to] = briFrom[from]; briDelta[to] = briDelta[from]; bri[to] = bri[from];
+  colorAFrom[to] = colorAFrom[from]; colorADelta[to] = colorADelta[from]; colorA[to] = colorA[from];
+  colorBFrom[to] = colorBFrom[from]; colorBDelta[to] = colorBDelta[from]; colorB[to] = colorB[from];
+}
+
+TransitionEngine::TransitionEngine(const Config& config)
+  : m_config(config)
+  , m_epoch(Clock::now())
+  , m_unpublished(0)
+  , m_fading(0)
+  , m_started(0)
+  , m_finished(0)
+  , m_superseded(0)
+  , m_ticks(0)
+  , m_stopped(false)
+  , m_ticker(&TransitionEngine::run, this)
+{}
+
+TransitionEngine::~TransitionEngine() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_condition.notify_all();
+  m_ticker.join();
+}
+
+void TransitionEngine::addListener(const std::shared_ptr<Database::ChangeListener>& listener, bool steps) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_listeners.push_back({listener, steps});
+}
+
+TransitionEngine::Stats TransitionEngine::getStats() const {
+  Stats stats;
+  stats.started = m_started.load();
+  stats.finished = m_finished.load();
+  stats.superseded = m_superseded.load();
+  stats.ticks = m_ticks.load();
+  stats.fading = (v_int64) m_fading.load();
+  return stats;
+}
+
+HueDevice TransitionEngine::getCurrent(size_t index) const {
+  HueDevice current = m_fades.records[index];
+  current.bri = toUInt8(m_fades.bri[index]);
+  switch (current.mode) {
+    case HueColorMode::HS:
+      current.hue = toHue(m_fades.colorA[index]);
+      current.sat = toUInt8(m_fades.colorB[index]);
+      break;
+    case HueColorMode::XY:
+      current.x = toUInt16(m_fades.colorA[index]);
+      current.y = toUInt16(m_fades.colorB[index]);
+      break;
+    default:
+      current.ct = toUInt16(m_fades.colorA[index]);
+  }
+  if (current.bri > 0) {
+    current.setOn(true); // a light switched off stays on until it faded out
+  }
+  return current;
+}
+
+std::shared_ptr<const TransitionEngine::States> TransitionEngine::publish() {
+  auto states = std::make_shared<States>();
+  const size_t count = m_fades.size();
+  states->records.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    states->records.push_back(getCurrent(i));
+  }
+  if (!m_index) {
+    auto index = std::make_shared<States::Index>();
+    index->reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      index->push_back({m_fades.records[i].id, (v_uint32) i});
+    }
+    std::sort(index->begin(), index->end());
+    m_index = index;
+  }
+  states->index = m_index;
+  std::shared_ptr<const States> published = states;
+  std::atomic_store(&m_states, published);
+  m_unpublished = 0; // after the store - see getState()
+  return published;
+}
+
+bool TransitionEngine::hasStepListener() const {
+  for (auto& listener : m_listeners) {
+    if (listener.steps) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransitionEngine::notify(const std::vector<HueDevice>& steps, const std::vector<HueDevice>& changes) {
+  for (auto& listener : m_listeners) {
+    const std::vector<HueDevice>& records = listener.steps ? steps : changes;
+    if (records.empty()) {
+      continue;
+    }
+    if (auto current = listener.listener.lock()) {
+      current->onHueDevicesChanged(records);
+    }
+  }
+}
+
+void TransitionEngine::remove(size_t index) {
+  size_t last = m_fades.size() - 1;
+  m_indexes.erase(m_fades.records[index].id);
+  m_index = nullptr;
+  if (index != last) {
+    m_fades.move(last, index);
+    m_indexes[m_fades.records[index].id] = index;
+  }
+  m_fades.resize(last);
+  m_fading = last;
+}
+
+void TransitionEngine::start(const HueDevice& previous, const HueDevice& updated, v_int32 transitionMs, Clock::time_point now) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  HueDevice from = previous;
+  auto it = m_indexes.find(updated.id);
+  if (it != m_indexes.end() && m_fades.records[it->second].version == previous.version) {
+    from = getCurrent(it->second); // redirected halfway - continue from where the light is now
+  }
+
+  if (transitionMs <= 0 || (!from.isOn() && !updated.isOn())) {
+    // nothing visible to fade
+    if (it != m_indexes.end()) {
+      remove(it->second);
+    }
+    return;
+  }
+
+  size_t index;
+  if (it != m_indexes.end()) {
+    index = it->second;
+  } else {
+    if (m_fades.size() == 0) {
+      m_epoch = now; // no start times to rebase
+    }
+    index = m_fades.size();
+    m_fades.resize(index + 1);
+    m_indexes[updated.id] = index;
+    m_index = nullptr;
+    m_fading = index + 1;
+  }
+
+  // on/off is faded through the brightness, an off light counts as bri 0
+  float briFrom = from.isOn() ? from.bri : 0;
+  float briTo = updated.isOn() ? updated.bri : 0;
+
+  ColorModel::setMode(from, updated.mode);
+  float colorAFrom, colorBFrom, colorATo, colorBTo;
+  getCoordinates(from, colorAFrom, colorBFrom);
+  getCoordinates(updated, colorATo, colorBTo);
+  float colorADelta = colorATo - colorAFrom;
+  if (updated.mode == HueColorMode::HS) {
+    if (colorADelta > 32768) {
+      colorADelta -= 65536;
+    } else if (colorADelta < -32768) {
+      colorADelta += 65536;
+    }
+  }
+
+  m_fades.records[index] = updated;
+  m_fades.starts[index] = std::chrono::duration<float, std::milli>(now - m_epoch).count();
+  m_fades.inverseDurations[index] = 1.0f / transitionMs;
+  m_fades.progress[index] = 0;
+  m_fades.briFrom[index] = m_fades.bri[index] = briFrom;
+  m_fades.briDelta[index] = briTo - briFrom;
+  m_fades.colorAFrom[index] = m_fades.colorA[index] = colorAFrom;
+  m_fades.colorADelta[index] = colorADelta;
+  m_fades.colorBFrom[index] = m_fades.colorB[index] = colorBFrom;
+  m_fades.colorBDelta[index] = colorBTo - colorBFrom;
+
+  m_unpublished++; // read under m_mutex until the next tick publishes it
+  m_started++;
+
+}
+
+size_t TransitionEngine::interpolate(Fades& fades, float nowMs) {
+
+  const size_t count = fades.size();
+  float* progress = fades.progress.data();
+  computeProgress(fades.starts.data(), fades.inverseDurations.data(), nowMs, progress, count);
+  interpolateChannel(fades.briFrom.data(), fades.briDelta.data(), progress, fades.bri.data(), count);
+  interpolateChannel(fades.colorAFrom.data(), fades.colorADelta.data(), progress, fades.colorA.data(), count);
+  interpolateChannel(fades.colorBFrom.data(), fades.colorBDelta.data(), progress, fades.colorB.data(), count);
+
+  // counted apart - a mixed int/float reduction keeps the loops above from being vectorized
+  v_int32 finished = 0;
+  for (size_t i = 0; i < count; i++) {
+    finished += progress[i] >= 1.0f ? 1 : 0;
+  }
+
+  return (size_t) finished;
+
+}
+
+void TransitionEngine::tick(Clock::time_point now) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ticks++;
+
+  const size_t count = m_fades.size();
+  if (count == 0) {
+    return;
+  }
+
+  float nowMs = std::chrono::duration<float, std::milli>(now - m_epoch).count();
+  if (nowMs > REBASE_MS) {
+    for (size_t i = 0; i < count; i++) {
+      m_fades.starts[i] -= nowMs;
+    }
+    m_epoch = now;
+    nowMs = 0;
+  }
+
+  size_t finished = interpolate(m_fades, nowMs);
+
+  m_arrived.clear();
+  if (finished > 0) {
+    // backwards, so the fade swapped into a removed one's index was visited already
+    for (size_t i = count; i-- > 0;) {
+      if (m_fades.progress[i] >= 1.0f) {
+        m_arrived.push_back(m_fades.records[i]);
+        remove(i);
+        m_finished++;
+      }
+    }
+  }
+
+  auto states = publish();
+
+  m_forward.clear();
+  if (hasStepListener()) {
+    m_forward = states->records;
+    m_forward.insert(m_forward.end(), m_arrived.begin(), m_arrived.end());
+  }
+
+  // under m_mutex, so a step never overtakes a later committed change of the light
+  notify(m_forward, m_arrived);
+
+}
+
+void TransitionEngine::run() {
+
+  auto interval = std::chrono::milliseconds(m_config.tickMs);
+  auto next = Clock::now() + interval;
+
+  while (true) {
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait_until(lock, next, [this] {
+        return m_stopped;
+      });
+      if (m_stopped) {
+        return;
+      }
+    }
+
+    auto now = Clock::now();
+    if (m_fading.load() > 0) {
+      tick(now);
+    }
+
+    // fixed rate - a late tick doesn't shift the following ones, missed ticks are skipped
+    next = std::max(next + interval, now);
+
+  }
+
+}
+
+void TransitionEngine::onStateUpdated(const HueDevice& previous, const HueDevice& updated, v_int32 transitionMs) {
+  start(previous, updated, transitionMs, Clock::now());
+}
+
+bool TransitionEngine::isEmpty() const {
+  return m_fading.load() == 0;
+}
+
+bool TransitionEngine::getState(HueDevice& hueDevice) const {
+
+  // the counter first - once it is back to 0, m_states has every fade started before
+  bool unpublished = m_unpublished.load() > 0;
+  auto states = std::atomic_load(&m_states);
+  if (states) {
+    auto& index = *states->index;
+    auto it = std::lower_bound(index.begin(), index.end(), std::make_pair(hueDevice.id, (v_uint32) 0));
+    if (it != index.end() && it->first == hueDevice.id) {
+      const HueDevice& record = states->records[it->second];
+      if (record.id == hueDevice.id && record.version == hueDevice.version) {
+        hueDevice = record;
+        return true;
+      }
+    }
+  }
+  if (!unpublished) {
+    return false;
+  }
+
+  // started or redirected after the last tick
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_indexes.find(hueDevice.id);
+  if (it == m_indexes.end() || m_fades.records[it->second].version != hueDevice.version) {
+    return false;
+  }
+  hueDevice = getCurrent(it->second);
+  return true;
+
+}
+
+void TransitionEngine::onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) {
+  // called by the Database writer with the write lock held
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_forward.clear();
+  for (const HueDevice& hueDevice : hueDevices) {
+    auto it = m_indexes.find(hueDevice.id);
+    if (it != m_indexes.end()) {
+      if ((hueDevice.flags & HueDevice::FLAG_IN_USE) && m_fades.records[it->second].version == hueDevice.version) {
+        continue; // target of a fade started by this write, the listeners of steps get its steps
+      }
+      remove(it->second);
+      m_superseded++;
+    }
+    m_forward.push_back(hueDevice);
+  }
+  notify(m_forward, hueDevices);
+}
@@ -0,0 +1,167 @@
+#ifndef transition_TransitionEngine_hpp
+#define transition_TransitionEngine_hpp
+
+#include "db/Database.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Fades lights to the state committed by a `PUT .../state` or `.../action` with a `transitiontime`.
+ *
+ *  The Database commits the target state right away and tells the engine where the light is coming from,
+ *  see Database::StateOverlay. A ticker thread then moves the brightness and the color of every fading light
+ *  towards the target at a fixed rate, until the transition time is over. The color fades in the colormode
+ *  of the target, the start color is converted to it - see ColorModel. Meanwhile the Database's read paths
+ *  report the interpolated state, and the LightDriver is fed one step per tick instead of the target at once.
+ *  The ChangeStream is told once more when a light reached its target, so event subscribers see the faded state.
+ *
+ *  Fades are kept as structure of arrays - one float array per attribute, one index per fading light -
+ *  so a tick is one branch-free loop over contiguous floats the compiler vectorizes.
+ *  Every tick publishes the states it computed as an immutable table, so the read paths don't take the engine's lock.
+ *  A fade is dropped once its light is changed again by any other write.
+ */
+class TransitionEngine : public Database::StateOverlay, public Database::ChangeListener {
+public:
+  typedef std::chrono::steady_clock Clock;
+public:
+
+  struct Config {
+    v_int32 tickMs = 20; ///< interpolate this often, `0` - no transitions, states are applied at once
+  };
+
+  struct Stats {
+    v_int64 started; ///< fades started, including fades redirected to a new target
+    v_int64 finished; ///< fades which reached their target
+    v_int64 superseded; ///< fades dropped because their light was changed by another write
+    v_int64 ticks;
+    v_int64 fading; ///< lights fading right now
+  };
+
+private:
+
+  /**
+   *  One array per attribute, index `i` of every array is the i-th fading light.
+   *  Times are in ms since m_epoch.
+   */
+  struct Fades {
+    std::vector<HueDevice> records; ///< committed target record
+    std::vector<float> starts;
+    std::vector<float> inverseDurations; ///< 1 / duration in ms
+    std::vector<float> progress; ///< 0..1 as of the last tick
+    std::vector<float> briFrom, briDelta, bri;
+    /*
+     * Color coordinates in the colormode of the target: hue and sat, ct, or x and y.
+     * Hue is not wrapped, the delta takes the short way around the color wheel.
+     */
+    std::vector<float> colorAFrom, colorADelta, colorA;
+    std::vector<float> colorBFrom, colorBDelta, colorB;
+
+    size_t size() const {
+      return records.size();
+    }
+
+    void resize(size_t size);
+    void move(size_t from, size_t to);
+  };
+
+  /**
+   *  States of the fading lights as of a tick, published to the read paths.
+   */
+  struct States {
+    typedef std::vector<std::pair<v_int32, v_uint32>> Index; ///< HueDeviceId and index in `records`, sorted by id
+    std::shared_ptr<const Index> index; ///< shared by the ticks between starts and ends of fades
+    std::vector<HueDevice> records;
+  };
+
+  struct Listener {
+    std::weak_ptr<Database::ChangeListener> listener; ///< not owned, like the Database's listeners
+    bool steps; ///< see addListener()
+  };
+
+private:
+  static constexpr v_int64 REBASE_MS = 3600 * 1000; ///< keeps the float start times precise
+private:
+  const Config m_config;
+  mutable std::mutex m_mutex;
+  Fades m_fades; ///< guarded by m_mutex
+  std::unordered_map<v_int32, size_t> m_indexes; ///< HueDeviceId -> index in m_fades, guarded by m_mutex
+  Clock::time_point m_epoch; ///< guarded by m_mutex
+  std::vector<Listener> m_listeners; ///< guarded by m_mutex
+  std::vector<HueDevice> m_forward; ///< records passed to the listeners of steps, guarded by m_mutex
+  std::vector<HueDevice> m_arrived; ///< targets reached by a tick, guarded by m_mutex
+  std::shared_ptr<const States::Index> m_index; ///< of the fades in m_fades, `nullptr` once a fade is added or removed. Guarded by m_mutex
+  std::shared_ptr<const States> m_states; ///< swapped by tick() with atomic_store
+  std::atomic<v_uint32> m_unpublished; ///< fades started or redirected since m_states was published
+  std::atomic<size_t> m_fading;
+  std::atomic<v_int64> m_started;
+  std::atomic<v_int64> m_finished;
+  std::atomic<v_int64> m_superseded;
+  std::atomic<v_int64> m_ticks;
+  std::condition_variable m_condition;
+  bool m_stopped; ///< guarded by m_mutex
+  std::thread m_ticker;
+private:
+  void run();
+  void remove(size_t index); // call with m_mutex held
+  HueDevice getCurrent(size_t index) const; // call with m_mutex held
+  bool hasStepListener() const; // call with m_mutex held
+  std::shared_ptr<const States> publish(); // call with m_mutex held
+  void notify(const std::vector<HueDevice>& steps, const std::vector<HueDevice>& changes); // call with m_mutex held
+  static size_t interpolate(Fades& fades, float nowMs); // returns the number of finished fades
+public:
+
+  /**
+   * Constructor. Starts the ticker. Attach the engine with `Database::setStateOverlay()`
+   * and register it with `Database::addChangeListener()`, so writes without transition stop the fades they interrupt.
+   * @param config - `tickMs` > 0
+   */
+  explicit TransitionEngine(const Config& config);
+
+  ~TransitionEngine() override;
+
+  static std::shared_ptr<TransitionEngine> createShared(const Config& config) {
+    return std::make_shared<TransitionEngine>(config);
+  }
+
+  /**
+   * Pass the committed changes on to `listener`. Register the engine with the Database in place of `listener`.
+   * The engine doesn't own the listener.
+   * @param listener
+   * @param steps - `true` - the target of a fade is replaced by its steps, i.E. for the DriverPipeline.
+   * `false` - changes are passed as committed, and a faded light once more when it reached its target,
+   * i.E. for the ChangeStream, whose subscribers read the state themselves.
+   */
+  void addListener(const std::shared_ptr<Database::ChangeListener>& listener, bool steps);
+
+  /**
+   * Start a fade, or redirect the fade of the light to a new target.
+   * @param previous - record before the change. A light which is fading already starts from its current state instead.
+   * @param updated - committed record
+   * @param transitionMs - duration
+   * @param now - start of the fade
+   */
+  void start(const HueDevice& previous, const HueDevice& updated, v_int32 transitionMs, Clock::time_point now);
+
+  /**
+   * Interpolate all fades to `now` and drop the finished ones. Called by the ticker every `tickMs`.
+   * @param now
+   */
+  void tick(Clock::time_point now);
+
+  Stats getStats() const;
+
+  void onStateUpdated(const HueDevice& previous, const HueDevice& updated, v_int32 transitionMs) override;
+  bool isEmpty() const override;
+  bool getState(HueDevice& hueDevice) const override;
+
+  void onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) override;
+
+};
+
+#endif /* transition_TransitionEngine_hpp */
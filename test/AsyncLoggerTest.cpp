@@ -0,0 +1,186 @@
+
+#include "AsyncLoggerTest.hpp"
+
+#include "logging/AsyncLogger.hpp"
+
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+const char* const LOG_TAG = "AsyncLoggerTest";
+
+std::string readAll(FILE* file) {
+  std::string text;
+  char buffer[4096];
+  std::rewind(file);
+  size_t size;
+  while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    text.append(buffer, size);
+  }
+  return text;
+}
+
+v_int64 countLines(const std::string& text, const char* needle) {
+  v_int64 count = 0;
+  size_t position = 0;
+  while ((position = text.find(needle, position)) != std::string::npos) {
+    count++;
+    position++;
+  }
+  return count;
+}
+
+AsyncLogger::Config createConfig(v_uint32 ringBytes, v_int32 flushIntervalMs) {
+  AsyncLogger::Config config;
+  config.level = AsyncLogger::PRIORITY_D;
+  config.ringBytes = ringBytes;
+  config.flushIntervalMs = flushIntervalMs;
+  return config;
+}
+
+}
+
+void AsyncLoggerTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "Records are formatted on the writer thread...");
+
+    FILE* file = std::tmpfile();
+    {
+      AsyncLogger logger(createConfig(64 * 1024, 10), file);
+      std::string name = "Grain";
+      HUE_LOGI(LOG_TAG, "light %d '%s' is %s, bri=%u, x=%.3f, %%", 3, name, "on", (v_uint8) 254, 0.32271);
+      HUE_LOGI(LOG_TAG, "width [%5d] [%-4s] [%x] [%lld]", (v_int32) 42, "ab", 255u, (long long) -7);
+      HUE_LOGI(LOG_TAG, "missing %d and %s", 1);
+      logger.log(AsyncLogger::PRIORITY_W, LOG_TAG, "formatted by oatpp");
+      logger.flush();
+
+      auto text = readAll(file);
+      OATPP_LOGD(TAG, "\n%s", text.c_str());
+      OATPP_ASSERT(text.find(" I |") == 0);
+      OATPP_ASSERT(text.find("| AsyncLoggerTest:light 3 'Grain' is on, bri=254, x=0.323, %\n") != std::string::npos);
+      OATPP_ASSERT(text.find("width [   42] [ab  ] [ff] [-7]\n") != std::string::npos);
+      OATPP_ASSERT(text.find("missing 1 and <?>\n") != std::string::npos);
+      OATPP_ASSERT(text.find(" W |") != std::string::npos);
+      OATPP_ASSERT(text.find("AsyncLoggerTest:formatted by oatpp\n") != std::string::npos);
+      OATPP_ASSERT(logger.getStats().written == 4);
+    }
+    std::fclose(file);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Levels are set per tag at runtime...");
+
+    FILE* file = std::tmpfile();
+    {
+      AsyncLogger logger(createConfig(64 * 1024, 10), file);
+      AsyncLogger::setLevel(LOG_TAG, AsyncLogger::PRIORITY_W);
+      HUE_LOGI(LOG_TAG, "filtered %d", 1);
+      logger.log(AsyncLogger::PRIORITY_I, LOG_TAG, "filtered 2");
+      HUE_LOGW(LOG_TAG, "passed %d", 1);
+      HUE_LOGI("AsyncLoggerTest-other", "passed %d", 2);
+      OATPP_ASSERT(logger.isLogPriorityEnabled(AsyncLogger::PRIORITY_D));
+
+      AsyncLogger::setLevel("*", AsyncLogger::PRIORITY_E);
+      HUE_LOGI("AsyncLoggerTest-other", "filtered %d", 3);
+      HUE_LOGW(LOG_TAG, "passed %d", 3);
+      OATPP_ASSERT(!logger.isLogPriorityEnabled(AsyncLogger::PRIORITY_I));
+      OATPP_ASSERT(logger.isLogPriorityEnabled(AsyncLogger::PRIORITY_W));
+
+      AsyncLogger::setLevel(LOG_TAG, -1);
+      AsyncLogger::setLevel("*", AsyncLogger::PRIORITY_D);
+      HUE_LOGD(LOG_TAG, "passed %d", 4);
+      logger.flush();
+
+      auto text = readAll(file);
+      OATPP_ASSERT(countLines(text, "filtered") == 0);
+      OATPP_ASSERT(countLines(text, "passed") == 4);
+    }
+    std::fclose(file);
+
+    // runtime changes don't create tags, configured ones exist before their first message
+    OATPP_ASSERT(!AsyncLogger::setLevel("AsyncLoggerTest-unknown", AsyncLogger::PRIORITY_V));
+    OATPP_ASSERT(AsyncLogger::findTag("AsyncLoggerTest-unknown") == nullptr);
+    {
+      auto config = createConfig(64 * 1024, 10);
+      config.tagLevels.push_back({"AsyncLoggerTest-configured", (v_uint32) AsyncLogger::PRIORITY_W});
+      AsyncLogger logger(config, stdout);
+      AsyncLogger::Tag* tag = AsyncLogger::findTag("AsyncLoggerTest-configured");
+      OATPP_ASSERT(tag != nullptr && tag->getLevel() == (v_int32) AsyncLogger::PRIORITY_W);
+      OATPP_ASSERT(AsyncLogger::setLevel("AsyncLoggerTest-configured", -1));
+    }
+
+    v_uint32 level;
+    OATPP_ASSERT(AsyncLogger::parseLevel("W", level) && level == AsyncLogger::PRIORITY_W);
+    OATPP_ASSERT(AsyncLogger::parseLevel("d", level) && level == AsyncLogger::PRIORITY_D);
+    OATPP_ASSERT(!AsyncLogger::parseLevel("X", level));
+    OATPP_ASSERT(!AsyncLogger::parseLevel("DEBUG", level));
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A full ring drops records and counts them...");
+
+    FILE* file = std::tmpfile();
+    {
+      AsyncLogger logger(createConfig(0, 60 * 1000), file); // smallest ring, no flush until asked
+      for (v_int32 i = 0; i < 1000; i++) {
+        HUE_LOGI(LOG_TAG, "record %d of a burst", i);
+      }
+      logger.flush();
+      auto stats = logger.getStats();
+      OATPP_ASSERT(stats.dropped > 0);
+      OATPP_ASSERT(stats.written + stats.dropped == 1000);
+      OATPP_ASSERT(AsyncLogger::getDroppedCount() == stats.dropped);
+
+      // room again after the flush
+      HUE_LOGI(LOG_TAG, "after the burst");
+      logger.flush();
+      OATPP_ASSERT(logger.getStats().written == stats.written + 1);
+      OATPP_ASSERT(countLines(readAll(file), "record ") == stats.written);
+    }
+    std::fclose(file);
+    OATPP_ASSERT(AsyncLogger::getDroppedCount() == 0);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Threads log concurrently...");
+
+    const v_int32 threadsCount = 8;
+    const v_int32 records = 2000;
+
+    FILE* file = std::tmpfile();
+    {
+      AsyncLogger logger(createConfig(1024 * 1024, 1), file);
+      std::vector<std::thread> threads;
+      for (v_int32 t = 0; t < threadsCount; t++) {
+        threads.emplace_back([t] {
+          for (v_int32 i = 0; i < records; i++) {
+            HUE_LOGD(LOG_TAG, "thread %d record %d", t, i);
+          }
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      logger.flush();
+
+      auto stats = logger.getStats();
+      OATPP_ASSERT(stats.dropped == 0);
+      OATPP_ASSERT(stats.written == threadsCount * records);
+      auto text = readAll(file);
+      OATPP_ASSERT(countLines(text, " record ") == threadsCount * records);
+      OATPP_ASSERT(text.find("thread 7 record 1999\n") != std::string::npos);
+    }
+    std::fclose(file);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,17 @@
+#ifndef AsyncLoggerTest_hpp
+#define AsyncLoggerTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class AsyncLoggerTest : public oatpp::test::UnitTest {
+public:
+
+  AsyncLoggerTest()
+    : UnitTest("TEST[AsyncLoggerTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* AsyncLoggerTest_hpp */
@@ -0,0 +1,160 @@
+
+#include "ChangeStreamTest.hpp"
+
+#include "events/EventStreamReader.hpp"
+#include "transition/TransitionEngine.hpp"
+
+#include <string>
+
+namespace {
+
+std::string readEvent(EventStreamReader& reader) {
+  char buffer[1024];
+  oatpp::async::Action action;
+  oatpp::v_io_size size;
+  do {
+    size = reader.read(buffer, sizeof(buffer), action);
+  } while (size == oatpp::IOError::RETRY_READ);
+  return size > 0 ? std::string(buffer, (size_t) size) : std::string();
+}
+
+}
+
+void ChangeStreamTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "Subscriber queue...");
+
+    ChangeStream::Subscriber subscriber(4);
+    std::vector<v_int32> ids;
+    bool resync;
+
+    // starts with the full state
+    OATPP_ASSERT(subscriber.take(ids, resync, std::chrono::milliseconds(0)));
+    OATPP_ASSERT(resync && ids.empty());
+
+    // a device is queued once until taken
+    OATPP_ASSERT(!subscriber.push({1, 2}));
+    OATPP_ASSERT(!subscriber.push({2, 3}));
+    OATPP_ASSERT(subscriber.take(ids, resync, std::chrono::milliseconds(0)));
+    OATPP_ASSERT(!resync);
+    OATPP_ASSERT(ids == std::vector<v_int32>({1, 2, 3}));
+
+    // too slow - the queue is replaced by a resync
+    OATPP_ASSERT(!subscriber.push({1, 2, 3}));
+    OATPP_ASSERT(subscriber.push({4, 5}));
+    OATPP_ASSERT(subscriber.take(ids, resync, std::chrono::milliseconds(0)));
+    OATPP_ASSERT(resync && ids.empty());
+
+    subscriber.close();
+    OATPP_ASSERT(!subscriber.take(ids, resync, std::chrono::milliseconds(0)));
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Committed changes are coalesced...");
+
+    ChangeStream::Config config;
+    config.windowMs = 100;
+    auto stream = ChangeStream::createShared(config);
+
+    Database db;
+    db.addChangeListener(stream);
+    v_int32 oat = db.registerHueDevice("Oat");
+    v_int32 grain = db.registerHueDevice("Grain");
+
+    auto subscriber = stream->subscribe();
+    OATPP_ASSERT(stream->getSubscribersCount() == 1);
+
+    std::vector<v_int32> ids;
+    bool resync;
+    OATPP_ASSERT(subscriber->take(ids, resync, std::chrono::milliseconds(0)));
+    OATPP_ASSERT(resync);
+
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_BRI;
+    HueDevice updated;
+    for (v_int32 i = 0; i < 10; i++) {
+      update.bri = (v_uint8) i;
+      OATPP_ASSERT(db.updateHueDeviceState(grain, update, updated));
+      OATPP_ASSERT(db.updateHueDeviceState(oat, update, updated));
+    }
+
+    OATPP_ASSERT(subscriber->take(ids, resync, std::chrono::milliseconds(5000)));
+    OATPP_ASSERT(!resync);
+    OATPP_ASSERT(ids == std::vector<v_int32>({oat, grain}));
+
+    OATPP_ASSERT(db.deleteHueDevice(grain));
+    OATPP_ASSERT(subscriber->take(ids, resync, std::chrono::milliseconds(5000)));
+    OATPP_ASSERT(ids == std::vector<v_int32>({grain}));
+
+    stream->unsubscribe(subscriber);
+    OATPP_ASSERT(stream->getSubscribersCount() == 0);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Server-sent events...");
+
+    ChangeStream::Config config;
+    config.windowMs = 10;
+    auto stream = ChangeStream::createShared(config);
+
+    auto db = std::make_shared<Database>();
+    db->addChangeListener(stream);
+    v_int32 oat = db->registerHueDevice("Oat");
+
+    EventStreamReader reader(stream, db, true);
+
+    std::string event = readEvent(reader);
+    OATPP_ASSERT(event == "event: resync\ndata: " + *db->getHueDevicesJson() + "\n\n");
+
+    OATPP_ASSERT(db->deleteHueDevice(oat));
+    event = readEvent(reader);
+    OATPP_ASSERT(event == "event: lights\ndata: {\"1\":null}\n\n");
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "The last event of a fading light has its target state...");
+
+    ChangeStream::Config config;
+    config.windowMs = 10;
+    auto stream = ChangeStream::createShared(config);
+
+    TransitionEngine::Config transitions;
+    transitions.tickMs = 10;
+    auto engine = TransitionEngine::createShared(transitions);
+
+    auto db = std::make_shared<Database>();
+    db->setStateOverlay(engine);
+    db->addChangeListener(engine);
+    engine->addListener(stream, false);
+    v_int32 oat = db->registerHueDevice("Oat", true, 1);
+
+    EventStreamReader reader(stream, db, true);
+    OATPP_ASSERT(readEvent(reader).find("event: resync\n") == 0);
+
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_BRI | HueStateUpdate::FIELD_TRANSITIONTIME;
+    update.bri = 200;
+    update.transitiontime = 10; // 1s
+    HueDevice updated;
+    OATPP_ASSERT(db->updateHueDeviceState(oat, update, updated));
+
+    // the commit is sent with the light on its way, then once more when it got there
+    std::string event = readEvent(reader);
+    OATPP_ASSERT(event.find("event: lights\n") == 0);
+    OATPP_ASSERT(event.find("\"bri\":200") == std::string::npos);
+    event = readEvent(reader);
+    OATPP_ASSERT(event.find("event: lights\n") == 0);
+    OATPP_ASSERT(event.find("\"bri\":200") != std::string::npos);
+    OATPP_ASSERT(engine->isEmpty());
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,17 @@
+#ifndef ChangeStreamTest_hpp
+#define ChangeStreamTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class ChangeStreamTest : public oatpp::test::UnitTest {
+public:
+
+  ChangeStreamTest()
+    : UnitTest("TEST[ChangeStreamTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ChangeStreamTest_hpp */
@@ -0,0 +1,212 @@
+
+#include "ColorModelTest.hpp"
+
+#include "color/ColorModel.hpp"
+#include "db/Database.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+bool near(float value, float expected, float tolerance) {
+  return std::abs(value - expected) <= tolerance;
+}
+
+/**
+ * Distance around the color wheel.
+ */
+v_int32 hueDistance(float hue, float expected) {
+  v_int32 distance = (v_int32) std::abs(hue - expected) % 65536;
+  return std::min(distance, 65536 - distance);
+}
+
+HueDevice makeLight(HueColorMode mode, v_uint16 hue, v_uint8 sat, v_uint16 ct) {
+  HueDevice hueDevice;
+  hueDevice.mode = mode;
+  if (mode == HueColorMode::HS) {
+    hueDevice.hue = hue;
+    hueDevice.sat = sat;
+  } else if (mode == HueColorMode::CT) {
+    hueDevice.ct = ct;
+  }
+  return hueDevice;
+}
+
+}
+
+void ColorModelTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "hue/sat match the sRGB primaries and D65...");
+
+    // red, green, blue, white
+    float hue[] = {0, 21845, 43691, 0};
+    float sat[] = {254, 254, 254, 0};
+    float x[4], y[4];
+    ColorModel::hueSatToXy(hue, sat, x, y, 4);
+    OATPP_ASSERT(near(x[0], 0.6400f, 0.0005f) && near(y[0], 0.3300f, 0.0005f));
+    OATPP_ASSERT(near(x[1], 0.3000f, 0.0005f) && near(y[1], 0.6000f, 0.0005f));
+    OATPP_ASSERT(near(x[2], 0.1500f, 0.0005f) && near(y[2], 0.0600f, 0.0005f));
+    OATPP_ASSERT(near(x[3], 0.3127f, 0.0005f) && near(y[3], 0.3290f, 0.0005f));
+
+    float backHue[4], backSat[4];
+    ColorModel::xyToHueSat(x, y, backHue, backSat, 4);
+    for (v_int32 i = 0; i < 3; i++) {
+      OATPP_ASSERT(hueDistance(backHue[i], hue[i]) <= 10);
+      OATPP_ASSERT(near(backSat[i], 254, 0.5f));
+    }
+    OATPP_ASSERT(backSat[3] < 0.5f);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "ct follows the Planckian locus...");
+
+    // CIE 1931 chromaticity of black bodies at 2000K, 2500K, 3000K, 4000K, 5000K and 6500K
+    const float kelvin[] = {2000, 2500, 3000, 4000, 5000, 6500};
+    const float referenceX[] = {0.5267f, 0.4770f, 0.4369f, 0.3805f, 0.3451f, 0.3135f};
+    const float referenceY[] = {0.4133f, 0.4137f, 0.4041f, 0.3768f, 0.3516f, 0.3236f};
+    float ct[6], x[6], y[6];
+    for (v_int32 i = 0; i < 6; i++) {
+      ct[i] = 1000000.0f / kelvin[i];
+    }
+    ColorModel::ctToXy(ct, x, y, 6);
+    for (v_int32 i = 0; i < 6; i++) {
+      OATPP_ASSERT(near(x[i], referenceX[i], 0.001f) && near(y[i], referenceY[i], 0.001f));
+    }
+
+    // McCamy against the correlated color temperatures of CIE illuminants A (2856K), D50 (5003K) and D65 (6504K)
+    float illuminantX[] = {0.44757f, 0.34567f, 0.31271f};
+    float illuminantY[] = {0.40745f, 0.35850f, 0.32902f};
+    const float referenceCt[] = {1000000.0f / 2856, 1000000.0f / 5003, 1000000.0f / 6504};
+    float illuminantCt[3];
+    ColorModel::xyToCt(illuminantX, illuminantY, illuminantCt, 3);
+    for (v_int32 i = 0; i < 3; i++) {
+      OATPP_ASSERT(near(illuminantCt[i], referenceCt[i], 0.5f));
+    }
+
+    // the way back stays within a couple of mired over the whole range
+    float backCt[6];
+    ColorModel::xyToCt(x, y, backCt, 6);
+    for (v_int32 i = 0; i < 6; i++) {
+      OATPP_ASSERT(near(backCt[i], ct[i], 2.0f));
+    }
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Colors outside of the gamut are clamped to its closest point...");
+
+    // inside, beyond the green corner, beyond the blue-green edge, beyond the red corner
+    float x[] = {0.64f, 0.30f, 0.15f, 0.80f};
+    float y[] = {0.33f, 0.60f, 0.06f, 0.20f};
+    ColorModel::clampToGamut(ColorModel::GAMUT_B, x, y, 4);
+    OATPP_ASSERT(x[0] == 0.64f && y[0] == 0.33f);
+    OATPP_ASSERT(near(x[1], 0.409f, 1e-5f) && near(y[1], 0.518f, 1e-5f));
+    OATPP_ASSERT(near(x[2], 0.17159f, 1e-5f) && near(y[2], 0.04907f, 1e-5f));
+    OATPP_ASSERT(near(x[3], 0.675f, 1e-5f) && near(y[3], 0.322f, 1e-5f));
+
+    HueDevice hueDevice;
+    ColorModel::setXy(hueDevice, 0.30f, 0.60f);
+    OATPP_ASSERT(hueDevice.mode == HueColorMode::XY);
+    ColorModel::Color color = ColorModel::convert(hueDevice);
+    OATPP_ASSERT(near(color.x, 0.409f, 0.0001f) && near(color.y, 0.518f, 0.0001f));
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Every space of a light describes the same color...");
+
+    HueDevice lights[] = {
+      makeLight(HueColorMode::HS, 10000, 200, 0),
+      makeLight(HueColorMode::CT, 0, 0, 366),
+      makeLight(HueColorMode::CT, 0, 0, 153)
+    };
+    ColorModel::setXy(lights[2], 0.4f, 0.35f);
+
+    for (HueDevice& light : lights) {
+
+      ColorModel::Color color = ColorModel::convert(light);
+      // the coordinates of the colormode are reported as they are
+      if (light.mode == HueColorMode::HS) {
+        OATPP_ASSERT(color.hue == light.hue && color.sat == light.sat);
+      } else if (light.mode == HueColorMode::CT) {
+        OATPP_ASSERT(color.ct == light.ct);
+      } else {
+        OATPP_ASSERT(near(color.x, light.x / ColorModel::XY_SCALE, 1e-6f));
+      }
+
+      // and any other space leads back to the same xy
+      for (HueColorMode mode : {HueColorMode::HS, HueColorMode::XY}) {
+        HueDevice converted = light;
+        ColorModel::setMode(converted, mode);
+        ColorModel::Color convertedColor = ColorModel::convert(converted);
+        OATPP_ASSERT(near(convertedColor.x, color.x, 0.002f) && near(convertedColor.y, color.y, 0.002f));
+      }
+
+    }
+
+    // a batch gives the same colors as one light at a time
+    std::vector<HueDevice> many(1000);
+    for (size_t i = 0; i < many.size(); i++) {
+      HueColorMode mode = (HueColorMode) (i % 3);
+      many[i] = makeLight(mode, (v_uint16) (i * 331), (v_uint8) (i % 255), (v_uint16) (153 + i % 348));
+      if (mode == HueColorMode::XY) {
+        ColorModel::setXy(many[i], (i % 100) / 100.0f, (i % 37) / 37.0f);
+      }
+    }
+    std::vector<ColorModel::Color> colors(many.size());
+    ColorModel::convert(many.data(), colors.data(), many.size());
+    for (size_t i = 0; i < many.size(); i++) {
+      ColorModel::Color color = ColorModel::convert(many[i]);
+      OATPP_ASSERT(color.x == colors[i].x && color.y == colors[i].y);
+      OATPP_ASSERT(color.hue == colors[i].hue && color.sat == colors[i].sat && color.ct == colors[i].ct);
+    }
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "State updates keep the color of the coordinates left out...");
+
+    HueDevice hueDevice = makeLight(HueColorMode::CT, 0, 0, 366);
+    ColorModel::Color warm = ColorModel::convert(hueDevice);
+
+    // only hue - sat is taken from the warm white the light had
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_HUE;
+    update.hue = 40000;
+    update.applyTo(hueDevice);
+    OATPP_ASSERT(hueDevice.mode == HueColorMode::HS);
+    OATPP_ASSERT(hueDevice.hue == 40000 && hueDevice.sat == warm.sat);
+
+    // xy wins over ct, like with the Hue API
+    update.fields = HueStateUpdate::FIELD_XY | HueStateUpdate::FIELD_CT;
+    update.x = 0.4573f;
+    update.y = 0.41f;
+    update.ct = 200;
+    update.applyTo(hueDevice);
+    OATPP_ASSERT(hueDevice.mode == HueColorMode::XY);
+
+    // the Database reports the light in every space
+    Database db;
+    v_int32 id = db.registerHueDevice("Oat", true, 254);
+    HueDevice updated;
+    OATPP_ASSERT(db.updateHueDeviceState(id, update, updated));
+    auto state = db.getHueDeviceById(id)->state;
+    OATPP_ASSERT(state->colormode == "xy");
+    OATPP_ASSERT(state->xy->size() == 2);
+    OATPP_ASSERT(near((float) *state->xy[0], 0.4573f, 0.00006f) && near((float) *state->xy[1], 0.41f, 0.00006f));
+    ColorModel::Color color = ColorModel::convert(updated);
+    OATPP_ASSERT(*state->hue == color.hue && *state->sat == color.sat && *state->ct == color.ct);
+    OATPP_ASSERT(near(*state->ct, 366, 1)); // the bridge reports this white as ct 366
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,17 @@
+#ifndef ColorModelTest_hpp
+#define ColorModelTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class ColorModelTest : public oatpp::test::UnitTest {
+public:
+
+  ColorModelTest()
+    : UnitTest("TEST[ColorModelTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ColorModelTest_hpp */
@@ -0,0 +1,56 @@
+
+#include "ConnectionPolicyTest.hpp"
+
+#include "AppConfig.hpp"
+
+void ConnectionPolicyTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "Connection: close by default...");
+
+    const char* argv[] = {"hub"};
+    auto config = AppConfig::fromArgs(oatpp::base::CommandLineArguments(1, argv));
+    const auto& policy = config.connectionPolicy;
+
+    OATPP_ASSERT(!policy.allowsKeepAlive());
+    OATPP_ASSERT(policy.getMode("Echo/1.0") == ConnectionPolicy::Mode::CLOSE);
+    OATPP_ASSERT(policy.getMode(nullptr) == ConnectionPolicy::Mode::CLOSE);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "keep-alive for selected User-Agents...");
+
+    const char* argv[] = {"hub", "--keep-alive-agents", "okhttp,hass", "--keep-alive-timeout", "30", "--keep-alive-max", "8"};
+    auto config = AppConfig::fromArgs(oatpp::base::CommandLineArguments(7, argv));
+    const auto& policy = config.connectionPolicy;
+
+    OATPP_ASSERT(policy.allowsKeepAlive());
+    OATPP_ASSERT(policy.rules.size() == 2);
+    OATPP_ASSERT(policy.idleTimeoutSeconds == 30);
+    OATPP_ASSERT(policy.maxRequests == 8);
+    OATPP_ASSERT(policy.getMode("okhttp/4.9.0") == ConnectionPolicy::Mode::KEEP_ALIVE);
+    OATPP_ASSERT(policy.getMode("hass/2023.1") == ConnectionPolicy::Mode::KEEP_ALIVE);
+    OATPP_ASSERT(policy.getMode("Echo/1.0") == ConnectionPolicy::Mode::CLOSE);
+    OATPP_ASSERT(policy.getMode(nullptr) == ConnectionPolicy::Mode::CLOSE);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "keep-alive for all except selected User-Agents...");
+
+    const char* argv[] = {"hub", "--keep-alive", "--close-agents", "Echo"};
+    auto config = AppConfig::fromArgs(oatpp::base::CommandLineArguments(4, argv));
+    const auto& policy = config.connectionPolicy;
+
+    OATPP_ASSERT(policy.allowsKeepAlive());
+    OATPP_ASSERT(policy.getMode("Echo/1.0") == ConnectionPolicy::Mode::CLOSE);
+    OATPP_ASSERT(policy.getMode("okhttp/4.9.0") == ConnectionPolicy::Mode::KEEP_ALIVE);
+    OATPP_ASSERT(policy.getMode(nullptr) == ConnectionPolicy::Mode::KEEP_ALIVE);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
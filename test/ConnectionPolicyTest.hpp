@@ -0,0 +1,17 @@
+#ifndef ConnectionPolicyTest_hpp
+#define ConnectionPolicyTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class ConnectionPolicyTest : public oatpp::test::UnitTest {
+public:
+
+  ConnectionPolicyTest()
+    : UnitTest("TEST[ConnectionPolicyTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ConnectionPolicyTest_hpp */
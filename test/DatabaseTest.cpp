@@ -0,0 +1,263 @@
+
+#include "DatabaseTest.hpp"
+
+#include "db/Database.hpp"
+
+void DatabaseTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "ID reuse after deleteHueDevice...");
+
+    Database db;
+    v_int32 oat = db.registerHueDevice("Oat");
+    v_int32 grain = db.registerHueDevice("Grain");
+    v_int32 bran = db.registerHueDevice("Bran");
+
+    OATPP_ASSERT(oat == 0);
+    OATPP_ASSERT(grain == 1);
+    OATPP_ASSERT(bran == 2);
+
+    OATPP_ASSERT(db.deleteHueDevice(grain));
+    OATPP_ASSERT(db.getHueDeviceById(grain) == nullptr);
+    OATPP_ASSERT(db.getHueDeviceJsonById(grain) == nullptr);
+    OATPP_ASSERT(!db.deleteHueDevice(grain));
+
+    // the freed slot is reused, but with a new generation
+    v_int32 rye = db.registerHueDevice("Rye");
+    OATPP_ASSERT(rye != grain);
+    OATPP_ASSERT(Database::slotOf(rye) == Database::slotOf(grain));
+    OATPP_ASSERT(Database::generationOf(rye) == Database::generationOf(grain) + 1);
+
+    // the stale id must not alias the new device
+    OATPP_ASSERT(db.getHueDeviceById(grain) == nullptr);
+    OATPP_ASSERT(!db.deleteHueDevice(grain));
+
+    bool thrown = false;
+    try {
+      auto state = HueDeviceStateDto::createShared();
+      state->on = true;
+      db.updateHueDeviceState(grain, state);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    auto device = db.getHueDeviceById(rye);
+    OATPP_ASSERT(device);
+    OATPP_ASSERT(device->name == "Rye");
+
+    // lights are listed in slot order
+    auto devices = db.getHueDevices();
+    OATPP_ASSERT(devices->size() == 3);
+    auto it = devices->begin();
+    OATPP_ASSERT(*(it++)->first == (v_uint32) oat);
+    OATPP_ASSERT(*(it++)->first == (v_uint32) rye);
+    OATPP_ASSERT(*(it++)->first == (v_uint32) bran);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Repeated reuse of one slot...");
+
+    Database db;
+    v_int32 id = db.registerHueDevice("Oat");
+    for (v_int32 i = 0; i < 10; i++) {
+      OATPP_ASSERT(db.deleteHueDevice(id));
+      v_int32 newId = db.registerHueDevice("Oat");
+      OATPP_ASSERT(newId != id);
+      OATPP_ASSERT(Database::slotOf(newId) == 0);
+      OATPP_ASSERT(db.getHueDeviceById(id) == nullptr);
+      id = newId;
+    }
+    OATPP_ASSERT(db.getHueDevices()->size() == 1);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Update by cached uniqueid...");
+
+    Database db;
+    db.registerHueDevice("Oat");
+    v_int32 grain = db.registerHueDevice("Grain");
+
+    auto device = db.getHueDeviceById(grain);
+    OATPP_ASSERT(device->uniqueid->size() == 12); // "%08zx%04d" - must not change, Alexa pairs by it
+    OATPP_ASSERT(device->uniqueid->substr(8) == "0002");
+
+    auto update = HueDeviceDto::createShared();
+    update->uniqueid = device->uniqueid;
+    update->name = "Barley";
+    update->state->bri = 42;
+    auto updated = db.updateHueDevice(update);
+    OATPP_ASSERT(updated->name == "Barley");
+    OATPP_ASSERT(updated->state->bri == 42);
+    OATPP_ASSERT(updated->uniqueid != device->uniqueid); // renamed - uniqueid follows the name
+    OATPP_ASSERT(db.getHueDeviceById(grain)->uniqueid == updated->uniqueid);
+
+    bool thrown = false;
+    try {
+      db.updateHueDevice(update); // stale uniqueid
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Group action updates the members in one write...");
+
+    Database db;
+    v_int32 oat = db.registerHueDevice("Oat");
+    v_int32 grain = db.registerHueDevice("Grain");
+    v_int32 bran = db.registerHueDevice("Bran");
+
+    v_int32 groupId = db.createGroup("Kitchen", {oat, bran});
+    OATPP_ASSERT(groupId == 1);
+    auto group = db.getGroupById(groupId);
+    OATPP_ASSERT(group->name == "Kitchen");
+    OATPP_ASSERT(group->lights->size() == 2);
+    OATPP_ASSERT(group->lights[0] == "1");
+    OATPP_ASSERT(group->lights[1] == "3");
+
+    auto state = HueDeviceStateDto::createShared();
+    state->on = true;
+    state->bri = 100;
+
+    v_uint64 version = db.getVersion();
+    auto action = db.updateGroupState(groupId, state);
+    OATPP_ASSERT(action != nullptr);
+    OATPP_ASSERT(action->on == true);
+    OATPP_ASSERT(action->bri == 100);
+    OATPP_ASSERT(db.getVersion() == version + 1);
+
+    OATPP_ASSERT(db.getHueDeviceById(oat)->state->bri == 100);
+    OATPP_ASSERT(db.getHueDeviceById(bran)->state->bri == 100);
+    OATPP_ASSERT(db.getHueDeviceById(grain)->state->on == false);
+    OATPP_ASSERT(db.getHueDeviceJsonById(bran)->find("\"bri\":100") != std::string::npos);
+
+    OATPP_ASSERT(db.updateGroupState(7, state) == nullptr);
+
+    bool thrown = false;
+    try {
+      db.createGroup("Ghosts", {42});
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Group 0 is all lights...");
+
+    Database db;
+    v_int32 oat = db.registerHueDevice("Oat");
+    v_int32 grain = db.registerHueDevice("Grain");
+
+    OATPP_ASSERT(db.getGroups()->size() == 0);
+    OATPP_ASSERT(db.getGroupById(0)->lights->size() == 2);
+    OATPP_ASSERT(!db.deleteGroup(0));
+
+    auto state = HueDeviceStateDto::createShared();
+    state->on = false;
+    state->ct = 200;
+    db.updateGroupState(0, state);
+    OATPP_ASSERT(db.getHueDeviceById(oat)->state->ct == 200);
+    OATPP_ASSERT(db.getHueDeviceById(grain)->state->ct == 200);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Deleted devices leave their groups...");
+
+    Database db;
+    v_int32 oat = db.registerHueDevice("Oat");
+    v_int32 grain = db.registerHueDevice("Grain");
+    v_int32 groupId = db.createGroup("Pantry", {oat, grain});
+
+    OATPP_ASSERT(db.deleteHueDevice(grain));
+    OATPP_ASSERT(db.getGroupById(groupId)->lights->size() == 1);
+
+    // the reused slot must not join the group
+    v_int32 rye = db.registerHueDevice("Rye");
+    OATPP_ASSERT(Database::slotOf(rye) == Database::slotOf(grain));
+    OATPP_ASSERT(db.getGroupById(groupId)->lights->size() == 1);
+
+    OATPP_ASSERT(db.getGroups()->size() == 1);
+    OATPP_ASSERT(db.deleteGroup(groupId));
+    OATPP_ASSERT(db.getGroupById(groupId) == nullptr);
+    OATPP_ASSERT(!db.deleteGroup(groupId));
+    OATPP_ASSERT(db.createGroup("Cellar", {oat}) == groupId); // the group id is reused
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Lights object rendered in chunks...");
+
+    Database db;
+    for (v_int32 i = 0; i < 600; i++) {
+      db.registerHueDevice(("Light-" + std::to_string(i)).c_str());
+    }
+    for (v_int32 i = 0; i < 600; i += 7) {
+      db.deleteHueDevice(i);
+    }
+
+    auto renderAll = [](Database::HueDevicesJsonCursor cursor, v_buff_size chunkSize, v_int32& chunks) {
+      std::string json;
+      std::string chunk;
+      chunks = 0;
+      while (cursor.next(chunk, chunkSize)) {
+        OATPP_ASSERT((v_buff_size) chunk.size() < chunkSize + 1024); // one device past the chunk size at most
+        json += chunk;
+        chunk.clear();
+        chunks++;
+      }
+      return json;
+    };
+
+    v_int32 chunks;
+    auto expected = *db.getHueDevicesJson();
+    auto cursor = db.getHueDevicesJsonCursor();
+    OATPP_ASSERT(cursor.getMaxCount() == 600);
+    OATPP_ASSERT(renderAll(cursor, 4096, chunks) == expected);
+    OATPP_ASSERT(chunks > 10);
+    OATPP_ASSERT(renderAll(cursor, 1 << 30, chunks) == expected);
+    OATPP_ASSERT(chunks == 1);
+
+    // pages count devices - id 0 is deleted, so devices 3 and 4 are the ids 4 and 5
+    OATPP_ASSERT(renderAll(db.getHueDevicesJsonCursor(3, 2), 4096, chunks)
+                 == "{\"5\":" + *db.getHueDeviceJsonById(4) + ",\"6\":" + *db.getHueDeviceJsonById(5) + "}");
+    OATPP_ASSERT(renderAll(db.getHueDevicesJsonCursor(0, 0), 4096, chunks) == "{}");
+    OATPP_ASSERT(renderAll(db.getHueDevicesJsonCursor(10000, 10), 4096, chunks) == "{}");
+    OATPP_ASSERT(db.getHueDevicesJsonCursor(590, 100).getMaxCount() == 10);
+
+    // the cursor keeps rendering the snapshot it was created on
+    cursor = db.getHueDevicesJsonCursor();
+    std::string json;
+    OATPP_ASSERT(cursor.next(json, 1));
+    db.registerHueDevice("Late");
+    db.deleteHueDevice(1);
+    // state writes copy the records and one chunk of JSON, the published fragments stay untouched
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_BRI;
+    update.bri = 1;
+    HueDevice updated;
+    OATPP_ASSERT(db.updateHueDeviceState(2, update, updated));
+    OATPP_ASSERT(db.updateHueDeviceState(300, update, updated));
+    while (cursor.next(json, 4096)) {}
+    OATPP_ASSERT(json == expected);
+    OATPP_ASSERT(db.getHueDeviceById(2)->state->bri == 1);
+    OATPP_ASSERT(db.getHueDeviceById(2)->name == "Light-2");
+    OATPP_ASSERT(db.getHueDeviceById(3)->state->bri == 254);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
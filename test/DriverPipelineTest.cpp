@@ -0,0 +1,130 @@
+
+#include "DriverPipelineTest.hpp"
+
+#include "driver/DriverPipeline.hpp"
+
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+class RecordingDriver : public LightDriver {
+public:
+  std::mutex mutex;
+  std::vector<Frame> frames;
+public:
+
+  void writeFrame(const Frame& frame) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    frames.push_back(frame);
+  }
+
+};
+
+}
+
+void DriverPipelineTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "CommandQueue...");
+
+    CommandQueue<v_int32> queue(4);
+    for (v_int32 i = 0; i < 4; i++) {
+      OATPP_ASSERT(queue.tryPush(i));
+    }
+    OATPP_ASSERT(!queue.tryPush(4));
+
+    v_int32 value;
+    for (v_int32 i = 0; i < 4; i++) {
+      OATPP_ASSERT(queue.tryPop(value));
+      OATPP_ASSERT(value == i);
+    }
+    OATPP_ASSERT(!queue.tryPop(value));
+
+    // wraps around
+    OATPP_ASSERT(queue.tryPush(5));
+    OATPP_ASSERT(queue.tryPop(value) && value == 5);
+
+    // rejected before the cells are allocated - a wrapped around negative capacity is not a bad_alloc
+    for (size_t capacity : {(size_t) 0, (size_t) 1, (size_t) 6, (size_t) -4096}) {
+      bool rejected = false;
+      try {
+        CommandQueue<v_int32> invalid(capacity);
+      } catch (const std::invalid_argument&) {
+        rejected = true;
+      }
+      OATPP_ASSERT(rejected);
+    }
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  DriverPipeline::Config config;
+  config.tickMs = 10000; // everything is written by the final frame of the destructor
+
+  {
+    OATPP_LOGI(TAG, "Superseded commands are coalesced...");
+
+    auto db = std::make_shared<Database>();
+    auto driver = std::make_shared<RecordingDriver>();
+    DriverPipeline::Stats stats;
+    v_int32 oat;
+    v_int32 grain;
+    {
+      auto pipeline = DriverPipeline::createShared(db, driver, config);
+      db->addChangeListener(pipeline);
+
+      oat = db->registerHueDevice("Oat");
+      grain = db->registerHueDevice("Grain");
+      HueStateUpdate update;
+      update.fields = HueStateUpdate::FIELD_BRI;
+      HueDevice updated;
+      for (v_int32 i = 1; i <= 10; i++) {
+        update.bri = (v_uint8) i;
+        OATPP_ASSERT(db->updateHueDeviceState(oat, update, updated));
+      }
+      OATPP_ASSERT(db->deleteHueDevice(grain));
+      stats = pipeline->getStats();
+    }
+
+    OATPP_ASSERT(stats.commandsQueued == 13);
+    OATPP_ASSERT(driver->frames.size() == 1);
+    const auto& frame = driver->frames.front();
+    OATPP_ASSERT(frame.sequence == 1);
+    OATPP_ASSERT(!frame.resync);
+    OATPP_ASSERT(frame.lights.size() == 2);
+    OATPP_ASSERT(frame.lights[0].id == oat);
+    OATPP_ASSERT(frame.lights[0].bri == 10);
+    OATPP_ASSERT(frame.lights[1].id == grain);
+    OATPP_ASSERT((frame.lights[1].flags & HueDevice::FLAG_IN_USE) == 0);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Overflow is followed by a resync...");
+
+    config.queueCapacity = 4;
+
+    auto db = std::make_shared<Database>();
+    auto driver = std::make_shared<RecordingDriver>();
+    DriverPipeline::Stats stats;
+    {
+      auto pipeline = DriverPipeline::createShared(db, driver, config);
+      db->addChangeListener(pipeline);
+      for (v_int32 i = 0; i < 6; i++) {
+        db->registerHueDevice("Light");
+      }
+      stats = pipeline->getStats();
+    }
+
+    OATPP_ASSERT(stats.commandsQueued == 4);
+    OATPP_ASSERT(stats.commandsDropped == 2);
+    OATPP_ASSERT(driver->frames.size() == 1);
+    OATPP_ASSERT(driver->frames.front().resync);
+    OATPP_ASSERT(driver->frames.front().lights.size() == 6);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
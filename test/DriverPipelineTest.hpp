@@ -0,0 +1,17 @@
+#ifndef DriverPipelineTest_hpp
+#define DriverPipelineTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class DriverPipelineTest : public oatpp::test::UnitTest {
+public:
+
+  DriverPipelineTest()
+    : UnitTest("TEST[DriverPipelineTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* DriverPipelineTest_hpp */
@@ -0,0 +1,65 @@
+
+#include "HueResponseWriterTest.hpp"
+
+#include "response/HueResponseWriter.hpp"
+
+#include <string>
+
+void HueResponseWriterTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "State success...");
+
+    HueStateUpdate state;
+    state.fields = HueStateUpdate::FIELD_ON | HueStateUpdate::FIELD_BRI | HueStateUpdate::FIELD_COLORMODE;
+    state.on = true;
+    state.bri = 0;
+    state.colormode = HueColorMode::XY;
+
+    HueDevice updated;
+    state.applyTo(updated); // "on" with bri 0 turns the light on at full brightness
+
+    HueResponseWriter writer;
+    writer.addStateSuccess("/lights/", 12, "/state/", state, updated);
+    OATPP_ASSERT(writer.toString() ==
+      "[{\"success\":{\"/lights/12/state/on\":true}},"
+      "{\"success\":{\"/lights/12/state/bri\":254}},"
+      "{\"success\":{\"/lights/12/state/colormode\":\"xy\"}}]");
+
+    HueResponseWriter empty;
+    OATPP_ASSERT(empty.toString() == "[]");
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Errors and messages...");
+
+    HueResponseWriter writer;
+    writer.addError(HueResponseWriter::ERROR_RESOURCE_NOT_AVAILABLE, "/lights/9", "resource, /lights/9, not available");
+    writer.addSuccess("id", "3");
+    writer.addSuccess("/groups/3 \"deleted\"");
+    OATPP_ASSERT(writer.toString() ==
+      "[{\"error\":{\"type\":3,\"address\":\"/lights/9\",\"description\":\"resource, /lights/9, not available\"}},"
+      "{\"success\":{\"id\":\"3\"}},"
+      "{\"success\":\"/groups/3 \\u0022deleted\\u0022\"}]");
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Entries exceeding the buffer are dropped...");
+
+    HueResponseWriter writer;
+    std::string message(100, 'x');
+    for (v_int32 i = 0; i < 100; i++) {
+      writer.addSuccess(message.c_str());
+    }
+    std::string json(writer.getData(), (size_t) writer.getSize());
+    OATPP_ASSERT(json.size() <= (size_t) HueResponseWriter::CAPACITY);
+    OATPP_ASSERT(json.substr(json.size() - 3) == "\"}]");
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
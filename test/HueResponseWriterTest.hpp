@@ -0,0 +1,17 @@
+#ifndef HueResponseWriterTest_hpp
+#define HueResponseWriterTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class HueResponseWriterTest : public oatpp::test::UnitTest {
+public:
+
+  HueResponseWriterTest()
+    : UnitTest("TEST[HueResponseWriterTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* HueResponseWriterTest_hpp */
@@ -0,0 +1,116 @@
+
+#include "HueStateParserTest.hpp"
+
+#include "parser/HueStateParser.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+
+#include <cstring>
+
+namespace {
+
+bool parse(const char* body, HueStateUpdate& update) {
+  return HueStateParser::parse(body, (v_buff_size) std::strlen(body), update);
+}
+
+}
+
+void HueStateParserTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "Plain state bodies...");
+
+    HueStateUpdate update;
+
+    OATPP_ASSERT(parse("{\"on\":true}", update));
+    OATPP_ASSERT(update.fields == HueStateUpdate::FIELD_ON);
+    OATPP_ASSERT(update.on);
+
+    OATPP_ASSERT(parse(" {\n \"bri\" : 254 , \"on\":false }\r\n", update));
+    OATPP_ASSERT(update.fields == (HueStateUpdate::FIELD_ON | HueStateUpdate::FIELD_BRI));
+    OATPP_ASSERT(!update.on);
+    OATPP_ASSERT(update.bri == 254);
+
+    OATPP_ASSERT(parse("{\"hue\":65535,\"sat\":0,\"ct\":153,\"colormode\":\"hue\",\"transitiontime\":4}", update));
+    OATPP_ASSERT(update.hue == 65535);
+    OATPP_ASSERT(update.sat == 0);
+    OATPP_ASSERT(update.ct == 153);
+    OATPP_ASSERT(update.colormode == HueColorMode::HS);
+    OATPP_ASSERT(update.transitiontime == 4);
+    OATPP_ASSERT(update.has(HueStateUpdate::FIELD_SAT));
+    OATPP_ASSERT(!update.has(HueStateUpdate::FIELD_ON));
+
+    OATPP_ASSERT(parse("{\"xy\":[0.3127, 1],\"on\":true}", update));
+    OATPP_ASSERT(update.fields == (HueStateUpdate::FIELD_XY | HueStateUpdate::FIELD_ON));
+    OATPP_ASSERT(update.x == 0.3127f);
+    OATPP_ASSERT(update.y == 1.0f);
+
+    OATPP_ASSERT(parse("{}", update));
+    OATPP_ASSERT(update.fields == 0);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Unusual bodies are left to the ObjectMapper...");
+
+    const char* rejected[] = {
+      "",
+      "[]",
+      "{\"on\":true",
+      "{\"on\":true,}",
+      "{\"on\":true} {}",
+      "{\"on\":null}",
+      "{\"on\":1}",
+      "{\"bri\":256}",
+      "{\"bri\":-1}",
+      "{\"bri\":1.5}",
+      "{\"hue\":1e3}",
+      "{\"hue\":99999999999}",
+      "{\"colormode\":\"rgb\"}",
+      "{\"o\\u006e\":true}",
+      "{\"xy\":[0.3]}",
+      "{\"xy\":[0.3,1.5]}",
+      "{\"xy\":[-0.3,0.3]}",
+      "{\"xy\":[0.3,3e-1]}",
+      "{\"xy\":[0.3,.3]}",
+      "{\"alert\":\"select\"}"
+    };
+    HueStateUpdate update;
+    for (const char* body : rejected) {
+      OATPP_ASSERT(!parse(body, update));
+    }
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Fallback to HueDeviceStateDto...");
+
+    auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    objectMapper->getDeserializer()->getConfig()->allowUnknownFields = true;
+
+    HueStateUpdate update;
+    const char* body = "{\"on\":true,\"bri\":10,\"xy\":[0.3,0.3],\"alert\":\"none\"}";
+    OATPP_ASSERT(!parse(body, update));
+    OATPP_ASSERT(HueStateParser::parse(body, (v_buff_size) std::strlen(body), objectMapper.get(), update));
+    OATPP_ASSERT(update.fields == (HueStateUpdate::FIELD_ON | HueStateUpdate::FIELD_BRI | HueStateUpdate::FIELD_XY));
+    OATPP_ASSERT(update.on);
+    OATPP_ASSERT(update.bri == 10);
+    OATPP_ASSERT(update.x == 0.3f && update.y == 0.3f);
+
+    // both paths agree on the same body
+    HueStateUpdate fast;
+    HueStateUpdate slow;
+    const char* plain = "{\"on\":false,\"ct\":366,\"colormode\":\"ct\"}";
+    OATPP_ASSERT(parse(plain, fast));
+    slow = HueStateUpdate::fromDto(objectMapper->readFromString<oatpp::Object<HueDeviceStateDto>>(plain));
+    OATPP_ASSERT(fast.fields == slow.fields);
+    OATPP_ASSERT(fast.on == slow.on);
+    OATPP_ASSERT(fast.ct == slow.ct);
+    OATPP_ASSERT(fast.colormode == slow.colormode);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,17 @@
+#ifndef HueStateParserTest_hpp
+#define HueStateParserTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class HueStateParserTest : public oatpp::test::UnitTest {
+public:
+
+  HueStateParserTest()
+    : UnitTest("TEST[HueStateParserTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* HueStateParserTest_hpp */
@@ -0,0 +1,135 @@
+
+#include "MetricsTest.hpp"
+
+#include "metrics/Metrics.hpp"
+#include "db/Database.hpp"
+
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const v_int32 THREADS = 8;
+const v_int32 RECORDS = 10000;
+
+bool contains(const oatpp::String& text, const char* line) {
+  return text->find(line) != std::string::npos;
+}
+
+void recordOnThreads(Metrics& metrics, v_int32 series) {
+  std::vector<std::thread> threads;
+  for (v_int32 t = 0; t < THREADS; t++) {
+    threads.emplace_back([&metrics, series] {
+      for (v_int32 i = 0; i < RECORDS; i++) {
+        metrics.record(series, 1000);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}
+
+void MetricsTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "Buckets are within 1/16 of their values...");
+
+    for (v_uint64 value = 0; value < ((v_uint64) 1 << 37); value = value < 1000 ? value + 1 : value + value / 7) {
+      v_int32 bucket = LatencyHistogram::getBucket(value);
+      OATPP_ASSERT(bucket >= 0 && bucket < LatencyHistogram::BUCKETS_COUNT);
+      v_uint64 lower = LatencyHistogram::getBucketLowerBound(bucket);
+      v_uint64 upper = LatencyHistogram::getBucketUpperBound(bucket);
+      OATPP_ASSERT(lower <= value && value <= upper);
+      OATPP_ASSERT((upper - lower) * 16 <= std::max<v_uint64>(lower, 16));
+    }
+    OATPP_ASSERT(LatencyHistogram::getBucket((v_uint64) -1) == LatencyHistogram::BUCKETS_COUNT - 1);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Percentiles...");
+
+    LatencyHistogram histogram;
+    for (v_uint64 us = 1; us <= 1000; us++) {
+      histogram.record(us * 1000);
+    }
+    OATPP_ASSERT(histogram.getCount() == 1000);
+    OATPP_ASSERT(histogram.getSumNs() == 500500000);
+    OATPP_ASSERT(std::abs((v_float64) histogram.getPercentile(0.5) - 500500) < 500500 / 16.0);
+    OATPP_ASSERT(std::abs((v_float64) histogram.getPercentile(0.99) - 990000) < 990000 / 16.0);
+    OATPP_ASSERT(std::abs((v_float64) histogram.getPercentile(1.0) - 1000000) < 1000000 / 16.0);
+    OATPP_ASSERT(histogram.getCountAtOrBelow(2000000) == 1000);
+    OATPP_ASSERT(histogram.getCountAtOrBelow(500) == 0);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Shards of all threads are summed up, exited threads hand theirs on...");
+
+    Metrics metrics;
+    v_int32 series = metrics.addSeries("hue_test_duration", "Test", "path=\"/x\"");
+    OATPP_ASSERT(series == 0);
+
+    recordOnThreads(metrics, series);
+    OATPP_ASSERT(metrics.getHistogram(series).getCount() == THREADS * RECORDS);
+    OATPP_ASSERT(metrics.getShardsCount() <= THREADS);
+
+    recordOnThreads(metrics, series);
+    OATPP_ASSERT(metrics.getHistogram(series).getCount() == 2 * THREADS * RECORDS);
+    OATPP_ASSERT(metrics.getShardsCount() <= THREADS);
+
+    metrics.record(-1, 1000); // dropped
+    OATPP_ASSERT(metrics.getHistogram(series).getCount() == 2 * THREADS * RECORDS);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Prometheus text...");
+
+    Metrics metrics;
+    v_int32 series = metrics.addSeries("hue_test_duration", "Test", "path=\"/x\"");
+    metrics.addSeries("hue_test_duration", "Test", "path=\"/y\"");
+    OATPP_ASSERT(metrics.addSeries("hue_test_duration", "Test", "path=\"/x\"") == series); // the endpoint of another bridge
+    metrics.addGauge("hue_test_connections", "Connections", [] { return (v_int64) 7; });
+    metrics.record(series, 1000);
+    metrics.record(series, 3000000);
+
+    auto text = metrics.render();
+    OATPP_LOGD(TAG, "\n%s", text->c_str());
+    OATPP_ASSERT(contains(text, "# TYPE hue_test_duration_seconds histogram\n"));
+    OATPP_ASSERT(contains(text, "hue_test_duration_seconds_bucket{path=\"/x\",le=\"0.000025\"} 1\n"));
+    OATPP_ASSERT(contains(text, "hue_test_duration_seconds_bucket{path=\"/x\",le=\"0.005\"} 2\n"));
+    OATPP_ASSERT(contains(text, "hue_test_duration_seconds_bucket{path=\"/x\",le=\"+Inf\"} 2\n"));
+    OATPP_ASSERT(contains(text, "hue_test_duration_seconds_count{path=\"/x\"} 2\n"));
+    OATPP_ASSERT(contains(text, "hue_test_duration_seconds_count{path=\"/y\"} 0\n"));
+    OATPP_ASSERT(contains(text, "hue_test_duration_quantile_seconds{path=\"/x\",quantile=\"0.999\"}"));
+    OATPP_ASSERT(contains(text, "# TYPE hue_test_connections gauge\nhue_test_connections 7\n"));
+    // one HELP/TYPE per family
+    OATPP_ASSERT(text->find("# TYPE hue_test_duration_seconds") == text->rfind("# TYPE hue_test_duration_seconds"));
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Database write lock...");
+
+    auto metrics = Metrics::createShared();
+    Database db;
+    db.setMetrics(metrics);
+    db.registerHueDevice("Oat");
+    db.registerHueDevice("Grain");
+
+    auto text = metrics->render();
+    OATPP_ASSERT(contains(text, "hue_db_write_lock_wait_seconds_count 2\n"));
+    OATPP_ASSERT(contains(text, "hue_db_write_lock_hold_seconds_count 2\n"));
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,105 @@
+#include "ReusePortConnectionProviderTest.hpp"
+
+#include "connection/ReusePortConnectionProvider.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const v_uint16 PORT = 18765;
+
+bool connectTo(v_uint16 port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bool connected = ::connect(fd, (const sockaddr*) &address, sizeof(address)) == 0;
+  ::close(fd);
+  return connected;
+}
+
+}
+
+void ReusePortConnectionProviderTest::onRun() {
+
+  {
+    OATPP_LOGI(TAG, "Shards accept on the same port...");
+
+    auto first = ReusePortConnectionProvider::createShared({"127.0.0.1", PORT, oatpp::network::Address::IP_4});
+    auto second = ReusePortConnectionProvider::createShared({"127.0.0.1", PORT, oatpp::network::Address::IP_4});
+
+    std::atomic<v_int32> firstAccepted(0);
+    std::atomic<v_int32> secondAccepted(0);
+    std::thread firstThread([first, &firstAccepted] {
+      while (first->get().object) {
+        firstAccepted++;
+      }
+    });
+    std::thread secondThread([second, &secondAccepted] {
+      while (second->get().object) {
+        secondAccepted++;
+      }
+    });
+
+    const v_int32 connections = 200;
+    for (v_int32 i = 0; i < connections; i++) {
+      OATPP_ASSERT(connectTo(PORT));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (firstAccepted + secondAccepted < connections && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    OATPP_LOGD(TAG, "accepted %d + %d", firstAccepted.load(), secondAccepted.load());
+    OATPP_ASSERT(firstAccepted + secondAccepted == connections);
+    // the kernel hashes the client ports over the sockets - both get a share
+    OATPP_ASSERT(firstAccepted > 0 && secondAccepted > 0);
+
+    // get() returns once stopped
+    first->stop();
+    second->stop();
+    firstThread.join();
+    secondThread.join();
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A port bound without SO_REUSEPORT can't be shared...");
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(PORT + 1);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    OATPP_ASSERT(::bind(fd, (const sockaddr*) &address, sizeof(address)) == 0);
+    OATPP_ASSERT(::listen(fd, 16) == 0);
+
+    bool thrown = false;
+    try {
+      ReusePortConnectionProvider::createShared({"127.0.0.1", (v_uint16) (PORT + 1), oatpp::network::Address::IP_4});
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+    ::close(fd);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,17 @@
+#ifndef ReusePortConnectionProviderTest_hpp
+#define ReusePortConnectionProviderTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class ReusePortConnectionProviderTest : public oatpp::test::UnitTest {
+public:
+
+  ReusePortConnectionProviderTest()
+    : UnitTest("TEST[ReusePortConnectionProviderTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* ReusePortConnectionProviderTest_hpp */
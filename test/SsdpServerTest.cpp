@@ -0,0 +1,382 @@
+
+#include "SsdpServerTest.hpp"
+
+#include "ssdp/SsdpServer.hpp"
+#include "ssdp/TimerWheel.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace {
+
+const char* const SEARCH =
+  "M-SEARCH * HTTP/1.1\r\n"
+  "HOST: 239.255.255.250:1900\r\n"
+  "MAN: \"ssdp:discover\"\r\n"
+  "MX: 1\r\n"
+  "ST: urn:schemas-upnp-org:device:basic:1\r\n"
+  "\r\n";
+
+const char* const NOTIFY =
+  "NOTIFY * HTTP/1.1\r\n"
+  "HOST: 239.255.255.250:1900\r\n"
+  "NTS: ssdp:alive\r\n"
+  "\r\n";
+
+/**
+ *  The LOCATION header of an answer, empty if it has none
+ */
+std::string getLocation(const std::string& packet) {
+  size_t begin = packet.find("\r\nLOCATION: ");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  begin += 12;
+  return packet.substr(begin, packet.find("\r\n", begin) - begin);
+}
+
+/**
+ *  Value of the header `name` (with the colon and space), empty if the packet has none
+ */
+std::string getHeader(const std::string& packet, const std::string& name) {
+  size_t begin = packet.find("\r\n" + name);
+  if (begin == std::string::npos) {
+    return "";
+  }
+  begin += 2 + name.size();
+  return packet.substr(begin, packet.find("\r\n", begin) - begin);
+}
+
+}
+
+void SsdpServerTest::onRun() {
+
+  auto first = std::make_shared<DeviceDescriptorComponent::DeviceDescriptor>();
+  first->ipPort = "127.0.0.1:8000";
+  first->mac = "be5t0a70cafe";
+  first->sn = "1000000471337";
+  first->uuid = DeviceDescriptorComponent::DeviceDescriptor::UUID_PREFIX + first->mac;
+
+  {
+    OATPP_LOGI(TAG, "Descriptors of further bridges...");
+
+    auto second = first->deriveBridge(1, 8001);
+    auto third = first->deriveBridge(2, 8002);
+    OATPP_ASSERT(second->ipPort == "127.0.0.1:8001");
+    OATPP_ASSERT(second->mac == "be5t0a70caff");
+    OATPP_ASSERT(third->mac == "be5t0a70cb00");
+    OATPP_ASSERT(third->uuid == "2f402f80-da50-11e1-9b23-be5t0a70cb00");
+    OATPP_ASSERT(third->sn == first->sn);
+    OATPP_ASSERT(third->getRendered()->usn == "uuid:2f402f80-da50-11e1-9b23-be5t0a70cb00::upnp:rootdevice");
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A search is answered once per bridge, other packets are ignored...");
+
+    SsdpServer::Config config;
+    config.host = "127.0.0.1";
+    config.port = 0;
+    config.multicastGroup = "";
+    config.notifyHost = "";
+    auto server = SsdpServer::createShared(config, {first, first->deriveBridge(1, 8001), first->deriveBridge(2, 8002)});
+    std::thread thread([server] { server->run(); });
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    OATPP_ASSERT(fd >= 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server->getPort());
+    ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    OATPP_ASSERT(::connect(fd, (const sockaddr*) &address, sizeof(address)) == 0);
+
+    OATPP_ASSERT(::send(fd, NOTIFY, std::strlen(NOTIFY), 0) > 0);
+    OATPP_ASSERT(::send(fd, SEARCH, std::strlen(SEARCH), 0) > 0);
+
+    std::set<std::string> locations;
+    char buffer[2048];
+    for (v_int32 i = 0; i < 3; i++) {
+      pollfd pollFd;
+      pollFd.fd = fd;
+      pollFd.events = POLLIN;
+      pollFd.revents = 0;
+      OATPP_ASSERT(::poll(&pollFd, 1, 2000) == 1);
+      auto res = ::recv(fd, buffer, sizeof(buffer), 0);
+      OATPP_ASSERT(res > 0);
+      std::string packet(buffer, (size_t) res);
+      OATPP_ASSERT(packet.compare(0, 17, "HTTP/1.1 200 OK\r\n") == 0);
+      OATPP_ASSERT(packet.find("\r\nST: urn:schemas-upnp-org:device:basic:1\r\n") != std::string::npos);
+      OATPP_ASSERT(packet.compare(packet.size() - 4, 4, "\r\n\r\n") == 0);
+      locations.insert(getLocation(packet));
+    }
+    OATPP_ASSERT(locations.size() == 3);
+    OATPP_ASSERT(locations.count("http://127.0.0.1:8000/description.xml") == 1);
+    OATPP_ASSERT(locations.count("http://127.0.0.1:8002/description.xml") == 1);
+
+    // the last answer may arrive before the server counted it
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (server->getStats().responses < 3 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto stats = server->getStats();
+    OATPP_ASSERT(stats.searches == 1);
+    OATPP_ASSERT(stats.responses == 3);
+    OATPP_ASSERT(stats.ignored == 1);
+
+    ::close(fd);
+    server->stop();
+    thread.join();
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A replayed discovery storm is answered once per client, target and matching bridge...");
+
+    OATPP_ASSERT(SsdpServer::getHeader(SEARCH, (v_buff_size) std::strlen(SEARCH), "mx") == "1");
+    OATPP_ASSERT(SsdpServer::getHeader(SEARCH, (v_buff_size) std::strlen(SEARCH), "MAN") == "\"ssdp:discover\"");
+    OATPP_ASSERT(SsdpServer::getHeader(SEARCH, (v_buff_size) std::strlen(SEARCH), "USER-AGENT") == "");
+
+    SsdpServer::Config config;
+    config.host = "127.0.0.1";
+    config.port = 0;
+    config.multicastGroup = "";
+    config.notifyHost = "";
+    config.maxResponseDelayMs = 200;
+    config.tickMs = 10;
+    auto second = first->deriveBridge(1, 8001);
+    auto server = SsdpServer::createShared(config, {first, second});
+    std::thread thread([server] { server->run(); });
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server->getPort());
+    ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+    // four Echo devices, each repeating its searches
+    const v_int32 clientsCount = 4;
+    int clients[clientsCount];
+    for (v_int32 i = 0; i < clientsCount; i++) {
+      clients[i] = ::socket(AF_INET, SOCK_DGRAM, 0);
+      OATPP_ASSERT(clients[i] >= 0);
+      OATPP_ASSERT(::connect(clients[i], (const sockaddr*) &address, sizeof(address)) == 0);
+    }
+
+    const std::string searchAll = std::string(SEARCH).replace(std::string(SEARCH).find("urn:schemas"), 35, "ssdp:all");
+    const std::string searchUuid = std::string(SEARCH).replace(std::string(SEARCH).find("urn:schemas"), 35, "uuid:" + *second->uuid);
+    const std::string searchOther = std::string(SEARCH).replace(std::string(SEARCH).find("urn:schemas"), 35, "urn:dial-multiscreen-org:service:dial:1");
+
+    v_int32 packetsIn = 0;
+    auto send = [&packetsIn](int fd, const std::string& search) {
+      OATPP_ASSERT(::send(fd, search.data(), search.size(), 0) > 0);
+      packetsIn++;
+    };
+    for (v_int32 copy = 0; copy < 5; copy++) {
+      for (v_int32 i = 0; i < clientsCount; i++) {
+        send(clients[i], SEARCH); // device type - one answer per bridge
+        if (i < 2 && copy < 3) {
+          send(clients[i], searchAll); // all three targets of each bridge
+        }
+        if (i == 2 && copy < 2) {
+          send(clients[i], searchUuid); // the second bridge only
+        }
+        if (i == 3 && copy < 3) {
+          send(clients[i], searchOther); // no bridge
+        }
+      }
+    }
+    const v_int32 expected = clientsCount * 2 + 2 * 2 * 3 + 1;
+
+    // the answers, by client and ST
+    std::map<std::string, v_int32> answers;
+    v_int32 packetsOut = 0;
+    char buffer[2048];
+    for (v_int32 i = 0; i < clientsCount; i++) {
+      pollfd pollFd;
+      pollFd.fd = clients[i];
+      pollFd.events = POLLIN;
+      pollFd.revents = 0;
+      while (::poll(&pollFd, 1, 500) == 1) {
+        auto res = ::recv(clients[i], buffer, sizeof(buffer), 0);
+        OATPP_ASSERT(res > 0);
+        std::string packet(buffer, (size_t) res);
+        answers[std::to_string(i) + " " + getHeader(packet, "ST: ")]++;
+        packetsOut++;
+      }
+    }
+
+    OATPP_LOGD(TAG, "packets in %d, packets out %d (%d answered unconditionally)", packetsIn, packetsOut, packetsIn * 2);
+    OATPP_ASSERT(packetsOut == expected);
+    OATPP_ASSERT(answers["0 urn:schemas-upnp-org:device:basic:1"] == 2 + 2); // for the device type and ssdp:all
+    OATPP_ASSERT(answers["1 upnp:rootdevice"] == 2);
+    OATPP_ASSERT(answers["2 uuid:" + *second->uuid] == 1);
+    OATPP_ASSERT(answers["3 urn:schemas-upnp-org:device:basic:1"] == 2);
+    OATPP_ASSERT(answers.size() == 4 + 4 + 2 + 1);
+
+    auto stats = server->getStats();
+    OATPP_ASSERT(stats.searches == packetsIn);
+    OATPP_ASSERT(stats.responses == packetsOut);
+    OATPP_ASSERT(stats.duplicates == packetsIn - 4 - 2 - 1 - 1);
+    OATPP_ASSERT(stats.unmatched == 1);
+
+    // unicast searches are answered every time
+    const std::string unicast = std::string(SEARCH).replace(std::string(SEARCH).find("MX: 1\r\n"), 7, "");
+    send(clients[0], unicast);
+    send(clients[0], unicast);
+    for (v_int32 i = 0; i < 2 * 2; i++) {
+      pollfd pollFd;
+      pollFd.fd = clients[0];
+      pollFd.events = POLLIN;
+      pollFd.revents = 0;
+      OATPP_ASSERT(::poll(&pollFd, 1, 500) == 1);
+      OATPP_ASSERT(::recv(clients[0], buffer, sizeof(buffer), 0) > 0);
+    }
+
+    for (v_int32 i = 0; i < clientsCount; i++) {
+      ::close(clients[i]);
+    }
+    server->stop();
+    thread.join();
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Timer wheel fires in order of the ticks, across revolutions...");
+
+    TimerWheel<v_int32> wheel(8);
+    wheel.schedule(3, 3);
+    wheel.schedule(1, 1);
+    wheel.schedule(11, 11); // same slot as 3, one revolution later
+    wheel.schedule(20, 20);
+    OATPP_ASSERT(wheel.getSize() == 4);
+
+    std::vector<v_int32> fired;
+    auto collect = [&fired](v_int64 tick, v_int32 value) {
+      OATPP_ASSERT(tick == value);
+      fired.push_back(value);
+    };
+
+    wheel.advance(3, collect);
+    OATPP_ASSERT(fired == std::vector<v_int32>({1, 3}));
+    wheel.advance(10, collect);
+    OATPP_ASSERT(fired.size() == 2);
+    wheel.schedule(2, 11); // in the past - fires with the next advance, at tick 11
+    wheel.advance(100, collect); // more than one revolution at once
+    OATPP_ASSERT(fired == std::vector<v_int32>({1, 3, 11, 11, 20}));
+    OATPP_ASSERT(wheel.getSize() == 0);
+    OATPP_ASSERT(wheel.getTick() == 100);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Bridges are announced on a jittered schedule and say byebye when stopped...");
+
+    // local listener in place of the multicast group
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    OATPP_ASSERT(fd >= 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    OATPP_ASSERT(::bind(fd, (const sockaddr*) &address, sizeof(address)) == 0);
+    socklen_t addressSize = sizeof(address);
+    OATPP_ASSERT(::getsockname(fd, (sockaddr*) &address, &addressSize) == 0);
+
+    SsdpServer::Config config;
+    config.host = "127.0.0.1";
+    config.port = 0;
+    config.multicastGroup = "";
+    config.notifyHost = "127.0.0.1";
+    config.notifyPort = ntohs(address.sin_port);
+    config.announceIntervalMs = 200;
+    config.announceJitterMs = 50;
+    config.tickMs = 10;
+    auto second = first->deriveBridge(1, 8001);
+    auto server = SsdpServer::createShared(config, {first, second});
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread thread([server] { server->run(); });
+
+    // time of every alive per USN, byebye count per USN
+    std::map<std::string, std::vector<v_int64>> alive;
+    std::map<std::string, v_int32> byebye;
+    v_int32 packets = 0;
+    bool stopped = false;
+    char buffer[2048];
+
+    while (true) {
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      if (!stopped && elapsed >= 1000) {
+        server->stop();
+        thread.join();
+        stopped = true;
+      }
+      pollfd pollFd;
+      pollFd.fd = fd;
+      pollFd.events = POLLIN;
+      pollFd.revents = 0;
+      if (::poll(&pollFd, 1, 100) <= 0) {
+        if (stopped) {
+          break; // byebyes are sent before run() returns
+        }
+        continue;
+      }
+      auto res = ::recv(fd, buffer, sizeof(buffer), 0);
+      OATPP_ASSERT(res > 0);
+      std::string packet(buffer, (size_t) res);
+      OATPP_ASSERT(packet.compare(0, 19, "NOTIFY * HTTP/1.1\r\n") == 0);
+      packets++;
+      auto usn = getHeader(packet, "USN: ");
+      auto nts = getHeader(packet, "NTS: ");
+      if (nts == "ssdp:alive") {
+        OATPP_ASSERT(getHeader(packet, "CACHE-CONTROL: ") == "max-age=100");
+        alive[usn].push_back((v_int64) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+      } else {
+        OATPP_ASSERT(nts == "ssdp:byebye");
+        byebye[usn]++;
+      }
+    }
+
+    // root device, UUID and device type of each bridge
+    OATPP_ASSERT(alive.size() == 6);
+    OATPP_ASSERT(byebye.size() == 6);
+    OATPP_ASSERT(alive.count(first->getRendered()->usn->c_str()) == 1);
+    OATPP_ASSERT(alive.count("uuid:" + *second->uuid) == 1);
+    OATPP_ASSERT(alive.count("uuid:" + *second->uuid + "::urn:schemas-upnp-org:device:basic:1") == 1);
+
+    v_int32 aliveCount = 0;
+    for (auto& times : alive) {
+      OATPP_ASSERT(byebye[times.first] == 1);
+      // first within the startup delay, then every 150..200ms - 1s holds 5 to 7 of them
+      OATPP_ASSERT(times.second.size() >= 5 && times.second.size() <= 7);
+      OATPP_ASSERT(times.second[0] < 150);
+      for (size_t i = 1; i < times.second.size(); i++) {
+        auto gap = times.second[i] - times.second[i - 1];
+        OATPP_ASSERT(gap >= 140 && gap <= 260);
+      }
+      aliveCount += (v_int32) times.second.size();
+    }
+    OATPP_ASSERT(aliveCount + 6 == packets);
+    OATPP_ASSERT(server->getStats().notifications == packets);
+
+    ::close(fd);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
@@ -0,0 +1,17 @@
+#ifndef SsdpServerTest_hpp
+#define SsdpServerTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class SsdpServerTest : public oatpp::test::UnitTest {
+public:
+
+  SsdpServerTest()
+    : UnitTest("TEST[SsdpServerTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* SsdpServerTest_hpp */
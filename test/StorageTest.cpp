@@ -0,0 +1,184 @@
+
+#include "StorageTest.hpp"
+
+#include "db/Storage.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <dirent.h>
+#include <unistd.h>
+
+namespace {
+
+std::vector<std::string> listFiles(const std::string& directory) {
+  std::vector<std::string> files;
+  DIR* dir = opendir(directory.c_str());
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      files.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  return files;
+}
+
+void removeDirectory(const std::string& directory) {
+  for (auto& file : listFiles(directory)) {
+    unlink((directory + "/" + file).c_str());
+  }
+  rmdir(directory.c_str());
+}
+
+oatpp::String getGroupsJson(Database& db) {
+  return Database::createDefaultObjectMapper()->writeToString(db.getGroups());
+}
+
+}
+
+void StorageTest::onRun() {
+
+  char directory[] = "/tmp/hue-storage-test-XXXXXX";
+  OATPP_ASSERT(mkdtemp(directory) != nullptr);
+
+  Storage::Config config;
+  config.directory = directory;
+
+  oatpp::String lightsJson;
+  oatpp::String groupsJson;
+  v_int32 rye;
+
+  {
+    OATPP_LOGI(TAG, "Writes are replayed from the journal...");
+
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+
+    v_int32 oat = db->registerHueDevice("Oat");
+    v_int32 grain = db->registerHueDevice("Grain");
+    rye = db->registerHueDevice("Rye", true, 10);
+
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_BRI | HueStateUpdate::FIELD_HUE;
+    update.bri = 42;
+    update.hue = 1000;
+    HueDevice updated;
+    OATPP_ASSERT(db->updateHueDeviceState(oat, update, updated));
+
+    auto renamed = db->getHueDeviceById(grain);
+    renamed->name = "Barley";
+    db->updateHueDevice(renamed);
+
+    v_int32 kitchen = db->createGroup("Kitchen", {oat, rye});
+    db->deleteGroup(db->createGroup("Hallway", {grain}));
+    update.fields = HueStateUpdate::FIELD_ON;
+    update.on = true;
+    Database::PendingWrite pending; // the way the async controller writes
+    OATPP_ASSERT(db->updateGroupState(kitchen, update, updated, &pending));
+    bool durable = false;
+    while (!pending.poll(durable)) {
+      std::this_thread::yield();
+    }
+    OATPP_ASSERT(durable);
+    OATPP_ASSERT(db->deleteHueDevice(rye));
+
+    lightsJson = db->getHueDevicesJson();
+    groupsJson = getGroupsJson(*db);
+    OATPP_ASSERT(storage->getStats().journal.commits == 10);
+  }
+
+  {
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+    OATPP_ASSERT(db->getHueDevicesJson() == lightsJson);
+    OATPP_ASSERT(getGroupsJson(*db) == groupsJson);
+    OATPP_ASSERT(storage->getStats().snapshotDevices == 0);
+
+    // the slot of the deleted device is reused with the next generation, as if the hub never stopped
+    v_int32 spelt = db->registerHueDevice("Spelt");
+    OATPP_ASSERT(Database::slotOf(spelt) == Database::slotOf(rye));
+    OATPP_ASSERT(Database::generationOf(spelt) == Database::generationOf(rye) + 1);
+
+    OATPP_LOGI(TAG, "OK");
+
+    OATPP_LOGI(TAG, "Compaction replaces the journals with a snapshot...");
+
+    storage->compact();
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_CT;
+    update.ct = 200;
+    HueDevice updated;
+    OATPP_ASSERT(db->updateHueDeviceState(spelt, update, updated));
+
+    lightsJson = db->getHueDevicesJson();
+    groupsJson = getGroupsJson(*db);
+  }
+
+  auto files = listFiles(directory);
+  OATPP_ASSERT(files.size() == 2); // snapshot + the journal started by the compaction
+  std::string journal = files[0] == "snapshot" ? files[1] : files[0];
+
+  {
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+    OATPP_ASSERT(db->getHueDevicesJson() == lightsJson);
+    OATPP_ASSERT(getGroupsJson(*db) == groupsJson);
+    OATPP_ASSERT(storage->getStats().snapshotDevices == 3);
+    OATPP_ASSERT(storage->getStats().journalRecords == 1);
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A torn record ends the journal...");
+
+    FILE* file = fopen((std::string(directory) + "/" + journal).c_str(), "a");
+    fwrite("\x30\0\0\0torn", 1, 8, file);
+    fclose(file);
+
+    auto db = std::make_shared<Database>();
+    auto storage = Storage::createShared(db, config);
+    OATPP_ASSERT(db->getHueDevicesJson() == lightsJson);
+    OATPP_ASSERT(storage->getStats().journalRecords == 1);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Failed writes are reported until the journal is rotated...");
+
+    std::string records;
+    HueDevice hueDevice;
+    Journal::writeDevice(records, hueDevice, "Oat");
+
+    Journal journal("/dev/full", true); // every write fails with ENOSPC
+    v_uint64 first = journal.append(records);
+    OATPP_ASSERT(!journal.waitDurable(first));
+    OATPP_ASSERT(journal.isFailing());
+    v_uint64 second = journal.append(records);
+    bool durable = true;
+    while (!journal.pollDurable(second, durable)) {
+      std::this_thread::yield();
+    }
+    OATPP_ASSERT(!durable);
+    OATPP_ASSERT(!journal.waitDurable(second));
+
+    std::string path = std::string(directory) + "/journal.rotated";
+    journal.rotate(Journal::openFile(path));
+    v_uint64 third = journal.append(records);
+    while (!journal.pollDurable(third, durable)) {
+      std::this_thread::yield();
+    }
+    OATPP_ASSERT(durable);
+    OATPP_ASSERT(journal.waitDurable(third));
+    OATPP_ASSERT(!journal.waitDurable(first));
+    OATPP_ASSERT(!journal.isFailing());
+    OATPP_ASSERT(journal.getStats().bytes == (v_int64) records.size());
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  removeDirectory(directory);
+
+}
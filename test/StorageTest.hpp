@@ -0,0 +1,17 @@
+#ifndef StorageTest_hpp
+#define StorageTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class StorageTest : public oatpp::test::UnitTest {
+public:
+
+  StorageTest()
+    : UnitTest("TEST[StorageTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* StorageTest_hpp */
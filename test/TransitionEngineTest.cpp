@@ -0,0 +1,308 @@
+
+#include "TransitionEngineTest.hpp"
+
+#include "transition/TransitionEngine.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+class RecordingListener : public Database::ChangeListener {
+public:
+  std::vector<HueDevice> changes;
+public:
+
+  void onHueDevicesChanged(const std::vector<HueDevice>& hueDevices) override {
+    changes.insert(changes.end(), hueDevices.begin(), hueDevices.end());
+  }
+
+};
+
+HueDevice makeLight(v_uint32 version, bool on, v_uint8 bri, v_uint16 hue, v_uint16 ct) {
+  HueDevice hueDevice;
+  hueDevice.id = 7;
+  hueDevice.version = version;
+  hueDevice.flags |= HueDevice::FLAG_IN_USE;
+  hueDevice.setOn(on);
+  hueDevice.bri = bri;
+  hueDevice.hue = hue;
+  hueDevice.ct = ct;
+  return hueDevice;
+}
+
+bool contains(const oatpp::String& json, const char* fragment) {
+  return json && json->find(fragment) != std::string::npos;
+}
+
+}
+
+void TransitionEngineTest::onRun() {
+
+  typedef TransitionEngine::Clock Clock;
+
+  TransitionEngine::Config config;
+  config.tickMs = 3600 * 1000; // ticked by the test
+
+  {
+    OATPP_LOGI(TAG, "Fades are interpolated per tick...");
+
+    auto engine = TransitionEngine::createShared(config);
+    auto t0 = Clock::now();
+    auto updated = makeLight(2, true, 200, 0, 400);
+    engine->start(makeLight(1, true, 100, 0, 200), updated, 1000, t0);
+    OATPP_ASSERT(!engine->isEmpty());
+
+    HueDevice current = updated;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.bri == 100 && current.ct == 200);
+
+    engine->tick(t0 + std::chrono::milliseconds(500));
+    current = updated;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.bri == 150 && current.ct == 300);
+    OATPP_ASSERT(current.isOn());
+
+    // a record of another version was committed after the fade started
+    current = makeLight(3, true, 10, 0, 400);
+    OATPP_ASSERT(!engine->getState(current));
+    OATPP_ASSERT(current.bri == 10);
+
+    engine->tick(t0 + std::chrono::milliseconds(1000));
+    current = updated;
+    OATPP_ASSERT(!engine->getState(current));
+    OATPP_ASSERT(engine->isEmpty());
+
+    auto stats = engine->getStats();
+    OATPP_ASSERT(stats.started == 1);
+    OATPP_ASSERT(stats.finished == 1);
+    OATPP_ASSERT(stats.fading == 0);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Hue takes the short way, off fades through the brightness...");
+
+    auto engine = TransitionEngine::createShared(config);
+    auto t0 = Clock::now();
+
+    auto hue = makeLight(2, true, 100, 500, 200);
+    hue.id = 1;
+    hue.mode = HueColorMode::HS;
+    auto hueFrom = makeLight(1, true, 100, 65000, 200);
+    hueFrom.id = 1;
+    hueFrom.mode = HueColorMode::HS;
+    engine->start(hueFrom, hue, 1000, t0);
+
+    auto off = makeLight(2, false, 200, 0, 200);
+    off.id = 2;
+    auto offFrom = makeLight(1, true, 200, 0, 200);
+    offFrom.id = 2;
+    engine->start(offFrom, off, 1000, t0);
+
+    auto on = makeLight(2, true, 200, 0, 200);
+    on.id = 3;
+    auto onFrom = makeLight(1, false, 200, 0, 200);
+    onFrom.id = 3;
+    engine->start(onFrom, on, 1000, t0);
+
+    // off to off - nothing to see
+    auto dark = makeLight(2, false, 50, 0, 200);
+    dark.id = 4;
+    auto darkFrom = makeLight(1, false, 200, 0, 200);
+    darkFrom.id = 4;
+    engine->start(darkFrom, dark, 1000, t0);
+    OATPP_ASSERT(engine->getStats().fading == 3);
+
+    engine->tick(t0 + std::chrono::milliseconds(500));
+
+    HueDevice current = hue;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.hue == 65518); // (65000 + 66036) / 2, wrapped
+
+    current = off;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.isOn() && current.bri == 100);
+
+    current = on;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.isOn() && current.bri == 100);
+
+    current = dark;
+    OATPP_ASSERT(!engine->getState(current));
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A redirected fade continues from the current state...");
+
+    auto engine = TransitionEngine::createShared(config);
+    auto t0 = Clock::now();
+    auto first = makeLight(2, true, 200, 0, 200);
+    engine->start(makeLight(1, true, 0, 0, 200), first, 1000, t0);
+    engine->tick(t0 + std::chrono::milliseconds(500));
+
+    auto second = makeLight(3, true, 0, 0, 200);
+    engine->start(first, second, 1000, t0 + std::chrono::milliseconds(500));
+    HueDevice current = second;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.bri == 100);
+
+    engine->tick(t0 + std::chrono::milliseconds(1000));
+    current = second;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.bri == 50);
+    OATPP_ASSERT(engine->getStats().started == 2);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Reads see every fade while the ticker publishes new states...");
+
+    TransitionEngine::Config fastConfig;
+    fastConfig.tickMs = 1;
+    auto engine = TransitionEngine::createShared(fastConfig);
+
+    const v_int32 lightsCount = 1000;
+    std::vector<HueDevice> targets;
+    auto t0 = Clock::now();
+    for (v_int32 i = 0; i < lightsCount; i++) {
+      auto target = makeLight(2, true, 200, 0, 200);
+      target.id = i + 1;
+      auto from = makeLight(1, true, 0, 0, 200);
+      from.id = i + 1;
+      engine->start(from, target, 200, t0);
+      targets.push_back(target);
+    }
+
+    // brightness only goes up, until the fade is over and the committed record is read
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> readers;
+    for (v_int32 t = 0; t < 4; t++) {
+      readers.emplace_back([&engine, &targets, &failed] {
+        std::vector<v_uint8> last(targets.size(), 0);
+        while (!engine->isEmpty()) {
+          for (size_t i = 0; i < targets.size(); i++) {
+            HueDevice current = targets[i];
+            if (engine->getState(current) && (current.bri < last[i] || current.bri > 200)) {
+              failed = true;
+            }
+            last[i] = current.bri;
+          }
+        }
+      });
+    }
+    for (auto& reader : readers) {
+      reader.join();
+    }
+    OATPP_ASSERT(!failed);
+    OATPP_ASSERT(engine->getStats().finished == lightsCount);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "A light in a reused slot is read with its own fade...");
+
+    auto db = std::make_shared<Database>();
+    auto engine = TransitionEngine::createShared(config);
+    db->setStateOverlay(engine);
+    db->addChangeListener(engine);
+
+    v_int32 first = db->registerHueDevice("Oat", true, 0);
+    OATPP_ASSERT(db->deleteHueDevice(first));
+    v_int32 id = db->registerHueDevice("Grain", true, 0);
+    OATPP_ASSERT(Database::slotOf(id) == Database::slotOf(first) && id != first);
+    OATPP_ASSERT(Database::generationOf(id) > 0); // the id is beyond 2^20
+
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_BRI | HueStateUpdate::FIELD_TRANSITIONTIME;
+    update.bri = 200;
+    update.transitiontime = 10; // 1s
+    HueDevice updated;
+    OATPP_ASSERT(db->updateHueDeviceState(id, update, updated));
+
+    auto t0 = Clock::now();
+    engine->tick(t0 + std::chrono::milliseconds(1));
+    HueDevice current = updated;
+    OATPP_ASSERT(engine->getState(current));
+    OATPP_ASSERT(current.id == id && current.bri < 200);
+    OATPP_ASSERT(*db->getHueDeviceById(id)->state->bri < 200);
+
+    // the id of the deleted light doesn't resolve to the fade
+    current = updated;
+    current.id = first;
+    OATPP_ASSERT(!engine->getState(current));
+
+    engine->tick(t0 + std::chrono::seconds(2));
+    current = updated;
+    OATPP_ASSERT(!engine->getState(current));
+    OATPP_ASSERT(*db->getHueDeviceById(id)->state->bri == 200);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+  {
+    OATPP_LOGI(TAG, "Database reads the fades, the listener gets the steps...");
+
+    auto db = std::make_shared<Database>();
+    auto engine = TransitionEngine::createShared(config);
+    auto listener = std::make_shared<RecordingListener>();
+    auto committed = std::make_shared<RecordingListener>();
+    db->setStateOverlay(engine);
+    db->addChangeListener(engine);
+    engine->addListener(listener, true);
+    engine->addListener(committed, false);
+
+    v_int32 id = db->registerHueDevice("Oat", false, 200);
+    OATPP_ASSERT(listener->changes.size() == 1);
+
+    HueStateUpdate update;
+    update.fields = HueStateUpdate::FIELD_ON | HueStateUpdate::FIELD_TRANSITIONTIME;
+    update.on = true;
+    update.transitiontime = 10; // 1s
+    HueDevice updated;
+    OATPP_ASSERT(db->updateHueDeviceState(id, update, updated));
+    OATPP_ASSERT(updated.isOn() && updated.bri == 200);
+
+    // committed, but the light is still dark - the target is held back from the listener of steps
+    OATPP_ASSERT(listener->changes.size() == 1);
+    OATPP_ASSERT(committed->changes.size() == 2 && committed->changes.back().bri == 200);
+    OATPP_ASSERT(*db->getHueDeviceById(id)->state->bri < 10);
+    OATPP_ASSERT(*db->getHueDeviceById(id)->state->on);
+    OATPP_ASSERT(!contains(db->getHueDeviceJsonById(id), "\"bri\":200"));
+    OATPP_ASSERT(!contains(db->getHueDevicesJson(), "\"bri\":200"));
+
+    engine->tick(Clock::now());
+    OATPP_ASSERT(listener->changes.size() == 2);
+    OATPP_ASSERT(listener->changes.back().bri < 10);
+
+    engine->tick(Clock::now() + std::chrono::seconds(2));
+    OATPP_ASSERT(listener->changes.size() == 3);
+    OATPP_ASSERT(listener->changes.back().bri == 200);
+    OATPP_ASSERT(listener->changes.back().version == updated.version);
+    // the other listener is told about the end of the fade only
+    OATPP_ASSERT(committed->changes.size() == 3 && committed->changes.back().bri == 200);
+    OATPP_ASSERT(contains(db->getHueDeviceJsonById(id), "\"bri\":200"));
+    OATPP_ASSERT(engine->isEmpty());
+
+    // a state without transitiontime stops the fade at once
+    update.fields = HueStateUpdate::FIELD_BRI | HueStateUpdate::FIELD_TRANSITIONTIME;
+    update.bri = 100;
+    OATPP_ASSERT(db->updateHueDeviceState(id, update, updated));
+    OATPP_ASSERT(!engine->isEmpty());
+    update.fields = HueStateUpdate::FIELD_BRI;
+    update.bri = 20;
+    OATPP_ASSERT(db->updateHueDeviceState(id, update, updated));
+    OATPP_ASSERT(engine->isEmpty());
+    OATPP_ASSERT(listener->changes.back().bri == 20);
+    OATPP_ASSERT(*db->getHueDeviceById(id)->state->bri == 20);
+    OATPP_ASSERT(engine->getStats().superseded == 1);
+
+    OATPP_LOGI(TAG, "OK");
+  }
+
+}
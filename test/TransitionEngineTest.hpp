@@ -0,0 +1,17 @@
+#ifndef TransitionEngineTest_hpp
+#define TransitionEngineTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+class TransitionEngineTest : public oatpp::test::UnitTest {
+public:
+
+  TransitionEngineTest()
+    : UnitTest("TEST[TransitionEngineTest]")
+  {}
+
+  void onRun() override;
+
+};
+
+#endif /* TransitionEngineTest_hpp */
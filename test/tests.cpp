@@ -1,4 +1,18 @@
 
+#include "DatabaseTest.hpp"
+#include "ConnectionPolicyTest.hpp"
+#include "HueStateParserTest.hpp"
+#include "HueResponseWriterTest.hpp"
+#include "ChangeStreamTest.hpp"
+#include "DriverPipelineTest.hpp"
+#include "StorageTest.hpp"
+#include "MetricsTest.hpp"
+#include "AsyncLoggerTest.hpp"
+#include "SsdpServerTest.hpp"
+#include "ReusePortConnectionProviderTest.hpp"
+#include "TransitionEngineTest.hpp"
+#include "ColorModelTest.hpp"
+
 #include "oatpp-test/UnitTest.hpp"
 
 #include "oatpp/core/concurrency/SpinLock.hpp"
@@ -25,6 +39,19 @@ void runTests() {
   OATPP_LOGD("test", "insert tests here");
 
   OATPP_RUN_TEST(Test);
+  OATPP_RUN_TEST(DatabaseTest);
+  OATPP_RUN_TEST(ConnectionPolicyTest);
+  OATPP_RUN_TEST(HueStateParserTest);
+  OATPP_RUN_TEST(HueResponseWriterTest);
+  OATPP_RUN_TEST(ChangeStreamTest);
+  OATPP_RUN_TEST(DriverPipelineTest);
+  OATPP_RUN_TEST(StorageTest);
+  OATPP_RUN_TEST(MetricsTest);
+  OATPP_RUN_TEST(AsyncLoggerTest);
+  OATPP_RUN_TEST(SsdpServerTest);
+  OATPP_RUN_TEST(ReusePortConnectionProviderTest);
+  OATPP_RUN_TEST(TransitionEngineTest);
+  OATPP_RUN_TEST(ColorModelTest);
 
 }
 
@@ -43,7 +43,6 @@ function install_module () {
 
 install_module $BUILD_TYPE oatpp
 install_module $BUILD_TYPE oatpp-swagger
-install_module $BUILD_TYPE oatpp-ssdp
 
 cd ../
 rm -rf tmp